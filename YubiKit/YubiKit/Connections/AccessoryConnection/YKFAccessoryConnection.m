@@ -507,8 +507,11 @@ static NSTimeInterval const YubiAccessorySessionStreamOpenDelay = 0.2; // second
     
     if (self.session) {
         self.reconnectOnApplicationActive = NO;
-        self.connectionController = [[YKFAccessoryConnectionController alloc] initWithSession:self.session operationQueue:self.communicationQueue];
-        self.session.outputStream.delegate = self;
+        YKFAccessoryConnectionController *connectionController = [[YKFAccessoryConnectionController alloc] initWithSession:self.session
+                                                                                                           operationQueue:self.communicationQueue
+                                                                                                            configuration:self.configuration];
+        connectionController.streamDelegate = self;
+        self.connectionController = connectionController;
         
         YKFLogInfo(@"Session opened.");
     } else {
@@ -18,8 +18,20 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+typedef NS_ENUM(NSUInteger, YKFAccessoryConnectionIOMode) {
+    
+    /// The connection controller probes the accessory streams periodically for available space or bytes.
+    YKFAccessoryConnectionIOModePolling,
+    
+    /// The connection controller reads and writes when the accessory streams signal it on the streams thread.
+    YKFAccessoryConnectionIOModeStreamEvents
+};
+
 @interface YKFAccessoryConnectionConfiguration : NSObject
 
+/// The way the connection controller waits for the accessory streams. Defaults to YKFAccessoryConnectionIOModePolling.
+@property (nonatomic, assign) YKFAccessoryConnectionIOMode ioMode;
+
 /// Returns YES if the accessory is a YubiKey.
 - (BOOL)allowsAccessory:(nonnull id<YKFEAAccessoryProtocol>)accessory;
 
@@ -35,6 +35,7 @@ static NSString* const YKFAccessoryConnectionConfigurationYubicoManufacturesName
     if (self) {
         self.allowedProtocols = @[YKFAccessoryConnectionConfigurationYLPProtocolName];
         self.allowedManufactures = @[YKFAccessoryConnectionConfigurationYubicoManufacturesName];
+        self.ioMode = YKFAccessoryConnectionIOModePolling;
     }
     return self;
 }
@@ -17,15 +17,53 @@
 
 #import "YKFConnectionControllerProtocol.h"
 #import "YKFAPDU.h"
+#import "YKFAccessoryConnectionConfiguration.h"
 #import "EASession+Testing.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
+/*
+ Execution details of a command sent to the key over the accessory connection.
+ */
+@interface YKFAccessoryCommandMetrics : NSObject
+
+/// The time between sending the command and receiving the response.
+@property (nonatomic, assign, readonly) NSTimeInterval executionTime;
+
+/// The number of WTX (key busy) frames received before the response.
+@property (nonatomic, assign, readonly) NSUInteger wtxCount;
+
+/// The time between the first WTX frame and the response. 0 when the key was not busy.
+@property (nonatomic, assign, readonly) NSTimeInterval wtxDuration;
+
+@end
+
+typedef void (^YKFAccessoryConnectionControllerMetricsResponseBlock)(NSData* _Nullable, NSError* _Nullable, YKFAccessoryCommandMetrics*);
+
 @interface YKFAccessoryConnectionController : NSObject<YKFConnectionControllerProtocol>
 
-- (nullable instancetype)initWithSession:(id<YKFEASessionProtocol>)session operationQueue:(NSOperationQueue *)operationQueue NS_DESIGNATED_INITIALIZER;
+/*
+ The controller is the delegate of the session streams. The events are forwarded to this delegate
+ on the streams thread, after the controller has handled them.
+ */
+@property (nonatomic, weak, nullable) id<NSStreamDelegate> streamDelegate;
+
+- (nullable instancetype)initWithSession:(id<YKFEASessionProtocol>)session operationQueue:(NSOperationQueue *)operationQueue;
+
+- (nullable instancetype)initWithSession:(id<YKFEASessionProtocol>)session operationQueue:(NSOperationQueue *)operationQueue
+                           configuration:(YKFAccessoryConnectionConfiguration *)configuration NS_DESIGNATED_INITIALIZER;
 - (instancetype)init NS_UNAVAILABLE;
 
+/*
+ Executes the command and reports the execution details in the completion, including the time the key was busy.
+ 
+ NOTE:
+ The WTX details are specific to the accessory connection and are available only through this method. The
+ YKFConnectionControllerProtocol completions report the execution time only, the sessions don't depend on
+ the connection type.
+ */
+- (void)execute:(YKFAPDU *)command timeout:(NSTimeInterval)timeout metricsCompletion:(YKFAccessoryConnectionControllerMetricsResponseBlock)completion;
+
 @end
 
 NS_ASSUME_NONNULL_END
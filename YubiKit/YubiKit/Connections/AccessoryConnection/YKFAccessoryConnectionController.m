@@ -22,39 +22,200 @@
 #import "YKFNSDataAdditions+Private.h"
 #import "YKFSessionError+Private.h"
 #import "YKFAPDU+Private.h"
+#import "YKFAPDUCommandInstruction.h"
+#import "YKFSelectApplicationAPDU.h"
 
-@interface YKFAccessoryConnectionController()
+#pragma mark - YKFAccessoryResponseBuffer
+
+/*
+ Preallocated buffer which receives the key responses. The bytes are read from the input stream directly into
+ the buffer and handed out as a no-copy view, which stays valid until the buffer is reset or appended again.
+ */
+@interface YKFAccessoryResponseBuffer: NSObject
+
+@property (nonatomic, readonly) NSUInteger length;
+
+- (instancetype)initWithCapacity:(NSUInteger)capacity NS_DESIGNATED_INITIALIZER;
+- (instancetype)init NS_UNAVAILABLE;
+
+/// Reads all the available bytes from the stream at the end of the buffer. Returns NO on read error.
+- (BOOL)appendAvailableBytesFromStream:(NSInputStream *)stream;
+
+/// No-copy view of the buffer content.
+- (NSData *)data;
+
+- (void)reset;
+
+@end
+
+@implementation YKFAccessoryResponseBuffer {
+    UInt8 *_bytes;
+    NSUInteger _capacity;
+}
+
+- (instancetype)initWithCapacity:(NSUInteger)capacity {
+    self = [super init];
+    if (self) {
+        _bytes = malloc(capacity);
+        YKFAssertAbortInit(_bytes);
+        _capacity = capacity;
+    }
+    return self;
+}
+
+- (void)dealloc {
+    free(_bytes);
+}
+
+- (BOOL)appendAvailableBytesFromStream:(NSInputStream *)stream {
+    while (stream.hasBytesAvailable) {
+        if (_length == _capacity) {
+            UInt8 *bytes = realloc(_bytes, _capacity * 2);
+            if (!bytes) {
+                return NO;
+            }
+            _bytes = bytes;
+            _capacity *= 2;
+        }
+        
+        NSInteger bytesRead = [stream read:_bytes + _length maxLength:_capacity - _length];
+        if (bytesRead > 0) {
+            _length += bytesRead;
+        } else if (bytesRead == -1) { // Read error.
+            return NO;
+        } else {
+            break;
+        }
+    }
+    return YES;
+}
+
+- (NSData *)data {
+    return [NSData dataWithBytesNoCopy:_bytes length:_length freeWhenDone:NO];
+}
+
+- (void)reset {
+    _length = 0;
+}
+
+@end
+
+#pragma mark - YKFAccessoryStreamTransfer
+
+/*
+ A read or write handed over to the streams thread when the controller runs in the stream events IO mode.
+ The streams thread signals the semaphore when the transfer is completed or failed.
+ */
+@interface YKFAccessoryStreamTransfer: NSObject
+
+@property (nonatomic) NSData *data;
+@property (nonatomic, assign) NSUInteger offset;
+@property (nonatomic, assign) BOOL failed;
+
+// The buffer backing the data of a completed read.
+@property (nonatomic) YKFAccessoryResponseBuffer *buffer;
+@property (nonatomic, readonly) dispatch_semaphore_t semaphore;
+
+@end
+
+@implementation YKFAccessoryStreamTransfer
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _semaphore = dispatch_semaphore_create(0);
+    }
+    return self;
+}
+
+@end
+
+#pragma mark - YKFAccessoryCommandMetrics
+
+@interface YKFAccessoryCommandMetrics()
+
+@property (nonatomic, assign, readwrite) NSTimeInterval executionTime;
+@property (nonatomic, assign, readwrite) NSUInteger wtxCount;
+@property (nonatomic, assign, readwrite) NSTimeInterval wtxDuration;
+
+@end
+
+@implementation YKFAccessoryCommandMetrics
+@end
+
+#pragma mark - YKFAccessoryConnectionController
+
+@interface YKFAccessoryConnectionController()<NSStreamDelegate>
 
 @property (nonatomic) NSOperationQueue *communicationQueue;
-@property (nonatomic) NSMutableDictionary *delayedDispatches;
+// The timers of the blocks dispatched with a delay, until they fire or are canceled.
+@property (nonatomic) NSMutableSet<dispatch_source_t> *delayedDispatches;
 
 @property (nonatomic) NSInputStream *inputStream;
 @property (nonatomic) NSOutputStream *outputStream;
 @property (nonatomic) NSThread *streamsThread;
 
+@property (nonatomic, assign) YKFAccessoryConnectionIOMode ioMode;
+
+// Polling IO state. The response buffer is accessed only from the communication queue.
+@property (nonatomic) YKFAccessoryResponseBuffer *responseBuffer;
+
+// Observed processing time of the commands, by selected application and instruction. Accessed only from the
+// communication queue.
+@property (nonatomic) NSMutableDictionary<NSData *, NSMutableDictionary<NSNumber *, NSNumber *> *> *commandDurations;
+
+// The AID of the last selected application. Accessed only from the communication queue.
+@property (nonatomic) NSData *selectedApplication;
+
+// Stream events IO state. These properties are accessed only from the streams thread.
+@property (nonatomic) YKFAccessoryStreamTransfer *pendingWrite;
+@property (nonatomic) YKFAccessoryStreamTransfer *pendingRead;
+@property (nonatomic) YKFAccessoryResponseBuffer *receiveBuffer;
+@property (nonatomic) YKFAccessoryResponseBuffer *spareReceiveBuffer;
+
+// The receive buffer handed over to the communication queue with the last completed read. It is
+// given back to the streams thread when the next read starts.
+@property (nonatomic) YKFAccessoryResponseBuffer *deliveredReceiveBuffer;
+
 @end
 
 @implementation YKFAccessoryConnectionController
 
-static NSUInteger const YubiKeyConnectionControllerReadBufferSize = 512; // bytes
+static NSUInteger const YubiKeyConnectionControllerReadBufferSize = 4096; // bytes, initial capacity of the response buffers
 static NSTimeInterval const YKFAccessoryConnectionCommandProbeTime = 0.05;
+static NSTimeInterval const YKFAccessoryConnectionMinProbeTime = 0.002;
+static NSTimeInterval const YKFAccessoryConnectionBusyWaitTime = 0.25;
 static NSTimeInterval const YKFAccessoryConnectionDefaultTimeout = 10.0;
 static NSTimeInterval const YKFAccessoryConnectionCommandTime = 0.002;
+static NSTimeInterval const YKFAccessoryConnectionWTXPeriod = 0.5;
+static double const YKFAccessoryConnectionDurationSmoothing = 0.3;
+static NSUInteger const YKFAccessoryConnectionMaxFrameSize = 3062; // bytes, the APDU buffer of the key
 
 - (instancetype)initWithSession:(id<YKFEASessionProtocol>)session operationQueue:(NSOperationQueue *)operationQueue {
+    YKFAccessoryConnectionConfiguration *configuration = [[YKFAccessoryConnectionConfiguration alloc] init];
+    return [self initWithSession:session operationQueue:operationQueue configuration:configuration];
+}
+
+- (instancetype)initWithSession:(id<YKFEASessionProtocol>)session operationQueue:(NSOperationQueue *)operationQueue
+                  configuration:(YKFAccessoryConnectionConfiguration *)configuration {
     YKFAssertAbortInit(session);
     YKFAssertAbortInit(operationQueue);
+    YKFAssertAbortInit(configuration);
     
     self = [super init];
     if (self) {
         self.communicationQueue = operationQueue;
         self.inputStream = session.inputStream;
         self.outputStream = session.outputStream;
+        self.ioMode = configuration.ioMode;
         
         YKFAssertAbortInit(self.inputStream);
         YKFAssertAbortInit(self.outputStream);
         
-        self.delayedDispatches = [[NSMutableDictionary alloc] init];
+        self.delayedDispatches = [[NSMutableSet alloc] init];
+        self.commandDurations = [[NSMutableDictionary alloc] init];
+        self.responseBuffer = [[YKFAccessoryResponseBuffer alloc] initWithCapacity:YubiKeyConnectionControllerReadBufferSize];
+        self.receiveBuffer = [[YKFAccessoryResponseBuffer alloc] initWithCapacity:YubiKeyConnectionControllerReadBufferSize];
         
         self.streamsThread = [[NSThread alloc] initWithTarget: self selector:@selector(streamsThreadExecution) object:nil];
         [self.streamsThread start];
@@ -100,6 +261,37 @@ static NSTimeInterval const YKFAccessoryConnectionCommandTime = 0.002;
     [self.communicationQueue addOperation:operation];
 }
 
+- (void)dispatchBlockOnCommunicationQueue:(YKFConnectionControllerCommunicationQueueBlock)block delay:(NSTimeInterval)delay {
+    YKFParameterAssertReturn(block);
+    
+    if (delay <= 0) {
+        [self dispatchBlockOnCommunicationQueue:block];
+        return;
+    }
+    
+    dispatch_source_t timer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, self.communicationQueue.underlyingQueue ?: dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0));
+    dispatch_source_set_timer(timer, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), DISPATCH_TIME_FOREVER, (uint64_t)(0.01 * NSEC_PER_SEC));
+    
+    // The handler retains the timer until it fires or is canceled, which releases the handler.
+    ykf_weak_self();
+    dispatch_source_set_event_handler(timer, ^{
+        dispatch_source_cancel(timer);
+        ykf_safe_strong_self();
+        @synchronized (strongSelf.delayedDispatches) {
+            if (![strongSelf.delayedDispatches containsObject:timer]) {
+                return; // Canceled by cancelAllCommands while firing.
+            }
+            [strongSelf.delayedDispatches removeObject:timer];
+        }
+        [strongSelf dispatchBlockOnCommunicationQueue:block];
+    });
+    
+    @synchronized (self.delayedDispatches) {
+        [self.delayedDispatches addObject:timer];
+    }
+    dispatch_resume(timer);
+}
+
 - (void)streamsThreadExecution {
     YKFAssertOffMainThread();
     
@@ -122,6 +314,9 @@ static NSTimeInterval const YKFAccessoryConnectionCommandTime = 0.002;
     ykf_dispatch_thread_async(self.streamsThread, ^{
         NSRunLoop *runLoop = [NSRunLoop currentRunLoop];
         
+        inputStream.delegate = self;
+        outputStream.delegate = self;
+        
         [inputStream scheduleInRunLoop:runLoop forMode:NSDefaultRunLoopMode];
         [inputStream open];
         
@@ -139,6 +334,10 @@ static NSTimeInterval const YKFAccessoryConnectionCommandTime = 0.002;
     ykf_dispatch_thread_async(self.streamsThread, ^{
         NSRunLoop *runLoop = [NSRunLoop currentRunLoop];
         
+        [self failPendingTransfers];
+        inputStream.delegate = nil;
+        outputStream.delegate = nil;
+        
         if (inputStream.streamStatus != NSStreamStatusClosed) {
             [inputStream close];
         }
@@ -163,18 +362,26 @@ static NSTimeInterval const YKFAccessoryConnectionCommandTime = 0.002;
     YKFParameterAssertReturnValue(data, NO);
     YKFParameterAssertReturnValue(self.outputStream, NO);
     
-    NSMutableData *writeData = [data mutableCopy];
+    if (self.ioMode == YKFAccessoryConnectionIOModeStreamEvents) {
+        return [self writeDataOnStreamEvents:data timeout:timeout parentOperation:operation];
+    }
+    
+    const UInt8 *bytes = (const UInt8 *)data.bytes;
+    NSUInteger offset = 0;
     NSTimeInterval totalSleepTime = 0;
     
-    while (writeData.length > 0 && !operation.isCancelled) {
-        while (self.outputStream.hasSpaceAvailable && writeData.length > 0 && !operation.isCancelled) {
-            NSInteger bytesWritten = [self.outputStream write:writeData.bytes maxLength:writeData.length];
+    while (offset < data.length && !operation.isCancelled) {
+        while (self.outputStream.hasSpaceAvailable && offset < data.length && !operation.isCancelled) {
+            NSInteger bytesWritten = [self.outputStream write:bytes + offset maxLength:data.length - offset];
             if (bytesWritten > 0) {
-                [writeData replaceBytesInRange:NSMakeRange(0, bytesWritten) withBytes:NULL length:0];
+                offset += bytesWritten;
             } else if (bytesWritten == -1) { // Write error.
                 return NO;
             }
         }
+        if (offset == data.length) {
+            break;
+        }
         
         [NSThread sleepForTimeInterval: YKFAccessoryConnectionCommandProbeTime];
         totalSleepTime += YKFAccessoryConnectionCommandProbeTime;
@@ -190,18 +397,18 @@ static NSTimeInterval const YKFAccessoryConnectionCommandTime = 0.002;
     return YES;
 }
 
-- (BOOL)readData:(NSData**)readData timeout:(NSTimeInterval)timeout parentOperation:(NSOperation *)operation {
+- (BOOL)readData:(NSData**)readData timeout:(NSTimeInterval)timeout expectedReplyDate:(NSDate *)expectedReplyDate maxWaitTime:(NSTimeInterval)maxWaitTime parentOperation:(NSOperation *)operation {
     YKFAssertOffMainThread();
     YKFParameterAssertReturnValue(self.inputStream, NO);
     
-    NSMutableData *buffer = [[NSMutableData alloc] init];
-    UInt8 readBuffer[YubiKeyConnectionControllerReadBufferSize];
+    if (self.ioMode == YKFAccessoryConnectionIOModeStreamEvents) {
+        return [self readData:readData onStreamEventsWithTimeout:timeout parentOperation:operation];
+    }
     
-    NSTimeInterval totalSleepTime = 0;
+    NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:timeout];
     while (!self.inputStream.hasBytesAvailable && !operation.isCancelled) {
-        [NSThread sleepForTimeInterval: YKFAccessoryConnectionCommandProbeTime];
-        totalSleepTime += YKFAccessoryConnectionCommandProbeTime;
-        if (totalSleepTime >= timeout) {
+        [NSThread sleepForTimeInterval: [self probeIntervalForExpectedReplyDate:expectedReplyDate maxWaitTime:maxWaitTime]];
+        if ([deadline timeIntervalSinceNow] <= 0) {
             return NO;
         }
     }
@@ -210,28 +417,196 @@ static NSTimeInterval const YKFAccessoryConnectionCommandTime = 0.002;
         return NO;
     }
     
-    // Read the data while available.
-    while (self.inputStream.hasBytesAvailable) {
-        NSInteger bytesRead = [self.inputStream read:readBuffer maxLength:YubiKeyConnectionControllerReadBufferSize];
-        if (bytesRead > 0) {
-            [buffer appendBytes:readBuffer length:bytesRead];
-        } else if (bytesRead == -1) { // Read error.
+    // Read the data while available. The previous response is overwritten, it was already consumed.
+    [self.responseBuffer reset];
+    if (![self.responseBuffer appendAvailableBytesFromStream:self.inputStream]) {
+        return NO;
+    }
+    
+    *readData = [self.responseBuffer data];
+    
+    return YES;
+}
+
+#pragma mark - Stream Events IO
+
+- (BOOL)writeDataOnStreamEvents:(NSData *)data timeout:(NSTimeInterval)timeout parentOperation:(NSOperation *)operation {
+    YKFAccessoryStreamTransfer *transfer = [[YKFAccessoryStreamTransfer alloc] init];
+    transfer.data = data;
+    
+    ykf_dispatch_thread_async(self.streamsThread, ^{
+        self.pendingWrite = transfer;
+        [self writePendingData];
+    });
+    
+    BOOL success = [self waitForTransfer:transfer timeout:timeout parentOperation:operation];
+    if (!success) {
+        ykf_dispatch_thread_async(self.streamsThread, ^{
+            if (self.pendingWrite == transfer) {
+                self.pendingWrite = nil;
+            }
+        });
+    }
+    return success;
+}
+
+- (BOOL)readData:(NSData**)readData onStreamEventsWithTimeout:(NSTimeInterval)timeout parentOperation:(NSOperation *)operation {
+    YKFAccessoryStreamTransfer *transfer = [[YKFAccessoryStreamTransfer alloc] init];
+    YKFAccessoryResponseBuffer *consumedBuffer = self.deliveredReceiveBuffer;
+    self.deliveredReceiveBuffer = nil;
+    
+    ykf_dispatch_thread_async(self.streamsThread, ^{
+        if (consumedBuffer) {
+            [consumedBuffer reset];
+            self.spareReceiveBuffer = consumedBuffer;
+        }
+        self.pendingRead = transfer;
+        [self readAvailableData];
+    });
+    
+    BOOL success = [self waitForTransfer:transfer timeout:timeout parentOperation:operation];
+    if (!success) {
+        ykf_dispatch_thread_async(self.streamsThread, ^{
+            if (self.pendingRead == transfer) {
+                self.pendingRead = nil;
+            }
+        });
+        return NO;
+    }
+    
+    self.deliveredReceiveBuffer = transfer.buffer;
+    *readData = transfer.data;
+    return YES;
+}
+
+/*
+ Blocks the communication queue until the streams thread completes the transfer. The probe time bounds only
+ how late a cancellation of the operation is noticed, a completed transfer wakes up the queue immediately.
+ */
+- (BOOL)waitForTransfer:(YKFAccessoryStreamTransfer *)transfer timeout:(NSTimeInterval)timeout parentOperation:(NSOperation *)operation {
+    NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:timeout];
+    
+    while (!operation.isCancelled) {
+        NSTimeInterval waitTime = MIN(YKFAccessoryConnectionCommandProbeTime, [deadline timeIntervalSinceNow]);
+        if (waitTime <= 0) {
             return NO;
         }
+        long result = dispatch_semaphore_wait(transfer.semaphore, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(waitTime * NSEC_PER_SEC)));
+        if (result == 0) {
+            return !transfer.failed && !operation.isCancelled;
+        }
     }
+    return NO;
+}
+
+- (void)writePendingData {
+    YKFAccessoryStreamTransfer *transfer = self.pendingWrite;
     
-    *readData = [buffer copy];
+    while (transfer && self.outputStream.hasSpaceAvailable) {
+        const UInt8 *bytes = (const UInt8 *)transfer.data.bytes;
+        NSInteger bytesWritten = [self.outputStream write:bytes + transfer.offset maxLength:transfer.data.length - transfer.offset];
+        
+        if (bytesWritten > 0) {
+            transfer.offset += bytesWritten;
+            if (transfer.offset == transfer.data.length) {
+                [self completeTransfer:transfer failed:NO];
+                return;
+            }
+        } else if (bytesWritten == -1) { // Write error.
+            [self completeTransfer:transfer failed:YES];
+            return;
+        } else {
+            return;
+        }
+    }
+}
+
+- (void)readAvailableData {
+    // The bytes are drained even when no read is pending, otherwise the stream doesn't signal again.
+    if (![self.receiveBuffer appendAvailableBytesFromStream:self.inputStream]) {
+        if (self.pendingRead) {
+            [self completeTransfer:self.pendingRead failed:YES];
+        }
+        return;
+    }
     
-    return YES;
+    YKFAccessoryStreamTransfer *transfer = self.pendingRead;
+    if (transfer && self.receiveBuffer.length) {
+        // Hand over the filled buffer to the communication queue and keep receiving into the spare one.
+        transfer.buffer = self.receiveBuffer;
+        transfer.data = [self.receiveBuffer data];
+        
+        self.receiveBuffer = self.spareReceiveBuffer ?: [[YKFAccessoryResponseBuffer alloc] initWithCapacity:YubiKeyConnectionControllerReadBufferSize];
+        self.spareReceiveBuffer = nil;
+        
+        [self completeTransfer:transfer failed:NO];
+    }
+}
+
+- (void)completeTransfer:(YKFAccessoryStreamTransfer *)transfer failed:(BOOL)failed {
+    if (transfer == self.pendingWrite) {
+        self.pendingWrite = nil;
+    }
+    if (transfer == self.pendingRead) {
+        self.pendingRead = nil;
+    }
+    transfer.failed = failed;
+    dispatch_semaphore_signal(transfer.semaphore);
+}
+
+- (void)failPendingTransfers {
+    if (self.pendingWrite) {
+        [self completeTransfer:self.pendingWrite failed:YES];
+    }
+    if (self.pendingRead) {
+        [self completeTransfer:self.pendingRead failed:YES];
+    }
+}
+
+#pragma mark - NSStreamDelegate
+
+- (void)stream:(NSStream *)aStream handleEvent:(NSStreamEvent)eventCode {
+    if (self.ioMode == YKFAccessoryConnectionIOModeStreamEvents) {
+        switch (eventCode) {
+            case NSStreamEventHasSpaceAvailable:
+                [self writePendingData];
+                break;
+            case NSStreamEventHasBytesAvailable:
+                [self readAvailableData];
+                break;
+            case NSStreamEventErrorOccurred:
+                [self failPendingTransfers];
+                break;
+            default:
+                break;
+        }
+    }
+    
+    id<NSStreamDelegate> streamDelegate = self.streamDelegate;
+    if ([streamDelegate respondsToSelector:@selector(stream:handleEvent:)]) {
+        [streamDelegate stream:aStream handleEvent:eventCode];
+    }
 }
 
 #pragma mark - Commands
 
+- (NSUInteger)maxFrameSize {
+    return YKFAccessoryConnectionMaxFrameSize;
+}
+
 - (void)execute:(YKFAPDU *)command completion:(YKFConnectionControllerCommandResponseBlock)completion {
     [self execute:command timeout:YKFAccessoryConnectionDefaultTimeout completion:completion];
 }
 
 - (void)execute:(YKFAPDU *)command timeout:(NSTimeInterval)timeout completion:(YKFConnectionControllerCommandResponseBlock)completion {
+    YKFParameterAssertReturn(completion);
+    
+    [self execute:command timeout:timeout metricsCompletion:^(NSData *response, NSError *error, YKFAccessoryCommandMetrics *metrics) {
+        completion(response, error, metrics.executionTime);
+    }];
+}
+
+- (void)execute:(YKFAPDU *)command timeout:(NSTimeInterval)timeout metricsCompletion:(YKFAccessoryConnectionControllerMetricsResponseBlock)completion {
     YKFParameterAssertReturn(command);
     YKFParameterAssertReturn(completion);
     
@@ -240,72 +615,132 @@ static NSTimeInterval const YKFAccessoryConnectionCommandTime = 0.002;
     ykf_weak_self();
     [self dispatchBlockOnCommunicationQueue:^(NSOperation *operation) {
         ykf_safe_strong_self();
-        NSDate *commandStartDate = [NSDate date];
-        YKFLogVerbose(@"Sent(IAP): %@", [command.ylpApduData ykf_hexadecimalString]);
+        [strongSelf executeCommand:command timeout:timeout parentOperation:operation completion:completion];
+    }];
+}
+
+- (void)executeSequence:(YKFAPDU *)command timeout:(NSTimeInterval)timeout next:(YKFConnectionControllerCommandSequenceBlock)next {
+    YKFParameterAssertReturn(command);
+    YKFParameterAssertReturn(next);
+    
+    YKFLogVerbose(@"AccessoryConnectionController - Execute command sequence...");
+    
+    ykf_weak_self();
+    [self dispatchBlockOnCommunicationQueue:^(NSOperation *operation) {
+        ykf_safe_strong_self();
+        
+        // The whole sequence runs in this operation, the next command is sent as soon as the response is handled.
+        __block YKFAPDU *nextCommand = command;
+        while (nextCommand && !operation.isCancelled) {
+            YKFAPDU *currentCommand = nextCommand;
+            nextCommand = nil;
+            [strongSelf executeCommand:currentCommand timeout:timeout parentOperation:operation completion:^(NSData *response, NSError *error, YKFAccessoryCommandMetrics *metrics) {
+                nextCommand = next(response, error, metrics.executionTime);
+            }];
+        }
+    }];
+}
+
+/*
+ Sends the command and reads the response synchronously on the communication queue. The completion is called
+ before returning, unless the operation was canceled.
+ */
+- (void)executeCommand:(YKFAPDU *)command timeout:(NSTimeInterval)timeout parentOperation:(NSOperation *)operation completion:(YKFAccessoryConnectionControllerMetricsResponseBlock)completion {
+    YKFAssertOffMainThread();
+    
+    NSDate *commandStartDate = [NSDate date];
+    YKFAccessoryCommandMetrics *metrics = [[YKFAccessoryCommandMetrics alloc] init];
+    YKFLogVerbose(@"Sent(IAP): %@", [command.ylpApduData ykf_hexadecimalString]);
+
+    // 1. Send the command to the key.
+    BOOL success = [self writeData:command.ylpApduData timeout:timeout parentOperation:operation];
+    
+    if (!success && !operation.isCancelled) {
+        NSError *error = nil;
+        if (self.outputStream.streamError) {
+            error = [self.outputStream.streamError copy];
+        } else {
+            error = [YKFSessionError errorWithCode:YKFSessionErrorWriteTimeoutCode];
+        }
+        
+        metrics.executionTime = [[NSDate date] timeIntervalSinceDate: commandStartDate];
+        completion(nil, error, metrics);
+        return;
+    }
 
-        // 1. Send the command to the key.
-        BOOL success = [strongSelf writeData:command.ylpApduData timeout:timeout parentOperation:operation];
+    // Do not wait for the command to process if the operation was canceled.
+    if (operation.isCancelled) {
+        return;
+    }
+
+    BOOL keyIsBusyProcesssing = YES;
+    NSData *commandResult = nil;
+    
+    NSDate *commandSentDate = [NSDate date];
+    NSDate *firstWTXDate = nil;
+    NSTimeInterval expectedDuration = [self expectedDurationForCommand:command];
+
+    while (keyIsBusyProcesssing) {
+        // 2. Wait for the key to process the command. The polling read sleeps through the expected processing
+        //    time and probes more often when the response is due. With stream events the read completes when
+        //    the response arrives.
+        //    The reply may come early when the expected time is off, so the read sleeps longer only once the key
+        //    reported that it's busy.
+        NSDate *expectedReplyDate = [commandSentDate dateByAddingTimeInterval:expectedDuration];
+        NSTimeInterval maxWaitTime = firstWTXDate ? YKFAccessoryConnectionBusyWaitTime : YKFAccessoryConnectionCommandProbeTime;
         
-        if (!success && !operation.isCancelled) {
+        // 3. Read the command result.
+        success = [self readData:&commandResult timeout:timeout expectedReplyDate:expectedReplyDate maxWaitTime:maxWaitTime parentOperation:operation];
+
+        if ((!success || commandResult.length == 0) && !operation.isCancelled) {
             NSError *error = nil;
-            if (strongSelf.outputStream.streamError) {
-                error = [strongSelf.outputStream.streamError copy];
+            if (self.inputStream.streamError) {
+                error = [self.inputStream.streamError copy];
             } else {
-                error = [YKFSessionError errorWithCode:YKFSessionErrorWriteTimeoutCode];
+                error = [YKFSessionError errorWithCode:YKFSessionErrorReadTimeoutCode];
             }
             
-            NSTimeInterval executionTime = [[NSDate date] timeIntervalSinceDate: commandStartDate];
-            completion(nil, error, executionTime);
+            metrics.executionTime = [[NSDate date] timeIntervalSinceDate: commandStartDate];
+            completion(nil, error, metrics);
             return;
         }
-
-        // Do not wait for the command to process if the operation was canceled.
+        
+        // Do not notify if the operation was canceled.
         if (operation.isCancelled) {
             return;
         }
-
-        BOOL keyIsBusyProcesssing = YES;
-        NSData *commandResult = nil;
-
-        while (keyIsBusyProcesssing) {
-            // 2. Wait for the key to process the command.
-            [NSThread sleepForTimeInterval: YKFAccessoryConnectionCommandTime];
-            
-            // 3. Read the command result.
-            success = [strongSelf readData:&commandResult timeout:timeout parentOperation:operation];
-
-            if ((!success || commandResult.length == 0) && !operation.isCancelled) {
-                NSError *error = nil;
-                if (strongSelf.inputStream.streamError) {
-                    error = [strongSelf.inputStream.streamError copy];
-                } else {
-                    error = [YKFSessionError errorWithCode:YKFSessionErrorReadTimeoutCode];
-                }
-                
-                NSTimeInterval executionTime = [[NSDate date] timeIntervalSinceDate: commandStartDate];
-                completion(nil, error, executionTime);
-                return;
-            }
-            
-            // Do not notify if the operation was canceled.
-            if (operation.isCancelled) {
-                return;
-            }
+        
+        keyIsBusyProcesssing = [self isKeyBusyProcessingResult:commandResult];
+        if (keyIsBusyProcesssing) {
+            YKFLogVerbose(@"The key is busy, processing the request. Waiting for response...");
             
-            keyIsBusyProcesssing = [strongSelf isKeyBusyProcessingResult:commandResult];
-            if (keyIsBusyProcesssing) {
-                YKFLogVerbose(@"The key is busy, processing the request. Waiting for response...");
-            }
+            // The key sends a WTX frame every ~500ms while busy: the command takes at least until the next one.
+            firstWTXDate = firstWTXDate ?: [NSDate date];
+            metrics.wtxCount += 1;
+            NSTimeInterval processingTime = [[NSDate date] timeIntervalSinceDate:commandSentDate];
+            expectedDuration = MAX(expectedDuration, processingTime + YKFAccessoryConnectionWTXPeriod);
         }
+    }
+    
+    NSDate *responseDate = [NSDate date];
+    
+    // The commands which kept the key busy, e.g. waiting for touch, don't tell how long the next ones take.
+    if (!firstWTXDate) {
+        [self recordDuration:[responseDate timeIntervalSinceDate:commandSentDate] forCommand:command];
+    }
+    
+    metrics.executionTime = [responseDate timeIntervalSinceDate: commandStartDate];
+    if (firstWTXDate) {
+        metrics.wtxDuration = [responseDate timeIntervalSinceDate:firstWTXDate];
+        YKFLogInfo(@"The key was busy for %lf seconds (%lu WTX frames).", metrics.wtxDuration, (unsigned long)metrics.wtxCount);
+    }
+    
+    YKFLogVerbose(@"Received(IAP): %@", [commandResult ykf_hexadecimalString]);
+    commandResult = [self dataAndStatusFromKeyResponse:commandResult];
 
-        NSTimeInterval executionTime = [[NSDate date] timeIntervalSinceDate: commandStartDate];
-        YKFLogVerbose(@"Received(IAP): %@", [commandResult ykf_hexadecimalString]);
-        commandResult = [self dataAndStatusFromKeyResponse:commandResult];
-
-        completion(commandResult, nil, executionTime);
-        
-        YKFLogVerbose(@"Command execution time: %lf seconds", executionTime);
-    }];
+    completion(commandResult, nil, metrics);
+    
+    YKFLogVerbose(@"Command execution time: %lf seconds", metrics.executionTime);
 }
 
 - (void)cancelAllCommands {
@@ -314,17 +749,87 @@ static NSTimeInterval const YKFAccessoryConnectionCommandTime = 0.002;
     
     [self.communicationQueue cancelAllOperations];
     
-    NSArray *keys = self.delayedDispatches.allKeys;
-    for (NSString *key in keys) {
-        dispatch_block_t block = self.delayedDispatches[key];
-        dispatch_block_cancel(block);
-    };
-    [self.delayedDispatches removeAllObjects];
+    @synchronized (self.delayedDispatches) {
+        for (dispatch_source_t timer in self.delayedDispatches) {
+            dispatch_source_cancel(timer);
+        }
+        [self.delayedDispatches removeAllObjects];
+    }
     
     dispatch_resume(self.communicationQueue.underlyingQueue);
     self.communicationQueue.suspended = NO;
 }
 
+#pragma mark - WTX
+
+/*
+ Returns the time the key is expected to take for processing the command. The hint is refined with the observed
+ duration of the previous commands with the same instruction, sent to the same application.
+ */
+- (NSTimeInterval)expectedDurationForCommand:(YKFAPDU *)command {
+    UInt8 ins = command.ins;
+    if (ins == YKFAPDUCommandInstructionSelectApplication && command.p1 == 0x04) {
+        // The pre-built APDUs don't expose their data, the whole APDU identifies the application.
+        self.selectedApplication = command.commandData ?: command.apduData;
+    }
+    NSData *application = self.selectedApplication ?: [NSData data];
+    
+    NSNumber *observedDuration = self.commandDurations[application][@(ins)];
+    if (observedDuration) {
+        return observedDuration.doubleValue;
+    }
+    
+    static NSData *pivApplication = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        pivApplication = [[YKFSelectApplicationAPDU alloc] initWithApplicationName:YKFSelectApplicationAPDUNamePIV].commandData;
+    });
+    if (![application isEqualToData:pivApplication]) {
+        return YKFAccessoryConnectionCommandTime;
+    }
+    
+    switch (ins) {
+        case 0x47: // PIV generate key, from ~100ms for ECC to seconds for RSA keys.
+            return 0.1;
+        case 0xF9: // PIV attest.
+            return 0.3;
+        case 0x87: // PIV general authenticate (sign, decrypt, key agreement).
+            return 0.1;
+        default:
+            return YKFAccessoryConnectionCommandTime;
+    }
+}
+
+- (void)recordDuration:(NSTimeInterval)duration forCommand:(YKFAPDU *)command {
+    NSData *application = self.selectedApplication ?: [NSData data];
+    NSMutableDictionary<NSNumber *, NSNumber *> *durations = self.commandDurations[application];
+    if (!durations) {
+        durations = [[NSMutableDictionary alloc] init];
+        self.commandDurations[application] = durations;
+    }
+    
+    NSNumber *observedDuration = durations[@(command.ins)];
+    if (observedDuration) {
+        duration = observedDuration.doubleValue + YKFAccessoryConnectionDurationSmoothing * (duration - observedDuration.doubleValue);
+    }
+    durations[@(command.ins)] = @(duration);
+}
+
+/*
+ Returns how long the polling read sleeps before probing the input stream again:
+ - Before the expected reply date it sleeps through half of the remaining time, up to the max wait time. The max
+   wait time is the probe time of a command until the key reports that it's busy, and longer after a WTX frame.
+ - After the expected reply date the interval grows with the delay, from the min to the max probe time, to
+   not burn CPU when the key is slower than expected.
+ */
+- (NSTimeInterval)probeIntervalForExpectedReplyDate:(NSDate *)expectedReplyDate maxWaitTime:(NSTimeInterval)maxWaitTime {
+    NSTimeInterval remainingTime = [expectedReplyDate timeIntervalSinceNow];
+    if (remainingTime > 0) {
+        return MAX(MIN(remainingTime / 2, maxWaitTime), YKFAccessoryConnectionMinProbeTime);
+    }
+    return MAX(MIN(-remainingTime, YKFAccessoryConnectionCommandProbeTime), YKFAccessoryConnectionMinProbeTime);
+}
+
 #pragma mark - Helpers
 
 /*
@@ -356,15 +861,15 @@ static NSTimeInterval const YKFAccessoryConnectionCommandTime = 0.002;
     UInt8 *bytes = (UInt8 *)response.bytes;
     YKFParameterAssertReturnValue(bytes[0] == 0x00 || bytes[0] == 0x01, [NSData data]);
     
+    // The response is a view over the response buffer: slice it without copying.
     if (bytes[0] == 0x00) {
         // Remove the first byte (the YLP key protocol header)
-        NSRange range = {1, response.length - 1};
-        return [response subdataWithRange:range];
+        return [NSData dataWithBytesNoCopy:bytes + 1 length:response.length - 1 freeWhenDone:NO];
     }
     else if (bytes[0] == 0x01) {
         // Remove the first byte (the YLP key protocol header) and the WTX
-        NSRange range = {4, response.length - 4};
-        return [response subdataWithRange:range];
+        YKFAssertReturnValue(response.length >= 4, @"Key response data is too short.", [NSData data]);
+        return [NSData dataWithBytesNoCopy:bytes + 4 length:response.length - 4 freeWhenDone:NO];
     }
     
     return [NSData data];
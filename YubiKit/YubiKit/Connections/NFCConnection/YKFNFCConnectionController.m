@@ -24,99 +24,269 @@
 
 static NSTimeInterval const YKFNFCConnectionDefaultTimeout = 10.0;
 
-@interface YKFNFCConnectionController()
+// Core NFC doesn't report if the reader negotiated extended length APDUs with the key, only short frames are assumed.
+static NSUInteger const YKFNFCConnectionMaxFrameSize = 261; // bytes, a short APDU with 255 bytes of data and Le
 
-@property (nonatomic) NSOperationQueue *communicationQueue;
-@property (nonatomic) NSMutableDictionary *delayedDispatches;
+#pragma mark - YKFNFCCommandOperation
+
+/*
+ Asynchronous operation which sends a sequence of commands to the tag. The operation releases the communication
+ queue while Core NFC processes a command. The next command of the sequence is sent from the tag callback and the
+ operation finishes when the sequence ends, or when the timeout timer fires, which lets the queue start the next
+ operation in order.
+ */
+API_AVAILABLE(ios(13.0))
+@interface YKFNFCCommandOperation: NSOperation
+
+- (instancetype)initWithTag:(id<NFCISO7816Tag>)tag command:(YKFAPDU *)command timeout:(NSTimeInterval)timeout
+                      queue:(dispatch_queue_t)queue next:(YKFConnectionControllerCommandSequenceBlock)next NS_DESIGNATED_INITIALIZER;
+- (instancetype)init NS_UNAVAILABLE;
+
+@end
+
+@interface YKFNFCCommandOperation()
 
 @property (nonatomic) id<NFCISO7816Tag> tag;
+@property (nonatomic) YKFAPDU *command;
+@property (nonatomic, assign) NSTimeInterval timeout;
+@property (nonatomic) dispatch_queue_t queue;
+@property (nonatomic, copy) YKFConnectionControllerCommandSequenceBlock next;
+
+@property (nonatomic) NSDate *commandStartDate;
+@property (nonatomic) dispatch_source_t timeoutTimer;
+@property (nonatomic, assign) NSUInteger sentCommandsCount;
 
 @end
 
-@implementation YKFNFCConnectionController
+@implementation YKFNFCCommandOperation {
+    BOOL _executing;
+    BOOL _finished;
+}
 
-- (instancetype)initWithNFCTag:(id<NFCISO7816Tag>)tag operationQueue:(NSOperationQueue *)operationQueue {
+- (instancetype)initWithTag:(id<NFCISO7816Tag>)tag command:(YKFAPDU *)command timeout:(NSTimeInterval)timeout
+                      queue:(dispatch_queue_t)queue next:(YKFConnectionControllerCommandSequenceBlock)next {
     self = [super init];
     if (self) {
         self.tag = tag;
-        self.communicationQueue = operationQueue;        
-        self.delayedDispatches = [[NSMutableDictionary alloc] init];
+        self.command = command;
+        self.timeout = timeout;
+        self.queue = queue;
+        self.next = next;
     }
     return self;
 }
 
-#pragma mark - Commands
-
-- (void)execute:(nonnull YKFAPDU *)command completion:(nonnull YKFConnectionControllerCommandResponseBlock)completion {
-    [self execute:command timeout:YKFNFCConnectionDefaultTimeout completion:completion];
+- (BOOL)isAsynchronous {
+    return YES;
 }
 
-- (void)execute:(nonnull YKFAPDU *)command timeout:(NSTimeInterval)timeout completion:(nonnull YKFConnectionControllerCommandResponseBlock)completion {
-    YKFParameterAssertReturn(command);
-    YKFParameterAssertReturn(completion);
-    
-    YKFLogVerbose(@"NFCConnectionController - Execute command...");
+- (BOOL)isExecuting {
+    @synchronized (self) {
+        return _executing;
+    }
+}
 
-    ykf_weak_self();
-    [self dispatchBlockOnCommunicationQueue:^(NSOperation *operation) {
-        ykf_safe_strong_self();
-      
-        // Do not wait for the command to process if the operation was canceled.
-        if (operation.isCancelled) {
-            return;
-        }
-        
-        // Check availability before executing. If the command is queued, the tag may become unavailable at execution time.
-        if (!strongSelf.tag.isAvailable) {
-            completion(nil, [YKFSessionError errorWithCode:YKFSessionErrorConnectionLost], 0);
-            return;
-        }
-                
-        NFCISO7816APDU *cnApdu = [[NFCISO7816APDU alloc] initWithData:command.apduData];
-        YKFAssertReturn(cnApdu, @"Could not create a Core NFC APDU object from the command data.");
+- (BOOL)isFinished {
+    @synchronized (self) {
+        return _finished;
+    }
+}
 
-        __block NSError *executionError = nil;
-        __block NSData *executionResult = nil;
-        NSDate *commandStartDate = [NSDate date];
-        dispatch_semaphore_t executionSemaphore = dispatch_semaphore_create(0);
-        YKFLogVerbose(@"Sent(NFC): %@", [command.apduData ykf_hexadecimalString]);
+- (void)start {
+    YKFAssertOffMainThread();
+    
+    if (self.isCancelled) {
+        [self finish];
+        return;
+    }
+    
+    [self willChangeValueForKey:@"isExecuting"];
+    @synchronized (self) {
+        _executing = YES;
+    }
+    [self didChangeValueForKey:@"isExecuting"];
+    
+    [self sendCommand:self.command];
+}
 
-        [strongSelf.tag sendCommandAPDU:cnApdu completionHandler:^(NSData *responseData, uint8_t sw1, uint8_t sw2, NSError *error) {
+- (void)sendCommand:(YKFAPDU *)command {
+    // Check availability before executing. If the command is queued, the tag may become unavailable at execution time.
+    if (!self.tag.isAvailable) {
+        [self completeWithResponse:nil error:[YKFSessionError errorWithCode:YKFSessionErrorConnectionLost]];
+        return;
+    }
+    
+    NFCISO7816APDU *cnApdu = [[NFCISO7816APDU alloc] initWithData:command.apduData];
+    if (!cnApdu) {
+        YKFLogError(@"Could not create a Core NFC APDU object from the command data.");
+        [self completeWithResponse:nil error:[YKFSessionError errorWithCode:YKFSessionErrorUnexpectedStatusCode]];
+        return;
+    }
+    
+    self.commandStartDate = [NSDate date];
+    [self startTimeoutTimer];
+    
+    YKFLogVerbose(@"Sent(NFC): %@", [command.apduData ykf_hexadecimalString]);
+    NSUInteger commandNumber = ++self.sentCommandsCount;
+    
+    // The operation is retained by the callback until Core NFC replies, even if it finished on timeout.
+    [self.tag sendCommandAPDU:cnApdu completionHandler:^(NSData *responseData, uint8_t sw1, uint8_t sw2, NSError *error) {
+        dispatch_async(self.queue, ^{
+            if (self.isFinished || commandNumber != self.sentCommandsCount) {
+                YKFLogInfo(@"Received a late response from the NFC tag after the command timed out or was canceled.");
+                return;
+            }
             if (error) {
-                executionError = error;
-                dispatch_semaphore_signal(executionSemaphore);
+                [self completeWithResponse:nil error:error];
                 return;
             }
             
-
-            NSMutableData *fullResponse = [[NSMutableData alloc] initWithData:responseData];
+            NSMutableData *fullResponse = [[NSMutableData alloc] initWithCapacity:responseData.length + 2];
+            [fullResponse appendData:responseData];
             [fullResponse ykf_appendByte:sw1];
             [fullResponse ykf_appendByte:sw2];
-            executionResult = [fullResponse copy];
+            
+            YKFLogVerbose(@"Received(NFC): %@", [fullResponse ykf_hexadecimalString]);
+            [self completeWithResponse:fullResponse error:nil];
+        });
+    }];
+}
 
-            YKFLogVerbose(@"Received(NFC): %@", [executionResult ykf_hexadecimalString]);
+- (void)cancel {
+    [super cancel];
+    
+    // Release the queue without notifying the caller, like the commands canceled before they started.
+    dispatch_async(self.queue, ^{
+        if (self.isExecuting) {
+            [self finish];
+        }
+    });
+}
 
-            dispatch_semaphore_signal(executionSemaphore);
-        }];
-        
-        // Lock the async call to enforce the sequential execution using the library dispatch queue.
-        dispatch_semaphore_wait(executionSemaphore, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(timeout * NSEC_PER_SEC)));
-        
-        // Do not notify if the operation was canceled.
-        if (operation.isCancelled) {
+#pragma mark - Timeout
+
+- (void)startTimeoutTimer {
+    dispatch_source_t timer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, self.queue);
+    dispatch_source_set_timer(timer, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.timeout * NSEC_PER_SEC)), DISPATCH_TIME_FOREVER, (uint64_t)(0.01 * NSEC_PER_SEC));
+    
+    __weak typeof(self) weakSelf = self;
+    dispatch_source_set_event_handler(timer, ^{
+        __strong typeof(self) strongSelf = weakSelf;
+        if (!strongSelf || strongSelf.isFinished) {
             return;
         }
+        YKFLogInfo(@"The NFC tag did not respond to the command in %lf seconds.", strongSelf.timeout);
+        [strongSelf completeWithResponse:nil error:[YKFSessionError errorWithCode:YKFSessionErrorReadTimeoutCode]];
+    });
+    
+    self.timeoutTimer = timer;
+    dispatch_resume(timer);
+}
 
-        NSTimeInterval executionTime = [[NSDate date] timeIntervalSinceDate: commandStartDate];
-        if (executionError) {
-            completion(nil, executionError, executionTime);
-        } else {
-            YKFAssertReturn(executionResult, @"The command did not return any response data when error was not nil.");
-            completion(executionResult, nil, executionTime);
+- (void)cancelTimeoutTimer {
+    if (self.timeoutTimer) {
+        dispatch_source_cancel(self.timeoutTimer);
+        self.timeoutTimer = nil;
+    }
+}
+
+#pragma mark - Completion
+
+- (void)completeWithResponse:(NSData *)response error:(NSError *)error {
+    NSTimeInterval executionTime = self.commandStartDate ? [[NSDate date] timeIntervalSinceDate:self.commandStartDate] : 0;
+    
+    // Do not notify if the operation was canceled.
+    if (!self.isCancelled) {
+        YKFLogVerbose(@"Command execution time: %lf seconds", executionTime);
+        
+        YKFAPDU *nextCommand = self.next(response, error, executionTime);
+        if (nextCommand && !self.isCancelled) {
+            [self cancelTimeoutTimer];
+            [self sendCommand:nextCommand];
+            return;
         }
+    }
+    [self finish];
+}
+
+- (void)finish {
+    [self cancelTimeoutTimer];
+    self.next = nil;
+    
+    [self willChangeValueForKey:@"isExecuting"];
+    [self willChangeValueForKey:@"isFinished"];
+    @synchronized (self) {
+        _executing = NO;
+        _finished = YES;
+    }
+    [self didChangeValueForKey:@"isFinished"];
+    [self didChangeValueForKey:@"isExecuting"];
+}
+
+@end
+
+#pragma mark - YKFNFCConnectionController
+
+@interface YKFNFCConnectionController()
+
+@property (nonatomic) NSOperationQueue *communicationQueue;
+@property (nonatomic) dispatch_queue_t callbackQueue;
+// The timers of the blocks dispatched with a delay, until they fire or are canceled.
+@property (nonatomic) NSMutableSet<dispatch_source_t> *delayedDispatches;
+
+@property (nonatomic) id<NFCISO7816Tag> tag;
+
+@end
+
+@implementation YKFNFCConnectionController
+
+- (instancetype)initWithNFCTag:(id<NFCISO7816Tag>)tag operationQueue:(NSOperationQueue *)operationQueue {
+    self = [super init];
+    if (self) {
+        self.tag = tag;
+        self.communicationQueue = operationQueue;        
+        self.delayedDispatches = [[NSMutableSet alloc] init];
         
-        YKFLogVerbose(@"Command execution time: %lf seconds", executionTime);
+        // The tag callbacks and timeouts are handled on the communication queue, like the commands were executed before.
+        self.callbackQueue = operationQueue.underlyingQueue ?: dispatch_queue_create("com.yubico.YKCOMNFC.callbacks", DISPATCH_QUEUE_SERIAL);
+    }
+    return self;
+}
+
+#pragma mark - Commands
+
+- (NSUInteger)maxFrameSize {
+    return YKFNFCConnectionMaxFrameSize;
+}
+
+- (void)execute:(nonnull YKFAPDU *)command completion:(nonnull YKFConnectionControllerCommandResponseBlock)completion {
+    [self execute:command timeout:YKFNFCConnectionDefaultTimeout completion:completion];
+}
+
+- (void)execute:(nonnull YKFAPDU *)command timeout:(NSTimeInterval)timeout completion:(nonnull YKFConnectionControllerCommandResponseBlock)completion {
+    YKFParameterAssertReturn(command);
+    YKFParameterAssertReturn(completion);
+    
+    YKFLogVerbose(@"NFCConnectionController - Execute command...");
+    
+    // The queue runs one operation at a time: the next command starts only when this one finishes, from
+    // the tag callback or on timeout, without blocking a thread in the meantime.
+    YKFNFCCommandOperation *operation = [[YKFNFCCommandOperation alloc] initWithTag:self.tag command:command timeout:timeout queue:self.callbackQueue next:^YKFAPDU *(NSData *response, NSError *error, NSTimeInterval executionTime) {
+        completion(response, error, executionTime);
+        return nil;
     }];
+    [self.communicationQueue addOperation:operation];
+}
+
+- (void)executeSequence:(YKFAPDU *)command timeout:(NSTimeInterval)timeout next:(YKFConnectionControllerCommandSequenceBlock)next {
+    YKFParameterAssertReturn(command);
+    YKFParameterAssertReturn(next);
+    
+    YKFLogVerbose(@"NFCConnectionController - Execute command sequence...");
+    
+    YKFNFCCommandOperation *operation = [[YKFNFCCommandOperation alloc] initWithTag:self.tag command:command timeout:timeout
+                                                                              queue:self.callbackQueue next:next];
+    [self.communicationQueue addOperation:operation];
 }
 
 - (void)closeConnectionWithCompletion:(nonnull YKFConnectionControllerCompletionBlock)completion {
@@ -130,12 +300,12 @@ static NSTimeInterval const YKFNFCConnectionDefaultTimeout = 10.0;
     
     [self.communicationQueue cancelAllOperations];
     
-    NSArray *keys = self.delayedDispatches.allKeys;
-    for (NSString *key in keys) {
-        dispatch_block_t block = self.delayedDispatches[key];
-        dispatch_block_cancel(block);
-    };
-    [self.delayedDispatches removeAllObjects];
+    @synchronized (self.delayedDispatches) {
+        for (dispatch_source_t timer in self.delayedDispatches) {
+            dispatch_source_cancel(timer);
+        }
+        [self.delayedDispatches removeAllObjects];
+    }
     
     dispatch_resume(self.communicationQueue.underlyingQueue);
     self.communicationQueue.suspended = NO;
@@ -160,4 +330,35 @@ static NSTimeInterval const YKFNFCConnectionDefaultTimeout = 10.0;
     [self.communicationQueue addOperation:operation];
 }
 
+- (void)dispatchBlockOnCommunicationQueue:(YKFConnectionControllerCommunicationQueueBlock)block delay:(NSTimeInterval)delay {
+    YKFParameterAssertReturn(block);
+    
+    if (delay <= 0) {
+        [self dispatchBlockOnCommunicationQueue:block];
+        return;
+    }
+    
+    dispatch_source_t timer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, self.callbackQueue);
+    dispatch_source_set_timer(timer, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), DISPATCH_TIME_FOREVER, (uint64_t)(0.01 * NSEC_PER_SEC));
+    
+    // The handler retains the timer until it fires or is canceled, which releases the handler.
+    ykf_weak_self();
+    dispatch_source_set_event_handler(timer, ^{
+        dispatch_source_cancel(timer);
+        ykf_safe_strong_self();
+        @synchronized (strongSelf.delayedDispatches) {
+            if (![strongSelf.delayedDispatches containsObject:timer]) {
+                return; // Canceled by cancelAllCommands while firing.
+            }
+            [strongSelf.delayedDispatches removeObject:timer];
+        }
+        [strongSelf dispatchBlockOnCommunicationQueue:block];
+    });
+    
+    @synchronized (self.delayedDispatches) {
+        [self.delayedDispatches addObject:timer];
+    }
+    dispatch_resume(timer);
+}
+
 @end
@@ -13,7 +13,6 @@
 // limitations under the License.
 
 #import "YKFFIDO2GetAssertionAPDU.h"
-#import "YKFCBORType.h"
 #import "YKFCBOREncoder.h"
 #import "YKFAssert.h"
 #import "YKFFIDO2Type.h"
@@ -29,6 +28,9 @@ typedef NS_ENUM(NSUInteger, YKFFIDO2GetAssertionAPDUKey) {
     YKFFIDO2GetAssertionAPDUKeyPinProtocol      = 0x07
 };
 
+static const NSUInteger YKFFIDO2GetAssertionAPDUBaseCapacity = 128;
+static const NSUInteger YKFFIDO2GetAssertionAPDUDescriptorCapacity = 32;
+
 @implementation YKFFIDO2GetAssertionAPDU
 
 - (nullable instancetype)initWithClientDataHash:(NSData *)clientDataHash
@@ -40,45 +42,61 @@ typedef NS_ENUM(NSUInteger, YKFFIDO2GetAssertionAPDUKey) {
     YKFAssertAbortInit(clientDataHash);
     YKFAssertAbortInit(rpId);
     
-    NSMutableDictionary *requestDictionary = [[NSMutableDictionary alloc] init];
+    // The variable length fields, and enough for the others to avoid growing the buffer.
+    NSUInteger capacity = clientDataHash.length + rpId.length + pinAuth.length + YKFFIDO2GetAssertionAPDUBaseCapacity;
+    for (YKFFIDO2PublicKeyCredentialDescriptor *descriptor in allowList) {
+        capacity += descriptor.credentialId.length + YKFFIDO2GetAssertionAPDUDescriptorCapacity;
+    }
+    
+    // The keys are written in increasing order, which is the CTAP2 canonical order.
+    YKFCBORWriter writer;
+    YKFCBORWriterInit(&writer, capacity);
+    YKFCBORWriterBeginMap(&writer);
     
     // RP
-    requestDictionary[YKFCBORInteger(YKFFIDO2GetAssertionAPDUKeyRp)] = YKFCBORTextString(rpId);
+    YKFCBORWriterAppendUnsigned(&writer, YKFFIDO2GetAssertionAPDUKeyRp);
+    [YKFCBOREncoder writeTextString:rpId toWriter:&writer];
     
     // Client Data Hash
-    requestDictionary[YKFCBORInteger(YKFFIDO2GetAssertionAPDUKeyClientDataHash)] = YKFCBORByteString(clientDataHash);
+    YKFCBORWriterAppendUnsigned(&writer, YKFFIDO2GetAssertionAPDUKeyClientDataHash);
+    YKFCBORWriterAppendByteString(&writer, clientDataHash.bytes, clientDataHash.length);
     
     // Allow List
     if (allowList) {
-        NSMutableArray *mutableAllowList = [[NSMutableArray alloc] initWithCapacity:allowList.count];
+        YKFCBORWriterAppendUnsigned(&writer, YKFFIDO2GetAssertionAPDUKeyAllowList);
+        YKFCBORWriterBeginArray(&writer);
         for (YKFFIDO2PublicKeyCredentialDescriptor *credentialDescriptor in allowList) {
-            [mutableAllowList addObject:[credentialDescriptor cborTypeObject]];
+            [credentialDescriptor writeCBORToWriter:&writer];
         }
-        requestDictionary[YKFCBORInteger(YKFFIDO2GetAssertionAPDUKeyAllowList)] = YKFCBORArray(mutableAllowList);
+        YKFCBORWriterEnd(&writer);
     }
     
     // Options
     if (options) {
-        NSMutableDictionary *mutableOptions = [[NSMutableDictionary alloc] initWithCapacity:options.count];
-        NSArray *optionsKeys = options.allKeys;
-        for (NSString *optionKey in optionsKeys) {
+        YKFCBORWriterAppendUnsigned(&writer, YKFFIDO2GetAssertionAPDUKeyOptions);
+        YKFCBORWriterBeginMap(&writer);
+        for (NSString *optionKey in options) {
             NSNumber *value = options[optionKey];
-            mutableOptions[YKFCBORTextString(optionKey)] = YKFCBORBool(value.boolValue);
+            [YKFCBOREncoder writeTextString:optionKey toWriter:&writer];
+            YKFCBORWriterAppendBool(&writer, value.boolValue);
         }
-        requestDictionary[YKFCBORInteger(YKFFIDO2GetAssertionAPDUKeyOptions)] = YKFCBORMap(mutableOptions);
+        YKFCBORWriterEnd(&writer);
     }
 
     // Pin Auth
     if (pinAuth) {
-        requestDictionary[YKFCBORInteger(YKFFIDO2GetAssertionAPDUKeyPinAuth)] = YKFCBORByteString(pinAuth);
+        YKFCBORWriterAppendUnsigned(&writer, YKFFIDO2GetAssertionAPDUKeyPinAuth);
+        YKFCBORWriterAppendByteString(&writer, pinAuth.bytes, pinAuth.length);
     }
 
     // Pin Protocol
     if (pinProtocol) {
-        requestDictionary[YKFCBORInteger(YKFFIDO2GetAssertionAPDUKeyPinProtocol)] = YKFCBORInteger(pinProtocol);
+        YKFCBORWriterAppendUnsigned(&writer, YKFFIDO2GetAssertionAPDUKeyPinProtocol);
+        YKFCBORWriterAppendUnsigned(&writer, pinProtocol);
     }
     
-    NSData *cborData = [YKFCBOREncoder encodeMap:YKFCBORMap(requestDictionary)];
+    YKFCBORWriterEnd(&writer);
+    NSData *cborData = [YKFCBOREncoder dataWithWriter:&writer];
     YKFAssertAbortInit(cborData);
     
     return [super initWithCommand:YKFFIDO2CommandGetAssertion data:cborData];
@@ -30,6 +30,9 @@ typedef NS_ENUM(NSUInteger, YKFFIDO2MakeCredentialAPDUKey) {
     YKFFIDO2MakeCredentialAPDUKeyPinProtocol        = 0x09,
 };
 
+static const NSUInteger YKFFIDO2MakeCredentialAPDUBaseCapacity = 256;
+static const NSUInteger YKFFIDO2MakeCredentialAPDUDescriptorCapacity = 32;
+
 @implementation YKFFIDO2MakeCredentialAPDU
 
 - (nullable instancetype)initWithClientDataHash:(NSData *)clientDataHash
@@ -46,121 +49,76 @@ typedef NS_ENUM(NSUInteger, YKFFIDO2MakeCredentialAPDUKey) {
     YKFAssertAbortInit(user);
     YKFAssertAbortInit(pubKeyCredParams);
     
-    NSMutableDictionary *requestDictionary = [[NSMutableDictionary alloc] init];
+    // The variable length fields, and enough for the others to avoid growing the buffer.
+    NSUInteger capacity = clientDataHash.length + user.userId.length + pinAuth.length + YKFFIDO2MakeCredentialAPDUBaseCapacity;
+    for (YKFFIDO2PublicKeyCredentialDescriptor *descriptor in excludeList) {
+        capacity += descriptor.credentialId.length + YKFFIDO2MakeCredentialAPDUDescriptorCapacity;
+    }
+    
+    // The keys are written in increasing order, which is the CTAP2 canonical order.
+    YKFCBORWriter writer;
+    YKFCBORWriterInit(&writer, capacity);
+    YKFCBORWriterBeginMap(&writer);
     
     // Client Data Hash
-    requestDictionary[YKFCBORInteger(YKFFIDO2MakeCredentialAPDUKeyClientDataHash)] = YKFCBORByteString(clientDataHash);
+    YKFCBORWriterAppendUnsigned(&writer, YKFFIDO2MakeCredentialAPDUKeyClientDataHash);
+    YKFCBORWriterAppendByteString(&writer, clientDataHash.bytes, clientDataHash.length);
     
     // RP
-    requestDictionary[YKFCBORInteger(YKFFIDO2MakeCredentialAPDUKeyRp)] = [rp cborTypeObject];
+    YKFCBORWriterAppendUnsigned(&writer, YKFFIDO2MakeCredentialAPDUKeyRp);
+    [rp writeCBORToWriter:&writer];
     
     // User
-    requestDictionary[YKFCBORInteger(YKFFIDO2MakeCredentialAPDUKeyUser)] = [user cborTypeObject];
+    YKFCBORWriterAppendUnsigned(&writer, YKFFIDO2MakeCredentialAPDUKeyUser);
+    [user writeCBORToWriter:&writer];
     
     // PubKeyCredParams
-    NSMutableArray *mutablePubKeyCredParams = [[NSMutableArray alloc] initWithCapacity:pubKeyCredParams.count];
-    for (YKFFIDO2PublicKeyCredentialType *credentialType in pubKeyCredParams) {
-        [mutablePubKeyCredParams addObject:[credentialType cborTypeObject]];
+    YKFCBORWriterAppendUnsigned(&writer, YKFFIDO2MakeCredentialAPDUKeyPubKeyCredParams);
+    YKFCBORWriterBeginArray(&writer);
+    for (id<YKFFIDO2TypeProtocol> credentialParam in pubKeyCredParams) {
+        [credentialParam writeCBORToWriter:&writer];
     }
-    requestDictionary[YKFCBORInteger(YKFFIDO2MakeCredentialAPDUKeyPubKeyCredParams)] = YKFCBORArray(mutablePubKeyCredParams);
+    YKFCBORWriterEnd(&writer);
     
     // ExcludeList
     if (excludeList) {
-        NSMutableArray *mutableExcludeList = [[NSMutableArray alloc] initWithCapacity:excludeList.count];
+        YKFCBORWriterAppendUnsigned(&writer, YKFFIDO2MakeCredentialAPDUKeyExcludeList);
+        YKFCBORWriterBeginArray(&writer);
         for (YKFFIDO2PublicKeyCredentialDescriptor *descriptor in excludeList) {
-            [mutableExcludeList addObject:[descriptor cborTypeObject]];
+            [descriptor writeCBORToWriter:&writer];
         }
-        requestDictionary[YKFCBORInteger(YKFFIDO2MakeCredentialAPDUKeyExcludeList)] = YKFCBORArray(mutableExcludeList);
+        YKFCBORWriterEnd(&writer);
     }
     
     // Options
     if (options) {
-        NSMutableDictionary *mutableOptions = [[NSMutableDictionary alloc] initWithCapacity:options.count];
-        NSArray *optionsKeys = options.allKeys;
-        for (NSString *optionKey in optionsKeys) {
+        YKFCBORWriterAppendUnsigned(&writer, YKFFIDO2MakeCredentialAPDUKeyOptions);
+        YKFCBORWriterBeginMap(&writer);
+        for (NSString *optionKey in options) {
             NSNumber *value = options[optionKey];
-            mutableOptions[YKFCBORTextString(optionKey)] = YKFCBORBool(value.boolValue);
+            [YKFCBOREncoder writeTextString:optionKey toWriter:&writer];
+            YKFCBORWriterAppendBool(&writer, value.boolValue);
         }
-        requestDictionary[YKFCBORInteger(YKFFIDO2MakeCredentialAPDUKeyOptions)] = YKFCBORMap(mutableOptions);
+        YKFCBORWriterEnd(&writer);
     }
     
     // Pin Auth
     if (pinAuth) {
-        requestDictionary[YKFCBORInteger(YKFFIDO2MakeCredentialAPDUKeyPinAuth)] = YKFCBORByteString(pinAuth);
+        YKFCBORWriterAppendUnsigned(&writer, YKFFIDO2MakeCredentialAPDUKeyPinAuth);
+        YKFCBORWriterAppendByteString(&writer, pinAuth.bytes, pinAuth.length);
     }
     
     // Pin Protocol
     if (pinProtocol) {
-        requestDictionary[YKFCBORInteger(YKFFIDO2MakeCredentialAPDUKeyPinProtocol)] = YKFCBORInteger(pinProtocol);
+        YKFCBORWriterAppendUnsigned(&writer, YKFFIDO2MakeCredentialAPDUKeyPinProtocol);
+        YKFCBORWriterAppendUnsigned(&writer, pinProtocol);
     }
-
-    NSData *cborData = [YKFCBOREncoder encodeMap:YKFCBORMap(requestDictionary)];
-    YKFAssertAbortInit(cborData);
-    
-    return [super initWithCommand:YKFFIDO2CommandMakeCredential data:cborData];
-    
-}
-
-/*
-- (instancetype)initWithRequest:(YKFFIDO2MakeCredentialRequest *)request {
-    YKFAssertAbortInit(request)
-    YKFAssertAbortInit(request.clientDataHash)
-    YKFAssertAbortInit(request.rp)
-    YKFAssertAbortInit(request.user)
-    YKFAssertAbortInit(request.pubKeyCredParams)
-    
-    NSMutableDictionary *requestDictionary = [[NSMutableDictionary alloc] init];
     
-    // Client Data Hash
-    requestDictionary[YKFCBORInteger(YKFFIDO2MakeCredentialAPDUKeyClientDataHash)] = YKFCBORByteString(request.clientDataHash);
-    
-    // RP
-    requestDictionary[YKFCBORInteger(YKFFIDO2MakeCredentialAPDUKeyRp)] = [request.rp cborTypeObject];
-    
-    // User
-    requestDictionary[YKFCBORInteger(YKFFIDO2MakeCredentialAPDUKeyUser)] = [request.user cborTypeObject];
-    
-    // PubKeyCredParams
-    NSMutableArray *pubKeyCredParams = [[NSMutableArray alloc] initWithCapacity:request.pubKeyCredParams.count];
-    for (YKFFIDO2PublicKeyCredentialType *credentialType in request.pubKeyCredParams) {
-        [pubKeyCredParams addObject:[credentialType cborTypeObject]];
-    }
-    requestDictionary[YKFCBORInteger(YKFFIDO2MakeCredentialAPDUKeyPubKeyCredParams)] = YKFCBORArray(pubKeyCredParams);
-    
-    // ExcludeList
-    if (request.excludeList) {
-        NSMutableArray *excludeList = [[NSMutableArray alloc] initWithCapacity:request.excludeList.count];
-        for (YKFFIDO2PublicKeyCredentialDescriptor *descriptor in request.excludeList) {
-            [excludeList addObject:[descriptor cborTypeObject]];
-        }
-        requestDictionary[YKFCBORInteger(YKFFIDO2MakeCredentialAPDUKeyExcludeList)] = YKFCBORArray(excludeList);
-    }
-    
-    // Options
-    if (request.options) {
-        NSMutableDictionary *options = [[NSMutableDictionary alloc] initWithCapacity:request.options.count];
-        NSArray *optionsKeys = request.options.allKeys;
-        for (NSString *optionKey in optionsKeys) {
-            NSNumber *value = request.options[optionKey];
-            options[YKFCBORTextString(optionKey)] = YKFCBORBool(value.boolValue);
-        }
-        requestDictionary[YKFCBORInteger(YKFFIDO2MakeCredentialAPDUKeyOptions)] = YKFCBORMap(options);
-    }
-    
-    // Pin Auth
-    if (request.pinAuth) {
-        requestDictionary[YKFCBORInteger(YKFFIDO2MakeCredentialAPDUKeyPinAuth)] = YKFCBORByteString(request.pinAuth);
-    }
-    
-    // Pin Protocol
-    if (request.pinProtocol) {
-        requestDictionary[YKFCBORInteger(YKFFIDO2MakeCredentialAPDUKeyPinProtocol)] = YKFCBORInteger(request.pinProtocol);
-    }
-
-    NSData *cborData = [YKFCBOREncoder encodeMap:YKFCBORMap(requestDictionary)];
+    YKFCBORWriterEnd(&writer);
+    NSData *cborData = [YKFCBOREncoder dataWithWriter:&writer];
     YKFAssertAbortInit(cborData);
     
     return [super initWithCommand:YKFFIDO2CommandMakeCredential data:cborData];
-}*/
+}
 
 @end
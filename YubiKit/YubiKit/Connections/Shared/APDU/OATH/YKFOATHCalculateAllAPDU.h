@@ -21,8 +21,15 @@ NS_ASSUME_NONNULL_BEGIN
 
 /*
  Note: Timestamp is passed to make sure the same exact timestamp is shared between the request and the response.
+ The challenge is calculated for the default period of 30 seconds.
  */
-- (nullable instancetype)initWithTimestamp:(nonnull NSDate *)timestamp NS_DESIGNATED_INITIALIZER;
+- (nullable instancetype)initWithTimestamp:(nonnull NSDate *)timestamp;
+
+/*
+ The key uses the same challenge for all TOTP credentials, so only the codes of the credentials with the
+ specified period are valid in the response.
+ */
+- (nullable instancetype)initWithTimestamp:(nonnull NSDate *)timestamp period:(NSUInteger)period NS_DESIGNATED_INITIALIZER;
 - (instancetype)init NS_UNAVAILABLE;
 
 @end
@@ -16,20 +16,26 @@
 #import "YKFAPDUCommandInstruction.h"
 #import "YKFNSMutableDataAdditions.h"
 #import "YKFAssert.h"
+#import "YKFOATHCredentialTypes.h"
 
 static const UInt8 YKFOATHCalculateAllAPDUChallengeTag = 0x74;
 
 @implementation YKFOATHCalculateAllAPDU
 
 - (instancetype)initWithTimestamp:(NSDate *)timestamp {
+    return [self initWithTimestamp:timestamp period:YKFOATHCredentialDefaultPeriod];
+}
+
+- (instancetype)initWithTimestamp:(NSDate *)timestamp period:(NSUInteger)period {
     YKFAssertAbortInit(timestamp)
+    YKFAssertAbortInit(period > 0)
     
     NSMutableData *rawRequest = [[NSMutableData alloc] init];
     
     // Challenge
     
     time_t time = (time_t)[timestamp timeIntervalSince1970];
-    time_t challengeTime = time / 30; // Calculate all assumes only 30s TOTPs
+    time_t challengeTime = time / period;
     
     [rawRequest ykf_appendUInt64EntryWithTag:YKFOATHCalculateAllAPDUChallengeTag value:challengeTime];
     
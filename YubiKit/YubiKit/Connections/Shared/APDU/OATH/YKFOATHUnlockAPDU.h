@@ -23,7 +23,13 @@ NS_ASSUME_NONNULL_BEGIN
 
 @property (nonatomic, nullable) NSData *expectedChallengeData;
 
-- (nullable instancetype)initWithPassword:(NSString *)code challenge:(NSData *)challenge salt:(NSData *)salt NS_DESIGNATED_INITIALIZER;
+- (nullable instancetype)initWithPassword:(NSString *)code challenge:(NSData *)challenge salt:(NSData *)salt;
+
+/*
+ The access key is the key derived from the password with the salt, which allows to skip the derivation
+ when the key is already known.
+ */
+- (nullable instancetype)initWithAccessKey:(NSData *)accessKey challenge:(NSData *)challenge NS_DESIGNATED_INITIALIZER;
 - (instancetype)init NS_UNAVAILABLE;
 
 @end
@@ -26,12 +26,17 @@ static const UInt8 YKFOATHSetCodeAPDUResponseTag = 0x75;
 
 - (nullable instancetype)initWithPassword:(nonnull NSString *)password challenge:(NSData *)challenge salt:(NSData *)salt {
     YKFAssertAbortInit(password);
-    YKFAssertAbortInit(challenge);
     YKFAssertAbortInit(salt.length);
     
-    NSMutableData *data = [[NSMutableData alloc] init];
-    
     NSData *keyData = [[password dataUsingEncoding:NSUTF8StringEncoding] ykf_deriveOATHKeyWithSalt:salt];
+    return [self initWithAccessKey:keyData challenge:challenge];
+}
+
+- (nullable instancetype)initWithAccessKey:(NSData *)keyData challenge:(NSData *)challenge {
+    YKFAssertAbortInit(keyData.length);
+    YKFAssertAbortInit(challenge);
+    
+    NSMutableData *data = [[NSMutableData alloc] init];
     
     // Response (hmac of the select challenge)
     
@@ -24,4 +24,15 @@ The APDU raw data.
 */
 @property (nonatomic, readonly) NSData *apduData;
 
+/*!
+ The command parameters. The header fields of an APDU created from pre-built data are read from its first bytes,
+ and the command data is nil.
+ */
+@property (nonatomic, readonly) UInt8 cla;
+@property (nonatomic, readonly) UInt8 ins;
+@property (nonatomic, readonly) UInt8 p1;
+@property (nonatomic, readonly) UInt8 p2;
+@property (nonatomic, readonly) NSData *commandData;
+@property (nonatomic, readonly) YKFAPDUType type;
+
 @end
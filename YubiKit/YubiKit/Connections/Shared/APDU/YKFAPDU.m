@@ -17,11 +17,26 @@
 #import "YKFNSMutableDataAdditions.h"
 #import "YKFAssert.h"
 
+static NSUInteger const YKFAPDUFrameHeadroom = 1; // byte, the YLP iAP2 signal in front of the APDU
+static NSUInteger const YKFAPDUHeaderSize = 4;    // bytes, CLA INS P1 P2
+
 @interface YKFAPDU()
 
-@property (nonatomic, readwrite) NSData *ylpApduData;
+// The APDU preceded by the YLP iAP2 signal, the single buffer of the APDUs created from parameters.
+@property (nonatomic, readwrite) NSData *frame;
+@property (nonatomic, assign) NSRange commandDataRange;
+
+// The view of the APDU in the frame, created once for the APDUs created from parameters.
+@property (nonatomic) NSData *frameApduView;
+
 @property (nonatomic, readwrite) NSData *apduData;
 
+@property (nonatomic, readwrite) UInt8 cla;
+@property (nonatomic, readwrite) UInt8 ins;
+@property (nonatomic, readwrite) UInt8 p1;
+@property (nonatomic, readwrite) UInt8 p2;
+@property (nonatomic, readwrite) YKFAPDUType type;
+
 @end
 
 @implementation YKFAPDU
@@ -37,6 +52,12 @@
     
     self = [super init];
     if (self) {
+        self.cla = cla;
+        self.ins = ins;
+        self.p1 = p1;
+        self.p2 = p2;
+        self.type = type;
+        
         switch (type) {
             case YKFAPDUTypeShort:
                 [self setupApduWithCla:cla ins:ins p1:p1 p2:p2 data:data];
@@ -51,70 +72,117 @@
 }
 
 - (void)setupApduWithCla:(UInt8)cla ins:(UInt8)ins p1:(UInt8)p1 p2:(UInt8)p2 data:(NSData*)data {
-    NSMutableData *command = [[NSMutableData alloc] init];
+    NSUInteger lengthSize = data.length ? 1 : 0;
+    UInt8 *bytes = [self allocateFrameWithCla:cla ins:ins p1:p1 p2:p2 lengthSize:lengthSize data:data];
     
-    [command ykf_appendByte:cla];   // APDU CLA
-    [command ykf_appendByte:ins];   // APDU INS
-    [command ykf_appendByte:p1];    // APDU P1
-    [command ykf_appendByte:p2];    // APDU P2
+    if (bytes && data.length) {
+        bytes[0] = data.length; // LenLc
+    }
+}
 
-    if (data.length) {
-        UInt8 length = data.length;
-        [command ykf_appendByte:length];    // LenLc
-        [command appendData:data];          // Data
+- (void)setupExtendedApduWithCla:(UInt8)cla ins:(UInt8)ins p1:(UInt8)p1 p2:(UInt8)p2 data:(NSData *)data {
+    UInt8 *bytes = [self allocateFrameWithCla:cla ins:ins p1:p1 p2:p2 lengthSize:3 data:data];
+    if (!bytes) {
+        return;
     }
     
-    self.apduData = [command copy];
-    
-    NSMutableData *ylpCommand = [[NSMutableData alloc] initWithCapacity:command.length + 1];
-    [ylpCommand ykf_appendByte:0x00]; // YLP iAP2 Signal
-    [ylpCommand appendData:command];
-    self.ylpApduData = [ylpCommand copy];
-    
+    bytes[0] = 0x00;                // APDU Zero
+    bytes[1] = data.length / 256;   // LenH
+    bytes[2] = data.length % 256;   // LenL
 }
 
-- (void)setupExtendedApduWithCla:(UInt8)cla ins:(UInt8)ins p1:(UInt8)p1 p2:(UInt8)p2 data:(NSData *)data {
-    NSMutableData *command = [[NSMutableData alloc] init];
+/*
+ Encodes the header and the data in a single buffer, with one byte of headroom for the YLP iAP2 signal.
+ Returns a pointer to the length bytes, which are filled by the caller.
+ */
+- (UInt8 *)allocateFrameWithCla:(UInt8)cla ins:(UInt8)ins p1:(UInt8)p1 p2:(UInt8)p2 lengthSize:(NSUInteger)lengthSize data:(NSData *)data {
+    NSUInteger dataOffset = YKFAPDUFrameHeadroom + YKFAPDUHeaderSize + lengthSize;
+    NSUInteger frameLength = dataOffset + data.length;
     
-    [command ykf_appendByte:cla];   // APDU CLA
-    [command ykf_appendByte:ins];   // APDU INS
-    [command ykf_appendByte:p1];    // APDU P1
-    [command ykf_appendByte:p2];    // APDU P2
+    UInt8 *bytes = malloc(frameLength);
+    YKFAssertReturnValue(bytes, @"Could not allocate the APDU buffer.", NULL);
     
+    bytes[0] = 0x00; // YLP iAP2 Signal
+    bytes[1] = cla;  // APDU CLA
+    bytes[2] = ins;  // APDU INS
+    bytes[3] = p1;   // APDU P1
+    bytes[4] = p2;   // APDU P2
     if (data.length) {
-        UInt8 lengthHigh = data.length / 256;
-        UInt8 lengthLow = data.length % 256;
-        [command ykf_appendByte:0x00];           // APDU Zero
-        [command ykf_appendByte:lengthHigh];     // LenH
-        [command ykf_appendByte:lengthLow];      // LenL
-        [command appendData:data];               // Data
-    } else {
-        [command ykf_appendByte:0x00];           // APDU Zero
-        [command ykf_appendByte:0x00];           // LenH
-        [command ykf_appendByte:0x00];           // LenL
+        memcpy(bytes + dataOffset, data.bytes, data.length); // Data
     }
     
-    self.apduData = [command copy];
+    self.frame = [[NSData alloc] initWithBytesNoCopy:bytes length:frameLength freeWhenDone:YES];
+    self.commandDataRange = NSMakeRange(dataOffset, data.length);
     
-    NSMutableData *ylpCommand = [[NSMutableData alloc] initWithCapacity:command.length + 1];
-    [ylpCommand ykf_appendByte:0x00]; // YLP iAP2 Signal
-    [ylpCommand appendData:command];
-    self.ylpApduData = [ylpCommand copy];
+    return bytes + YKFAPDUFrameHeadroom + YKFAPDUHeaderSize;
 }
 
 - (nullable instancetype)initWithData:(nonnull NSData *)data {
     YKFAssertAbortInit(data.length);
     self = [super init];
     if (self) {
+        // The YLP frame is built on demand, only the accessory connection uses it.
         self.apduData = [data copy];
-        
-        // Append the YLP iAP2 Signal for the ylpApduData.
-        NSMutableData *tempBuffer = [[NSMutableData alloc] initWithCapacity:data.length + 1];
-        [tempBuffer ykf_appendByte:0x00];
-        [tempBuffer appendData:data];
-        self.ylpApduData = [tempBuffer copy];
+        if (self.apduData.length >= YKFAPDUHeaderSize) {
+            const UInt8 *bytes = self.apduData.bytes;
+            self.cla = bytes[0];
+            self.ins = bytes[1];
+            self.p1 = bytes[2];
+            self.p2 = bytes[3];
+        }
     }
     return self;
 }
 
+#pragma mark - Views
+
+- (NSData *)apduData {
+    if (_apduData) {
+        return _apduData;
+    }
+    @synchronized (self) {
+        if (!self.frameApduView) {
+            self.frameApduView = [self viewOfFrameInRange:NSMakeRange(YKFAPDUFrameHeadroom, self.frame.length - YKFAPDUFrameHeadroom)];
+        }
+        return self.frameApduView;
+    }
+}
+
+- (NSData *)ylpApduData {
+    if (!_apduData) {
+        return self.frame;
+    }
+    
+    // Pre-built APDU: append the YLP iAP2 Signal on demand.
+    @synchronized (self) {
+        if (!self.frame) {
+            NSMutableData *tempBuffer = [[NSMutableData alloc] initWithCapacity:_apduData.length + YKFAPDUFrameHeadroom];
+            [tempBuffer ykf_appendByte:0x00];
+            [tempBuffer appendData:_apduData];
+            self.frame = tempBuffer;
+        }
+        return self.frame;
+    }
+}
+
+- (NSData *)commandData {
+    if (_apduData) {
+        return nil;
+    }
+    if (!self.commandDataRange.length) {
+        return [NSData data];
+    }
+    return [self viewOfFrameInRange:self.commandDataRange];
+}
+
+/*
+ Returns a no-copy view over a range of the frame. The view keeps the frame alive, it can outlive the APDU.
+ */
+- (NSData *)viewOfFrameInRange:(NSRange)range {
+    NSData *frame = self.frame;
+    return [[NSData alloc] initWithBytesNoCopy:(UInt8 *)frame.bytes + range.location length:range.length deallocator:^(void *bytes, NSUInteger length) {
+        (void)frame;
+    }];
+}
+
 @end
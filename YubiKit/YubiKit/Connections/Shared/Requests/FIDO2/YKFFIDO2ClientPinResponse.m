@@ -35,12 +35,7 @@ typedef NS_ENUM(NSUInteger, YKFFIDO2ClientPinResponseKey) {
 - (nullable instancetype)initWithCBORData:(NSData *)cborData {
     self = [super init];
     if (self) {
-        YKFCBORMap *responseMap = nil;
-        
-        NSInputStream *decoderInputStream = [[NSInputStream alloc] initWithData:cborData];
-        [decoderInputStream open];
-        responseMap = [YKFCBORDecoder decodeObjectFrom:decoderInputStream];
-        [decoderInputStream close];
+        YKFCBORMap *responseMap = [YKFCBORDecoder decodeObjectFromData:cborData];
         
         YKFAssertAbortInit(responseMap);
         
@@ -14,7 +14,7 @@
 
 #import "YKFFIDO2GetAssertionResponse.h"
 #import "YKFFIDO2GetAssertionResponse+Private.h"
-#import "YKFCBORDecoder.h"
+#import "YKFCBORMapView.h"
 #import "YKFFIDO2Type.h"
 #import "YKFAssert.h"
 
@@ -36,6 +36,12 @@ typedef NS_ENUM(NSUInteger, YKFFIDO2GetAssertionResponseKey) {
 
 @property (nonatomic, readwrite) NSData *rawResponse;
 
+// The optional structures are decoded from the response when they are used.
+@property (nonatomic) YKFCBORMapView *responseView;
+
+// The keys already decoded, including the ones which are missing or have another type.
+@property (nonatomic) NSMutableIndexSet *decodedKeys;
+
 @end
 
 @implementation YKFFIDO2GetAssertionResponse
@@ -46,75 +52,61 @@ typedef NS_ENUM(NSUInteger, YKFFIDO2GetAssertionResponseKey) {
         YKFAssertAbortInit(cborData);
         self.rawResponse = cborData;
         
-        YKFCBORMap *responseMap = nil;
-        
-        NSInputStream *decoderInputStream = [[NSInputStream alloc] initWithData:cborData];
-        [decoderInputStream open];
-        responseMap = [YKFCBORDecoder decodeObjectFrom:decoderInputStream];
-        [decoderInputStream close];
+        YKFCBORMapView *responseView = [[YKFCBORMapView alloc] initWithData:cborData];
         
-        YKFAssertAbortInit(responseMap);
+        YKFAssertAbortInit(responseView);
+        self.responseView = responseView;
+        self.decodedKeys = [[NSMutableIndexSet alloc] init];
         
-        BOOL success = [self parseResponseMap: responseMap];
+        BOOL success = [self parseResponseView:responseView];
         YKFAssertAbortInit(success);
     }
     return self;
 }
 
-#pragma mark - Private
+#pragma mark - Lazy Properties
 
-- (BOOL)parseResponseMap:(YKFCBORMap *)map {
-    id convertedObject = [YKFCBORDecoder convertCBORObjectToFoundationType:map];
-    if (!convertedObject || ![convertedObject isKindOfClass:NSDictionary.class]) {
-        return NO;
+- (YKFFIDO2PublicKeyCredentialDescriptor *)credential {
+    @synchronized (self) {
+        if (![self.decodedKeys containsIndex:YKFFIDO2GetAssertionResponseKeyCredential]) {
+            [self.decodedKeys addIndex:YKFFIDO2GetAssertionResponseKeyCredential];
+            id responseCredential = [self.responseView objectForKey:YKFFIDO2GetAssertionResponseKeyCredential];
+            if ([responseCredential isKindOfClass:NSDictionary.class]) {
+                _credential = [self credentialFromResponseCredential:responseCredential];
+            }
+        }
+        return _credential;
     }
-    NSDictionary *response = (NSDictionary *)convertedObject;
-    
-    // Credential    
-    NSDictionary *responseCredential = response[@(YKFFIDO2GetAssertionResponseKeyCredential)];
-    if (responseCredential) {
-        YKFFIDO2PublicKeyCredentialDescriptor *credentialDescriptor = [[YKFFIDO2PublicKeyCredentialDescriptor alloc] init];
-        credentialDescriptor.credentialId = responseCredential[@"id"];
-        
-        YKFFIDO2PublicKeyCredentialType *credentialType = [[YKFFIDO2PublicKeyCredentialType alloc] init];
-        credentialType.name = responseCredential[@"type"];
-        credentialDescriptor.credentialType = credentialType;
-        
-        NSArray *responseTransports = responseCredential[@"transports"];
-        NSMutableArray *transports = [[NSMutableArray alloc] initWithCapacity:responseTransports.count];
-        for (NSString *responseTransport in responseTransports) {
-            YKFFIDO2AuthenticatorTransport *transport = [[YKFFIDO2AuthenticatorTransport alloc] init];
-            transport.name = responseTransport;
-            [transports addObject: transport];
+}
+
+- (YKFFIDO2PublicKeyCredentialUserEntity *)user {
+    @synchronized (self) {
+        if (![self.decodedKeys containsIndex:YKFFIDO2GetAssertionResponseKeyUser]) {
+            [self.decodedKeys addIndex:YKFFIDO2GetAssertionResponseKeyUser];
+            id responseUser = [self.responseView objectForKey:YKFFIDO2GetAssertionResponseKeyUser];
+            if ([responseUser isKindOfClass:NSDictionary.class]) {
+                _user = [self userFromResponseUser:responseUser];
+            }
         }
-        credentialDescriptor.credentialTransports = transports;
-        
-        self.credential = credentialDescriptor;
+        return _user;
     }
+}
 
+#pragma mark - Private
+
+- (BOOL)parseResponseView:(YKFCBORMapView *)view {
     // Auth Data
-    NSData *authData = response[@(YKFFIDO2GetAssertionResponseKeyAuthData)];    
+    NSData *authData = [view byteStringForKey:YKFFIDO2GetAssertionResponseKeyAuthData];
     YKFAssertReturnValue(authData, @"authenticatorGetAssertion authData is required.", NO);
     self.authData = authData;
     
     // Signature
-    NSData *signature = response[@(YKFFIDO2GetAssertionResponseKeySignature)];
+    NSData *signature = [view byteStringForKey:YKFFIDO2GetAssertionResponseKeySignature];
     YKFAssertReturnValue(signature, @"authenticatorGetAssertion signature is required.", NO);
     self.signature = signature;
     
-    // User
-    NSDictionary *responseUser = response[@(YKFFIDO2GetAssertionResponseKeyUser)];
-    if (responseUser) {
-        YKFFIDO2PublicKeyCredentialUserEntity *user = [[YKFFIDO2PublicKeyCredentialUserEntity alloc] init];
-        user.userId = responseUser[@"id"];
-        user.userName = responseUser[@"name"];
-        user.userDisplayName = responseUser[@"displayName"];
-        user.userIcon = responseUser[@"icon"];
-        self.user = user;
-    }
-    
     // Number Of Credentials
-    NSNumber *numberOfCredentials = response[@(YKFFIDO2GetAssertionResponseKeyNumberOfCredentials)];
+    NSNumber *numberOfCredentials = [view integerForKey:YKFFIDO2GetAssertionResponseKeyNumberOfCredentials];
     if (numberOfCredentials != nil) {
         self.numberOfCredentials = numberOfCredentials.integerValue;
     }
@@ -122,4 +114,33 @@ typedef NS_ENUM(NSUInteger, YKFFIDO2GetAssertionResponseKey) {
     return YES;
 }
 
+- (YKFFIDO2PublicKeyCredentialDescriptor *)credentialFromResponseCredential:(NSDictionary *)responseCredential {
+    YKFFIDO2PublicKeyCredentialDescriptor *credentialDescriptor = [[YKFFIDO2PublicKeyCredentialDescriptor alloc] init];
+    credentialDescriptor.credentialId = responseCredential[@"id"];
+    
+    YKFFIDO2PublicKeyCredentialType *credentialType = [[YKFFIDO2PublicKeyCredentialType alloc] init];
+    credentialType.name = responseCredential[@"type"];
+    credentialDescriptor.credentialType = credentialType;
+    
+    NSArray *responseTransports = responseCredential[@"transports"];
+    NSMutableArray *transports = [[NSMutableArray alloc] initWithCapacity:responseTransports.count];
+    for (NSString *responseTransport in responseTransports) {
+        YKFFIDO2AuthenticatorTransport *transport = [[YKFFIDO2AuthenticatorTransport alloc] init];
+        transport.name = responseTransport;
+        [transports addObject: transport];
+    }
+    credentialDescriptor.credentialTransports = transports;
+    
+    return credentialDescriptor;
+}
+
+- (YKFFIDO2PublicKeyCredentialUserEntity *)userFromResponseUser:(NSDictionary *)responseUser {
+    YKFFIDO2PublicKeyCredentialUserEntity *user = [[YKFFIDO2PublicKeyCredentialUserEntity alloc] init];
+    user.userId = responseUser[@"id"];
+    user.userName = responseUser[@"name"];
+    user.userDisplayName = responseUser[@"displayName"];
+    user.userIcon = responseUser[@"icon"];
+    return user;
+}
+
 @end
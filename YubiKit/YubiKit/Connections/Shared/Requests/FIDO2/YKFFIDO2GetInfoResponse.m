@@ -14,7 +14,7 @@
 
 #import "YKFFIDO2GetInfoResponse.h"
 #import "YKFFIDO2GetInfoResponse+Private.h"
-#import "YKFCBORDecoder.h"
+#import "YKFCBORMapView.h"
 #import "YKFAssert.h"
 
 NSString* const YKFFIDO2GetInfoResponseOptionClientPin = @"clientPin";
@@ -41,6 +41,12 @@ typedef NS_ENUM(NSUInteger, YKFFIDO2GetInfoResponseKey) {
 @property (nonatomic, assign, readwrite) NSUInteger maxMsgSize;
 @property (nonatomic, readwrite) NSArray *pinProtocols;
 
+// The arrays and the maps are decoded from the response when they are used.
+@property (nonatomic) YKFCBORMapView *responseView;
+
+// The keys already decoded, including the ones which are missing or have another type.
+@property (nonatomic) NSMutableIndexSet *decodedKeys;
+
 @end
 
 @implementation YKFFIDO2GetInfoResponse
@@ -48,57 +54,81 @@ typedef NS_ENUM(NSUInteger, YKFFIDO2GetInfoResponseKey) {
 - (instancetype)initWithCBORData:(NSData *)cborData {
     self = [super init];
     if (self) {
-        YKFCBORMap *getInfoMap = nil;
-        
-        NSInputStream *decoderInputStream = [[NSInputStream alloc] initWithData:cborData];
-        [decoderInputStream open];
-        getInfoMap = [YKFCBORDecoder decodeObjectFrom:decoderInputStream];
-        [decoderInputStream close];
+        YKFCBORMapView *responseView = [[YKFCBORMapView alloc] initWithData:cborData];
         
-        YKFAssertAbortInit(getInfoMap);
+        YKFAssertAbortInit(responseView);
+        self.responseView = responseView;
+        self.decodedKeys = [[NSMutableIndexSet alloc] init];
         
-        BOOL success = [self parseResponseMap:getInfoMap];
+        BOOL success = [self parseResponseView:responseView];
         YKFAssertAbortInit(success);
     }
     return self;
 }
 
-#pragma mark - Private
+#pragma mark - Lazy Properties
 
-- (BOOL)parseResponseMap:(YKFCBORMap *)map {
-    id convertedObject = [YKFCBORDecoder convertCBORObjectToFoundationType:map];
-    if (!convertedObject || ![convertedObject isKindOfClass:NSDictionary.class]) {
-        return NO;
+- (NSArray *)versions {
+    @synchronized (self) {
+        if (![self.decodedKeys containsIndex:YKFFIDO2GetInfoResponseKeyVersions]) {
+            _versions = [self objectOfClass:NSArray.class forKey:YKFFIDO2GetInfoResponseKeyVersions];
+        }
+        return _versions;
     }
-    NSDictionary *response = (NSDictionary *)convertedObject;
-    
-    // versions
-    NSArray *versions = response[@(YKFFIDO2GetInfoResponseKeyVersions)];
-    YKFAssertReturnValue(versions, @"authenticatorGetInfo versions is required.", NO);
-    self.versions = versions;
-    
-    // extensions
-    self.extensions = response[@(YKFFIDO2GetInfoResponseKeyExtensions)];
+}
+
+- (NSArray *)extensions {
+    @synchronized (self) {
+        if (![self.decodedKeys containsIndex:YKFFIDO2GetInfoResponseKeyExtensions]) {
+            _extensions = [self objectOfClass:NSArray.class forKey:YKFFIDO2GetInfoResponseKeyExtensions];
+        }
+        return _extensions;
+    }
+}
+
+- (NSDictionary *)options {
+    @synchronized (self) {
+        if (![self.decodedKeys containsIndex:YKFFIDO2GetInfoResponseKeyOptions]) {
+            _options = [self objectOfClass:NSDictionary.class forKey:YKFFIDO2GetInfoResponseKeyOptions];
+        }
+        return _options;
+    }
+}
+
+- (NSArray *)pinProtocols {
+    @synchronized (self) {
+        if (![self.decodedKeys containsIndex:YKFFIDO2GetInfoResponseKeyPinProtocols]) {
+            _pinProtocols = [self objectOfClass:NSArray.class forKey:YKFFIDO2GetInfoResponseKeyPinProtocols];
+        }
+        return _pinProtocols;
+    }
+}
+
+#pragma mark - Private
+
+- (BOOL)parseResponseView:(YKFCBORMapView *)view {
+    // versions, decoded when used
+    YKFAssertReturnValue([view containsArrayForKey:YKFFIDO2GetInfoResponseKeyVersions], @"authenticatorGetInfo versions is required.", NO);
     
     // aaguid
-    NSData *aaguid = response[@(YKFFIDO2GetInfoResponseKeyAAGUID)];
+    NSData *aaguid = [view byteStringForKey:YKFFIDO2GetInfoResponseKeyAAGUID];
     YKFAssertReturnValue(aaguid, @"authenticatorGetInfo aaguid is required.", NO);
     YKFAssertReturnValue(aaguid.length == 16, @"authenticatorGetInfo aaguid has the wrong value.", NO);
     self.aaguid = aaguid;
     
-    // options
-    self.options = response[@(YKFFIDO2GetInfoResponseKeyOptions)];
-    
     // maxMsgSize
-    NSNumber *maxMsgSize = response[@(YKFFIDO2GetInfoResponseKeyMaxMsgSize)];
+    NSNumber *maxMsgSize = [view integerForKey:YKFFIDO2GetInfoResponseKeyMaxMsgSize];
     if (maxMsgSize != nil) {
         self.maxMsgSize = maxMsgSize.integerValue;
     }
     
-    // pin protocols
-    self.pinProtocols = response[@(YKFFIDO2GetInfoResponseKeyPinProtocols)];
-        
     return YES;
 }
 
+- (id)objectOfClass:(Class)objectClass forKey:(NSUInteger)key {
+    [self.decodedKeys addIndex:key];
+    id object = [self.responseView objectForKey:key];
+    return [object isKindOfClass:objectClass] ? object : nil;
+}
+
 @end
@@ -14,7 +14,7 @@
 
 #import "YKFFIDO2MakeCredentialResponse.h"
 #import "YKFFIDO2MakeCredentialResponse+Private.h"
-#import "YKFCBORDecoder.h"
+#import "YKFCBORMapView.h"
 #import "YKFCBOREncoder.h"
 #import "YKFAssert.h"
 
@@ -24,6 +24,9 @@ typedef NS_ENUM(NSUInteger, YKFFIDO2MakeCredentialResponseKey) {
     YKFFIDO2GetInfoResponseKeyAttStmt    = 0x03
 };
 
+// The map head and the three text keys of the WebAuthN attestation object.
+static const NSUInteger YKFFIDO2MakeCredentialResponseKeysLength = 1 + 4 + 8 + 9;
+
 typedef NS_ENUM(NSUInteger, YKFFIDO2AuthenticatorDataFlag) {
     YKFFIDO2AuthenticatorDataFlagUserPresent    = 0x01,
     YKFFIDO2AuthenticatorDataFlagUserVerified   = 0x04,
@@ -31,8 +34,6 @@ typedef NS_ENUM(NSUInteger, YKFFIDO2AuthenticatorDataFlag) {
     YKFFIDO2AuthenticatorDataFlagExtensionData  = 0x80
 };
 
-static NSString* const YKFFIDO2MakeCredentialResponsePackedAttStmtFmt = @"packed";
-
 @interface YKFFIDO2AuthenticatorData()
 
 @property (nonatomic, readwrite) NSData *rpIdHash;
@@ -69,68 +70,61 @@ static NSString* const YKFFIDO2MakeCredentialResponsePackedAttStmtFmt = @"packed
         self.rawResponse = cborData;
         self.ctapAttestationObject = cborData;
         
-        YKFCBORMap *attestationMap = nil;
-        
-        NSInputStream *decoderInputStream = [[NSInputStream alloc] initWithData:cborData];
-        [decoderInputStream open];
-        attestationMap = [YKFCBORDecoder decodeObjectFrom:decoderInputStream];
-        [decoderInputStream close];
+        YKFCBORMapView *attestationView = [[YKFCBORMapView alloc] initWithData:cborData];
         
-        YKFAssertAbortInit(attestationMap);
+        YKFAssertAbortInit(attestationView);
         
-        BOOL success = [self parseAttestationMap: attestationMap];
+        BOOL success = [self parseAttestationView:attestationView];
         YKFAssertAbortInit(success);
         
-        success = [self buildWebAuthnAttestationObjectFromMap:attestationMap];
+        success = [self buildWebAuthnAttestationObjectFromView:attestationView];
         YKFAssertAbortInit(success);
     }
     return self;
 }
 
-- (BOOL)parseAttestationMap:(YKFCBORMap *)map {
-    id convertedObject = [YKFCBORDecoder convertCBORObjectToFoundationType:map];
-    if (!convertedObject || ![convertedObject isKindOfClass:NSDictionary.class]) {
-        return NO;
-    }
-    NSDictionary *response = (NSDictionary *)convertedObject;
-    
+- (BOOL)parseAttestationView:(YKFCBORMapView *)view {
     // Auth Data
-    NSData *authData = response[@(YKFFIDO2GetInfoResponseKeyAuthData)];
+    NSData *authData = [view byteStringForKey:YKFFIDO2GetInfoResponseKeyAuthData];
     YKFAssertReturnValue(authData, @"authenticatorMakeCredential authData is required.", NO);
     self.authData = authData;
 
     // Fmt
-    NSString *fmt = response[@(YKFFIDO2GetInfoResponseKeyFmt)];
+    NSString *fmt = [view textStringForKey:YKFFIDO2GetInfoResponseKeyFmt];
     YKFAssertReturnValue(fmt, @"authenticatorMakeCredential fmt is required.", NO);
     self.fmt = fmt;
 
-    // AttStmt
-    if ([fmt isEqualToString:YKFFIDO2MakeCredentialResponsePackedAttStmtFmt]) {
-        YKFCBORMap *attStmtMap = map.value[YKFCBORInteger(YKFFIDO2GetInfoResponseKeyAttStmt)];
-        self.attStmt = [YKFCBOREncoder encodeMap:attStmtMap];
-    } else {
-        self.attStmt = response[@(YKFFIDO2GetInfoResponseKeyAttStmt)];
-    }
-    YKFAssertReturnValue(self.attStmt, @"authenticatorGetInfo attStmt is required.", NO);
+    // AttStmt, kept encoded for all the formats since the client treats it as an opaque object.
+    NSData *attStmt = [view encodedValueForKey:YKFFIDO2GetInfoResponseKeyAttStmt];
+    YKFAssertReturnValue(attStmt, @"authenticatorGetInfo attStmt is required.", NO);
+    self.attStmt = attStmt;
 
     return YES;
 }
 
-- (BOOL)buildWebAuthnAttestationObjectFromMap:(YKFCBORMap *)map {
-    id authData = map.value[YKFCBORInteger(YKFFIDO2GetInfoResponseKeyAuthData)];
-    YKFAssertReturnValue(authData, @"authenticatorGetInfo authData is required.", NO);
+/*
+ The WebAuthN attestation object has the same values with text keys. The encoded values are copied from the
+ response as received, without decoding and encoding them again.
+ */
+- (BOOL)buildWebAuthnAttestationObjectFromView:(YKFCBORMapView *)view {
+    NSData *authData = [view encodedValueForKey:YKFFIDO2GetInfoResponseKeyAuthData];
+    NSData *fmt = [view encodedValueForKey:YKFFIDO2GetInfoResponseKeyFmt];
+    NSData *attStmt = [view encodedValueForKey:YKFFIDO2GetInfoResponseKeyAttStmt];
+    YKFAssertReturnValue(authData && fmt && attStmt, @"authenticatorMakeCredential authData, fmt and attStmt are required.", NO);
     
-    id fmt = map.value[YKFCBORInteger(YKFFIDO2GetInfoResponseKeyFmt)];
-    YKFAssertReturnValue(fmt, @"authenticatorGetInfo fmt is required.", NO);
-    
-    id attStmt = map.value[YKFCBORInteger(YKFFIDO2GetInfoResponseKeyAttStmt)];
-    YKFAssertReturnValue(attStmt, @"authenticatorGetInfo attStmt is required.", NO);
+    // The keys are written in the CTAP2 canonical order: fmt, attStmt, authData.
+    YKFCBORWriter writer;
+    YKFCBORWriterInit(&writer, fmt.length + attStmt.length + authData.length + YKFFIDO2MakeCredentialResponseKeysLength);
+    YKFCBORWriterBeginMap(&writer);
+    YKFCBORWriterAppendTextString(&writer, "fmt", 3);
+    YKFCBORWriterAppendEncoded(&writer, fmt.bytes, fmt.length);
+    YKFCBORWriterAppendTextString(&writer, "attStmt", 7);
+    YKFCBORWriterAppendEncoded(&writer, attStmt.bytes, attStmt.length);
+    YKFCBORWriterAppendTextString(&writer, "authData", 8);
+    YKFCBORWriterAppendEncoded(&writer, authData.bytes, authData.length);
+    YKFCBORWriterEnd(&writer);
     
-    NSDictionary *attestationDictionary = @{YKFCBORTextString(@"authData"): authData,
-                                            YKFCBORTextString(@"fmt"): fmt,
-                                            YKFCBORTextString(@"attStmt"): attStmt};
-    YKFCBORMap *attestationMap = YKFCBORMap(attestationDictionary);
-    NSData *cborEncodedAttestationMap = [YKFCBOREncoder encodeMap:attestationMap];
+    NSData *cborEncodedAttestationMap = [YKFCBOREncoder dataWithWriter:&writer];
     self.webauthnAttestationObject = cborEncodedAttestationMap;
     
     return cborEncodedAttestationMap != nil;
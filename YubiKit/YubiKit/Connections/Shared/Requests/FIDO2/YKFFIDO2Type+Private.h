@@ -12,9 +12,12 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#import "YKFCBORWriter.h"
+
 @protocol YKFFIDO2TypeProtocol<NSObject>
 
-- (id)cborTypeObject;
+/// Writes the CTAP2 CBOR encoding of the type.
+- (BOOL)writeCBORToWriter:(YKFCBORWriter *)writer;
 
 @end
 
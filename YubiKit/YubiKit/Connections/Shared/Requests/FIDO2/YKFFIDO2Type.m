@@ -13,29 +13,37 @@
 // limitations under the License.
 
 #import "YKFFIDO2Type.h"
-#import "YKFCBORType.h"
+#import "YKFCBOREncoder.h"
 #import "YKFFIDO2Type+Private.h"
 
+/*
+ The map keys are written in the CTAP2 canonical order (shorter keys first), so the writer doesn't have to
+ reorder the pairs when the map is closed.
+ */
+static bool YKFFIDO2TypeAppendText(YKFCBORWriter *writer, const char *text) {
+    return YKFCBORWriterAppendTextString(writer, text, strlen(text));
+}
+
 #pragma mark - YKFFIDO2PublicKeyCredentialRpEntity
 
 @implementation YKFFIDO2PublicKeyCredentialRpEntity
 
-- (id)cborTypeObject {
-    NSMutableDictionary *dictionary = [[NSMutableDictionary alloc] init];
+- (BOOL)writeCBORToWriter:(YKFCBORWriter *)writer {
+    YKFCBORWriterBeginMap(writer);
     
-    YKFCBORTextString *idKey = YKFCBORTextString(@"id");
-    dictionary[idKey] = YKFCBORTextString(self.rpId);
+    YKFFIDO2TypeAppendText(writer, "id");
+    [YKFCBOREncoder writeTextString:self.rpId toWriter:writer];
     
-    if (self.rpName) {
-        YKFCBORTextString *nameKey = YKFCBORTextString(@"name");
-        dictionary[nameKey] = YKFCBORTextString(self.rpName);
-    }
     if (self.rpIcon) {
-        YKFCBORTextString *iconKey = YKFCBORTextString(@"icon");
-        dictionary[iconKey] = YKFCBORTextString(self.rpIcon);
+        YKFFIDO2TypeAppendText(writer, "icon");
+        [YKFCBOREncoder writeTextString:self.rpIcon toWriter:writer];
+    }
+    if (self.rpName) {
+        YKFFIDO2TypeAppendText(writer, "name");
+        [YKFCBOREncoder writeTextString:self.rpName toWriter:writer];
     }
     
-    return YKFCBORMap([dictionary copy]);
+    return YKFCBORWriterEnd(writer);
 }
 
 @end
@@ -45,26 +53,26 @@
 
 @implementation YKFFIDO2PublicKeyCredentialUserEntity
 
-- (id)cborTypeObject {
-    NSMutableDictionary *dictionary = [[NSMutableDictionary alloc] init];
+- (BOOL)writeCBORToWriter:(YKFCBORWriter *)writer {
+    YKFCBORWriterBeginMap(writer);
     
-    YKFCBORTextString *idKey = YKFCBORTextString(@"id");
-    dictionary[idKey] = YKFCBORByteString(self.userId);
+    YKFFIDO2TypeAppendText(writer, "id");
+    YKFCBORWriterAppendByteString(writer, self.userId.bytes, self.userId.length);
     
+    if (self.userIcon) {
+        YKFFIDO2TypeAppendText(writer, "icon");
+        [YKFCBOREncoder writeTextString:self.userIcon toWriter:writer];
+    }
     if (self.userName) {
-        YKFCBORTextString *nameKey = YKFCBORTextString(@"name");
-        dictionary[nameKey] = YKFCBORTextString(self.userName);
+        YKFFIDO2TypeAppendText(writer, "name");
+        [YKFCBOREncoder writeTextString:self.userName toWriter:writer];
     }
     if (self.userDisplayName) {
-        YKFCBORTextString *userDisplayNameKey = YKFCBORTextString(@"displayName");
-        dictionary[userDisplayNameKey] = YKFCBORTextString(self.userDisplayName);
-    }
-    if (self.userIcon) {
-        YKFCBORTextString *userIconKey = YKFCBORTextString(@"icon");
-        dictionary[userIconKey] = YKFCBORTextString(self.userIcon);
+        YKFFIDO2TypeAppendText(writer, "displayName");
+        [YKFCBOREncoder writeTextString:self.userDisplayName toWriter:writer];
     }
     
-    return YKFCBORMap([dictionary copy]);
+    return YKFCBORWriterEnd(writer);
 }
 
 @end
@@ -74,8 +82,8 @@
 
 @implementation YKFFIDO2PublicKeyCredentialType
 
-- (id)cborTypeObject {
-    return YKFCBORTextString(self.name);
+- (BOOL)writeCBORToWriter:(YKFCBORWriter *)writer {
+    return [YKFCBOREncoder writeTextString:self.name toWriter:writer];
 }
 
 @end
@@ -85,10 +93,13 @@
 
 @implementation YKFFIDO2PublicKeyCredentialParam
 
-- (id)cborTypeObject {
-    NSDictionary *dictionary = @{YKFCBORTextString(@"alg"): YKFCBORInteger(self.alg),
-                                 YKFCBORTextString(@"type"): YKFCBORTextString(@"public-key")};
-    return YKFCBORMap(dictionary);
+- (BOOL)writeCBORToWriter:(YKFCBORWriter *)writer {
+    YKFCBORWriterBeginMap(writer);
+    YKFFIDO2TypeAppendText(writer, "alg");
+    YKFCBORWriterAppendInteger(writer, self.alg);
+    YKFFIDO2TypeAppendText(writer, "type");
+    YKFFIDO2TypeAppendText(writer, "public-key");
+    return YKFCBORWriterEnd(writer);
 }
 
 @end
@@ -102,8 +113,8 @@ NSString* const YKFFIDO2AuthenticatorTransportBLE = @"ble";
 
 @implementation YKFFIDO2AuthenticatorTransport
 
-- (id)cborTypeObject {
-    return YKFCBORTextString(self.name);
+- (BOOL)writeCBORToWriter:(YKFCBORWriter *)writer {
+    return [YKFCBOREncoder writeTextString:self.name toWriter:writer];
 }
 
 @end
@@ -113,25 +124,25 @@ NSString* const YKFFIDO2AuthenticatorTransportBLE = @"ble";
 
 @implementation YKFFIDO2PublicKeyCredentialDescriptor
 
-- (id)cborTypeObject {
-    NSMutableDictionary *dictionary = [[NSMutableDictionary alloc] init];
+- (BOOL)writeCBORToWriter:(YKFCBORWriter *)writer {
+    YKFCBORWriterBeginMap(writer);
     
-    YKFCBORTextString *idKey = YKFCBORTextString(@"id");
-    dictionary[idKey] = YKFCBORByteString(self.credentialId);
+    YKFFIDO2TypeAppendText(writer, "id");
+    YKFCBORWriterAppendByteString(writer, self.credentialId.bytes, self.credentialId.length);
     
-    YKFCBORTextString *typeKey = YKFCBORTextString(@"type");
-    dictionary[typeKey] = [self.credentialType cborTypeObject];
+    YKFFIDO2TypeAppendText(writer, "type");
+    [self.credentialType writeCBORToWriter:writer];
 
     if (self.credentialTransports) {
-        YKFCBORTextString *transportsKey = YKFCBORTextString(@"transports");
-        NSMutableArray *transportsArray = [[NSMutableArray alloc] initWithCapacity:self.credentialTransports.count];
+        YKFFIDO2TypeAppendText(writer, "transports");
+        YKFCBORWriterBeginArray(writer);
         for (YKFFIDO2AuthenticatorTransport *transport in self.credentialTransports) {
-            [transportsArray addObject:[transport cborTypeObject]];
+            [transport writeCBORToWriter:writer];
         }
-        dictionary[transportsKey] = YKFCBORArray([transportsArray copy]);
+        YKFCBORWriterEnd(writer);
     }
     
-    return YKFCBORMap([dictionary copy]);
+    return YKFCBORWriterEnd(writer);
 }
 
 @end
@@ -18,8 +18,6 @@
 #import "YKFOATHCode.h"
 #import "YKFOATHCode+Private.h"
 #import "YKFAssert.h"
-#import "YKFNSStringAdditions.h"
-#import "YKFNSDataAdditions+Private.h"
 #import "YKFOATHCredentialWithCode.h"
 
 static const UInt8 YKFOATHCalculateAllNameTag = 0x71;
@@ -28,8 +26,6 @@ static const UInt8 YKFOATHCalculateAllResponseFullResponseTag = 0x75;
 static const UInt8 YKFOATHCalculateAllResponseTruncatedResponseTag = 0x76;
 static const UInt8 YKFOATHCalculateAllResponseTouchTag = 0x7C;
 
-static NSUInteger const YKFOATHCredentialCalculateResultDefaultPeriod = 30; // seconds
-
 @interface YKFOATHCalculateAllResponse()
 
 @property (nonatomic, readwrite) NSArray *credentials;
@@ -40,110 +36,87 @@ static NSUInteger const YKFOATHCredentialCalculateResultDefaultPeriod = 30; // s
 
 - (instancetype)initWithKeyResponseData:(NSData *)responseData requestTimetamp:(NSDate *)timestamp {
     YKFAssertAbortInit(responseData);
+    YKFAssertAbortInit(timestamp);
     
     self = [super init];
     if (self) {
-        NSMutableArray *responseCredentials = [[NSMutableArray alloc] init];
-        UInt8 *responseBytes = (UInt8 *)responseData.bytes;
+        // Keep an immutable buffer, the credentials reference the names from it without copying.
+        NSData *data = [responseData copy];
+        const UInt8 *bytes = (const UInt8 *)data.bytes;
+        NSUInteger length = data.length;
         NSUInteger readIndex = 0;
         
-        while (readIndex < responseData.length && responseBytes[readIndex] == YKFOATHCalculateAllNameTag) {
-            YKFOATHCredential *credential = [[YKFOATHCredential alloc] init];
-            
-            ++readIndex;
-            YKFAssertAbortInit([responseData ykf_containsIndex:readIndex]);
-            
-            UInt8 nameLength = responseBytes[readIndex];
+        NSMutableArray *responseCredentials = [[NSMutableArray alloc] init];
+        
+        // The validity intervals are shared by all the codes with the same period.
+        NSUInteger requestTime = [timestamp timeIntervalSince1970]; // truncate to seconds
+        NSMutableDictionary<NSNumber *, NSDateInterval *> *validities = [[NSMutableDictionary alloc] init];
+        NSDateInterval *unlimitedValidity = nil;
+        
+        while (readIndex < length && bytes[readIndex] == YKFOATHCalculateAllNameTag) {
+            // Name: [0x71][length][name]
+            YKFAssertAbortInit(readIndex + 1 < length);
+            UInt8 nameLength = bytes[readIndex + 1];
             YKFAssertAbortInit(nameLength > 0);
-            
-            ++readIndex;
+            readIndex += 2;
+            YKFAssertAbortInit(readIndex + nameLength <= length);
             NSRange nameRange = NSMakeRange(readIndex, nameLength);
-            YKFAssertAbortInit([responseData ykf_containsRange:nameRange]);
-            
-            NSData *nameData = [responseData subdataWithRange:nameRange];
-            credential.key = [[NSString alloc] initWithData:nameData encoding:NSUTF8StringEncoding];
-            
             readIndex += nameLength;
-            YKFAssertAbortInit([responseData ykf_containsIndex:readIndex]);
             
-            UInt8 responseTag = responseBytes[readIndex];
+            // Response: [tag][length][digits][value]
+            YKFAssertAbortInit(readIndex + 2 < length);
+            UInt8 responseTag = bytes[readIndex];
+            UInt8 responseLength = bytes[readIndex + 1];
+            UInt8 digits = bytes[readIndex + 2];
+            YKFAssertAbortInit(responseLength > 0);
+            YKFAssertAbortInit(digits == 6 || digits == 7 || digits == 8);
+            
+            YKFOATHCredentialType type;
             switch (responseTag) {
                 case YKFOATHCalculateAllResponseHOTPTag:
-                    credential.type = YKFOATHCredentialTypeHOTP;
+                    type = YKFOATHCredentialTypeHOTP;
                     break;
                     
                 case YKFOATHCalculateAllResponseFullResponseTag:
                 case YKFOATHCalculateAllResponseTruncatedResponseTag:
                 case YKFOATHCalculateAllResponseTouchTag:
-                    credential.type = YKFOATHCredentialTypeTOTP;
+                    type = YKFOATHCredentialTypeTOTP;
                     break;
                 
                 default:
-                    credential.type = YKFOATHCredentialTypeUnknown;
+                    type = YKFOATHCredentialTypeUnknown;
             }
-            YKFAssertAbortInit(credential.type != YKFOATHCredentialTypeUnknown);
-            
-            ++readIndex;
-            YKFAssertAbortInit([responseData ykf_containsIndex:readIndex]);
-            
-            UInt8 responseLength = responseBytes[readIndex];
-            YKFAssertAbortInit(responseLength > 0);
+            YKFAssertAbortInit(type != YKFOATHCredentialTypeUnknown);
             
-            ++readIndex;
-            YKFAssertAbortInit([responseData ykf_containsIndex:readIndex]);
+            YKFOATHCredential *credential = [[YKFOATHCredential alloc] initWithKeyData:data range:nameRange type:type];
             
-            UInt8 digits = responseBytes[readIndex];
-            YKFAssertAbortInit(digits == 6 || digits == 7 || digits == 8);
-            
-            // Parse the period, account and issuer from the key.
-            
-            NSString *credentialKey = credential.key;
-            NSUInteger period = 0;
-            NSString *issuer = nil;
-            NSString *account = nil;
-            NSString *label = nil;
-            
-            [credentialKey ykf_OATHKeyExtractPeriod:&period issuer:&issuer account:&account label:&label];
-            
-            credential.issuer = issuer;
-            credential.accountName = account;
-            if (credential.type == YKFOATHCredentialTypeTOTP) {
-                credential.period = period ? period : YKFOATHCredentialCalculateResultDefaultPeriod;
-            }
-            
-            // Parse the OTP value when TOTP and touch is not required.
-            NSString *otp;
-            if (credential.type == YKFOATHCredentialTypeTOTP && responseTag != YKFOATHCalculateAllResponseTouchTag) {
-                ++readIndex;
-                YKFAssertAbortInit([responseData ykf_containsIndex:readIndex]);
-                
-                UInt8 otpBytesLength = responseLength - 1;
-                YKFAssertAbortInit(otpBytesLength == 4);
+            YKFOATHCode *code;
+            if (type == YKFOATHCredentialTypeTOTP && responseTag != YKFOATHCalculateAllResponseTouchTag) {
+                // Parse the OTP value when TOTP and touch is not required.
+                YKFAssertAbortInit(responseLength - 1 == sizeof(UInt32));
+                YKFAssertAbortInit(readIndex + 3 + sizeof(UInt32) <= length);
+                UInt32 value = CFSwapInt32BigToHost(*(UInt32 *)(bytes + readIndex + 3));
                 
-                otp = [responseData ykf_parseOATHOTPFromIndex:readIndex digits:digits];
-                YKFAssertAbortInit(otp.length == digits);
-                
-                readIndex += otpBytesLength; // Jump to the next extry.
+                NSUInteger period = credential.period;
+                NSDateInterval *validity = validities[@(period)];
+                if (!validity) {
+                    NSDate *startDate = [NSDate dateWithTimeIntervalSince1970:requestTime - requestTime % period];
+                    validity = [[NSDateInterval alloc] initWithStartDate:startDate duration:period];
+                    validities[@(period)] = validity;
+                }
+                code = [[YKFOATHCode alloc] initWithTruncatedValue:value digits:digits validity:validity];
             } else {
                 // No result for TOTP with touch or HOTP
-                if (credential.type == YKFOATHCredentialTypeTOTP) {
+                if (type == YKFOATHCredentialTypeTOTP) {
                     credential.requiresTouch = YES;
                 }
-                ++readIndex;
+                if (!unlimitedValidity) {
+                    unlimitedValidity = [[NSDateInterval alloc] initWithStartDate:timestamp endDate:[NSDate distantFuture]];
+                }
+                code = [[YKFOATHCode alloc] initWithOtp:nil validity:unlimitedValidity];
             }
+            readIndex += 2 + responseLength; // Jump to the next entry.
             
-            // Calculate validity
-            NSDateInterval *validity;
-            if (credential.type == YKFOATHCredentialTypeTOTP && responseTag != YKFOATHCalculateAllResponseTouchTag) {
-                NSUInteger timestampTimeInterval = [timestamp timeIntervalSince1970]; // truncate to seconds
-                
-                NSDate *startDate = [NSDate dateWithTimeIntervalSince1970:timestampTimeInterval - timestampTimeInterval % credential.period];
-                validity = [[NSDateInterval alloc] initWithStartDate:startDate duration:credential.period];
-            } else {
-                validity = [[NSDateInterval alloc] initWithStartDate:timestamp endDate:[NSDate distantFuture]];
-            }
-
-            YKFOATHCode *code = [[YKFOATHCode alloc] initWithOtp:otp validity:validity];
             YKFOATHCredentialWithCode *result = [[YKFOATHCredentialWithCode alloc] initWithCredential:credential code:code];
             [responseCredentials addObject:result];
         }
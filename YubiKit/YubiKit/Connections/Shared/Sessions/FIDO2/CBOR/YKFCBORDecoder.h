@@ -22,9 +22,22 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @protocol YKFCBORDecoderProtocol<NSObject>
 
+/*!
+ @abstract
+    Decodes a CBOR type from the beginning of the data.
+ @discussion
+    The data is read in place, without intermediate buffers, and the decoded byte strings reference the bytes of
+    the data instead of copying them. This is the preferred way to decode a response received from the key.
+ @returns
+    The object or nil if the object could not be parsed.
+ */
++ (nullable id)decodeObjectFromData:(NSData *)data;
+
 /*!
  @abstract
     Decodes a CBOR type from an input stream.
+ @discussion
+    The stream is read one element at a time, which is slower than decodeObjectFromData: for complete responses.
  @returns
     The object or nil if the object could not be parsed.
  */
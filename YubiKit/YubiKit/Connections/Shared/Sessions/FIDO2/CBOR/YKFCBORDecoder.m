@@ -15,6 +15,7 @@
 #import "YKFCBORDecoder.h"
 #import "YKFCBORTag.h"
 #import "YKFAssert.h"
+#import "YKFCBORReader.h"
 
 @interface NSInputStream(YKFCBORDecoder)
 
@@ -25,6 +26,104 @@
 
 @implementation YKFCBORDecoder
 
++ (nullable id)decodeObjectFromData:(NSData *)data {
+    YKFAssertReturnValue(data.length, @"CBOR - Cannot decode from empty data.", nil);
+    
+    // The byte strings keep a reference to the immutable buffer instead of copying their bytes.
+    NSData *buffer = [data copy];
+    YKFCBORReader reader;
+    YKFCBORReaderInit(&reader, buffer.bytes, buffer.length);
+    return [self decodeObjectFromReader:&reader buffer:buffer depth:0];
+}
+
++ (id)decodeObjectFromReader:(YKFCBORReader *)reader buffer:(NSData *)buffer depth:(NSUInteger)depth {
+    // Malformed data is an expected input, which fails the decoding without asserting.
+    YKFCBORItem item;
+    if (!YKFCBORReaderNext(reader, &item)) {
+        return nil;
+    }
+    
+    switch (item.majorType) {
+        case YKFCBORMajorTypeUnsigned:
+        case YKFCBORMajorTypeNegative: {
+            // Avoid overflow for values which cannot be represented on a NSInteger.
+            if (item.argument > INT64_MAX) {
+                return nil;
+            }
+            NSInteger value = (NSInteger)item.argument;
+            return YKFCBORInteger(item.majorType == YKFCBORMajorTypeNegative ? -1 - value : value);
+        }
+        case YKFCBORMajorTypeByteString:
+            return YKFCBORByteString([self subdataOfBuffer:buffer bytes:item.bytes length:(NSUInteger)item.argument]);
+            
+        case YKFCBORMajorTypeTextString: {
+            NSString *stringValue = [[NSString alloc] initWithBytes:item.bytes length:(NSUInteger)item.argument encoding:NSUTF8StringEncoding];
+            if (!stringValue) {
+                return nil;
+            }
+            return YKFCBORTextString(stringValue);
+        }
+        case YKFCBORMajorTypeArray: {
+            if (depth == YKF_CBOR_MAX_DEPTH) {
+                return nil;
+            }
+            NSMutableArray *array = [[NSMutableArray alloc] initWithCapacity:(NSUInteger)item.argument];
+            for (UInt64 i = 0; i < item.argument; ++i) {
+                id element = [self decodeObjectFromReader:reader buffer:buffer depth:depth + 1];
+                if (!element) {
+                    return nil;
+                }
+                [array addObject:element];
+            }
+            return YKFCBORArray([array copy]);
+        }
+        case YKFCBORMajorTypeMap: {
+            if (depth == YKF_CBOR_MAX_DEPTH) {
+                return nil;
+            }
+            NSMutableDictionary *dictionary = [[NSMutableDictionary alloc] initWithCapacity:(NSUInteger)item.argument];
+            for (UInt64 i = 0; i < item.argument; ++i) {
+                id key = [self decodeObjectFromReader:reader buffer:buffer depth:depth + 1];
+                if (!key) {
+                    return nil;
+                }
+                
+                id value = [self decodeObjectFromReader:reader buffer:buffer depth:depth + 1];
+                if (!value) {
+                    return nil;
+                }
+                
+                // Security check: Verify if the key already exists in the decoded map. A map with duplicated keys is invalid.
+                if (dictionary[key]) {
+                    return nil;
+                }
+                dictionary[key] = value;
+            }
+            return YKFCBORMap([dictionary copy]);
+        }
+        case YKFCBORMajorTypeSimple:
+            if (item.argument != YKF_CBOR_SIMPLE_FALSE && item.argument != YKF_CBOR_SIMPLE_TRUE) {
+                return nil;
+            }
+            return YKFCBORBool(item.argument == YKF_CBOR_SIMPLE_TRUE);
+            
+        default:
+            return nil;
+    }
+}
+
++ (NSData *)subdataOfBuffer:(NSData *)buffer bytes:(const UInt8 *)bytes length:(NSUInteger)length {
+    if (!length) {
+        return [NSData data];
+    }
+    // The deallocator retains the buffer for the lifetime of the subdata.
+    return [[NSData alloc] initWithBytesNoCopy:(void *)bytes length:length deallocator:^(void *bytes, NSUInteger length) {
+        (void)buffer;
+    }];
+}
+
+#pragma mark - Input Stream Decoding
+
 + (nullable id)decodeObjectFrom:(NSInputStream *)inputStream {
     YKFAssertReturnValue(inputStream, @"CBOR - Decoding input stream is nil.", nil);
     YKFAssertReturnValue(inputStream.streamStatus == NSStreamStatusOpen, @"CBOR - Decoding input stream not opened.", nil);
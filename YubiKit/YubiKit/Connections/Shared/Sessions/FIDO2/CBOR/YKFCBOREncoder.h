@@ -14,6 +14,7 @@
 
 #import <Foundation/Foundation.h>
 #import "YKFCBORType.h"
+#import "YKFCBORWriter.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -38,8 +39,28 @@ NS_ASSUME_NONNULL_BEGIN
 
 /*!
  CTAP2 CBOR encoder.
+
+ The objects are written into one buffer with YKFCBORWriter, and the map keys are sorted in the CTAP2 canonical
+ order. Requests which are built once, like the FIDO2 commands, can skip the CBOR objects and write their values
+ directly with YKFCBORWriter and the helpers below.
  */
 @interface YKFCBOREncoder: NSObject<YKFCBOREncoderProtocol>
+
+/*!
+ Writes a CBOR object (YKFCBORInteger, YKFCBORMap, etc.) and its content.
+ */
++ (BOOL)writeObject:(id)object toWriter:(YKFCBORWriter *)writer;
+
+/*!
+ Writes the UTF-8 encoding of the string.
+ */
++ (BOOL)writeTextString:(NSString *)string toWriter:(YKFCBORWriter *)writer;
+
+/*!
+ Finishes the writer and returns its buffer, without copying it. Returns nil if any write failed.
+ */
++ (nullable NSData *)dataWithWriter:(YKFCBORWriter *)writer;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -0,0 +1,65 @@
+// Copyright 2018-2019 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*!
+ A read-only view of a CBOR map with integer keys, like the CTAP2 responses.
+
+ The map is indexed in one pass when the view is created, and a value is decoded only when it is requested. The
+ strings and the encoded values reference the bytes of the data instead of copying them.
+ */
+@interface YKFCBORMapView: NSObject
+
+/*!
+ The data of the map.
+ */
+@property (nonatomic, readonly) NSData *data;
+
+/*!
+ Returns nil if the data is not exactly one well-formed map.
+ */
+- (nullable instancetype)initWithData:(NSData *)data NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+- (BOOL)containsKey:(NSUInteger)key;
+
+/*!
+ Returns YES if the value for the key is an array. The array is not decoded.
+ */
+- (BOOL)containsArrayForKey:(NSUInteger)key;
+
+/*!
+ The encoded value for the key, as received. Returns nil if the key is missing.
+ */
+- (nullable NSData *)encodedValueForKey:(NSUInteger)key;
+
+/*!
+ The typed getters return nil if the key is missing or if the value has another type.
+ */
+- (nullable NSData *)byteStringForKey:(NSUInteger)key;
+- (nullable NSString *)textStringForKey:(NSUInteger)key;
+- (nullable NSNumber *)integerForKey:(NSUInteger)key;
+
+/*!
+ Decodes the value for the key and converts it to the Foundation types (e.g. NSArray, NSDictionary).
+ */
+- (nullable id)objectForKey:(NSUInteger)key;
+
+@end
+
+NS_ASSUME_NONNULL_END
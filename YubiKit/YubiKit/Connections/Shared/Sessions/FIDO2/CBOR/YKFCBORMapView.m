@@ -0,0 +1,118 @@
+// Copyright 2018-2019 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import "YKFCBORMapView.h"
+#import "YKFCBORDecoder.h"
+#import "YKFCBORReader.h"
+
+@interface YKFCBORMapView() {
+    YKFCBORMapIndex _index;
+}
+
+@property (nonatomic, readwrite) NSData *data;
+
+@end
+
+@implementation YKFCBORMapView
+
+- (instancetype)initWithData:(NSData *)data {
+    self = [super init];
+    if (self) {
+        // The values reference the immutable buffer instead of copying their bytes.
+        self.data = [data copy];
+        if (!YKFCBORMapIndexInit(&_index, self.data.bytes, self.data.length)) {
+            return nil;
+        }
+    }
+    return self;
+}
+
+- (BOOL)containsKey:(NSUInteger)key {
+    return YKFCBORMapIndexFind(&_index, key) != NULL;
+}
+
+- (BOOL)containsArrayForKey:(NSUInteger)key {
+    const YKFCBORIndexEntry *entry = YKFCBORMapIndexFind(&_index, key);
+    return entry && entry->item.majorType == YKFCBORMajorTypeArray;
+}
+
+- (NSData *)encodedValueForKey:(NSUInteger)key {
+    const YKFCBORIndexEntry *entry = YKFCBORMapIndexFind(&_index, key);
+    if (!entry) {
+        return nil;
+    }
+    return [self viewOfDataInRange:NSMakeRange(entry->item.offset, entry->length)];
+}
+
+- (NSData *)byteStringForKey:(NSUInteger)key {
+    const YKFCBORIndexEntry *entry = YKFCBORMapIndexFind(&_index, key);
+    if (!entry || entry->item.majorType != YKFCBORMajorTypeByteString) {
+        return nil;
+    }
+    NSUInteger offset = entry->item.bytes - (const UInt8 *)self.data.bytes;
+    return [self viewOfDataInRange:NSMakeRange(offset, (NSUInteger)entry->item.argument)];
+}
+
+- (NSString *)textStringForKey:(NSUInteger)key {
+    const YKFCBORIndexEntry *entry = YKFCBORMapIndexFind(&_index, key);
+    if (!entry || entry->item.majorType != YKFCBORMajorTypeTextString) {
+        return nil;
+    }
+    return [[NSString alloc] initWithBytes:entry->item.bytes length:(NSUInteger)entry->item.argument encoding:NSUTF8StringEncoding];
+}
+
+- (NSNumber *)integerForKey:(NSUInteger)key {
+    const YKFCBORIndexEntry *entry = YKFCBORMapIndexFind(&_index, key);
+    if (!entry || entry->item.argument > INT64_MAX) {
+        return nil;
+    }
+    NSInteger value = (NSInteger)entry->item.argument;
+    switch (entry->item.majorType) {
+        case YKFCBORMajorTypeUnsigned:
+            return @(value);
+        case YKFCBORMajorTypeNegative:
+            return @(-1 - value);
+        default:
+            return nil;
+    }
+}
+
+- (id)objectForKey:(NSUInteger)key {
+    NSData *encodedValue = [self encodedValueForKey:key];
+    if (!encodedValue) {
+        return nil;
+    }
+    id cborObject = [YKFCBORDecoder decodeObjectFromData:encodedValue];
+    if (!cborObject) {
+        return nil;
+    }
+    return [YKFCBORDecoder convertCBORObjectToFoundationType:cborObject];
+}
+
+#pragma mark - Helpers
+
+/*
+ Returns a no-copy view over a range of the data. The view keeps the data alive, it can outlive the map view.
+ */
+- (NSData *)viewOfDataInRange:(NSRange)range {
+    if (!range.length) {
+        return [NSData data];
+    }
+    NSData *data = self.data;
+    return [[NSData alloc] initWithBytesNoCopy:(UInt8 *)data.bytes + range.location length:range.length deallocator:^(void *bytes, NSUInteger length) {
+        (void)data;
+    }];
+}
+
+@end
@@ -0,0 +1,167 @@
+// Copyright 2018-2021 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "YKFCBORReader.h"
+
+void YKFCBORReaderInit(YKFCBORReader *reader, const uint8_t *bytes, size_t length) {
+    reader->start = bytes;
+    reader->cursor = bytes;
+    reader->end = bytes ? bytes + length : bytes;
+}
+
+size_t YKFCBORReaderOffset(const YKFCBORReader *reader) {
+    return (size_t)(reader->cursor - reader->start);
+}
+
+bool YKFCBORReaderNext(YKFCBORReader *reader, YKFCBORItem *item) {
+    const uint8_t *cursor = reader->cursor;
+    if (cursor == reader->end) {
+        return false;
+    }
+    uint8_t head = *cursor++;
+    YKFCBORMajorType majorType = (YKFCBORMajorType)(head >> 5);
+    uint8_t additionalInfo = head & 0x1F;
+
+    // The argument is in the additional info up to 23, or in the following 1, 2, 4 or 8 bytes.
+    uint64_t argument = additionalInfo;
+    if (additionalInfo >= 24) {
+        if (additionalInfo > 27) {
+            // Indefinite lengths (31) are not used by CTAP2, 28-30 are reserved.
+            return false;
+        }
+        size_t argumentLength = (size_t)1 << (additionalInfo - 24);
+        if ((size_t)(reader->end - cursor) < argumentLength) {
+            return false;
+        }
+        argument = 0;
+        for (size_t i = 0; i < argumentLength; ++i) {
+            argument = (argument << 8) | *cursor++;
+        }
+    }
+
+    size_t available = (size_t)(reader->end - cursor);
+    const uint8_t *bytes = NULL;
+    switch (majorType) {
+        case YKFCBORMajorTypeByteString:
+        case YKFCBORMajorTypeTextString:
+            if (argument > available) {
+                return false;
+            }
+            bytes = cursor;
+            cursor += argument;
+            break;
+        case YKFCBORMajorTypeArray:
+            // Each element takes at least one byte.
+            if (argument > available) {
+                return false;
+            }
+            break;
+        case YKFCBORMajorTypeMap:
+            if (argument > available / 2) {
+                return false;
+            }
+            break;
+        case YKFCBORMajorTypeTag:
+            return false;
+        case YKFCBORMajorTypeSimple:
+            // Floats are not used by CTAP2.
+            if (additionalInfo > 24) {
+                return false;
+            }
+            break;
+        default:
+            break;
+    }
+
+    item->majorType = majorType;
+    item->argument = argument;
+    item->bytes = bytes;
+    item->offset = (size_t)(reader->cursor - reader->start);
+    reader->cursor = cursor;
+    return true;
+}
+
+bool YKFCBORReaderSkip(YKFCBORReader *reader) {
+    // The elements left to skip at each nesting level, iteratively to bound the stack use.
+    uint64_t remaining[YKF_CBOR_MAX_DEPTH + 1];
+    size_t depth = 0;
+    remaining[0] = 1;
+    while (true) {
+        while (remaining[depth] == 0) {
+            if (depth == 0) {
+                return true;
+            }
+            --depth;
+        }
+        YKFCBORItem item;
+        if (!YKFCBORReaderNext(reader, &item)) {
+            return false;
+        }
+        --remaining[depth];
+        if (item.majorType == YKFCBORMajorTypeArray || item.majorType == YKFCBORMajorTypeMap) {
+            if (item.argument == 0) {
+                continue;
+            }
+            if (depth == YKF_CBOR_MAX_DEPTH) {
+                return false;
+            }
+            remaining[++depth] = item.majorType == YKFCBORMajorTypeMap ? 2 * item.argument : item.argument;
+        }
+    }
+}
+
+// Index
+
+bool YKFCBORMapIndexInit(YKFCBORMapIndex *index, const uint8_t *bytes, size_t length) {
+    index->keys = 0;
+
+    YKFCBORReader reader;
+    YKFCBORReaderInit(&reader, bytes, length);
+    YKFCBORItem map;
+    if (!YKFCBORReaderNext(&reader, &map) || map.majorType != YKFCBORMajorTypeMap) {
+        return false;
+    }
+    for (uint64_t i = 0; i < map.argument; ++i) {
+        // The heads are read with a copy of the reader, which then skips the whole key or value.
+        YKFCBORReader itemReader = reader;
+        YKFCBORItem key;
+        if (!YKFCBORReaderNext(&itemReader, &key) || !YKFCBORReaderSkip(&reader)) {
+            return false;
+        }
+        YKFCBORIndexEntry entry;
+        itemReader = reader;
+        if (!YKFCBORReaderNext(&itemReader, &entry.item) || !YKFCBORReaderSkip(&reader)) {
+            return false;
+        }
+        entry.length = YKFCBORReaderOffset(&reader) - entry.item.offset;
+
+        if (key.majorType != YKFCBORMajorTypeUnsigned || key.argument >= YKF_CBOR_INDEX_CAPACITY) {
+            continue;
+        }
+        uint32_t keyBit = (uint32_t)1 << key.argument;
+        if (index->keys & keyBit) {
+            return false;
+        }
+        index->keys |= keyBit;
+        index->entries[key.argument] = entry;
+    }
+    return YKFCBORReaderOffset(&reader) == length;
+}
+
+const YKFCBORIndexEntry *YKFCBORMapIndexFind(const YKFCBORMapIndex *index, uint64_t key) {
+    if (key >= YKF_CBOR_INDEX_CAPACITY || !(index->keys & ((uint32_t)1 << key))) {
+        return NULL;
+    }
+    return &index->entries[key];
+}
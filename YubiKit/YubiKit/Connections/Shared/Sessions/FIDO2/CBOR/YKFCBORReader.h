@@ -0,0 +1,125 @@
+// Copyright 2018-2021 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef YKFCBORReader_h
+#define YKFCBORReader_h
+
+/*
+ Cursor based reading of the CTAP2 CBOR encoding from a contiguous buffer.
+
+ This is plain C, without Foundation, so it can be built and fuzzed on any platform. The reader doesn't allocate
+ and doesn't copy: the strings point into the buffer, which must outlive them. Every read is checked against the
+ end of the buffer, and the lengths and counts are checked against the bytes left, so a malformed buffer fails
+ the read instead of reading out of bounds.
+
+ Only the subset of CBOR used by CTAP2 is read: definite lengths, no floats, and no tags.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// The maximum nesting of arrays and maps skipped by YKFCBORReaderSkip. CTAP2 messages nest at most 4 levels.
+#define YKF_CBOR_MAX_DEPTH 16
+
+typedef enum {
+    YKFCBORMajorTypeUnsigned = 0,
+    YKFCBORMajorTypeNegative = 1,
+    YKFCBORMajorTypeByteString = 2,
+    YKFCBORMajorTypeTextString = 3,
+    YKFCBORMajorTypeArray = 4,
+    YKFCBORMajorTypeMap = 5,
+    YKFCBORMajorTypeTag = 6,
+    YKFCBORMajorTypeSimple = 7,
+} YKFCBORMajorType;
+
+/// The simple values of major type 7 used by CTAP2.
+#define YKF_CBOR_SIMPLE_FALSE 20
+#define YKF_CBOR_SIMPLE_TRUE 21
+
+typedef struct {
+    YKFCBORMajorType majorType;
+
+    /*
+     The value of the integers, the length of the strings, the number of elements of the arrays, the number of
+     pairs of the maps, or the simple value. For negative integers the value is -1 - argument.
+     */
+    uint64_t argument;
+
+    /// The bytes of the strings, pointing into the buffer. NULL for the other types.
+    const uint8_t *bytes;
+
+    /// The offset of the item in the buffer, from its head.
+    size_t offset;
+} YKFCBORItem;
+
+typedef struct {
+    const uint8_t *start;
+    const uint8_t *cursor;
+    const uint8_t *end;
+} YKFCBORReader;
+
+void YKFCBORReaderInit(YKFCBORReader *reader, const uint8_t *bytes, size_t length);
+
+/*
+ Reads the head of the next item. The strings are read entirely and the reader moves past them. For arrays and
+ maps, the reader moves to the first element, which is read with the next calls.
+ */
+bool YKFCBORReaderNext(YKFCBORReader *reader, YKFCBORItem *item);
+
+/// Moves past the next item, including all the elements of the arrays and maps.
+bool YKFCBORReaderSkip(YKFCBORReader *reader);
+
+/// The offset of the reader in the buffer.
+size_t YKFCBORReaderOffset(const YKFCBORReader *reader);
+
+// Index
+
+/// The integer keys below this value are indexed by YKFCBORMapIndexInit. CTAP2 responses use small integer keys.
+#define YKF_CBOR_INDEX_CAPACITY 32
+
+typedef struct {
+    /// The head of the value. The strings are read, the arrays and maps are not.
+    YKFCBORItem item;
+
+    /// The length of the encoded value, from its head. The value is at item.offset in the buffer.
+    size_t length;
+} YKFCBORIndexEntry;
+
+/*
+ The values of a map with integer keys, read in one pass, with constant time lookup by key. The values are checked
+ to be well-formed but are not decoded, so the fields of a response can be decoded when used, or copied as encoded.
+ The other keys (e.g. text keys or the unknown keys of a newer authenticator) are skipped.
+ */
+typedef struct {
+    YKFCBORIndexEntry entries[YKF_CBOR_INDEX_CAPACITY];
+    // Bit set of the keys found in the map.
+    uint32_t keys;
+} YKFCBORMapIndex;
+
+/// Returns false when the buffer is not exactly one well-formed map, or when an indexed key is repeated.
+bool YKFCBORMapIndexInit(YKFCBORMapIndex *index, const uint8_t *bytes, size_t length);
+
+/// Returns the entry of the value with the key, or NULL.
+const YKFCBORIndexEntry *YKFCBORMapIndexFind(const YKFCBORMapIndex *index, uint64_t key);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* YKFCBORReader_h */
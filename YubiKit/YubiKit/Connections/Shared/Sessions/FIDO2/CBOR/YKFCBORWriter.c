@@ -0,0 +1,322 @@
+// Copyright 2018-2021 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "YKFCBORWriter.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const size_t YKFCBORWriterMinimumCapacity = 64;
+
+typedef struct {
+    size_t keyOffset;
+    size_t keyLength;
+    size_t pairLength;
+} YKFCBORWriterPair;
+
+size_t YKFCBORHeadLength(uint64_t argument) {
+    if (argument < 24) {
+        return 1;
+    }
+    if (argument <= UINT8_MAX) {
+        return 2;
+    }
+    if (argument <= UINT16_MAX) {
+        return 3;
+    }
+    if (argument <= UINT32_MAX) {
+        return 5;
+    }
+    return 9;
+}
+
+static void YKFCBOREncodeHead(uint8_t *bytes, YKFCBORMajorType majorType, uint64_t argument, size_t headLength) {
+    uint8_t majorTypeBits = (uint8_t)(majorType << 5);
+    if (headLength == 1) {
+        bytes[0] = majorTypeBits | (uint8_t)argument;
+        return;
+    }
+    // The additional info 24, 25, 26 and 27 is followed by 1, 2, 4 and 8 bytes.
+    size_t argumentLength = headLength - 1;
+    uint8_t additionalInfo = argumentLength == 1 ? 24 : argumentLength == 2 ? 25 : argumentLength == 4 ? 26 : 27;
+    bytes[0] = majorTypeBits | additionalInfo;
+    for (size_t i = argumentLength; i > 0; --i) {
+        bytes[i] = (uint8_t)argument;
+        argument >>= 8;
+    }
+}
+
+void YKFCBORWriterInit(YKFCBORWriter *writer, size_t capacity) {
+    memset(writer, 0, sizeof(YKFCBORWriter));
+    if (capacity) {
+        writer->buffer = malloc(capacity);
+        writer->capacity = writer->buffer ? capacity : 0;
+    }
+}
+
+static bool YKFCBORWriterReserve(YKFCBORWriter *writer, size_t length) {
+    if (writer->failed) {
+        return false;
+    }
+    if (writer->capacity - writer->length >= length) {
+        return true;
+    }
+    if (length > SIZE_MAX / 2 || writer->length > SIZE_MAX / 2 - length) {
+        writer->failed = true;
+        return false;
+    }
+    size_t capacity = writer->capacity * 2;
+    if (capacity < writer->length + length) {
+        capacity = writer->length + length;
+    }
+    if (capacity < YKFCBORWriterMinimumCapacity) {
+        capacity = YKFCBORWriterMinimumCapacity;
+    }
+    uint8_t *buffer = realloc(writer->buffer, capacity);
+    if (!buffer) {
+        writer->failed = true;
+        return false;
+    }
+    writer->buffer = buffer;
+    writer->capacity = capacity;
+    return true;
+}
+
+// Counts one more element in the open container, if any.
+static void YKFCBORWriterCountItem(YKFCBORWriter *writer) {
+    if (writer->depth) {
+        ++writer->containers[writer->depth - 1].count;
+    }
+}
+
+static bool YKFCBORWriterAppendHead(YKFCBORWriter *writer, YKFCBORMajorType majorType, uint64_t argument, size_t contentLength) {
+    size_t headLength = YKFCBORHeadLength(argument);
+    if (contentLength > SIZE_MAX - headLength) {
+        writer->failed = true;
+        return false;
+    }
+    if (!YKFCBORWriterReserve(writer, headLength + contentLength)) {
+        return false;
+    }
+    YKFCBOREncodeHead(writer->buffer + writer->length, majorType, argument, headLength);
+    writer->length += headLength;
+    YKFCBORWriterCountItem(writer);
+    return true;
+}
+
+bool YKFCBORWriterAppendUnsigned(YKFCBORWriter *writer, uint64_t value) {
+    return YKFCBORWriterAppendHead(writer, YKFCBORMajorTypeUnsigned, value, 0);
+}
+
+bool YKFCBORWriterAppendInteger(YKFCBORWriter *writer, int64_t value) {
+    if (value >= 0) {
+        return YKFCBORWriterAppendHead(writer, YKFCBORMajorTypeUnsigned, (uint64_t)value, 0);
+    }
+    // -1 - value, without overflowing for INT64_MIN.
+    return YKFCBORWriterAppendHead(writer, YKFCBORMajorTypeNegative, ~(uint64_t)value, 0);
+}
+
+static bool YKFCBORWriterAppendString(YKFCBORWriter *writer, YKFCBORMajorType majorType, const void *bytes, size_t length) {
+    if (length && !bytes) {
+        writer->failed = true;
+        return false;
+    }
+    if (!YKFCBORWriterAppendHead(writer, majorType, length, length)) {
+        return false;
+    }
+    if (length) {
+        memcpy(writer->buffer + writer->length, bytes, length);
+        writer->length += length;
+    }
+    return true;
+}
+
+bool YKFCBORWriterAppendByteString(YKFCBORWriter *writer, const uint8_t *bytes, size_t length) {
+    return YKFCBORWriterAppendString(writer, YKFCBORMajorTypeByteString, bytes, length);
+}
+
+bool YKFCBORWriterAppendTextString(YKFCBORWriter *writer, const char *string, size_t length) {
+    return YKFCBORWriterAppendString(writer, YKFCBORMajorTypeTextString, string, length);
+}
+
+bool YKFCBORWriterAppendBool(YKFCBORWriter *writer, bool value) {
+    return YKFCBORWriterAppendHead(writer, YKFCBORMajorTypeSimple, value ? YKF_CBOR_SIMPLE_TRUE : YKF_CBOR_SIMPLE_FALSE, 0);
+}
+
+bool YKFCBORWriterAppendEncoded(YKFCBORWriter *writer, const uint8_t *bytes, size_t length) {
+    // The bytes must be exactly one item, for the count of the container to be right.
+    YKFCBORReader reader;
+    YKFCBORReaderInit(&reader, bytes, length);
+    if (!bytes || !YKFCBORReaderSkip(&reader) || YKFCBORReaderOffset(&reader) != length) {
+        writer->failed = true;
+        return false;
+    }
+    if (!YKFCBORWriterReserve(writer, length)) {
+        return false;
+    }
+    memcpy(writer->buffer + writer->length, bytes, length);
+    writer->length += length;
+    YKFCBORWriterCountItem(writer);
+    return true;
+}
+
+static bool YKFCBORWriterBegin(YKFCBORWriter *writer, bool isMap) {
+    if (writer->depth == YKF_CBOR_MAX_DEPTH) {
+        writer->failed = true;
+        return false;
+    }
+    // One byte is reserved for the head, which is enough up to 23 elements. Larger containers move the content on End.
+    if (!YKFCBORWriterReserve(writer, 1)) {
+        return false;
+    }
+    YKFCBORWriterCountItem(writer);
+    YKFCBORWriterContainer *container = &writer->containers[writer->depth++];
+    container->headOffset = writer->length++;
+    container->count = 0;
+    container->isMap = isMap;
+    return true;
+}
+
+bool YKFCBORWriterBeginArray(YKFCBORWriter *writer) {
+    return YKFCBORWriterBegin(writer, false);
+}
+
+bool YKFCBORWriterBeginMap(YKFCBORWriter *writer) {
+    return YKFCBORWriterBegin(writer, true);
+}
+
+static int YKFCBORWriterCompareKeys(const uint8_t *buffer, const YKFCBORWriterPair *pair, const YKFCBORWriterPair *otherPair) {
+    if (pair->keyLength != otherPair->keyLength) {
+        return pair->keyLength < otherPair->keyLength ? -1 : 1;
+    }
+    return memcmp(buffer + pair->keyOffset, buffer + otherPair->keyOffset, pair->keyLength);
+}
+
+// Sorts the pairs of the map content in the canonical order. Fails on duplicate keys.
+static bool YKFCBORWriterSortPairs(YKFCBORWriter *writer, size_t contentOffset, uint64_t pairsCount) {
+    if (pairsCount < 2) {
+        return true;
+    }
+    size_t contentLength = writer->length - contentOffset;
+    YKFCBORWriterPair *pairs = malloc((size_t)pairsCount * sizeof(YKFCBORWriterPair));
+    if (!pairs) {
+        return false;
+    }
+
+    YKFCBORReader reader;
+    YKFCBORReaderInit(&reader, writer->buffer + contentOffset, contentLength);
+    bool isSorted = true;
+    for (size_t i = 0; i < pairsCount; ++i) {
+        YKFCBORWriterPair *pair = &pairs[i];
+        pair->keyOffset = YKFCBORReaderOffset(&reader);
+        if (!YKFCBORReaderSkip(&reader)) {
+            free(pairs);
+            return false;
+        }
+        pair->keyLength = YKFCBORReaderOffset(&reader) - pair->keyOffset;
+        if (!YKFCBORReaderSkip(&reader)) {
+            free(pairs);
+            return false;
+        }
+        pair->pairLength = YKFCBORReaderOffset(&reader) - pair->keyOffset;
+        if (i && YKFCBORWriterCompareKeys(reader.start, &pairs[i - 1], pair) >= 0) {
+            isSorted = false;
+        }
+    }
+    if (isSorted) {
+        free(pairs);
+        return true;
+    }
+
+    // Maps are small in CTAP2, an insertion sort is enough.
+    for (size_t i = 1; i < pairsCount; ++i) {
+        YKFCBORWriterPair pair = pairs[i];
+        size_t j = i;
+        while (j > 0 && YKFCBORWriterCompareKeys(reader.start, &pairs[j - 1], &pair) > 0) {
+            pairs[j] = pairs[j - 1];
+            --j;
+        }
+        pairs[j] = pair;
+    }
+    for (size_t i = 1; i < pairsCount; ++i) {
+        if (YKFCBORWriterCompareKeys(reader.start, &pairs[i - 1], &pairs[i]) == 0) {
+            free(pairs);
+            return false;
+        }
+    }
+
+    uint8_t *content = malloc(contentLength);
+    if (!content) {
+        free(pairs);
+        return false;
+    }
+    memcpy(content, reader.start, contentLength);
+    uint8_t *cursor = writer->buffer + contentOffset;
+    for (size_t i = 0; i < pairsCount; ++i) {
+        memcpy(cursor, content + pairs[i].keyOffset, pairs[i].pairLength);
+        cursor += pairs[i].pairLength;
+    }
+    free(content);
+    free(pairs);
+    return true;
+}
+
+bool YKFCBORWriterEnd(YKFCBORWriter *writer) {
+    if (writer->failed || writer->depth == 0) {
+        writer->failed = true;
+        return false;
+    }
+    YKFCBORWriterContainer container = writer->containers[--writer->depth];
+    if (container.isMap && container.count % 2) {
+        writer->failed = true;
+        return false;
+    }
+    uint64_t argument = container.isMap ? container.count / 2 : container.count;
+    size_t contentOffset = container.headOffset + 1;
+    size_t headLength = YKFCBORHeadLength(argument);
+    if (headLength > 1) {
+        size_t shift = headLength - 1;
+        if (!YKFCBORWriterReserve(writer, shift)) {
+            return false;
+        }
+        memmove(writer->buffer + contentOffset + shift, writer->buffer + contentOffset, writer->length - contentOffset);
+        writer->length += shift;
+        contentOffset += shift;
+    }
+    YKFCBOREncodeHead(writer->buffer + container.headOffset, container.isMap ? YKFCBORMajorTypeMap : YKFCBORMajorTypeArray,
+                      argument, headLength);
+
+    if (container.isMap && !YKFCBORWriterSortPairs(writer, contentOffset, argument)) {
+        writer->failed = true;
+        return false;
+    }
+    return true;
+}
+
+uint8_t *YKFCBORWriterFinish(YKFCBORWriter *writer, size_t *encodedLength) {
+    *encodedLength = 0;
+    if (writer->failed || writer->depth || writer->length == 0) {
+        YKFCBORWriterDiscard(writer);
+        return NULL;
+    }
+    uint8_t *buffer = writer->buffer;
+    *encodedLength = writer->length;
+    memset(writer, 0, sizeof(YKFCBORWriter));
+    return buffer;
+}
+
+void YKFCBORWriterDiscard(YKFCBORWriter *writer) {
+    free(writer->buffer);
+    memset(writer, 0, sizeof(YKFCBORWriter));
+}
@@ -0,0 +1,97 @@
+// Copyright 2018-2021 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef YKFCBORWriter_h
+#define YKFCBORWriter_h
+
+/*
+ Writing of the CTAP2 canonical CBOR encoding into one growable buffer.
+
+ This is plain C, without Foundation, so it can be built and fuzzed on any platform. Items are written in place:
+ arrays and maps are opened with YKFCBORWriterBeginArray/YKFCBORWriterBeginMap and closed with YKFCBORWriterEnd,
+ which writes the number of elements once they are known. When a map is closed its pairs are sorted in the CTAP2
+ canonical order: shorter encoded keys first, then bytewise. The pairs can be written in any order, and the
+ ones already in order are not moved.
+
+ The writer remembers the first failure (allocation, duplicate map key, unbalanced containers), so the result of
+ a sequence of calls can be checked once with YKFCBORWriterFinish.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "YKFCBORReader.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    size_t headOffset;
+    uint64_t count;
+    bool isMap;
+} YKFCBORWriterContainer;
+
+typedef struct {
+    uint8_t *buffer;
+    size_t capacity;
+    size_t length;
+    YKFCBORWriterContainer containers[YKF_CBOR_MAX_DEPTH];
+    size_t depth;
+    bool failed;
+} YKFCBORWriter;
+
+/// Allocates the buffer with the capacity, which grows when needed. A good estimate avoids the reallocations.
+void YKFCBORWriterInit(YKFCBORWriter *writer, size_t capacity);
+
+bool YKFCBORWriterAppendUnsigned(YKFCBORWriter *writer, uint64_t value);
+
+bool YKFCBORWriterAppendInteger(YKFCBORWriter *writer, int64_t value);
+
+bool YKFCBORWriterAppendByteString(YKFCBORWriter *writer, const uint8_t *bytes, size_t length);
+
+/// The bytes must be UTF-8.
+bool YKFCBORWriterAppendTextString(YKFCBORWriter *writer, const char *string, size_t length);
+
+bool YKFCBORWriterAppendBool(YKFCBORWriter *writer, bool value);
+
+/// Appends one item which is already encoded, e.g. a cached COSE key.
+bool YKFCBORWriterAppendEncoded(YKFCBORWriter *writer, const uint8_t *bytes, size_t length);
+
+bool YKFCBORWriterBeginArray(YKFCBORWriter *writer);
+
+/// The following items are the keys and the values of the map, alternately, until YKFCBORWriterEnd is called.
+bool YKFCBORWriterBeginMap(YKFCBORWriter *writer);
+
+/// Closes the last opened array or map and writes its number of elements. Maps are sorted in the canonical order.
+bool YKFCBORWriterEnd(YKFCBORWriter *writer);
+
+/*
+ Returns the encoded bytes, which the caller frees with free(), and the length in encodedLength. Returns NULL when
+ a write failed or a container is still open. The writer is empty after the call in both cases.
+ */
+uint8_t *YKFCBORWriterFinish(YKFCBORWriter *writer, size_t *encodedLength);
+
+/// Frees the buffer of a writer which is not finished.
+void YKFCBORWriterDiscard(YKFCBORWriter *writer);
+
+/// The length of the head of an item, to estimate the capacity of the writer.
+size_t YKFCBORHeadLength(uint64_t argument);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* YKFCBORWriter_h */
@@ -48,9 +48,8 @@
 
 #import "YKFSmartCardInterface.h"
 #import "YKFSelectApplicationAPDU.h"
+#import "YKFTouchPollSchedule.h"
 
-static const int YKFFIDO2RequestMaxRetries = 30; // times
-static const NSTimeInterval YKFFIDO2RequestRetryTimeInterval = 0.5; // seconds
 NSString* const YKFFIDO2OptionRK = @"rk";
 NSString* const YKFFIDO2OptionUV = @"uv";
 NSString* const YKFFIDO2OptionUP = @"up";
@@ -66,6 +65,22 @@ typedef void (^YKFFIDO2SessionClientPinCompletionBlock)
 typedef void (^YKFFIDO2SessionClientPinSharedSecretCompletionBlock)
     (NSData* _Nullable sharedSecret, YKFCBORMap* _Nullable cosePlatformPublicKey, NSError* _Nullable error);
 
+#pragma mark - YKFFIDO2KeyAgreement
+
+/*
+ The key agreement of the PIN protocol with the authenticator: the platform key sent to the authenticator and the
+ shared secret derived from the authenticator key agreement key.
+ */
+@interface YKFFIDO2KeyAgreement: NSObject
+
+@property (nonatomic) YKFCBORMap *cosePlatformPublicKey;
+@property (nonatomic) NSData *sharedSecret;
+
+@end
+
+@implementation YKFFIDO2KeyAgreement
+@end
+
 #pragma mark - YKFFIDO2Session
 
 @interface YKFFIDO2Session()
@@ -77,6 +92,23 @@ typedef void (^YKFFIDO2SessionClientPinSharedSecretCompletionBlock)
 // Keeps the state of the application selection to avoid reselecting the application.
 @property BOOL applicationSelected;
 
+/*
+ The key agreement is reused by the PIN requests of the session, which saves the key generation, the GetKeyAgreement
+ request and the ECDH for each of them. The authenticator keeps its key agreement key until it's power cycled or
+ reset, or until a PIN request fails, so the key agreement is dropped when the session state is cleared, after a
+ reset and after an error of a request using it. Accessed with the session locked.
+ */
+@property (nonatomic, nullable) YKFFIDO2KeyAgreement *keyAgreement;
+
+// A platform key generated in the background, ready for the next key agreement. Accessed with the session locked.
+@property (nonatomic, nullable) YKFFIDO2PinAuthKey *preparedPlatformKey;
+
+/*
+ Incremented when the session state is cleared, so a platform key generated in the background for the previous state
+ is not stored. Accessed with the session locked.
+ */
+@property (nonatomic) NSUInteger platformKeyGeneration;
+
 @end
 
 @implementation YKFFIDO2Session
@@ -95,6 +127,7 @@ typedef void (^YKFFIDO2SessionClientPinSharedSecretCompletionBlock)
             completion(nil, error);
         } else {
             [session updateKeyState:YKFFIDO2SessionKeyStateIdle];
+            [session preparePlatformKey];
             completion(session, nil);
         }
     }];
@@ -102,6 +135,13 @@ typedef void (^YKFFIDO2SessionClientPinSharedSecretCompletionBlock)
 
 - (void)clearSessionState {
     [self clearUserVerification];
+    
+    // The session is not used anymore, the key agreement is dropped without preparing a platform key for the next one.
+    @synchronized (self) {
+        self.keyAgreement = nil;
+        self.preparedPlatformKey = nil;
+        self.platformKeyGeneration += 1;
+    }
 }
 
 #pragma mark - Key State
@@ -122,7 +162,7 @@ typedef void (^YKFFIDO2SessionClientPinSharedSecretCompletionBlock)
     YKFAPDU *apdu = [[YKFFIDO2CommandAPDU alloc] initWithCommand:YKFFIDO2CommandGetInfo data:nil];
     
     ykf_weak_self();
-    [self executeFIDO2Command:apdu retryCount:0 completion:^(NSData * data, NSError *error) {
+    [self executeFIDO2Command:apdu completion:^(NSData * data, NSError *error) {
         ykf_safe_strong_self();
         if (error) {
             completion(nil, error);
@@ -168,6 +208,7 @@ typedef void (^YKFFIDO2SessionClientPinSharedSecretCompletionBlock)
         
         [strongSelf executeClientPinRequest:clientPinGetPinTokenRequest completion:^(YKFFIDO2ClientPinResponse *response, NSError *error) {
             if (error) {
+                [strongSelf clearKeyAgreement];
                 completion(error);
                 return;
             }
@@ -235,6 +276,7 @@ typedef void (^YKFFIDO2SessionClientPinSharedSecretCompletionBlock)
         
         [strongSelf executeClientPinRequest:changePinRequest completion:^(YKFFIDO2ClientPinResponse *response, NSError *error) {
             if (error) {
+                [strongSelf clearKeyAgreement];
                 completion(error);
                 return;
             }
@@ -278,6 +320,7 @@ typedef void (^YKFFIDO2SessionClientPinSharedSecretCompletionBlock)
         
         [strongSelf executeClientPinRequest:setPinRequest completion:^(YKFFIDO2ClientPinResponse *response, NSError *error) {
             if (error) {
+                [strongSelf clearKeyAgreement];
                 completion(error);
                 return;
             }
@@ -337,7 +380,7 @@ typedef void (^YKFFIDO2SessionClientPinSharedSecretCompletionBlock)
     }
     
     ykf_weak_self();
-    [self executeFIDO2Command:apdu retryCount:0 completion:^(NSData *data, NSError *error) {
+    [self executeFIDO2Command:apdu completion:^(NSData *data, NSError *error) {
         ykf_safe_strong_self();
         if (error) {
             completion(nil, error);
@@ -390,7 +433,7 @@ typedef void (^YKFFIDO2SessionClientPinSharedSecretCompletionBlock)
     }
     
     ykf_weak_self();
-    [self executeFIDO2Command:apdu retryCount:0 completion:^(NSData *data, NSError *error) {
+    [self executeFIDO2Command:apdu completion:^(NSData *data, NSError *error) {
         ykf_safe_strong_self();
         if (error) {
             completion(nil, error);
@@ -414,7 +457,7 @@ typedef void (^YKFFIDO2SessionClientPinSharedSecretCompletionBlock)
     YKFAPDU *apdu = [[YKFFIDO2GetNextAssertionAPDU alloc] init];
     
     ykf_weak_self();
-    [self executeFIDO2Command:apdu retryCount:0 completion:^(NSData *data, NSError *error) {
+    [self executeFIDO2Command:apdu completion:^(NSData *data, NSError *error) {
         ykf_safe_strong_self();
         if (error) {
             completion(nil, error);
@@ -438,10 +481,11 @@ typedef void (^YKFFIDO2SessionClientPinSharedSecretCompletionBlock)
     YKFAPDU *apdu = [[YKFFIDO2ResetAPDU alloc] init];
     
     ykf_weak_self();
-    [self executeFIDO2Command:apdu retryCount:0 completion:^(NSData *response, NSError *error) {
+    [self executeFIDO2Command:apdu completion:^(NSData *response, NSError *error) {
         ykf_strong_self();
         if (!error) {
             [strongSelf clearUserVerification];
+            [strongSelf clearKeyAgreement];
         }
         completion(error);
     }];
@@ -462,7 +506,7 @@ typedef void (^YKFFIDO2SessionClientPinSharedSecretCompletionBlock)
     request.apdu = apdu;
     
     ykf_weak_self();
-    [self executeFIDO2Command:request.apdu retryCount:0 completion:^(NSData *data, NSError *error) {
+    [self executeFIDO2Command:request.apdu completion:^(NSData *data, NSError *error) {
         ykf_safe_strong_self();
         if (error) {
             completion(nil, error);
@@ -492,8 +536,22 @@ typedef void (^YKFFIDO2SessionClientPinSharedSecretCompletionBlock)
 - (void)executeGetSharedSecretWithCompletion:(YKFFIDO2SessionClientPinSharedSecretCompletionBlock)completion {
     YKFParameterAssertReturn(completion);
     
-    // Generate the platform key.
-    YKFFIDO2PinAuthKey *platformKey = [[YKFFIDO2PinAuthKey alloc] init];
+    YKFFIDO2KeyAgreement *keyAgreement = nil;
+    YKFFIDO2PinAuthKey *platformKey = nil;
+    @synchronized (self) {
+        keyAgreement = self.keyAgreement;
+        if (!keyAgreement) {
+            platformKey = self.preparedPlatformKey;
+            self.preparedPlatformKey = nil;
+        }
+    }
+    if (keyAgreement) {
+        completion(keyAgreement.sharedSecret, keyAgreement.cosePlatformPublicKey, nil);
+        return;
+    }
+    
+    // Generate the platform key, if it was not prepared in the background.
+    platformKey = platformKey ?: [[YKFFIDO2PinAuthKey alloc] init];
     if (!platformKey) {
         completion(nil, nil, [YKFFIDO2Error errorWithCode:YKFFIDO2ErrorCodeOTHER]);
         return;
@@ -510,7 +568,9 @@ typedef void (^YKFFIDO2SessionClientPinSharedSecretCompletionBlock)
     clientPinKeyAgreementRequest.subCommand = YKFFIDO2ClientPinRequestSubCommandGetKeyAgreement;
     clientPinKeyAgreementRequest.keyAgreement = cosePlatformPublicKey;
     
+    ykf_weak_self();
     [self executeClientPinRequest:clientPinKeyAgreementRequest completion:^(YKFFIDO2ClientPinResponse *response, NSError *error) {
+        ykf_strong_self();
         if (error) {
             completion(nil, nil, error);
             return;
@@ -534,14 +594,62 @@ typedef void (^YKFFIDO2SessionClientPinSharedSecretCompletionBlock)
         }
         sharedSecret = [sharedSecret ykf_SHA256];
         
+        // Keep the key agreement for the next PIN requests.
+        YKFFIDO2KeyAgreement *newKeyAgreement = [[YKFFIDO2KeyAgreement alloc] init];
+        newKeyAgreement.cosePlatformPublicKey = cosePlatformPublicKey;
+        newKeyAgreement.sharedSecret = sharedSecret;
+        @synchronized (strongSelf) {
+            strongSelf.keyAgreement = newKeyAgreement;
+        }
+        
         // Success
         completion(sharedSecret, cosePlatformPublicKey, nil);
     }];
 }
 
+#pragma mark - Key Agreement
+
+- (void)preparePlatformKey {
+    // The key pair generation is slow, it's done in the background while the session is idle.
+    ykf_weak_self();
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+        ykf_safe_strong_self();
+        NSUInteger generation = 0;
+        @synchronized (strongSelf) {
+            if (strongSelf.keyAgreement || strongSelf.preparedPlatformKey) {
+                return;
+            }
+            generation = strongSelf.platformKeyGeneration;
+        }
+        YKFFIDO2PinAuthKey *platformKey = [[YKFFIDO2PinAuthKey alloc] init];
+        @synchronized (strongSelf) {
+            // The session state was cleared while the key was generated.
+            if (strongSelf.platformKeyGeneration != generation) {
+                return;
+            }
+            strongSelf.preparedPlatformKey = strongSelf.preparedPlatformKey ?: platformKey;
+        }
+    });
+}
+
+- (void)clearKeyAgreement {
+    @synchronized (self) {
+        if (!self.keyAgreement) {
+            return;
+        }
+        YKFLogVerbose(@"Clearing FIDO2 Session PIN key agreement.");
+        self.keyAgreement = nil;
+    }
+    [self preparePlatformKey];
+}
+
 #pragma mark - Request Execution
 
-- (void)executeFIDO2Command:(YKFAPDU *)apdu retryCount:(int)retryCount completion:(YKFFIDO2SessionResultCompletionBlock)completion {
+- (void)executeFIDO2Command:(YKFAPDU *)apdu completion:(YKFFIDO2SessionResultCompletionBlock)completion {
+    [self executeFIDO2Command:apdu pollSchedule:nil completion:completion];
+}
+
+- (void)executeFIDO2Command:(YKFAPDU *)apdu pollSchedule:(YKFTouchPollSchedule *)pollSchedule completion:(YKFFIDO2SessionResultCompletionBlock)completion {
     YKFParameterAssertReturn(apdu);
     YKFParameterAssertReturn(completion);
     
@@ -552,7 +660,11 @@ typedef void (^YKFFIDO2SessionClientPinSharedSecretCompletionBlock)
         ykf_safe_strong_self();
 
         if (data) {
-            UInt8 fido2Error = [self fido2ErrorCodeFromResponseData:data];
+            UInt8 fido2Error = [strongSelf fido2ErrorCodeFromResponseData:data];
+            if (fido2Error == YKFFIDO2ErrorCodePIN_AUTH_INVALID) {
+                // The authenticator may have a new key agreement key.
+                [strongSelf clearKeyAgreement];
+            }
             if (fido2Error != YKFFIDO2ErrorCodeSUCCESS) {
                 completion(nil, [YKFFIDO2Error errorWithCode:fido2Error]);
             } else {
@@ -561,7 +673,7 @@ typedef void (^YKFFIDO2SessionClientPinSharedSecretCompletionBlock)
             [strongSelf updateKeyState:YKFFIDO2SessionKeyStateIdle];
         } else {
             if (error.code == YKFAPDUErrorCodeFIDO2TouchRequired) {
-                [strongSelf handleTouchRequired:apdu retryCount:retryCount completion:completion];
+                [strongSelf handleTouchRequired:apdu pollSchedule:pollSchedule completion:completion];
             } else {
                 [strongSelf updateKeyState:YKFFIDO2SessionKeyStateIdle];
                 completion(nil, error);
@@ -585,11 +697,14 @@ typedef void (^YKFFIDO2SessionClientPinSharedSecretCompletionBlock)
     return [data subdataWithRange:NSMakeRange(1, data.length - 1)];
 }
 
-- (void)handleTouchRequired:(YKFAPDU *)apdu  retryCount:(int)retryCount completion:(YKFFIDO2SessionResultCompletionBlock)completion {
+- (void)handleTouchRequired:(YKFAPDU *)apdu pollSchedule:(YKFTouchPollSchedule *)pollSchedule completion:(YKFFIDO2SessionResultCompletionBlock)completion {
     YKFParameterAssertReturn(apdu);
     YKFParameterAssertReturn(completion);
     
-    if (retryCount >= YKFFIDO2RequestMaxRetries) {
+    // The schedule starts when the key asks for touch the first time.
+    pollSchedule = pollSchedule ?: [[YKFTouchPollSchedule alloc] init];
+    
+    if ([pollSchedule isExpiredAtDate:[NSDate date]]) {
         YKFSessionError *timeoutError = [YKFSessionError errorWithCode:YKFSessionErrorTouchTimeoutCode];
         completion(nil, timeoutError);
 
@@ -598,15 +713,15 @@ typedef void (^YKFFIDO2SessionClientPinSharedSecretCompletionBlock)
     }
     
     [self updateKeyState:YKFFIDO2SessionKeyStateTouchKey];
-    retryCount += 1;
 
+    // The poll is scheduled on the communication queue, so a busy main queue doesn't delay it.
     ykf_weak_self();
-    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, YKFFIDO2RequestRetryTimeInterval * NSEC_PER_SEC), dispatch_get_main_queue(), ^{
+    [self.smartCardInterface dispatchAfterCurrentCommands:^{
         ykf_safe_strong_self();
 
         YKFAPDU* apdu = [[YKFFIDO2TouchPoolingAPDU alloc] init];
-        [strongSelf executeFIDO2Command:apdu retryCount:retryCount completion:completion];
-    });
+        [strongSelf executeFIDO2Command:apdu pollSchedule:pollSchedule completion:completion];
+    } delay:[pollSchedule nextInterval]];
 }
 
 @end
@@ -23,6 +23,7 @@ extern NSString* _Nonnull const YKFManagementErrorDomain;
 /// Management error codes.
 typedef NS_ENUM(NSUInteger, YKFManagementErrorCode) {
     YKFManagementErrorCodeUnsupportedOperation = 1,
+    YKFManagementErrorCodeInvalidResponse = 2,
 };
 
 /// @abstract
@@ -0,0 +1,79 @@
+// Copyright 2018-2020 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef YKFOATHAccessKeyCache_h
+#define YKFOATHAccessKeyCache_h
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*!
+ @class YKFOATHAccessKeyCache
+
+ @abstract
+    Memory only cache for the OATH access keys derived from the user password.
+
+ @discussion
+    Deriving the access key from the password runs PBKDF2, which is expensive. When an access key cache is set on
+    the YKFOATHSession, the key derived by a successful unlock is kept for the time to live, identified by the salt
+    of the OATH application (the select ID of the device). The next unlock with the same password skips the
+    derivation and only performs the HMAC challenge-response with the key.
+
+    The cached keys are never persisted and their bytes are overwritten when they expire, when they are removed
+    and when the cache is deallocated. The same cache instance can be shared by the sessions of multiple connections.
+
+ @note
+    This class is thread safe.
+ */
+@interface YKFOATHAccessKeyCache: NSObject
+
+/*!
+ The time interval, in seconds, for which an access key is kept after being stored.
+ */
+@property (nonatomic, readonly) NSTimeInterval timeToLive;
+
+/*!
+ @param timeToLive
+    The time interval, in seconds, for which an access key is kept after being stored.
+ */
+- (instancetype)initWithTimeToLive:(NSTimeInterval)timeToLive NS_DESIGNATED_INITIALIZER;
+
+/*!
+ Returns the access key derived from the password for the salt, or nil if it is not cached or expired.
+ */
+- (nullable NSData *)accessKeyForPassword:(NSString *)password salt:(NSData *)salt;
+
+/*!
+ Stores the access key derived from the password for the salt, replacing any key stored for the salt.
+ */
+- (void)storeAccessKey:(NSData *)accessKey forPassword:(NSString *)password salt:(NSData *)salt;
+
+/*!
+ Removes and zeroizes the access key stored for the salt.
+ */
+- (void)removeAccessKeyForSalt:(NSData *)salt;
+
+/*!
+ Removes and zeroizes all stored access keys.
+ */
+- (void)clear;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@end
+
+NS_ASSUME_NONNULL_END
+
+#endif /* YKFOATHAccessKeyCache_h */
@@ -0,0 +1,126 @@
+// Copyright 2018-2020 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <CommonCrypto/CommonCrypto.h>
+
+#import "YKFOATHAccessKeyCache.h"
+#import "YKFAssert.h"
+
+@interface YKFOATHAccessKeyCacheEntry: NSObject
+
+// HMAC-SHA256 of the password with the salt, to match the password without storing it.
+@property (nonatomic) NSMutableData *passwordDigest;
+@property (nonatomic) NSMutableData *accessKey;
+@property (nonatomic) NSDate *expirationDate;
+
+- (void)zeroize;
+
+@end
+
+@implementation YKFOATHAccessKeyCacheEntry
+
+- (void)zeroize {
+    [self.passwordDigest resetBytesInRange:NSMakeRange(0, self.passwordDigest.length)];
+    [self.accessKey resetBytesInRange:NSMakeRange(0, self.accessKey.length)];
+}
+
+@end
+
+@interface YKFOATHAccessKeyCache()
+
+@property (nonatomic, readwrite) NSTimeInterval timeToLive;
+@property (nonatomic) NSMutableDictionary<NSData *, YKFOATHAccessKeyCacheEntry *> *entries;
+
+@end
+
+@implementation YKFOATHAccessKeyCache
+
+- (instancetype)initWithTimeToLive:(NSTimeInterval)timeToLive {
+    self = [super init];
+    if (self) {
+        self.timeToLive = timeToLive;
+        self.entries = [[NSMutableDictionary alloc] init];
+    }
+    return self;
+}
+
+- (void)dealloc {
+    [self clear];
+}
+
+- (NSData *)accessKeyForPassword:(NSString *)password salt:(NSData *)salt {
+    YKFParameterAssertReturnValue(password, nil);
+    YKFParameterAssertReturnValue(salt.length, nil);
+
+    NSData *passwordDigest = [YKFOATHAccessKeyCache digestOfPassword:password salt:salt];
+    @synchronized (self) {
+        YKFOATHAccessKeyCacheEntry *entry = self.entries[salt];
+        if (!entry) {
+            return nil;
+        }
+        if ([entry.expirationDate timeIntervalSinceNow] <= 0) {
+            [entry zeroize];
+            [self.entries removeObjectForKey:salt];
+            return nil;
+        }
+        if (![entry.passwordDigest isEqualToData:passwordDigest]) {
+            return nil;
+        }
+        return [entry.accessKey copy];
+    }
+}
+
+- (void)storeAccessKey:(NSData *)accessKey forPassword:(NSString *)password salt:(NSData *)salt {
+    YKFParameterAssertReturn(accessKey.length);
+    YKFParameterAssertReturn(password);
+    YKFParameterAssertReturn(salt.length);
+
+    YKFOATHAccessKeyCacheEntry *entry = [[YKFOATHAccessKeyCacheEntry alloc] init];
+    entry.passwordDigest = [[YKFOATHAccessKeyCache digestOfPassword:password salt:salt] mutableCopy];
+    entry.accessKey = [accessKey mutableCopy];
+    entry.expirationDate = [NSDate dateWithTimeIntervalSinceNow:self.timeToLive];
+
+    @synchronized (self) {
+        [self.entries[salt] zeroize];
+        self.entries[[salt copy]] = entry;
+    }
+}
+
+- (void)removeAccessKeyForSalt:(NSData *)salt {
+    YKFParameterAssertReturn(salt);
+    @synchronized (self) {
+        [self.entries[salt] zeroize];
+        [self.entries removeObjectForKey:salt];
+    }
+}
+
+- (void)clear {
+    @synchronized (self) {
+        for (YKFOATHAccessKeyCacheEntry *entry in self.entries.allValues) {
+            [entry zeroize];
+        }
+        [self.entries removeAllObjects];
+    }
+}
+
+#pragma mark - Helpers
+
++ (NSData *)digestOfPassword:(NSString *)password salt:(NSData *)salt {
+    NSData *passwordData = [password dataUsingEncoding:NSUTF8StringEncoding];
+    UInt8 digest[CC_SHA256_DIGEST_LENGTH];
+    CCHmac(kCCHmacAlgSHA256, salt.bytes, salt.length, passwordData.bytes, passwordData.length, digest);
+    return [NSData dataWithBytes:digest length:CC_SHA256_DIGEST_LENGTH];
+}
+
+@end
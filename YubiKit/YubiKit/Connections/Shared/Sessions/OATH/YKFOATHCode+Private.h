@@ -19,6 +19,12 @@
 
 - (nonnull instancetype)initWithOtp:(nullable NSString *)otp validity:(nonnull NSDateInterval *)validity;
 
+/*!
+ Initializes the code with the truncated response value from the key. The OTP string is created from the value
+ when accessed.
+ */
+- (nonnull instancetype)initWithTruncatedValue:(UInt32)value digits:(UInt8)digits validity:(nonnull NSDateInterval *)validity;
+
 - (nullable instancetype)initWithKeyResponseData:(nonnull NSData *)responseData requestTimetamp:(nonnull NSDate *)timestamp requestPeriod:(NSUInteger)period NS_DESIGNATED_INITIALIZER;
 
 @end
@@ -27,6 +27,10 @@ typedef NS_ENUM(NSUInteger, YKFOATHCalculateResponseType) {
 @property (nonatomic, readwrite) NSString *otp;
 @property (nonatomic, readwrite) NSDateInterval *validity;
 
+// The value and number of digits of an OTP which is formatted on the first access.
+@property (nonatomic) UInt32 truncatedValue;
+@property (nonatomic) UInt8 digits;
+
 @end
 
 @implementation YKFOATHCode
@@ -40,6 +44,32 @@ typedef NS_ENUM(NSUInteger, YKFOATHCalculateResponseType) {
     return self;
 }
 
+- (instancetype)initWithTruncatedValue:(UInt32)value digits:(UInt8)digits validity:(NSDateInterval *)validity {
+    self = [self init];
+    if (self) {
+        self.truncatedValue = value;
+        self.digits = digits;
+        self.validity = validity;
+    }
+    return self;
+}
+
+- (NSString *)otp {
+    if (!_otp && self.digits) {
+        @synchronized (self) {
+            if (!_otp) {
+                UInt32 modulus = 1;
+                for (UInt8 i = 0; i < self.digits; ++i) {
+                    modulus *= 10;
+                }
+                UInt32 value = (self.truncatedValue & 0x7FFFFFFF) % modulus; // remove the sign bit, keep [digits] only
+                _otp = [NSString stringWithFormat:@"%0*u", (int)self.digits, (unsigned int)value];
+            }
+        }
+    }
+    return _otp;
+}
+
 - (nullable instancetype)initWithKeyResponseData:(nonnull NSData *)responseData requestTimetamp:(NSDate *)timestamp requestPeriod:(NSUInteger)period {
     YKFAssertAbortInit(responseData.length);
     YKFAssertAbortInit(timestamp);
@@ -0,0 +1,81 @@
+// Copyright 2018-2020 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef YKFOATHCodeCache_h
+#define YKFOATHCodeCache_h
+
+#import <Foundation/Foundation.h>
+
+@class YKFOATHCredential, YKFOATHCode, YKFOATHCredentialWithCode;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*!
+ In-session cache of the codes returned by the key, keyed by credential ID and period.
+
+ A new CALCULATE ALL is required when a code with the period of the last CALCULATE ALL expires. The credentials
+ with another period are marked as requiring a targeted calculation whenever their own validity window has rolled over.
+
+ @note
+    The cache is thread safe.
+ */
+@interface YKFOATHCodeCache: NSObject
+
+/*!
+ The period of the challenge sent with the last CALCULATE ALL. Defaults to 30 seconds.
+ */
+@property (nonatomic, readonly) NSUInteger calculateAllPeriod;
+
+/*!
+ YES if the cache does not contain the list of credentials from the key or if any TOTP code with the
+ CALCULATE ALL period is not valid at the specified date, which requires a new CALCULATE ALL.
+ */
+- (BOOL)requiresCalculateAllAtDate:(NSDate *)date;
+
+/*!
+ The TOTP credentials with a period other than the CALCULATE ALL period which do not have a valid code at the specified date.
+ */
+- (NSArray<YKFOATHCredential *> *)credentialsRequiringCalculationAtDate:(NSDate *)date;
+
+/*!
+ Replaces the list of cached credentials with the merged result of a CALCULATE ALL sent with the challenge for
+ the period, where the codes of the credentials with a different period were calculated individually.
+ */
+- (void)updateWithCalculateAllResult:(NSArray<YKFOATHCredentialWithCode *> *)result period:(NSUInteger)period;
+
+/*!
+ Stores a code calculated for a single credential. The code is ignored if the credential is not in the cache.
+ */
+- (void)updateCode:(YKFOATHCode *)code forCredential:(YKFOATHCredential *)credential;
+
+/*!
+ The cached credentials in the order returned by the key. Returns nil if the cache is empty.
+ */
+- (nullable NSArray<YKFOATHCredentialWithCode *> *)credentialsWithCodes;
+
+/*!
+ The earliest end of validity of the cached TOTP codes or nil if no cached code expires.
+ */
+@property (nonatomic, readonly, nullable) NSDate *nextExpirationDate;
+
+/*!
+ Removes all cached credentials and codes.
+ */
+- (void)invalidate;
+
+@end
+
+NS_ASSUME_NONNULL_END
+
+#endif /* YKFOATHCodeCache_h */
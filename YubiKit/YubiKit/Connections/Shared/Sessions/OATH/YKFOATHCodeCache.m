@@ -0,0 +1,177 @@
+// Copyright 2018-2020 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import "YKFOATHCodeCache.h"
+#import "YKFOATHCredential.h"
+#import "YKFOATHCredential+Private.h"
+#import "YKFOATHCredentialTypes.h"
+#import "YKFOATHCredentialWithCode.h"
+#import "YKFOATHCode.h"
+#import "YKFAssert.h"
+
+@interface YKFOATHCodeCache()
+
+// Cache keys in the order returned by the key.
+@property (nonatomic) NSMutableArray<NSString *> *orderedKeys;
+@property (nonatomic) NSMutableDictionary<NSString *, YKFOATHCredentialWithCode *> *entries;
+@property (nonatomic, readwrite) NSUInteger calculateAllPeriod;
+
+@end
+
+@implementation YKFOATHCodeCache
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        self.orderedKeys = [[NSMutableArray alloc] init];
+        self.entries = [[NSMutableDictionary alloc] init];
+        self.calculateAllPeriod = YKFOATHCredentialDefaultPeriod;
+    }
+    return self;
+}
+
+#pragma mark - Queries
+
+- (BOOL)requiresCalculateAllAtDate:(NSDate *)date {
+    YKFParameterAssertReturnValue(date, YES);
+
+    @synchronized (self) {
+        if (!self.orderedKeys.count) {
+            return YES;
+        }
+        for (YKFOATHCredentialWithCode *entry in self.entries.allValues) {
+            if (![YKFOATHCodeCache hasExpiringCode:entry.credential] || entry.credential.period != self.calculateAllPeriod) {
+                continue;
+            }
+            if (![YKFOATHCodeCache code:entry.code isValidAtDate:date]) {
+                return YES;
+            }
+        }
+        return NO;
+    }
+}
+
+- (NSArray<YKFOATHCredential *> *)credentialsRequiringCalculationAtDate:(NSDate *)date {
+    YKFParameterAssertReturnValue(date, @[]);
+
+    NSMutableArray *credentials = [[NSMutableArray alloc] init];
+    @synchronized (self) {
+        for (NSString *key in self.orderedKeys) {
+            YKFOATHCredentialWithCode *entry = self.entries[key];
+            if (![YKFOATHCodeCache hasExpiringCode:entry.credential] || entry.credential.period == self.calculateAllPeriod) {
+                continue;
+            }
+            if (![YKFOATHCodeCache code:entry.code isValidAtDate:date]) {
+                [credentials addObject:entry.credential];
+            }
+        }
+    }
+    return [credentials copy];
+}
+
+- (NSArray<YKFOATHCredentialWithCode *> *)credentialsWithCodes {
+    @synchronized (self) {
+        if (!self.orderedKeys.count) {
+            return nil;
+        }
+        NSMutableArray *result = [[NSMutableArray alloc] initWithCapacity:self.orderedKeys.count];
+        for (NSString *key in self.orderedKeys) {
+            [result addObject:self.entries[key]];
+        }
+        return [result copy];
+    }
+}
+
+- (NSDate *)nextExpirationDate {
+    NSDate *expirationDate = nil;
+    @synchronized (self) {
+        for (YKFOATHCredentialWithCode *entry in self.entries.allValues) {
+            if (![YKFOATHCodeCache hasExpiringCode:entry.credential] || !entry.code.otp) {
+                continue;
+            }
+            NSDate *endDate = entry.code.validity.endDate;
+            if (!expirationDate || [endDate compare:expirationDate] == NSOrderedAscending) {
+                expirationDate = endDate;
+            }
+        }
+    }
+    return expirationDate;
+}
+
+#pragma mark - Updates
+
+- (void)updateWithCalculateAllResult:(NSArray<YKFOATHCredentialWithCode *> *)result period:(NSUInteger)period {
+    YKFParameterAssertReturn(result);
+    YKFParameterAssertReturn(period);
+
+    @synchronized (self) {
+        NSMutableArray *orderedKeys = [[NSMutableArray alloc] initWithCapacity:result.count];
+        NSMutableDictionary *entries = [[NSMutableDictionary alloc] initWithCapacity:result.count];
+
+        for (YKFOATHCredentialWithCode *entry in result) {
+            NSString *cacheKey = [YKFOATHCodeCache cacheKeyForCredential:entry.credential];
+            if (!entries[cacheKey]) {
+                [orderedKeys addObject:cacheKey];
+            }
+            entries[cacheKey] = entry;
+        }
+
+        self.orderedKeys = orderedKeys;
+        self.entries = entries;
+        self.calculateAllPeriod = period;
+    }
+}
+
+- (void)updateCode:(YKFOATHCode *)code forCredential:(YKFOATHCredential *)credential {
+    YKFParameterAssertReturn(code);
+    YKFParameterAssertReturn(credential);
+
+    NSString *cacheKey = [YKFOATHCodeCache cacheKeyForCredential:credential];
+    @synchronized (self) {
+        YKFOATHCredentialWithCode *entry = self.entries[cacheKey];
+        if (!entry) {
+            return;
+        }
+        self.entries[cacheKey] = [[YKFOATHCredentialWithCode alloc] initWithCredential:entry.credential code:code];
+    }
+}
+
+- (void)invalidate {
+    @synchronized (self) {
+        [self.orderedKeys removeAllObjects];
+        [self.entries removeAllObjects];
+        self.calculateAllPeriod = YKFOATHCredentialDefaultPeriod;
+    }
+}
+
+#pragma mark - Helpers
+
++ (NSString *)cacheKeyForCredential:(YKFOATHCredential *)credential {
+    return [NSString stringWithFormat:@"%lu:%@", (unsigned long)credential.period, credential.key];
+}
+
+// Only TOTP codes which do not require touch are calculated without user interaction and expire.
++ (BOOL)hasExpiringCode:(YKFOATHCredential *)credential {
+    return credential.type == YKFOATHCredentialTypeTOTP && !credential.requiresTouch;
+}
+
++ (BOOL)code:(YKFOATHCode *)code isValidAtDate:(NSDate *)date {
+    if (!code.otp) {
+        return NO;
+    }
+    NSDateInterval *validity = code.validity;
+    return [validity.startDate compare:date] != NSOrderedDescending && [date compare:validity.endDate] == NSOrderedAscending;
+}
+
+@end
@@ -27,4 +27,11 @@
  */
 @property (nonatomic, nonnull) NSString *key;
 
+/*!
+ Initializes the credential with the name stored on the key at range in data, without copying it. The period,
+ issuer and account are located with a single scan of the name bytes and the strings are created only
+ when the properties are accessed.
+ */
+- (nonnull instancetype)initWithKeyData:(nonnull NSData *)data range:(NSRange)range type:(YKFOATHCredentialType)type;
+
 @end
@@ -22,8 +22,70 @@
 
 #import "MF_Base32Additions.h"
 
+@interface YKFOATHCredential()
+
+/*
+ The response data which contains the name of the credential, when created from a key response. The key,
+ issuer and account name strings are created from the ranges of this buffer on the first access.
+ */
+@property (nonatomic, nullable) NSData *keyData;
+@property (nonatomic) NSRange keyRange;
+@property (nonatomic) NSRange issuerRange;
+@property (nonatomic) NSRange accountRange;
+
+@end
+
 @implementation YKFOATHCredential
 
+@synthesize issuer = _issuer;
+
+- (instancetype)initWithKeyData:(NSData *)data range:(NSRange)range type:(YKFOATHCredentialType)type {
+    self = [super init];
+    if (self) {
+        self.keyData = data;
+        self.keyRange = range;
+        self.type = type;
+        
+        const UInt8 *bytes = (const UInt8 *)data.bytes + range.location;
+        NSUInteger length = range.length;
+        
+        // TOTP key with format [period]/[label]. The period is the number at the beginning of the key,
+        // ignored when missing or 0.
+        NSUInteger labelOffset = 0;
+        NSUInteger period = 0;
+        NSUInteger index = 0;
+        while (index < length && bytes[index] >= '0' && bytes[index] <= '9') {
+            period = period * 10 + (bytes[index] - '0');
+            ++index;
+        }
+        if (period && memchr(bytes + index, '/', length - index)) {
+            labelOffset = (const UInt8 *)memchr(bytes + index, '/', length - index) - bytes + 1;
+        } else {
+            period = 0;
+        }
+        if (type == YKFOATHCredentialTypeTOTP) {
+            self.period = period ? period : YKFOATHCredentialDefaultPeriod;
+        }
+        
+        // Label with format [issuer]:[account], split at the last colon.
+        NSInteger separator = -1;
+        for (NSUInteger i = length; i > labelOffset; --i) {
+            if (bytes[i - 1] == ':') {
+                separator = i - 1;
+                break;
+            }
+        }
+        if (separator >= 0) {
+            self.issuerRange = NSMakeRange(range.location + labelOffset, separator - labelOffset);
+            self.accountRange = NSMakeRange(range.location + separator + 1, length - separator - 1);
+        } else {
+            self.issuerRange = NSMakeRange(NSNotFound, 0);
+            self.accountRange = NSMakeRange(range.location + labelOffset, length - labelOffset);
+        }
+    }
+    return self;
+}
+
 #pragma mark - Properties Overrides
 
 - (YKFOATHCredentialType)type {
@@ -41,12 +103,54 @@
 }
 
 - (NSString *)key {
+    if (!_key && self.keyData) {
+        @synchronized (self) {
+            if (!_key) {
+                _key = [self stringFromKeyDataRange:self.keyRange];
+            }
+        }
+    }
     if (!_key) {
         return [YKFOATHCredentialUtils keyFromCredentialIdentifier:self];
     }
     return _key;
 }
 
+- (NSString *)issuer {
+    if (!_issuer && self.keyData && self.issuerRange.location != NSNotFound) {
+        @synchronized (self) {
+            if (!_issuer) {
+                _issuer = [self stringFromKeyDataRange:self.issuerRange];
+            }
+        }
+    }
+    return _issuer;
+}
+
+- (void)setIssuer:(NSString *)issuer {
+    @synchronized (self) {
+        // An explicit value replaces the issuer parsed from the key.
+        self.issuerRange = NSMakeRange(NSNotFound, 0);
+        _issuer = issuer;
+    }
+}
+
+- (NSString *)accountName {
+    if (!_accountName && self.keyData) {
+        @synchronized (self) {
+            if (!_accountName) {
+                _accountName = [self stringFromKeyDataRange:self.accountRange];
+            }
+        }
+    }
+    return _accountName;
+}
+
+- (NSString *)stringFromKeyDataRange:(NSRange)range {
+    const void *bytes = (const UInt8 *)self.keyData.bytes + range.location;
+    return [[NSString alloc] initWithBytes:bytes length:range.length encoding:NSUTF8StringEncoding];
+}
+
 - (NSString *)label {
     YKFAssertReturnValue(self.accountName, @"Missing OATH credential account. Cannot build the credential label.", nil);
     
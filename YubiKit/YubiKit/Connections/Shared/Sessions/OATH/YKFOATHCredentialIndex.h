@@ -0,0 +1,55 @@
+// Copyright 2018-2020 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef YKFOATHCredentialIndex_h
+#define YKFOATHCredentialIndex_h
+
+#import <Foundation/Foundation.h>
+
+@class YKFOATHCredential, YKFOATHCredentialWithCode, YKFOATHCredentialsDelta;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*!
+ Index of the credentials returned by the last refresh of a session, keyed by the credential ID. Each update
+ is compared with the index to build the delta and replaces the indexed credentials, reusing the previous
+ objects of the credentials which did not change.
+
+ @note
+    The index is thread safe.
+ */
+@interface YKFOATHCredentialIndex: NSObject
+
+/*!
+ Updates the index with the result of a Calculate All and returns the changes, including the changed codes.
+ */
+- (YKFOATHCredentialsDelta *)updateWithCredentials:(NSArray<YKFOATHCredentialWithCode *> *)credentials;
+
+/*!
+ Updates the index with the result of a List and returns the changes. The List doesn't return codes, so the
+ credentials which had a code are returned without it and reported with a changed code.
+ */
+- (YKFOATHCredentialsDelta *)updateWithListedCredentials:(NSArray<YKFOATHCredential *> *)credentials;
+
+/*!
+ Records a rename done with the session, reported as such by the next update instead of a removed and
+ an added credential.
+ */
+- (void)recordRenameFromKey:(NSString *)previousKey toKey:(NSString *)key;
+
+@end
+
+NS_ASSUME_NONNULL_END
+
+#endif /* YKFOATHCredentialIndex_h */
@@ -0,0 +1,169 @@
+// Copyright 2018-2020 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import "YKFOATHCredentialIndex.h"
+#import "YKFOATHCredential.h"
+#import "YKFOATHCredential+Private.h"
+#import "YKFOATHCredentialWithCode.h"
+#import "YKFOATHCredentialsDelta.h"
+#import "YKFOATHCredentialsDelta+Private.h"
+#import "YKFOATHCode.h"
+#import "YKFAssert.h"
+
+@interface YKFOATHCredentialIndex()
+
+@property (nonatomic) NSArray<NSString *> *orderedKeys;
+@property (nonatomic) NSDictionary<NSString *, YKFOATHCredentialWithCode *> *entries;
+
+// Renames done since the last update, from the previous key to the new key.
+@property (nonatomic) NSMutableDictionary<NSString *, NSString *> *pendingRenames;
+
+@end
+
+@implementation YKFOATHCredentialIndex
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        self.orderedKeys = @[];
+        self.entries = @{};
+        self.pendingRenames = [[NSMutableDictionary alloc] init];
+    }
+    return self;
+}
+
+#pragma mark - Updates
+
+- (YKFOATHCredentialsDelta *)updateWithCredentials:(NSArray<YKFOATHCredentialWithCode *> *)credentials {
+    YKFParameterAssertReturnValue(credentials, nil);
+    return [self updateWithEntries:credentials compareTouch:YES];
+}
+
+- (YKFOATHCredentialsDelta *)updateWithListedCredentials:(NSArray<YKFOATHCredential *> *)credentials {
+    YKFParameterAssertReturnValue(credentials, nil);
+    
+    NSMutableArray *entries = [[NSMutableArray alloc] initWithCapacity:credentials.count];
+    for (YKFOATHCredential *credential in credentials) {
+        [entries addObject:[[YKFOATHCredentialWithCode alloc] initWithCredential:credential code:nil]];
+    }
+    // The List response doesn't tell if a credential requires touch.
+    return [self updateWithEntries:entries compareTouch:NO];
+}
+
+- (void)recordRenameFromKey:(NSString *)previousKey toKey:(NSString *)key {
+    YKFParameterAssertReturn(previousKey);
+    YKFParameterAssertReturn(key);
+    @synchronized (self) {
+        self.pendingRenames[previousKey] = key;
+    }
+}
+
+- (YKFOATHCredentialsDelta *)updateWithEntries:(NSArray<YKFOATHCredentialWithCode *> *)newEntries compareTouch:(BOOL)compareTouch {
+    @synchronized (self) {
+        NSDictionary<NSString *, YKFOATHCredentialWithCode *> *previousEntries = self.entries;
+        
+        NSMutableArray<NSString *> *orderedKeys = [[NSMutableArray alloc] initWithCapacity:newEntries.count];
+        NSMutableDictionary<NSString *, YKFOATHCredentialWithCode *> *entries = [[NSMutableDictionary alloc] initWithCapacity:newEntries.count];
+        for (YKFOATHCredentialWithCode *entry in newEntries) {
+            NSString *key = entry.credential.key;
+            if (!entries[key]) {
+                [orderedKeys addObject:key];
+            }
+            entries[key] = entry;
+        }
+        
+        // Renames are reported only when the previous credential is gone and the renamed one exists.
+        NSMutableDictionary<NSString *, NSString *> *renamedFromKeys = [[NSMutableDictionary alloc] init];
+        [self.pendingRenames enumerateKeysAndObjectsUsingBlock:^(NSString *previousKey, NSString *key, BOOL *stop) {
+            if (previousEntries[previousKey] && !entries[previousKey] && entries[key] && !previousEntries[key]) {
+                renamedFromKeys[key] = previousKey;
+            }
+        }];
+        [self.pendingRenames removeAllObjects];
+        
+        NSMutableArray *credentials = [[NSMutableArray alloc] initWithCapacity:orderedKeys.count];
+        NSMutableArray *added = [[NSMutableArray alloc] init];
+        NSMutableArray *renamed = [[NSMutableArray alloc] init];
+        NSMutableArray *codeChanged = [[NSMutableArray alloc] init];
+        
+        for (NSString *key in orderedKeys) {
+            YKFOATHCredentialWithCode *entry = entries[key];
+            YKFOATHCredentialWithCode *previousEntry = previousEntries[key];
+            
+            if (previousEntry && [YKFOATHCredentialIndex credential:previousEntry.credential isEqualToCredential:entry.credential compareTouch:compareTouch]) {
+                // The listed credentials have no code, the codes of the previous refresh are cleared as stale.
+                if ([YKFOATHCredentialIndex code:previousEntry.code isEqualToCode:entry.code]) {
+                    entry = previousEntry;
+                } else {
+                    entry = [[YKFOATHCredentialWithCode alloc] initWithCredential:previousEntry.credential code:entry.code];
+                    [codeChanged addObject:entry];
+                }
+            } else if (previousEntry) {
+                // Same ID with a different type or period: the credential was replaced.
+                [added addObject:entry];
+            } else if (renamedFromKeys[key]) {
+                YKFOATHCredential *previousCredential = previousEntries[renamedFromKeys[key]].credential;
+                [renamed addObject:[[YKFOATHRenamedCredential alloc] initWithPreviousCredential:previousCredential credential:entry]];
+            } else {
+                [added addObject:entry];
+            }
+            entries[key] = entry;
+            [credentials addObject:entry];
+        }
+        
+        NSMutableArray *removed = [[NSMutableArray alloc] init];
+        NSSet<NSString *> *renamedPreviousKeys = [NSSet setWithArray:renamedFromKeys.allValues];
+        for (NSString *previousKey in self.orderedKeys) {
+            YKFOATHCredentialWithCode *previousEntry = previousEntries[previousKey];
+            YKFOATHCredentialWithCode *entry = entries[previousKey];
+            if ([renamedPreviousKeys containsObject:previousKey]) {
+                continue;
+            }
+            if (!entry || entry.credential != previousEntry.credential) {
+                [removed addObject:previousEntry.credential];
+            }
+        }
+        
+        self.orderedKeys = orderedKeys;
+        self.entries = entries;
+        
+        return [[YKFOATHCredentialsDelta alloc] initWithCredentials:[credentials copy]
+                                                              added:[added copy]
+                                                            removed:[removed copy]
+                                                            renamed:[renamed copy]
+                                                        codeChanged:[codeChanged copy]];
+    }
+}
+
+#pragma mark - Helpers
+
++ (BOOL)credential:(YKFOATHCredential *)credential isEqualToCredential:(YKFOATHCredential *)otherCredential compareTouch:(BOOL)compareTouch {
+    if (credential.type != otherCredential.type || credential.period != otherCredential.period) {
+        return NO;
+    }
+    return !compareTouch || credential.requiresTouch == otherCredential.requiresTouch;
+}
+
++ (BOOL)code:(YKFOATHCode *)code isEqualToCode:(YKFOATHCode *)otherCode {
+    if (code == otherCode) {
+        return YES;
+    }
+    // The codes of HOTP credentials and of credentials requiring touch are not calculated by a refresh.
+    if (!code.otp && !otherCode.otp) {
+        return YES;
+    }
+    return [code.otp isEqualToString:otherCode.otp] && [code.validity isEqual:otherCode.validity];
+}
+
+@end
@@ -0,0 +1,36 @@
+// Copyright 2018-2020 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <Foundation/Foundation.h>
+#import "YKFOATHCredentialsDelta.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface YKFOATHRenamedCredential()
+
+- (instancetype)initWithPreviousCredential:(YKFOATHCredential *)previousCredential credential:(YKFOATHCredentialWithCode *)credential NS_DESIGNATED_INITIALIZER;
+
+@end
+
+@interface YKFOATHCredentialsDelta()
+
+- (instancetype)initWithCredentials:(NSArray<YKFOATHCredentialWithCode *> *)credentials
+                              added:(NSArray<YKFOATHCredentialWithCode *> *)added
+                            removed:(NSArray<YKFOATHCredential *> *)removed
+                            renamed:(NSArray<YKFOATHRenamedCredential *> *)renamed
+                        codeChanged:(NSArray<YKFOATHCredentialWithCode *> *)codeChanged NS_DESIGNATED_INITIALIZER;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,96 @@
+// Copyright 2018-2020 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef YKFOATHCredentialsDelta_h
+#define YKFOATHCredentialsDelta_h
+
+#import <Foundation/Foundation.h>
+
+@class YKFOATHCredential, YKFOATHCredentialWithCode;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*!
+ @class YKFOATHRenamedCredential
+
+ @abstract
+    A credential renamed with the session since the previous refresh.
+ */
+@interface YKFOATHRenamedCredential: NSObject
+
+/*!
+ The credential before the rename, as returned by the previous refresh.
+ */
+@property (nonatomic, readonly) YKFOATHCredential *previousCredential;
+
+/*!
+ The renamed credential and its current code.
+ */
+@property (nonatomic, readonly) YKFOATHCredentialWithCode *credential;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@end
+
+/*!
+ @class YKFOATHCredentialsDelta
+
+ @abstract
+    The changes of the credentials stored on the key since the previous refresh done with the same session.
+
+ @discussion
+    The objects of the unchanged credentials are the same instances returned by the previous refresh, so
+    they can be compared by identity. A credential with a new code keeps the same YKFOATHCredential instance
+    and is returned in a new YKFOATHCredentialWithCode. The first refresh of a session returns all credentials
+    as added.
+ */
+@interface YKFOATHCredentialsDelta: NSObject
+
+/*!
+ All the credentials stored on the key, in the order returned by the key.
+ */
+@property (nonatomic, readonly) NSArray<YKFOATHCredentialWithCode *> *credentials;
+
+/*!
+ The credentials which were not returned by the previous refresh.
+ */
+@property (nonatomic, readonly) NSArray<YKFOATHCredentialWithCode *> *added;
+
+/*!
+ The credentials returned by the previous refresh which are not stored on the key anymore.
+ */
+@property (nonatomic, readonly) NSArray<YKFOATHCredential *> *removed;
+
+/*!
+ The credentials renamed since the previous refresh. They are not part of the added and removed credentials.
+ */
+@property (nonatomic, readonly) NSArray<YKFOATHRenamedCredential *> *renamed;
+
+/*!
+ The unchanged credentials which have a different code than in the previous refresh.
+ */
+@property (nonatomic, readonly) NSArray<YKFOATHCredentialWithCode *> *codeChanged;
+
+/*!
+ YES if any credential was added, removed, renamed or has a new code.
+ */
+@property (nonatomic, readonly) BOOL hasChanges;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@end
+
+NS_ASSUME_NONNULL_END
+
+#endif /* YKFOATHCredentialsDelta_h */
@@ -0,0 +1,70 @@
+// Copyright 2018-2020 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import "YKFOATHCredentialsDelta.h"
+#import "YKFOATHCredentialsDelta+Private.h"
+
+@interface YKFOATHRenamedCredential()
+
+@property (nonatomic, readwrite) YKFOATHCredential *previousCredential;
+@property (nonatomic, readwrite) YKFOATHCredentialWithCode *credential;
+
+@end
+
+@implementation YKFOATHRenamedCredential
+
+- (instancetype)initWithPreviousCredential:(YKFOATHCredential *)previousCredential credential:(YKFOATHCredentialWithCode *)credential {
+    self = [super init];
+    if (self) {
+        self.previousCredential = previousCredential;
+        self.credential = credential;
+    }
+    return self;
+}
+
+@end
+
+@interface YKFOATHCredentialsDelta()
+
+@property (nonatomic, readwrite) NSArray<YKFOATHCredentialWithCode *> *credentials;
+@property (nonatomic, readwrite) NSArray<YKFOATHCredentialWithCode *> *added;
+@property (nonatomic, readwrite) NSArray<YKFOATHCredential *> *removed;
+@property (nonatomic, readwrite) NSArray<YKFOATHRenamedCredential *> *renamed;
+@property (nonatomic, readwrite) NSArray<YKFOATHCredentialWithCode *> *codeChanged;
+
+@end
+
+@implementation YKFOATHCredentialsDelta
+
+- (instancetype)initWithCredentials:(NSArray<YKFOATHCredentialWithCode *> *)credentials
+                              added:(NSArray<YKFOATHCredentialWithCode *> *)added
+                            removed:(NSArray<YKFOATHCredential *> *)removed
+                            renamed:(NSArray<YKFOATHRenamedCredential *> *)renamed
+                        codeChanged:(NSArray<YKFOATHCredentialWithCode *> *)codeChanged {
+    self = [super init];
+    if (self) {
+        self.credentials = credentials;
+        self.added = added;
+        self.removed = removed;
+        self.renamed = renamed;
+        self.codeChanged = codeChanged;
+    }
+    return self;
+}
+
+- (BOOL)hasChanges {
+    return self.added.count || self.removed.count || self.renamed.count || self.codeChanged.count;
+}
+
+@end
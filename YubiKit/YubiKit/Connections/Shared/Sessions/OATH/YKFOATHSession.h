@@ -16,7 +16,9 @@
 #import "YKFSession.h"
 #import "YKFVersion.h"
 
-@class YKFOATHCode,
+@class YKFOATHAccessKeyCache,
+       YKFOATHCode,
+       YKFOATHCredentialsDelta,
        YKFOATHCredential,
        YKFOATHCredentialWithCode,
        YKFOATHCredentialTemplate,
@@ -84,6 +86,50 @@ typedef void (^YKFOATHSessionListCompletionBlock)
 typedef void (^YKFOATHSessionCalculateAllCompletionBlock)
     (NSArray<YKFOATHCredentialWithCode*>* _Nullable credentials, NSError* _Nullable error);
 
+/*!
+ @abstract
+    Response block for [calculateAllChangesWithCompletion:] and [listCredentialChangesWithCompletion:] which
+    provides the changes of the credentials since the previous refresh.
+ 
+ @param delta
+    The changes of the credentials if the request was successful. In case of error this parameter is nil.
+ 
+ @param error
+    In case of a failed request this parameter contains the error. If the request was successful this
+    parameter is nil.
+ */
+typedef void (^YKFOATHSessionCredentialsDeltaCompletionBlock)
+    (YKFOATHCredentialsDelta* _Nullable delta, NSError* _Nullable error);
+
+/*!
+ @abstract
+    Response block for [putCredentialTemplates:requiresTouch:progress:completion:] which provides the result
+    of adding each credential.
+ 
+ @param errors
+    The errors of the credentials which could not be added, keyed by the index of their template. The dictionary
+    is empty when all the credentials were added.
+ 
+ @param error
+    The first error returned for a credential, if any. When a template is not valid, no credential is sent to the key
+    and the errors contain the validation errors.
+ */
+typedef void (^YKFOATHSessionPutCredentialsCompletionBlock)
+    (NSDictionary<NSNumber*, NSError*>* _Nonnull errors, NSError* _Nullable error);
+
+/*!
+ @abstract
+    Progress block for [putCredentialTemplates:requiresTouch:progress:completion:].
+ 
+ @param completedCount
+    The number of templates processed by the key.
+ 
+ @param totalCount
+    The number of templates to add.
+ */
+typedef void (^YKFOATHSessionPutCredentialsProgressBlock)
+    (NSUInteger completedCount, NSUInteger totalCount);
+
 /*!
  @abstract
     Response block for [selectOATHApplicationWithCompletion:] which provides the result for the execution
@@ -158,6 +204,39 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)putCredentialTemplate:(YKFOATHCredentialTemplate *)credentialTemplate requiresTouch:(BOOL)requiresTouch completion:(YKFOATHSessionGenericCompletionBlock)completion;
 
+/*!
+ @method putCredentialTemplates:requiresTouch:progress:completion:
+ 
+ @abstract
+    Sends to the key an OATH Put request for each template, to add multiple credentials at once.
+ 
+ @discussion
+    All the templates are validated before sending anything to the key. The Put requests are then sent back-to-back
+    in a single operation of the communication queue, so adding many credentials doesn't wait for a queue hop per
+    credential and no other request is interleaved. A failed Put request doesn't stop the following ones.
+ 
+ @param credentialTemplates
+    The new credentials to add.
+ 
+ @param requiresTouch
+    Whether the new credentials require a touch to be calculated.
+ 
+ @param progress
+    Optional block to follow the progress. It's called on a background thread at most every 100ms, and once
+    after the last credential was processed.
+ 
+ @param completion
+    The response block which is executed after all the requests were processed by the key. The completion block
+    will be executed on a background thread.
+ 
+ @note:
+    This method is thread safe and can be invoked from any thread (main or a background thread).
+ */
+- (void)putCredentialTemplates:(NSArray<YKFOATHCredentialTemplate *> *)credentialTemplates
+                 requiresTouch:(BOOL)requiresTouch
+                      progress:(nullable YKFOATHSessionPutCredentialsProgressBlock)progress
+                    completion:(YKFOATHSessionPutCredentialsCompletionBlock)completion;
+
 /*!
  @method deleteCredential:completion:
  
@@ -273,6 +352,11 @@ NS_ASSUME_NONNULL_BEGIN
     Sends to the key an OATH Calculate All request to calculate all stored credentials on the key.
     The request is performed asynchronously on a background execution queue.
  
+ @discussion
+    The key calculates all TOTP codes with the same challenge. The Calculate All request uses the period shared
+    by most credentials and the TOTP credentials with other periods are calculated individually in the same
+    operation, so all the returned codes are valid for their own period.
+ 
  @param timestamp
     The timestamp used when calculating the OTP.
  
@@ -286,6 +370,76 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)calculateAllWithTimestamp:(NSDate *)timestamp completion:(YKFOATHSessionCalculateAllCompletionBlock)completion;
 
+/*!
+ @method calculateAllUsingCacheWithCompletion:
+
+ @abstract
+    Same as calculateAllUsingCacheWithTimestamp:completion: using the current date as timestamp.
+ */
+- (void)calculateAllUsingCacheWithCompletion:(YKFOATHSessionCalculateAllCompletionBlock)completion;
+
+/*!
+ @method calculateAllUsingCacheWithTimestamp:completion:
+
+ @abstract
+    Returns the codes of all stored credentials on the key, using the codes cached by the session when
+    they are still valid at the timestamp. The request is performed asynchronously on a background
+    execution queue.
+
+ @discussion
+    A Calculate All request is sent to the key only when a code with the default period of 30 seconds is not
+    valid anymore. The credentials with a custom period are calculated individually, only when their own
+    validity window has rolled over. Use cachedCodesExpirationDate to schedule the next refresh.
+    The cache is cleared when credentials are added, removed or renamed and when the session is reset.
+
+ @param timestamp
+    The timestamp used when calculating the OTP.
+
+ @param completion
+    The response block which is executed after the request was processed by the key. The completion block
+    will be executed on a background thread. If the intention is to update the UI, dispatch the results
+    on the main thread to avoid an UIKit assertion.
+
+ @note
+    This method is thread safe and can be invoked from any thread (main or a background thread).
+ */
+- (void)calculateAllUsingCacheWithTimestamp:(NSDate *)timestamp completion:(YKFOATHSessionCalculateAllCompletionBlock)completion;
+
+/*!
+ The earliest date when a code cached by the session expires, or nil if no cached code expires.
+ */
+@property (nonatomic, readonly, nullable) NSDate *cachedCodesExpirationDate;
+
+/*!
+ @method calculateAllChangesWithCompletion:
+ 
+ @abstract
+    Same as calculateAllChangesWithTimestamp:completion: using the current date as timestamp.
+ */
+- (void)calculateAllChangesWithCompletion:(YKFOATHSessionCredentialsDeltaCompletionBlock)completion;
+
+/*!
+ @method calculateAllChangesWithTimestamp:completion:
+ 
+ @abstract
+    Calculates all stored credentials like calculateAllUsingCacheWithTimestamp:completion: and returns the
+    changes since the previous refresh done with the session: the added, removed and renamed credentials and the
+    credentials with a new code. The objects of the unchanged credentials are the same instances as in the
+    previous refresh. The request is performed asynchronously on a background execution queue.
+ 
+ @param timestamp
+    The timestamp used when calculating the OTP.
+ 
+ @param completion
+    The response block which is executed after the request was processed by the key. The completion block
+    will be executed on a background thread. If the intention is to update the UI, dispatch the results
+    on the main thread to avoid an UIKit assertion.
+ 
+ @note
+    This method is thread safe and can be invoked from any thread (main or a background thread).
+ */
+- (void)calculateAllChangesWithTimestamp:(NSDate *)timestamp completion:(YKFOATHSessionCredentialsDeltaCompletionBlock)completion;
+
 /*!
  @method listCredentialsWithCompletion:
  
@@ -303,6 +457,25 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)listCredentialsWithCompletion:(YKFOATHSessionListCompletionBlock)completion;
 
+/*!
+ @method listCredentialChangesWithCompletion:
+ 
+ @abstract
+    Sends to the key an OATH List request and returns the changes of the credentials since the previous
+    refresh done with the session. The List doesn't return codes: the credentials which had a code from the
+    previous refresh are returned without code and reported in codeChanged, the stale codes are not kept.
+    The request is performed asynchronously on a background execution queue.
+ 
+ @param completion
+    The response block which is executed after the request was processed by the key. The completion block
+    will be executed on a background thread. If the intention is to update the UI, dispatch the results
+    on the main thread to avoid an UIKit assertion.
+ 
+ @note
+    This method is thread safe and can be invoked from any thread (main or a background thread).
+ */
+- (void)listCredentialChangesWithCompletion:(YKFOATHSessionCredentialsDeltaCompletionBlock)completion;
+
 /*!
  @method resetWithCompletion:
  
@@ -358,13 +531,71 @@ NS_ASSUME_NONNULL_BEGIN
  @param completion
     The response block which is executed after the request was processed by the key. The completion block
     will be executed on a background thread. If the intention is to update the UI, dispatch the results
-    on the main thread to avoid an UIKit assertion.
+    on the main thread to avoid an UIKit assertion. When the access key can't be derived because the key
+    didn't return a select ID, the completion receives YKFOATHErrorCodeBadApplicationSelectionResponse
+    without sending a request.
  
  @note
     This method is thread safe and can be invoked from any thread (main or a background thread).
  */
 - (void)unlockWithPassword:(NSString *)password completion:(YKFOATHSessionGenericCompletionBlock)completion;
 
+/*!
+ @method unlockWithAccessKey:completion:
+ 
+ @abstract
+    Same as unlockWithPassword:completion: using the access key derived from the password with
+    deriveAccessKeyWithPassword:. The key derivation is skipped and only the challenge-response is performed.
+ 
+ @param accessKey
+    The access key derived from the password. deriveAccessKeyWithPassword: returns nil when the key can't be
+    derived, the result must be checked before calling this method.
+ 
+ @param completion
+    The response block which is executed after the request was processed by the key. The completion block
+    will be executed on a background thread. If the intention is to update the UI, dispatch the results
+    on the main thread to avoid an UIKit assertion.
+ 
+ @note
+    This method is thread safe and can be invoked from any thread (main or a background thread).
+ */
+- (void)unlockWithAccessKey:(NSData *)accessKey completion:(YKFOATHSessionGenericCompletionBlock)completion;
+
+/*!
+ @method deriveAccessKeyWithPassword:salt:
+ 
+ @abstract
+    Derives the access key of an OATH application from the password, using PBKDF2. The method is synchronous
+    and does not need a session, so the key can be derived on a background thread before the key is connected,
+    when the salt is known from a previous session.
+ 
+ @param salt
+    The select ID returned by the OATH application when it's selected, which identifies the device.
+ 
+ @return
+    The access key or nil if the salt is empty.
+ */
++ (nullable NSData *)deriveAccessKeyWithPassword:(NSString *)password salt:(NSData *)salt;
+
+/*!
+ @method deriveAccessKeyWithPassword:
+ 
+ @abstract
+    Same as deriveAccessKeyWithPassword:salt: using the select ID returned by the OATH application of the
+    connected key. The result can be passed to unlockWithAccessKey:completion:.
+ 
+ @return
+    The access key or nil if the session is not valid anymore or the key didn't return a select ID.
+ */
+- (nullable NSData *)deriveAccessKeyWithPassword:(NSString *)password;
+
+/*!
+ Optional cache for the access keys derived from the passwords used to unlock the OATH application. When set,
+ unlockWithPassword:completion: reuses the key cached for the device instead of deriving it again. The cache
+ is not set by default and can be shared between sessions.
+ */
+@property (nonatomic, nullable) YKFOATHAccessKeyCache *accessKeyCache;
+
 
 /*!
  @method calculateResponseForCredentialID:challenge:completion:
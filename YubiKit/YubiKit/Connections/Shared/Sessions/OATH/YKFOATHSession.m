@@ -32,7 +32,7 @@
 #import "YKFNSDataAdditions.h"
 #import "YKFNSDataAdditions+Private.h"
 #import "YKFNSMutableDataAdditions.h"
-#import "TKTLVRecordAdditions+Private.h"
+#import "YKFBERTLV.h"
 
 #import "YKFAPDU+Private.h"
 
@@ -47,6 +47,11 @@
 #import "YKFOATHCode+Private.h"
 #import "YKFOATHCode.h"
 #import "YKFOATHCredentialUtils.h"
+#import "YKFOATHCredentialWithCode.h"
+#import "YKFOATHCredential+Private.h"
+#import "YKFOATHCodeCache.h"
+#import "YKFOATHAccessKeyCache.h"
+#import "YKFOATHCredentialIndex.h"
 #import "YKFOATHCredentialTemplate.h"
 #import "YKFOATHListResponse.h"
 #import "YKFOATHSelectApplicationResponse.h"
@@ -62,6 +67,8 @@ static const NSUInteger YKFOATHChallengeTag = 0x74;
 static const NSUInteger YKFOATHCalculateIns = 0xa2;
 
 static const NSTimeInterval YKFOATHServiceTimeoutThreshold = 10; // seconds
+static const NSTimeInterval YKFOATHPutProgressInterval = 0.1; // seconds
+static const NSTimeInterval YKFOATHPutTimeout = 10; // seconds, per frame
 
 typedef void (^YKFOATHServiceResultCompletionBlock)(NSData* _Nullable  result, NSError* _Nullable error);
 
@@ -75,6 +82,17 @@ typedef void (^YKFOATHServiceResultCompletionBlock)(NSData* _Nullable  result, N
 @property (nonatomic) YKFOATHSelectApplicationResponse *cachedSelectApplicationResponse;
 @property (nonatomic, readonly) BOOL isValid;
 
+/*
+ Codes calculated during the session, used by calculateAllUsingCacheWithTimestamp:completion: to avoid
+ sending a Calculate All request while the codes are still valid.
+ */
+@property (nonatomic) YKFOATHCodeCache *codeCache;
+
+/*
+ The credentials returned by the last refresh, used to return the changes of the credentials.
+ */
+@property (nonatomic) YKFOATHCredentialIndex *credentialIndex;
+
 @end
 
 @implementation YKFOATHSession
@@ -86,6 +104,8 @@ typedef void (^YKFOATHServiceResultCompletionBlock)(NSData* _Nullable  result, N
 + (void)sessionWithConnectionController:(nonnull id<YKFConnectionControllerProtocol>)connectionController
                                completion:(YKFOATHSessionCompletion _Nonnull)completion {
     YKFOATHSession *session = [YKFOATHSession new];
+    session.codeCache = [[YKFOATHCodeCache alloc] init];
+    session.credentialIndex = [[YKFOATHCredentialIndex alloc] init];
     session.smartCardInterface = [[YKFSmartCardInterface alloc] initWithConnectionController:connectionController];
     
     YKFSelectApplicationAPDU *apdu = [[YKFSelectApplicationAPDU alloc] initWithApplicationName:YKFSelectApplicationAPDUNameOATH];
@@ -119,10 +139,71 @@ typedef void (^YKFOATHServiceResultCompletionBlock)(NSData* _Nullable  result, N
     
     [self executeOATHCommand:apdu completion:^(NSData * _Nullable result, NSError * _Nullable error) {
         // No result except status code
+        [self.codeCache invalidate];
         completion(error);
     }];
 }
 
+- (void)putCredentialTemplates:(NSArray<YKFOATHCredentialTemplate *> *)credentialTemplates
+                 requiresTouch:(BOOL)requiresTouch
+                      progress:(YKFOATHSessionPutCredentialsProgressBlock)progress
+                    completion:(YKFOATHSessionPutCredentialsCompletionBlock)completion {
+    YKFParameterAssertReturn(credentialTemplates);
+    YKFParameterAssertReturn(completion);
+    
+    // Nothing is sent when a template is invalid, to avoid leaving the key half provisioned.
+    NSMutableDictionary<NSNumber *, NSError *> *errors = [[NSMutableDictionary alloc] init];
+    NSError *firstError = nil;
+    NSMutableArray<YKFAPDU *> *apdus = [[NSMutableArray alloc] initWithCapacity:credentialTemplates.count];
+    for (NSUInteger i = 0; i < credentialTemplates.count; ++i) {
+        YKFSessionError *credentialError = [YKFOATHCredentialUtils validateCredentialTemplate:credentialTemplates[i]];
+        if (credentialError) {
+            errors[@(i)] = credentialError;
+            firstError = firstError ?: credentialError;
+            continue;
+        }
+        [apdus addObject:[[YKFOATHPutAPDU alloc] initWithCredentialTemplate:credentialTemplates[i] requriesTouch:requiresTouch]];
+    }
+    if (firstError) {
+        completion(errors, firstError);
+        return;
+    }
+    if (!self.isValid) {
+        completion(errors, [YKFSessionError errorWithCode:YKFSessionErrorInvalidSessionStateStatusCode]);
+        return;
+    }
+    
+    // The progress is reported on the communication queue, throttled to not delay the next command.
+    __block NSDate *lastProgressDate = nil;
+    YKFSmartCardInterfaceBatchProgressBlock batchProgress = nil;
+    if (progress) {
+        batchProgress = ^(NSUInteger completedCount, NSUInteger totalCount) {
+            if (completedCount < totalCount && lastProgressDate && -[lastProgressDate timeIntervalSinceNow] < YKFOATHPutProgressInterval) {
+                return;
+            }
+            lastProgressDate = [NSDate date];
+            progress(completedCount, totalCount);
+        };
+    }
+    
+    [self.smartCardInterface executeCommands:apdus sendRemainingIns:YKFSmartCardInterfaceSendRemainingInsOATH errorPolicy:YKFSmartCardInterfaceErrorPolicyContinue timeout:YKFOATHPutTimeout progress:batchProgress completion:^(NSArray<YKFSmartCardInterfaceCommandResult *> * _Nonnull results, NSError * _Nullable error) {
+        [self.codeCache invalidate];
+        
+        // Put requests never wait for a touch, so a long batch must not turn a locked session into a touch timeout.
+        NSDate *mappingTime = [NSDate date];
+        NSError *firstPutError = nil;
+        for (NSUInteger i = 0; i < results.count; ++i) {
+            if (!results[i].error) {
+                continue;
+            }
+            NSError *putError = [YKFOATHSession oathErrorFromError:results[i].error startTime:mappingTime];
+            errors[@(i)] = putError;
+            firstPutError = firstPutError ?: putError;
+        }
+        completion(errors, firstPutError);
+    }];
+}
+
 - (void)deleteCredential:(YKFOATHCredential *)credential completion:(YKFOATHSessionGenericCompletionBlock)completion {
     YKFParameterAssertReturn(credential);
     YKFParameterAssertReturn(completion);
@@ -136,6 +217,7 @@ typedef void (^YKFOATHServiceResultCompletionBlock)(NSData* _Nullable  result, N
     YKFOATHDeleteAPDU *apdu = [[YKFOATHDeleteAPDU alloc] initWithCredential:credential];
     [self executeOATHCommand:apdu completion:^(NSData * _Nullable result, NSError * _Nullable error) {
         // No result except status code
+        [self.codeCache invalidate];
         completion(error);
     }];
 }
@@ -169,6 +251,10 @@ typedef void (^YKFOATHServiceResultCompletionBlock)(NSData* _Nullable  result, N
     
     [self executeOATHCommand:apdu completion:^(NSData * _Nullable result, NSError * _Nullable error) {
         // No result except status code
+        [self.codeCache invalidate];
+        if (!error) {
+            [self.credentialIndex recordRenameFromKey:credential.key toKey:renamedCredential.key];
+        }
         completion(error);
     }];
 }
@@ -216,25 +302,205 @@ typedef void (^YKFOATHServiceResultCompletionBlock)(NSData* _Nullable  result, N
 }
 
 - (void)calculateAllWithTimestamp:(NSDate *)timestamp completion:(YKFOATHSessionCalculateAllCompletionBlock)completion {
+    YKFParameterAssertReturn(timestamp);
     YKFParameterAssertReturn(completion);
     
-    YKFAPDU *apdu = [[YKFOATHCalculateAllAPDU alloc] initWithTimestamp:timestamp];
+    // The key calculates all TOTP codes with the same challenge. Use the period of most credentials known
+    // from the previous calculation for the Calculate All request and calculate the other ones in the same batch.
+    NSArray<YKFOATHCredential *> *knownCredentials = [self.codeCache.credentialsWithCodes valueForKey:@"credential"];
+    NSUInteger period = [YKFOATHSession dominantPeriodOfCredentials:knownCredentials];
+    NSArray<YKFOATHCredential *> *otherPeriodCredentials = [YKFOATHSession credentials:knownCredentials withCodesNotMatchingPeriod:period];
     
-    [self executeOATHCommand:apdu completion:^(NSData * _Nullable result, NSError * _Nullable error) {
+    NSMutableArray<YKFAPDU *> *apdus = [[NSMutableArray alloc] initWithCapacity:otherPeriodCredentials.count + 1];
+    [apdus addObject:[[YKFOATHCalculateAllAPDU alloc] initWithTimestamp:timestamp period:period]];
+    for (YKFOATHCredential *credential in otherPeriodCredentials) {
+        [apdus addObject:[[YKFOATHCalculateAPDU alloc] initWithCredential:credential timestamp:timestamp]];
+    }
+    
+    ykf_weak_self();
+    [self executeOATHCommands:apdus completion:^(NSArray<NSData *> * _Nullable results, NSError * _Nullable error) {
+        ykf_safe_strong_self();
+        if (error.code == YKFOATHErrorCodeNoSuchObject && otherPeriodCredentials.count) {
+            // A cached credential was removed from the key. Start over from the credentials of a new Calculate All.
+            [strongSelf.codeCache invalidate];
+            [strongSelf calculateAllWithTimestamp:timestamp completion:completion];
+            return;
+        }
         if (error) {
             completion(nil, error);
             return;
         }
-        YKFOATHCalculateAllResponse *response = [[YKFOATHCalculateAllResponse alloc] initWithKeyResponseData:result
+        YKFOATHCalculateAllResponse *response = [[YKFOATHCalculateAllResponse alloc] initWithKeyResponseData:results.firstObject
                                                                                              requestTimetamp:timestamp];
         if (!response) {
             completion(nil, [YKFOATHError errorWithCode:YKFOATHErrorCodeBadCalculateAllResponse]);
             return;
         }
-        completion(response.credentials, nil);
+        
+        NSMutableDictionary<NSString *, YKFOATHCode *> *codes = [[NSMutableDictionary alloc] initWithCapacity:otherPeriodCredentials.count];
+        for (NSUInteger i = 0; i < otherPeriodCredentials.count; ++i) {
+            YKFOATHCredential *credential = otherPeriodCredentials[i];
+            YKFOATHCode *code = [[YKFOATHCode alloc] initWithKeyResponseData:results[i + 1] requestTimetamp:timestamp requestPeriod:credential.period];
+            if (!code) {
+                completion(nil, [YKFOATHError errorWithCode:YKFOATHErrorCodeBadCalculationResponse]);
+                return;
+            }
+            codes[credential.key] = code;
+        }
+        
+        // Credentials added since the previous calculation are not part of the batch.
+        NSArray<YKFOATHCredential *> *responseCredentials = [response.credentials valueForKey:@"credential"];
+        NSMutableArray<YKFOATHCredential *> *missingCredentials = [[NSMutableArray alloc] init];
+        for (YKFOATHCredential *credential in [YKFOATHSession credentials:responseCredentials withCodesNotMatchingPeriod:period]) {
+            if (!codes[credential.key]) {
+                [missingCredentials addObject:credential];
+            }
+        }
+        
+        [strongSelf calculateCredentials:missingCredentials timestamp:timestamp completion:^(NSArray<YKFOATHCode *> * _Nullable missingCodes, NSError * _Nullable error) {
+            if (error) {
+                completion(nil, error);
+                return;
+            }
+            for (NSUInteger i = 0; i < missingCredentials.count; ++i) {
+                codes[missingCredentials[i].key] = missingCodes[i];
+            }
+            
+            NSMutableArray<YKFOATHCredentialWithCode *> *credentials = [[NSMutableArray alloc] initWithCapacity:response.credentials.count];
+            for (YKFOATHCredentialWithCode *credentialWithCode in response.credentials) {
+                YKFOATHCode *code = codes[credentialWithCode.credential.key];
+                if (code) {
+                    [credentials addObject:[[YKFOATHCredentialWithCode alloc] initWithCredential:credentialWithCode.credential code:code]];
+                } else {
+                    [credentials addObject:credentialWithCode];
+                }
+            }
+            
+            [strongSelf.codeCache updateWithCalculateAllResult:credentials period:period];
+            completion([credentials copy], nil);
+        }];
+    }];
+}
+
+- (void)calculateAllUsingCacheWithCompletion:(YKFOATHSessionCalculateAllCompletionBlock)completion {
+    NSDate *timestamp = [NSDate date];
+    [self calculateAllUsingCacheWithTimestamp:timestamp completion:completion];
+}
+
+- (void)calculateAllUsingCacheWithTimestamp:(NSDate *)timestamp completion:(YKFOATHSessionCalculateAllCompletionBlock)completion {
+    YKFParameterAssertReturn(timestamp);
+    YKFParameterAssertReturn(completion);
+
+    if ([self.codeCache requiresCalculateAllAtDate:timestamp]) {
+        [self calculateAllWithTimestamp:timestamp completion:completion];
+        return;
+    }
+
+    NSArray<YKFOATHCredential *> *expiredCredentials = [self.codeCache credentialsRequiringCalculationAtDate:timestamp];
+    ykf_weak_self();
+    [self calculateCredentials:expiredCredentials timestamp:timestamp completion:^(NSArray<YKFOATHCode *> * _Nullable codes, NSError * _Nullable error) {
+        ykf_safe_strong_self();
+        if (error) {
+            completion(nil, error);
+            return;
+        }
+        for (NSUInteger i = 0; i < expiredCredentials.count; ++i) {
+            [strongSelf.codeCache updateCode:codes[i] forCredential:expiredCredentials[i]];
+        }
+        completion(strongSelf.codeCache.credentialsWithCodes ?: @[], nil);
+    }];
+}
+
+- (void)calculateAllChangesWithCompletion:(YKFOATHSessionCredentialsDeltaCompletionBlock)completion {
+    NSDate *timestamp = [NSDate date];
+    [self calculateAllChangesWithTimestamp:timestamp completion:completion];
+}
+
+- (void)calculateAllChangesWithTimestamp:(NSDate *)timestamp completion:(YKFOATHSessionCredentialsDeltaCompletionBlock)completion {
+    YKFParameterAssertReturn(timestamp);
+    YKFParameterAssertReturn(completion);
+    
+    ykf_weak_self();
+    [self calculateAllUsingCacheWithTimestamp:timestamp completion:^(NSArray<YKFOATHCredentialWithCode *> * _Nullable credentials, NSError * _Nullable error) {
+        ykf_safe_strong_self();
+        if (error) {
+            completion(nil, error);
+            return;
+        }
+        completion([strongSelf.credentialIndex updateWithCredentials:credentials], nil);
+    }];
+}
+
+- (NSDate *)cachedCodesExpirationDate {
+    return self.codeCache.nextExpirationDate;
+}
+
+/*
+ Calculates the credentials in a single batch. The codes are returned in the order of the credentials.
+ */
+- (void)calculateCredentials:(NSArray<YKFOATHCredential *> *)credentials timestamp:(NSDate *)timestamp completion:(void (^)(NSArray<YKFOATHCode *> * _Nullable codes, NSError * _Nullable error))completion {
+    if (!credentials.count) {
+        completion(@[], nil);
+        return;
+    }
+    
+    NSMutableArray<YKFAPDU *> *apdus = [[NSMutableArray alloc] initWithCapacity:credentials.count];
+    for (YKFOATHCredential *credential in credentials) {
+        [apdus addObject:[[YKFOATHCalculateAPDU alloc] initWithCredential:credential timestamp:timestamp]];
+    }
+    
+    [self executeOATHCommands:apdus completion:^(NSArray<NSData *> * _Nullable results, NSError * _Nullable error) {
+        if (error) {
+            completion(nil, error);
+            return;
+        }
+        NSMutableArray<YKFOATHCode *> *codes = [[NSMutableArray alloc] initWithCapacity:credentials.count];
+        for (NSUInteger i = 0; i < credentials.count; ++i) {
+            YKFOATHCode *code = [[YKFOATHCode alloc] initWithKeyResponseData:results[i] requestTimetamp:timestamp requestPeriod:credentials[i].period];
+            if (!code) {
+                completion(nil, [YKFOATHError errorWithCode:YKFOATHErrorCodeBadCalculationResponse]);
+                return;
+            }
+            [codes addObject:code];
+        }
+        completion([codes copy], nil);
     }];
 }
 
+/*
+ The most common period of the TOTP credentials calculated without touch. Defaults to 30 seconds.
+ */
++ (NSUInteger)dominantPeriodOfCredentials:(NSArray<YKFOATHCredential *> *)credentials {
+    NSCountedSet *periods = [[NSCountedSet alloc] init];
+    for (YKFOATHCredential *credential in credentials) {
+        if (credential.type == YKFOATHCredentialTypeTOTP && !credential.requiresTouch) {
+            [periods addObject:@(credential.period)];
+        }
+    }
+    NSUInteger period = YKFOATHCredentialDefaultPeriod;
+    NSUInteger count = [periods countForObject:@(period)];
+    for (NSNumber *candidate in periods) {
+        if ([periods countForObject:candidate] > count) {
+            period = candidate.unsignedIntegerValue;
+            count = [periods countForObject:candidate];
+        }
+    }
+    return period;
+}
+
+/*
+ The TOTP credentials calculated without touch which get a wrong code from a Calculate All for the period.
+ */
++ (NSArray<YKFOATHCredential *> *)credentials:(NSArray<YKFOATHCredential *> *)credentials withCodesNotMatchingPeriod:(NSUInteger)period {
+    NSMutableArray *result = [[NSMutableArray alloc] init];
+    for (YKFOATHCredential *credential in credentials) {
+        if (credential.type == YKFOATHCredentialTypeTOTP && !credential.requiresTouch && credential.period != period) {
+            [result addObject:credential];
+        }
+    }
+    return [result copy];
+}
+
 #pragma mark - Credential Listing
 
 - (void)listCredentialsWithCompletion:(YKFOATHSessionListCompletionBlock)completion {
@@ -256,6 +522,20 @@ typedef void (^YKFOATHServiceResultCompletionBlock)(NSData* _Nullable  result, N
     }];
 }
 
+- (void)listCredentialChangesWithCompletion:(YKFOATHSessionCredentialsDeltaCompletionBlock)completion {
+    YKFParameterAssertReturn(completion);
+    
+    ykf_weak_self();
+    [self listCredentialsWithCompletion:^(NSArray<YKFOATHCredential *> * _Nullable credentials, NSError * _Nullable error) {
+        ykf_safe_strong_self();
+        if (error) {
+            completion(nil, error);
+            return;
+        }
+        completion([strongSelf.credentialIndex updateWithListedCredentials:credentials], nil);
+    }];
+}
+
 #pragma mark - Reset
 
 - (void)resetWithCompletion:(YKFOATHSessionGenericCompletionBlock)completion {
@@ -265,7 +545,9 @@ typedef void (^YKFOATHServiceResultCompletionBlock)(NSData* _Nullable  result, N
         return;
     }
     
+    [self.accessKeyCache removeAccessKeyForSalt:self.cachedSelectApplicationResponse.selectID];
     self.cachedSelectApplicationResponse = nil;
+    [self.codeCache invalidate];
     YKFAPDU *apdu = [[YKFAPDU alloc] initWithCla:0x00 ins:0x04 p1:0xDE p2:0xAD data:[NSData data] type:YKFAPDUTypeShort];
     [self.smartCardInterface executeCommand:apdu completion:^(NSData * _Nullable data, NSError * _Nullable error) {
         if (!error) {
@@ -295,8 +577,11 @@ typedef void (^YKFOATHServiceResultCompletionBlock)(NSData* _Nullable  result, N
         return;
     }
     // Build the request APDU with the select ID salt
-    YKFOATHSetPasswordAPDU *apdu = [[YKFOATHSetPasswordAPDU alloc] initWithPassword:password salt:self.cachedSelectApplicationResponse.selectID];
+    NSData *salt = self.cachedSelectApplicationResponse.selectID;
+    YKFOATHSetPasswordAPDU *apdu = [[YKFOATHSetPasswordAPDU alloc] initWithPassword:password salt:salt];
     [self.smartCardInterface executeCommand:apdu completion:^(NSData * _Nullable data, NSError * _Nullable error) {
+        // The key cached for the previous password is not valid anymore.
+        [self.accessKeyCache removeAccessKeyForSalt:salt];
         if (error) {
             if (error.code == YKFAPDUErrorCodeAuthenticationRequired) {
                 completion([YKFOATHError errorWithCode:YKFOATHErrorCodeAuthenticationRequired]);
@@ -316,7 +601,35 @@ typedef void (^YKFOATHServiceResultCompletionBlock)(NSData* _Nullable  result, N
         completion([YKFSessionError errorWithCode:YKFSessionErrorInvalidSessionStateStatusCode]);
         return;
     }
-    YKFOATHUnlockAPDU *apdu = [[YKFOATHUnlockAPDU alloc] initWithPassword:password challenge:self.cachedSelectApplicationResponse.challenge salt:self.cachedSelectApplicationResponse.selectID];
+    NSData *salt = self.cachedSelectApplicationResponse.selectID;
+    YKFOATHAccessKeyCache *accessKeyCache = self.accessKeyCache;
+    
+    NSData *accessKey = [accessKeyCache accessKeyForPassword:password salt:salt];
+    if (!accessKey) {
+        accessKey = [self deriveAccessKeyWithPassword:password];
+    }
+    if (!accessKey) {
+        completion([YKFOATHError errorWithCode:YKFOATHErrorCodeBadApplicationSelectionResponse]);
+        return;
+    }
+    [self unlockWithAccessKey:accessKey completion:^(NSError * _Nullable error) {
+        if (!error) {
+            [accessKeyCache storeAccessKey:accessKey forPassword:password salt:salt];
+        } else if (error.code == YKFOATHErrorCodeWrongPassword) {
+            [accessKeyCache removeAccessKeyForSalt:salt];
+        }
+        completion(error);
+    }];
+}
+
+- (void)unlockWithAccessKey:(NSData *)accessKey completion:(YKFOATHSessionGenericCompletionBlock)completion {
+    YKFParameterAssertReturn(accessKey);
+    YKFParameterAssertReturn(completion);
+    if (!self.isValid) {
+        completion([YKFSessionError errorWithCode:YKFSessionErrorInvalidSessionStateStatusCode]);
+        return;
+    }
+    YKFOATHUnlockAPDU *apdu = [[YKFOATHUnlockAPDU alloc] initWithAccessKey:accessKey challenge:self.cachedSelectApplicationResponse.challenge];
     [self.smartCardInterface executeCommand:apdu completion:^(NSData * _Nullable data, NSError * _Nullable error) {
         if (error) {
             if (error.code == YKFAPDUErrorCodeWrongData) {
@@ -342,14 +655,29 @@ typedef void (^YKFOATHServiceResultCompletionBlock)(NSData* _Nullable  result, N
     }];
 }
 
++ (NSData *)deriveAccessKeyWithPassword:(NSString *)password salt:(NSData *)salt {
+    YKFParameterAssertReturnValue(password, nil);
+    if (!salt.length) {
+        return nil;
+    }
+    return [[password dataUsingEncoding:NSUTF8StringEncoding] ykf_deriveOATHKeyWithSalt:salt];
+}
+
+- (NSData *)deriveAccessKeyWithPassword:(NSString *)password {
+    return [YKFOATHSession deriveAccessKeyWithPassword:password salt:self.cachedSelectApplicationResponse.selectID];
+}
+
 - (void)calculateResponseForCredentialID:(NSData *)credentialId challenge:(NSData *)challenge completion:(YKFOATHSessionCalculateResponseCompletionBlock)completion {
     YKFParameterAssertReturn(credentialId);
     YKFParameterAssertReturn(challenge);
     YKFParameterAssertReturn(completion);
 
-    NSMutableData *data = [[NSMutableData alloc] init];
-    [data appendData:[[TKBERTLVRecord alloc] initWithTag:YKFOATHCredentialIdTag value:credentialId].data];
-    [data appendData:[[TKBERTLVRecord alloc] initWithTag:YKFOATHChallengeTag value:challenge].data];
+    NSMutableData *data = [[NSMutableData alloc] initWithLength:YKFBERTLVEncodedLength(YKFOATHCredentialIdTag, credentialId.length) + YKFBERTLVEncodedLength(YKFOATHChallengeTag, challenge.length)];
+    YKFBERTLVWriter writer;
+    YKFBERTLVWriterInit(&writer, data.mutableBytes, data.length);
+    YKFBERTLVWriterAppend(&writer, YKFOATHCredentialIdTag, credentialId.bytes, credentialId.length);
+    YKFBERTLVWriterAppend(&writer, YKFOATHChallengeTag, challenge.bytes, challenge.length);
+    data.length = YKFBERTLVWriterFinish(&writer);
     
     YKFAPDU *apdu = [[YKFAPDU alloc] initWithCla:0 ins:YKFOATHCalculateIns p1:0 p2:0 data:data type:YKFAPDUTypeShort];
     
@@ -359,14 +687,14 @@ typedef void (^YKFOATHServiceResultCompletionBlock)(NSData* _Nullable  result, N
             return;
         }
         
-        TKBERTLVRecord *responseRecord = [TKBERTLVRecord recordFromData:result];
-
-        if (responseRecord.tag != YKFOATHResponseTag || responseRecord.value.length == 0) {
+        YKFBERTLVRecord responseRecord;
+        if (!YKFBERTLVReadSingleRecord(result.bytes, result.length, &responseRecord) || responseRecord.tag != YKFOATHResponseTag || responseRecord.length == 0) {
             completion(nil, [YKFOATHError errorWithCode:YKFOATHErrorCodeBadCalculationResponse]);
             return;
         }
-        NSRange range = NSMakeRange(1, [responseRecord.value length] - 1);
-        NSData *response = [responseRecord.value subdataWithRange:range];
+        // The first byte of the value is the number of digits.
+        NSUInteger offset = responseRecord.value - (const UInt8 *)result.bytes;
+        NSData *response = [result subdataWithRange:NSMakeRange(offset + 1, responseRecord.length - 1)];
         
         completion(response, nil);
     }];
@@ -388,35 +716,60 @@ typedef void (^YKFOATHServiceResultCompletionBlock)(NSData* _Nullable  result, N
             completion(data, nil);
             return;
         }
-        NSTimeInterval executionTime = -[startTime timeIntervalSinceNow];
-        switch(error.code) {
-            case YKFAPDUErrorCodeAuthenticationRequired:
-                if (executionTime < YKFOATHServiceTimeoutThreshold) {
-                    completion(nil, [YKFOATHError errorWithCode:YKFOATHErrorCodeAuthenticationRequired]);
-                } else {
-                    completion(nil, [YKFOATHError errorWithCode:YKFOATHErrorCodeTouchTimeout]);
-                }
-                break;
-            case YKFAPDUErrorCodeDataInvalid:
-                completion(nil, [YKFOATHError errorWithCode:YKFOATHErrorCodeNoSuchObject]);
-                break;
-            default: {
-                completion(nil, error);
-            }
+        completion(nil, [YKFOATHSession oathErrorFromError:error startTime:startTime]);
+    }];
+}
+
+/*
+ Executes the commands in a single batch, stopping on the first error. The results contain the response
+ data of each command, in order.
+ */
+- (void)executeOATHCommands:(NSArray<YKFAPDU *> *)apdus completion:(void (^)(NSArray<NSData *> * _Nullable results, NSError * _Nullable error))completion {
+    YKFParameterAssertReturn(apdus);
+    YKFParameterAssertReturn(completion);
+    if (!self.isValid) {
+        completion(nil, [YKFSessionError errorWithCode:YKFSessionErrorInvalidSessionStateStatusCode]);
+        return;
+    }
+    
+    NSDate *startTime = [NSDate date];
+    [self.smartCardInterface executeCommands:apdus sendRemainingIns:YKFSmartCardInterfaceSendRemainingInsOATH completion:^(NSArray<YKFSmartCardInterfaceCommandResult *> * _Nonnull results, NSError * _Nullable error) {
+        if (error) {
+            completion(nil, [YKFOATHSession oathErrorFromError:error startTime:startTime]);
+            return;
         }
+        completion([results valueForKey:@"data"], nil);
     }];
 }
 
++ (NSError *)oathErrorFromError:(NSError *)error startTime:(NSDate *)startTime {
+    NSTimeInterval executionTime = -[startTime timeIntervalSinceNow];
+    switch(error.code) {
+        case YKFAPDUErrorCodeAuthenticationRequired:
+            if (executionTime < YKFOATHServiceTimeoutThreshold) {
+                return [YKFOATHError errorWithCode:YKFOATHErrorCodeAuthenticationRequired];
+            } else {
+                return [YKFOATHError errorWithCode:YKFOATHErrorCodeTouchTimeout];
+            }
+        case YKFAPDUErrorCodeDataInvalid:
+            return [YKFOATHError errorWithCode:YKFOATHErrorCodeNoSuchObject];
+        default:
+            return error;
+    }
+}
+
 #pragma mark - YKFSessionProtocol
 
 - (void)clearSessionState {
     self.cachedSelectApplicationResponse = nil;
+    [self.codeCache invalidate];
 }
 
 #pragma mark - Test Helpers
 
 - (void)invalidateApplicationSelectionCache {
     self.cachedSelectApplicationResponse = nil;
+    [self.codeCache invalidate];
 }
 
 @end
@@ -0,0 +1,67 @@
+// Copyright 2018-2021 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef YKFPIVObjectCache_h
+#define YKFPIVObjectCache_h
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef NS_ENUM(NSUInteger, YKFPIVObjectCacheValidation) {
+    /// The cached objects are returned without asking the YubiKey.
+    YKFPIVObjectCacheValidationNone,
+    
+    /// The first response frame of the object is read from the YubiKey and compared with the cached object, which
+    /// is returned only if it has the same length and starts with the same bytes. Over NFC this transfers a fraction
+    /// of a certificate and detects objects written by other applications.
+    YKFPIVObjectCacheValidationHeader,
+};
+
+/// @abstract Memory only cache for the PIV data objects read from the YubiKeys, like the certificates.
+/// @discussion When set on the YKFPIVSession, the objects read by getCertificateInSlot:completion: are cached by
+///             serial number of the YubiKey and object ID, and returned without reading them again. The objects
+///             written or deleted through the session and the objects of a YubiKey which is reset are removed from
+///             the cache. The cache is used only with YubiKeys which report their serial number (firmware 5.0 and
+///             above). The same instance can be shared by the sessions of multiple connections.
+/// @note This class is thread safe.
+@interface YKFPIVObjectCache: NSObject
+
+/// @abstract How the cached objects are checked before being returned.
+@property (nonatomic, readonly) YKFPIVObjectCacheValidation validation;
+
+- (instancetype)initWithValidation:(YKFPIVObjectCacheValidation)validation NS_DESIGNATED_INITIALIZER;
+
+/// @abstract Returns the object cached for the YubiKey, or nil.
+- (nullable NSData *)objectWithId:(NSData *)objectId serialNumber:(UInt32)serialNumber;
+
+/// @abstract Stores the object read from the YubiKey, replacing the one cached for the object ID.
+- (void)storeObject:(NSData *)object withId:(NSData *)objectId serialNumber:(UInt32)serialNumber;
+
+/// @abstract Removes the object cached for the YubiKey.
+- (void)removeObjectWithId:(NSData *)objectId serialNumber:(UInt32)serialNumber;
+
+/// @abstract Removes all the objects cached for the YubiKey.
+- (void)removeObjectsForSerialNumber:(UInt32)serialNumber;
+
+/// @abstract Removes all the cached objects.
+- (void)clear;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@end
+
+NS_ASSUME_NONNULL_END
+
+#endif /* YKFPIVObjectCache_h */
@@ -0,0 +1,75 @@
+// Copyright 2018-2021 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import "YKFPIVObjectCache.h"
+#import "YKFAssert.h"
+
+@interface YKFPIVObjectCache()
+
+@property (nonatomic, readwrite) YKFPIVObjectCacheValidation validation;
+@property (nonatomic) NSMutableDictionary<NSNumber *, NSMutableDictionary<NSData *, NSData *> *> *objects;
+
+@end
+
+@implementation YKFPIVObjectCache
+
+- (instancetype)initWithValidation:(YKFPIVObjectCacheValidation)validation {
+    self = [super init];
+    if (self) {
+        self.validation = validation;
+        self.objects = [[NSMutableDictionary alloc] init];
+    }
+    return self;
+}
+
+- (NSData *)objectWithId:(NSData *)objectId serialNumber:(UInt32)serialNumber {
+    YKFParameterAssertReturnValue(objectId, nil);
+    @synchronized (self) {
+        return self.objects[@(serialNumber)][objectId];
+    }
+}
+
+- (void)storeObject:(NSData *)object withId:(NSData *)objectId serialNumber:(UInt32)serialNumber {
+    YKFParameterAssertReturn(object);
+    YKFParameterAssertReturn(objectId);
+    @synchronized (self) {
+        NSMutableDictionary<NSData *, NSData *> *deviceObjects = self.objects[@(serialNumber)];
+        if (!deviceObjects) {
+            deviceObjects = [[NSMutableDictionary alloc] init];
+            self.objects[@(serialNumber)] = deviceObjects;
+        }
+        deviceObjects[[objectId copy]] = [object copy];
+    }
+}
+
+- (void)removeObjectWithId:(NSData *)objectId serialNumber:(UInt32)serialNumber {
+    YKFParameterAssertReturn(objectId);
+    @synchronized (self) {
+        [self.objects[@(serialNumber)] removeObjectForKey:objectId];
+    }
+}
+
+- (void)removeObjectsForSerialNumber:(UInt32)serialNumber {
+    @synchronized (self) {
+        [self.objects removeObjectForKey:@(serialNumber)];
+    }
+}
+
+- (void)clear {
+    @synchronized (self) {
+        [self.objects removeAllObjects];
+    }
+}
+
+@end
@@ -15,36 +15,308 @@
 #import <Foundation/Foundation.h>
 #import "YKFPIVPadding+Private.h"
 #import <CommonCrypto/CommonDigest.h>
+#import <Security/Security.h>
+
+#pragma mark - Digests
+
+/*
+ The digests used by the RSA padding schemes. The DigestInfo prefix is the DER encoding of the digest algorithm
+ identifier, followed by the header of the digest octet string (RFC 8017, section 9.2).
+ */
+typedef unsigned char *(*YKFPIVPaddingDigestFunction)(const void *data, CC_LONG length, unsigned char *digest);
+
+typedef struct {
+    NSUInteger length;
+    YKFPIVPaddingDigestFunction function;
+    const UInt8 *digestInfoPrefix;
+    NSUInteger digestInfoPrefixLength;
+} YKFPIVPaddingDigest;
+
+static const UInt8 YKFPIVPaddingSHA1Prefix[] = {0x30, 0x21, 0x30, 0x09, 0x06, 0x05, 0x2b, 0x0e, 0x03, 0x02, 0x1a, 0x05, 0x00, 0x04, 0x14};
+static const UInt8 YKFPIVPaddingSHA224Prefix[] = {0x30, 0x2d, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x04, 0x05, 0x00, 0x04, 0x1c};
+static const UInt8 YKFPIVPaddingSHA256Prefix[] = {0x30, 0x31, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x01, 0x05, 0x00, 0x04, 0x20};
+static const UInt8 YKFPIVPaddingSHA384Prefix[] = {0x30, 0x41, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x02, 0x05, 0x00, 0x04, 0x30};
+static const UInt8 YKFPIVPaddingSHA512Prefix[] = {0x30, 0x51, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x03, 0x05, 0x00, 0x04, 0x40};
+
+static const YKFPIVPaddingDigest YKFPIVPaddingSHA1 = {CC_SHA1_DIGEST_LENGTH, CC_SHA1, YKFPIVPaddingSHA1Prefix, sizeof(YKFPIVPaddingSHA1Prefix)};
+static const YKFPIVPaddingDigest YKFPIVPaddingSHA224 = {CC_SHA224_DIGEST_LENGTH, CC_SHA224, YKFPIVPaddingSHA224Prefix, sizeof(YKFPIVPaddingSHA224Prefix)};
+static const YKFPIVPaddingDigest YKFPIVPaddingSHA256 = {CC_SHA256_DIGEST_LENGTH, CC_SHA256, YKFPIVPaddingSHA256Prefix, sizeof(YKFPIVPaddingSHA256Prefix)};
+static const YKFPIVPaddingDigest YKFPIVPaddingSHA384 = {CC_SHA384_DIGEST_LENGTH, CC_SHA384, YKFPIVPaddingSHA384Prefix, sizeof(YKFPIVPaddingSHA384Prefix)};
+static const YKFPIVPaddingDigest YKFPIVPaddingSHA512 = {CC_SHA512_DIGEST_LENGTH, CC_SHA512, YKFPIVPaddingSHA512Prefix, sizeof(YKFPIVPaddingSHA512Prefix)};
+
+// PKCS#1 v1.5 requires at least 8 bytes of padding string.
+static const NSUInteger YKFPIVPaddingPKCS1MinPaddingLength = 8;
+
+typedef NS_ENUM(NSUInteger, YKFPIVPaddingScheme) {
+    YKFPIVPaddingSchemeUnsupported,
+    YKFPIVPaddingSchemeRaw,
+    YKFPIVPaddingSchemePKCS1,
+    YKFPIVPaddingSchemePSS,
+    // The encryption schemes are only removed from decrypted data, the data is encrypted with the public key.
+    YKFPIVPaddingSchemeRawEncryption,
+    YKFPIVPaddingSchemePKCS1Encryption,
+    YKFPIVPaddingSchemeOAEP,
+};
+
+typedef struct {
+    YKFPIVPaddingScheme scheme;
+    // NULL for the schemes without digest and for the raw PKCS#1 v1.5 signature.
+    const YKFPIVPaddingDigest *digest;
+    // YES when the input is the message, which is hashed before padding.
+    BOOL hashesMessage;
+} YKFPIVPaddingParameters;
+
+static BOOL YKFPIVPaddingAlgorithmIs(SecKeyAlgorithm algorithm, SecKeyAlgorithm other) {
+    return CFEqual(algorithm, other);
+}
+
+static YKFPIVPaddingParameters YKFPIVPaddingParametersForAlgorithm(SecKeyAlgorithm algorithm) {
+    if (YKFPIVPaddingAlgorithmIs(algorithm, kSecKeyAlgorithmRSASignatureRaw)) {
+        return (YKFPIVPaddingParameters){YKFPIVPaddingSchemeRaw, NULL, NO};
+    }
+    if (YKFPIVPaddingAlgorithmIs(algorithm, kSecKeyAlgorithmRSAEncryptionRaw)) {
+        return (YKFPIVPaddingParameters){YKFPIVPaddingSchemeRawEncryption, NULL, NO};
+    }
+    if (YKFPIVPaddingAlgorithmIs(algorithm, kSecKeyAlgorithmRSASignatureDigestPKCS1v15Raw)) {
+        return (YKFPIVPaddingParameters){YKFPIVPaddingSchemePKCS1, NULL, NO};
+    }
+    if (YKFPIVPaddingAlgorithmIs(algorithm, kSecKeyAlgorithmRSAEncryptionPKCS1)) {
+        return (YKFPIVPaddingParameters){YKFPIVPaddingSchemePKCS1Encryption, NULL, NO};
+    }
+    
+    const struct {
+        SecKeyAlgorithm algorithm;
+        YKFPIVPaddingScheme scheme;
+        const YKFPIVPaddingDigest *digest;
+        BOOL hashesMessage;
+    } algorithms[] = {
+        {kSecKeyAlgorithmRSASignatureDigestPKCS1v15SHA1, YKFPIVPaddingSchemePKCS1, &YKFPIVPaddingSHA1, NO},
+        {kSecKeyAlgorithmRSASignatureDigestPKCS1v15SHA224, YKFPIVPaddingSchemePKCS1, &YKFPIVPaddingSHA224, NO},
+        {kSecKeyAlgorithmRSASignatureDigestPKCS1v15SHA256, YKFPIVPaddingSchemePKCS1, &YKFPIVPaddingSHA256, NO},
+        {kSecKeyAlgorithmRSASignatureDigestPKCS1v15SHA384, YKFPIVPaddingSchemePKCS1, &YKFPIVPaddingSHA384, NO},
+        {kSecKeyAlgorithmRSASignatureDigestPKCS1v15SHA512, YKFPIVPaddingSchemePKCS1, &YKFPIVPaddingSHA512, NO},
+        {kSecKeyAlgorithmRSASignatureMessagePKCS1v15SHA1, YKFPIVPaddingSchemePKCS1, &YKFPIVPaddingSHA1, YES},
+        {kSecKeyAlgorithmRSASignatureMessagePKCS1v15SHA224, YKFPIVPaddingSchemePKCS1, &YKFPIVPaddingSHA224, YES},
+        {kSecKeyAlgorithmRSASignatureMessagePKCS1v15SHA256, YKFPIVPaddingSchemePKCS1, &YKFPIVPaddingSHA256, YES},
+        {kSecKeyAlgorithmRSASignatureMessagePKCS1v15SHA384, YKFPIVPaddingSchemePKCS1, &YKFPIVPaddingSHA384, YES},
+        {kSecKeyAlgorithmRSASignatureMessagePKCS1v15SHA512, YKFPIVPaddingSchemePKCS1, &YKFPIVPaddingSHA512, YES},
+        {kSecKeyAlgorithmRSASignatureDigestPSSSHA1, YKFPIVPaddingSchemePSS, &YKFPIVPaddingSHA1, NO},
+        {kSecKeyAlgorithmRSASignatureDigestPSSSHA224, YKFPIVPaddingSchemePSS, &YKFPIVPaddingSHA224, NO},
+        {kSecKeyAlgorithmRSASignatureDigestPSSSHA256, YKFPIVPaddingSchemePSS, &YKFPIVPaddingSHA256, NO},
+        {kSecKeyAlgorithmRSASignatureDigestPSSSHA384, YKFPIVPaddingSchemePSS, &YKFPIVPaddingSHA384, NO},
+        {kSecKeyAlgorithmRSASignatureDigestPSSSHA512, YKFPIVPaddingSchemePSS, &YKFPIVPaddingSHA512, NO},
+        {kSecKeyAlgorithmRSASignatureMessagePSSSHA1, YKFPIVPaddingSchemePSS, &YKFPIVPaddingSHA1, YES},
+        {kSecKeyAlgorithmRSASignatureMessagePSSSHA224, YKFPIVPaddingSchemePSS, &YKFPIVPaddingSHA224, YES},
+        {kSecKeyAlgorithmRSASignatureMessagePSSSHA256, YKFPIVPaddingSchemePSS, &YKFPIVPaddingSHA256, YES},
+        {kSecKeyAlgorithmRSASignatureMessagePSSSHA384, YKFPIVPaddingSchemePSS, &YKFPIVPaddingSHA384, YES},
+        {kSecKeyAlgorithmRSASignatureMessagePSSSHA512, YKFPIVPaddingSchemePSS, &YKFPIVPaddingSHA512, YES},
+        {kSecKeyAlgorithmRSAEncryptionOAEPSHA1, YKFPIVPaddingSchemeOAEP, &YKFPIVPaddingSHA1, NO},
+        {kSecKeyAlgorithmRSAEncryptionOAEPSHA224, YKFPIVPaddingSchemeOAEP, &YKFPIVPaddingSHA224, NO},
+        {kSecKeyAlgorithmRSAEncryptionOAEPSHA256, YKFPIVPaddingSchemeOAEP, &YKFPIVPaddingSHA256, NO},
+        {kSecKeyAlgorithmRSAEncryptionOAEPSHA384, YKFPIVPaddingSchemeOAEP, &YKFPIVPaddingSHA384, NO},
+        {kSecKeyAlgorithmRSAEncryptionOAEPSHA512, YKFPIVPaddingSchemeOAEP, &YKFPIVPaddingSHA512, NO},
+    };
+    for (size_t i = 0; i < sizeof(algorithms) / sizeof(algorithms[0]); ++i) {
+        if (YKFPIVPaddingAlgorithmIs(algorithm, algorithms[i].algorithm)) {
+            return (YKFPIVPaddingParameters){algorithms[i].scheme, algorithms[i].digest, algorithms[i].hashesMessage};
+        }
+    }
+    return (YKFPIVPaddingParameters){YKFPIVPaddingSchemeUnsupported, NULL, NO};
+}
+
+#pragma mark - Encoding
+
+static NSError *YKFPIVPaddingError(NSString *description) {
+    return [[NSError alloc] initWithDomain:@"com.yubico.piv" code:1 userInfo:@{NSLocalizedDescriptionKey: description}];
+}
+
+/*
+ XORs the mask generated with MGF1 from the seed into the buffer (RFC 8017, appendix B.2.1). The seed is at most
+ the length of the largest key.
+ */
+static void YKFPIVPaddingApplyMGF1(const YKFPIVPaddingDigest *digest, const UInt8 *seed, NSUInteger seedLength, UInt8 *buffer, NSUInteger length) {
+    UInt8 input[2048 / 8 + 4];
+    NSCParameterAssert(seedLength <= 2048 / 8);
+    UInt8 mask[CC_SHA512_DIGEST_LENGTH];
+    memcpy(input, seed, seedLength);
+    
+    UInt32 counter = 0;
+    for (NSUInteger offset = 0; offset < length; offset += digest->length, ++counter) {
+        input[seedLength] = (UInt8)(counter >> 24);
+        input[seedLength + 1] = (UInt8)(counter >> 16);
+        input[seedLength + 2] = (UInt8)(counter >> 8);
+        input[seedLength + 3] = (UInt8)counter;
+        digest->function(input, (CC_LONG)(seedLength + 4), mask);
+        
+        NSUInteger maskLength = MIN(digest->length, length - offset);
+        for (NSUInteger i = 0; i < maskLength; ++i) {
+            buffer[offset + i] ^= mask[i];
+        }
+    }
+}
+
+/*
+ EMSA-PKCS1-v1_5 encoding: 00 01 FF...FF 00 T, where T is the DigestInfo or the raw input (RFC 8017, section 9.2).
+ */
+static NSData *YKFPIVPaddingEncodePKCS1(const UInt8 *prefix, NSUInteger prefixLength, const UInt8 *value, NSUInteger valueLength, NSUInteger keyLength) {
+    NSUInteger tLength = prefixLength + valueLength;
+    if (tLength + 3 + YKFPIVPaddingPKCS1MinPaddingLength > keyLength) {
+        return nil;
+    }
+    NSMutableData *encoded = [[NSMutableData alloc] initWithLength:keyLength];
+    UInt8 *bytes = encoded.mutableBytes;
+    NSUInteger paddingLength = keyLength - tLength - 3;
+    bytes[1] = 0x01;
+    memset(bytes + 2, 0xFF, paddingLength);
+    if (prefixLength) {
+        memcpy(bytes + 3 + paddingLength, prefix, prefixLength);
+    }
+    memcpy(bytes + 3 + paddingLength + prefixLength, value, valueLength);
+    return encoded;
+}
+
+/*
+ EMSA-PSS encoding with MGF1 of the same digest and a salt of the digest length, which is what the Security framework
+ uses (RFC 8017, section 9.1.1). The modulus of the PIV keys is a multiple of 8 bits, so the encoded message has
+ the length of the key with its top bit cleared.
+ */
+static NSData *YKFPIVPaddingEncodePSS(const YKFPIVPaddingDigest *digest, const UInt8 *hash, NSUInteger keyLength) {
+    NSUInteger hLength = digest->length;
+    NSUInteger sLength = hLength;
+    if (keyLength < hLength + sLength + 2) {
+        return nil;
+    }
+    
+    UInt8 salt[CC_SHA512_DIGEST_LENGTH];
+    if (SecRandomCopyBytes(kSecRandomDefault, sLength, salt) != errSecSuccess) {
+        return nil;
+    }
+    
+    // M' = 00 00 00 00 00 00 00 00 || mHash || salt
+    UInt8 mPrime[8 + 2 * CC_SHA512_DIGEST_LENGTH] = {0};
+    memcpy(mPrime + 8, hash, hLength);
+    memcpy(mPrime + 8 + hLength, salt, sLength);
+    
+    NSMutableData *encoded = [[NSMutableData alloc] initWithLength:keyLength];
+    UInt8 *bytes = encoded.mutableBytes;
+    NSUInteger dbLength = keyLength - hLength - 1;
+    UInt8 *h = bytes + dbLength;
+    digest->function(mPrime, (CC_LONG)(8 + hLength + sLength), h);
+    
+    // DB = PS || 01 || salt, masked with MGF1(H).
+    bytes[dbLength - sLength - 1] = 0x01;
+    memcpy(bytes + dbLength - sLength, salt, sLength);
+    YKFPIVPaddingApplyMGF1(digest, h, hLength, bytes, dbLength);
+    bytes[0] &= 0x7F;
+    bytes[keyLength - 1] = 0xBC;
+    return encoded;
+}
+
+/*
+ EME-PKCS1-v1_5 decoding: 00 02 PS 00 M, where PS is at least 8 nonzero bytes (RFC 8017, section 7.2.2).
+ */
+static NSData *YKFPIVPaddingDecodePKCS1(const UInt8 *bytes, NSUInteger length) {
+    if (length < 3 + YKFPIVPaddingPKCS1MinPaddingLength || bytes[0] != 0x00 || bytes[1] != 0x02) {
+        return nil;
+    }
+    NSUInteger separator = 2;
+    while (separator < length && bytes[separator] != 0x00) {
+        ++separator;
+    }
+    if (separator == length || separator - 2 < YKFPIVPaddingPKCS1MinPaddingLength) {
+        return nil;
+    }
+    return [NSData dataWithBytes:bytes + separator + 1 length:length - separator - 1];
+}
+
+/*
+ EME-OAEP decoding with MGF1 of the same digest and an empty label (RFC 8017, section 7.1.2). All the checks are
+ evaluated before failing to not reveal which one failed.
+ */
+static NSData *YKFPIVPaddingDecodeOAEP(const YKFPIVPaddingDigest *digest, const UInt8 *bytes, NSUInteger length) {
+    NSUInteger hLength = digest->length;
+    if (length < 2 * hLength + 2) {
+        return nil;
+    }
+    
+    NSMutableData *decoded = [[NSMutableData alloc] initWithBytes:bytes length:length];
+    UInt8 *em = decoded.mutableBytes;
+    UInt8 *seed = em + 1;
+    UInt8 *db = em + 1 + hLength;
+    NSUInteger dbLength = length - hLength - 1;
+    YKFPIVPaddingApplyMGF1(digest, db, dbLength, seed, hLength);
+    YKFPIVPaddingApplyMGF1(digest, seed, hLength, db, dbLength);
+    
+    UInt8 labelHash[CC_SHA512_DIGEST_LENGTH];
+    digest->function("", 0, labelHash);
+    
+    UInt8 invalid = em[0];
+    for (NSUInteger i = 0; i < hLength; ++i) {
+        invalid |= db[i] ^ labelHash[i];
+    }
+    
+    // DB = lHash || PS || 01 || M, where PS is zero or more 00 bytes.
+    NSUInteger messageOffset = 0;
+    UInt8 foundSeparator = 0;
+    for (NSUInteger i = hLength; i < dbLength; ++i) {
+        UInt8 isSeparator = !foundSeparator && db[i] == 0x01;
+        UInt8 isPadding = !foundSeparator && db[i] == 0x00;
+        if (isSeparator) {
+            messageOffset = i + 1;
+        }
+        invalid |= !foundSeparator && !isSeparator && !isPadding;
+        foundSeparator |= isSeparator;
+    }
+    invalid |= !foundSeparator;
+    
+    NSData *message = invalid ? nil : [NSData dataWithBytes:db + messageOffset length:dbLength - messageOffset];
+    [decoded resetBytesInRange:NSMakeRange(0, length)];
+    return message;
+}
 
 @implementation YKFPIVPadding
 
 + (NSData *)padData:(NSData *)data keyType:(YKFPIVKeyType)keyType algorithm:(SecKeyAlgorithm)algorithm error:(NSError **)error {
     if (keyType == YKFPIVKeyTypeRSA2048 || keyType == YKFPIVKeyTypeRSA1024) {
-        NSNumber *keySize = [NSNumber numberWithInt:YKFPIVSizeFromKeyType(keyType) * 8];
-        CFDictionaryRef attributes = (__bridge CFDictionaryRef) (@{(id)kSecAttrKeyType: (id)kSecAttrKeyTypeRSA,
-                                                                   (id)kSecAttrKeySizeInBits: keySize});
+        NSUInteger keyLength = YKFPIVSizeFromKeyType(keyType);
+        YKFPIVPaddingParameters parameters = YKFPIVPaddingParametersForAlgorithm(algorithm);
+        const YKFPIVPaddingDigest *digest = parameters.digest;
         
-        SecKeyRef publicKey;
-        SecKeyRef privateKey;
-        SecKeyGeneratePair(attributes, &publicKey, &privateKey);
-        CFErrorRef cfErrorRef = nil;
-        CFDataRef cfDataRef = (__bridge CFDataRef)data;
-        CFDataRef cfSignedDataRef = SecKeyCreateSignature(privateKey, algorithm, cfDataRef, &cfErrorRef);
-        CFRelease(privateKey);
-        if (cfErrorRef) {
-            NSError *encryptError = (__bridge NSError *)cfErrorRef;
-            *error = encryptError;
+        UInt8 hash[CC_SHA512_DIGEST_LENGTH];
+        const UInt8 *value = data.bytes;
+        NSUInteger valueLength = data.length;
+        if (digest && parameters.hashesMessage) {
+            digest->function(data.bytes, (CC_LONG)data.length, hash);
+            value = hash;
+            valueLength = digest->length;
+        } else if (digest && data.length != digest->length) {
+            *error = YKFPIVPaddingError(@"Failed to pad RSA data - digest has bad size.");
             return nil;
         }
-        CFDataRef cfEncryptedDataRef = SecKeyCreateEncryptedData(publicKey, kSecKeyAlgorithmRSAEncryptionRaw, cfSignedDataRef, &cfErrorRef);
-        CFRelease(publicKey);
-        if (cfErrorRef) {
-            NSError *encryptError = (__bridge NSError *)cfErrorRef;
-            *error = encryptError;
-            return nil;
+        
+        NSData *padded = nil;
+        switch (parameters.scheme) {
+            case YKFPIVPaddingSchemeRaw:
+                if (valueLength <= keyLength) {
+                    NSMutableData *rawData = [[NSMutableData alloc] initWithLength:keyLength - valueLength];
+                    [rawData appendData:data];
+                    padded = rawData;
+                }
+                break;
+            case YKFPIVPaddingSchemePKCS1:
+                padded = YKFPIVPaddingEncodePKCS1(digest ? digest->digestInfoPrefix : NULL, digest ? digest->digestInfoPrefixLength : 0, value, valueLength, keyLength);
+                break;
+            case YKFPIVPaddingSchemePSS:
+                padded = YKFPIVPaddingEncodePSS(digest, value, keyLength);
+                break;
+            default:
+                *error = YKFPIVPaddingError(@"RSA padding algorithm not supported.");
+                return nil;
+        }
+        if (!padded) {
+            *error = YKFPIVPaddingError(@"Failed to pad RSA data - input buffer bad size.");
         }
-        NSData *encrypted = (__bridge NSData*)cfEncryptedDataRef;
-        return encrypted;
+        return padded;
     } else if (keyType == YKFPIVKeyTypeECCP256 || keyType == YKFPIVKeyTypeECCP384) {
         int keySize = YKFPIVSizeFromKeyType(keyType);
         NSMutableData *hash = nil;
@@ -101,41 +373,30 @@
 }
 
 + (NSData *)unpadRSAData:(NSData *)data algorithm:(SecKeyAlgorithm)algorithm error:(NSError **)error {
-    NSNumber *size;
-    switch (data.length) {
-        case 1024 / 8:
-            size = @1024;
+    if (data.length != 1024 / 8 && data.length != 2048 / 8) {
+        *error = YKFPIVPaddingError(@"Failed to unpad RSA data - input buffer bad size.");
+        return nil;
+    }
+    
+    YKFPIVPaddingParameters parameters = YKFPIVPaddingParametersForAlgorithm(algorithm);
+    NSData *unpadded = nil;
+    switch (parameters.scheme) {
+        case YKFPIVPaddingSchemeRawEncryption:
+            return data;
+        case YKFPIVPaddingSchemePKCS1Encryption:
+            unpadded = YKFPIVPaddingDecodePKCS1(data.bytes, data.length);
             break;
-        case 2048 / 8:
-            size = @2048;
+        case YKFPIVPaddingSchemeOAEP:
+            unpadded = YKFPIVPaddingDecodeOAEP(parameters.digest, data.bytes, data.length);
             break;
         default:
-            *error = [[NSError alloc] initWithDomain:@"com.yubico.piv" code:1 userInfo:@{NSLocalizedDescriptionKey: @"Failed to unpad RSA data - input buffer bad size."}];
+            *error = YKFPIVPaddingError(@"RSA padding algorithm not supported.");
             return nil;
     }
-    CFDictionaryRef attributes = (__bridge CFDictionaryRef) @{(id)kSecAttrKeyType: (id)kSecAttrKeyTypeRSA,
-                                                              (id)kSecAttrKeySizeInBits: size};
-    SecKeyRef publicKey;
-    SecKeyRef privateKey;
-    SecKeyGeneratePair(attributes, &publicKey, &privateKey);
-    CFErrorRef cfErrorRef = nil;
-    CFDataRef cfDataRef = (__bridge CFDataRef)data;
-    CFDataRef cfEncryptedDataRef = SecKeyCreateEncryptedData(publicKey, kSecKeyAlgorithmRSAEncryptionRaw, cfDataRef, &cfErrorRef);
-    CFRelease(publicKey);
-    if (cfErrorRef) {
-        NSError *encryptError = (__bridge NSError *)cfErrorRef;
-        *error = encryptError;
-        return nil;
-    }
-    CFDataRef cfDecryptedDataRef = SecKeyCreateDecryptedData(privateKey, algorithm, cfEncryptedDataRef, &cfErrorRef);
-    CFRelease(privateKey);
-    if (cfErrorRef) {
-        NSError *decryptError = (__bridge NSError *)cfErrorRef;
-        *error = decryptError;
-        return nil;
+    if (!unpadded) {
+        *error = YKFPIVPaddingError(@"Failed to unpad RSA data - padding is not valid.");
     }
-    NSData *decrypted = (__bridge NSData*)cfDecryptedDataRef;
-    return decrypted;
+    return unpadded;
 }
 
 @end
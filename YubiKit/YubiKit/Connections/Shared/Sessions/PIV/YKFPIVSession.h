@@ -59,7 +59,7 @@ typedef NS_ENUM(NSUInteger, YKFPIVFErrorCode) {
     YKFPIVFErrorCodeAuthenticationFailed = 8
 };
 
-@class YKFPIVSessionFeatures, YKFPIVManagementKeyType, YKFPIVManagementKeyMetadata;
+@class YKFPIVSessionFeatures, YKFPIVManagementKeyType, YKFPIVManagementKeyMetadata, YKFPIVObjectCache, YKFPIVSlotInventory;
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -75,6 +75,15 @@ typedef void (^YKFPIVSessionGenericCompletionBlock)
 typedef void (^YKFPIVSessionSignCompletionBlock)
     (NSData* _Nullable signature, NSError* _Nullable error);
 
+/// @abstract Response block for [signMessages:withKeyInSlot:type:algorithm:pin:completion:] which provides the
+///           signatures or the errors of the messages.
+/// @param signatures The signatures, in the order of the messages. The signature of a message which failed is empty.
+/// @param errors The errors of the messages which could not be signed, keyed by the index of the message. The
+///               dictionary is empty when all the messages were signed.
+/// @param error The first error returned for a message, if any.
+typedef void (^YKFPIVSessionSignMessagesCompletionBlock)
+    (NSArray<NSData*>* _Nonnull signatures, NSDictionary<NSNumber*, NSError*>* _Nonnull errors, NSError* _Nullable error);
+
 /// @abstract Response block for [decryptWithKeyInSlot:algorithm:encrypted:completion:] which provides the decrypted data or an error.
 /// @param decrypted The decrypted data.
 /// @param error An error object that indicates why the request failed, or nil if the request was successful.
@@ -146,6 +155,13 @@ typedef void (^YKFPIVSessionPinAttemptsCompletionBlock)
 typedef void (^YKFPIVSessionManagementKeyMetadataCompletionBlock)
     (YKFPIVManagementKeyMetadata* _Nullable metaData, NSError* _Nullable error);
 
+/// @abstract Response block for [getSlotInventoryWithCompletion:] which provides the keys and certificates stored
+///           in the slots or an error.
+/// @param inventory The keys and certificates stored in the slots.
+/// @param error An error object that indicates why the request failed, or nil if the request was successful.
+typedef void (^YKFPIVSessionSlotInventoryCompletionBlock)
+    (YKFPIVSlotInventory* _Nullable inventory, NSError* _Nullable error);
+
 /// @class YKFPIVSession
 /// @abstract Provides the interface for executing PIV requests with the key.
 /// @discussion The PIV session is mantained by the YKFConnection which controls its lifecycle. The application
@@ -170,6 +186,22 @@ typedef void (^YKFPIVSessionManagementKeyMetadataCompletionBlock)
 /// @note This method is thread safe and can be invoked from any thread (main or a background thread).
 - (void)signWithKeyInSlot:(YKFPIVSlot)slot type:(YKFPIVKeyType)keyType algorithm:(SecKeyAlgorithm)algorithm message:(nonnull NSData *)message completion:(nonnull YKFPIVSessionSignCompletionBlock)completion;
 
+/// @abstract Create the signatures of several messages with the same key.
+/// @discussion The messages are padded in parallel before anything is sent to the YubiKey, then the signing requests
+///             are sent back to back in one operation, after verifying the PIN when one is given. This avoids the
+///             dispatch and the round trip of a separate request for each message.
+/// @param messages The messages to hash and sign.
+/// @param slot The slot containing the private key to use.
+/// @param keyType The type of the key stored in the slot.
+/// @param algorithm The signing algorithm to use.
+/// @param pin The PIN verified before signing, or nil if it's already verified or not required by the key.
+///            When the PIN verification fails, no signing request is sent and the error is returned for all the
+///            messages.
+/// @param completion The completion handler that gets called once the YubiKey has finished processing the
+///                   requests. This handler is executed on a background queue.
+/// @note This method is thread safe and can be invoked from any thread (main or a background thread).
+- (void)signMessages:(nonnull NSArray<NSData *> *)messages withKeyInSlot:(YKFPIVSlot)slot type:(YKFPIVKeyType)keyType algorithm:(SecKeyAlgorithm)algorithm pin:(nullable NSString *)pin completion:(nonnull YKFPIVSessionSignMessagesCompletionBlock)completion;
+
 /// @abstract Decrypt a RSA-encrypted message.
 /// @param slot The slot containing the private key to use.
 /// @param algorithm The algorithm used for encryption.
@@ -283,6 +315,20 @@ typedef void (^YKFPIVSessionManagementKeyMetadataCompletionBlock)
 ///                   This handler is executed on a background queue.
 - (void)getCertificateInSlot:(YKFPIVSlot)slot completion:(nonnull YKFPIVSessionReadCertCompletionBlock)completion;
 
+/// @abstract Reads the metadata of the keys and the certificates of all the slots in a single exchange with the YubiKey.
+/// @discussion The requests are sent back to back in one operation, which is much faster over NFC than reading
+///             each slot with getCertificateInSlot:completion:. Slots without key or certificate are not an error.
+/// @param completion The completion handler that gets called once the YubiKey has finished processing the request.
+///                   This handler is executed on a background queue.
+///             The certificates are read through the object cache when it is set: the read objects are stored, so
+///             a following getCertificateInSlot:completion: doesn't read them again.
+/// @note The inventory covers the slots of YKFPIVSlot (9a, 9c, 9d, 9e and f9). The retired key management
+///       slots 82 to 95 are not read.
+///       The metadata of the keys requires support for feature metadata, available on YubiKey 5.3 or later. Older
+///       YubiKeys return the certificates only.
+///       This method is thread safe and can be invoked from any thread (main or a background thread).
+- (void)getSlotInventoryWithCompletion:(nonnull YKFPIVSessionSlotInventoryCompletionBlock)completion;
+
 /// @abstract Deletes the X.509 certificate stored in the specified slot on the YubiKey.
 /// @discussion This method requires authentication.
 /// @param slot The slot where the certificate is stored.
@@ -384,6 +430,8 @@ typedef void (^YKFPIVSessionManagementKeyMetadataCompletionBlock)
 /// @abstract Retrieve the number of pin attempts left for the YubiKey.
 /// @param completion The completion handler that gets called once the YubiKey has finished processing the request.
 ///                   This handler is executed on a background queue.
+/// @discussion The retries reported by the YubiKey for the PIN metadata, the PIN verification or the PIN change
+///             in this session are returned without sending a request to the YubiKey.
 /// @note If this command is run in a session where the correct pin has already been verified,
 ///       the correct value will not be retrievable, and the value returned may be incorrect if the
 ///       number of total attempts has been changed from the default.
@@ -399,6 +447,12 @@ typedef void (^YKFPIVSessionManagementKeyMetadataCompletionBlock)
 /// @note This method is thread safe and can be invoked from any thread (main or a background thread).
 - (void)setPinAttempts:(int)pinAttempts pukAttempts:(int)pukAttempts completion:(nonnull YKFPIVSessionGenericCompletionBlock)completion;
 
+/// @abstract Optional cache for the data objects read from the YubiKey, like the certificates.
+/// @discussion When set, getCertificateInSlot:completion: returns the certificate cached for the YubiKey, checked
+///             according to the validation of the cache. The objects written through the session are removed from
+///             the cache. The cache is not set by default and can be shared between sessions.
+@property (nonatomic, nullable) YKFPIVObjectCache *objectCache;
+
 /// Not available. Use only the instance from the YKFAccessoryConnection or YKFNFCConnection.
 - (nonnull instancetype)init NS_UNAVAILABLE;
 
@@ -32,7 +32,12 @@
 #import "YKFSessionError+Private.h"
 #import "YKFPIVManagementKeyMetadata+Private.h"
 #import "YKFPIVPadding+Private.h"
-#import "TKTLVRecordAdditions+Private.h"
+#import "YKFPIVObjectCache.h"
+#import "YKFPIVSlotMetadata+Private.h"
+#import "YKFPIVSlotInventory+Private.h"
+#import "YKFAPDUError.h"
+#import "YKFBERTLV.h"
+#import "YKFAssert.h"
 
 NSString* const YKFPIVErrorDomain = @"com.yubico.piv";
 
@@ -61,6 +66,7 @@ static const NSUInteger YKFPIVInsAttest = 0xf9;
 static const NSUInteger YKFPIVTagMetadataIsDefault = 0x05;
 static const NSUInteger YKFPIVTagMetadataAlgorithm = 0x01;
 static const NSUInteger YKFPIVTagMetadataTouchPolicy = 0x02;
+static const NSUInteger YKFPIVTagMetadataOrigin = 0x03;
 static const NSUInteger YKFPIVTagMetadataRetries = 0x06;
 static const NSUInteger YKFPIVTagDynAuth = 0x7c;
 static const NSUInteger YKFPIVTagAuthWitness = 0x80;
@@ -80,15 +86,68 @@ static const NSUInteger YKFPIVTagTouchPolicy = 0xab;
 static const NSUInteger YKFPIVP2Pin = 0x80;
 static const NSUInteger YKFPIVP2Puk = 0x81;
 
+// Metadata values
+static const UInt8 YKFPIVMetadataOriginGenerated = 0x01;
+
+// The slots read by getSlotInventoryWithCompletion:
+static const YKFPIVSlot YKFPIVInventorySlots[] = {
+    YKFPIVSlotAuthentication, YKFPIVSlotSignature, YKFPIVSlotKeyManagement, YKFPIVSlotCardAuth, YKFPIVSlotAttestation
+};
+static const NSUInteger YKFPIVInventorySlotsCount = sizeof(YKFPIVInventorySlots) / sizeof(YKFPIVInventorySlots[0]);
+static const NSTimeInterval YKFPIVInventoryTimeout = 10; // seconds, per frame
+
+// The private key operations may wait for a touch.
+static const NSTimeInterval YKFPIVAuthenticateTimeout = 120; // seconds
+
+// The retries of the PIN and the PUK of a new or reset YubiKey.
+static const int YKFPIVDefaultRetries = 3;
+
 typedef void (^YKFPIVSessionDataCompletionBlock)
     (NSData* _Nullable data, NSError* _Nullable error);
 
+/*
+ The retries of the PIN or the PUK, as last reported by the YubiKey to the session. -1 when the value is unknown.
+ */
+@interface YKFPIVReferenceRetries: NSObject
+
+@property (nonatomic) int total;
+@property (nonatomic) int remaining;
+
+@end
+
+@implementation YKFPIVReferenceRetries
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        self.total = -1;
+        self.remaining = -1;
+    }
+    return self;
+}
+
+@end
+
 @interface YKFPIVSession()
 
 @property (nonatomic, readonly) BOOL isValid;
 @property (nonatomic, readwrite) YKFVersion * _Nonnull version;
 @property (nonatomic, readwrite) YKFPIVSessionFeatures * _Nonnull features;
 
+/*
+ The serial number of the YubiKey, read once to key the objects in the object cache. nil until it is read or
+ when the YubiKey doesn't report it.
+ */
+@property (nonatomic, nullable) NSNumber *objectCacheSerialNumber;
+
+/*
+ The retries of the PIN and the PUK, keyed by their P2 reference. The retries are updated from the metadata and,
+ through updateRetriesForReference:error:, from the status word of every command verifying the PIN or the PUK.
+ They are accurate as long as the YubiKey isn't used by another session while this one is open, and unknown again
+ after a status word which doesn't report them.
+ */
+@property (nonatomic) NSMutableDictionary<NSNumber *, YKFPIVReferenceRetries *> *referenceRetries;
+
 @end
 
 @implementation YKFPIVSession
@@ -112,40 +171,94 @@ typedef void (^YKFPIVSessionDataCompletionBlock)
 }
 
 
-int currentPinAttempts = 3;
-int maxPinAttempts = 3;
-
 + (void)sessionWithConnectionController:(nonnull id<YKFConnectionControllerProtocol>)connectionController
                              completion:(YKFPIVSessionCompletion _Nonnull)completion {
     YKFPIVSession *session = [YKFPIVSession new];
     session.features = [YKFPIVSessionFeatures new];
+    session.referenceRetries = [[NSMutableDictionary alloc] init];
     session.smartCardInterface = [[YKFSmartCardInterface alloc] initWithConnectionController:connectionController];
     
     YKFSelectApplicationAPDU *apdu = [[YKFSelectApplicationAPDU alloc] initWithApplicationName:YKFSelectApplicationAPDUNamePIV];
-    [session.smartCardInterface selectApplication:apdu completion:^(NSData * _Nullable data, NSError * _Nullable error) {
+    YKFAPDU *versionAPDU = [[YKFAPDU alloc] initWithCla:0 ins:YKFPIVInsGetVersion p1:0 p2:0 data:[NSData data] type:YKFAPDUTypeShort];
+    [session.smartCardInterface executeCommands:@[apdu, versionAPDU] completion:^(NSArray<YKFSmartCardInterfaceCommandResult *> * _Nonnull results, NSError * _Nullable error) {
         if (error) {
             completion(nil, error);
-        } else {
-            YKFAPDU *versionAPDU = [[YKFAPDU alloc] initWithCla:0 ins:YKFPIVInsGetVersion p1:0 p2:0 data:[NSData data] type:YKFAPDUTypeShort];
-            [session.smartCardInterface executeCommand:versionAPDU completion:^(NSData * _Nullable data, NSError * _Nullable error) {
-                if (error) {
-                    completion(nil, error);
-                } else {
-                    if ([data length] < 3) {
-                        completion(nil, [[NSError alloc] initWithDomain:YKFPIVErrorDomain code:YKFPIVFErrorCodeInvalidResponse userInfo:@{NSLocalizedDescriptionKey: @"Invalid response when retrieving PIV version."}]);
-                        return;
-                    }
-                    UInt8 *versionBytes = (UInt8 *)data.bytes;
-                    session.version = [[YKFVersion alloc] initWithBytes:versionBytes[0] minor:versionBytes[1] micro:versionBytes[2]];
-                    completion(session, nil);
-                }
-            }];
+            return;
+        }
+        NSData *data = results.lastObject.data;
+        if ([data length] < 3) {
+            completion(nil, [[NSError alloc] initWithDomain:YKFPIVErrorDomain code:YKFPIVFErrorCodeInvalidResponse userInfo:@{NSLocalizedDescriptionKey: @"Invalid response when retrieving PIV version."}]);
+            return;
         }
+        UInt8 *versionBytes = (UInt8 *)data.bytes;
+        session.version = [[YKFVersion alloc] initWithBytes:versionBytes[0] minor:versionBytes[1] micro:versionBytes[2]];
+        completion(session, nil);
     }];
 }
 
 - (void)clearSessionState {
-    // Do nothing for now
+    self.objectCacheSerialNumber = nil;
+    @synchronized (self.referenceRetries) {
+        [self.referenceRetries removeAllObjects];
+    }
+}
+
+#pragma mark - PIN and PUK retries
+
+- (YKFPIVReferenceRetries *)retriesForReference:(UInt8)p2 {
+    YKFPIVReferenceRetries *retries = self.referenceRetries[@(p2)];
+    if (!retries) {
+        retries = [[YKFPIVReferenceRetries alloc] init];
+        self.referenceRetries[@(p2)] = retries;
+    }
+    return retries;
+}
+
+- (void)setRetriesTotal:(int)total remaining:(int)remaining forReference:(UInt8)p2 {
+    @synchronized (self.referenceRetries) {
+        YKFPIVReferenceRetries *retries = [self retriesForReference:p2];
+        retries.total = total;
+        retries.remaining = remaining;
+    }
+}
+
+- (void)setRetriesRemaining:(int)remaining forReference:(UInt8)p2 {
+    @synchronized (self.referenceRetries) {
+        [self retriesForReference:p2].remaining = remaining;
+    }
+}
+
+/*
+ A successful verification restores the retries to the total. Returns the remaining retries, or the default number
+ of retries when the total is unknown, like the YubiKey would after a reset.
+ */
+- (int)didVerifyReference:(UInt8)p2 {
+    @synchronized (self.referenceRetries) {
+        YKFPIVReferenceRetries *retries = [self retriesForReference:p2];
+        retries.remaining = retries.total;
+        return retries.total >= 0 ? retries.total : YKFPIVDefaultRetries;
+    }
+}
+
+/*
+ Updates the retries of the reference from the result of a command verifying it: a success restores the retries,
+ a wrong value reports the remaining ones. Any other error leaves the retries unknown. Returns the remaining
+ retries, or -1 when the error doesn't report them.
+ */
+- (int)updateRetriesForReference:(UInt8)p2 error:(NSError *)error {
+    if (!error) {
+        return [self didVerifyReference:p2];
+    }
+    int retries = [error isKindOfClass:[YKFSessionError class]] ? [self getRetriesFromStatusCode:(int)error.code] : -1;
+    [self setRetriesRemaining:retries forReference:p2];
+    return retries;
+}
+
+- (int)cachedRetriesRemainingForReference:(UInt8)p2 {
+    @synchronized (self.referenceRetries) {
+        YKFPIVReferenceRetries *retries = self.referenceRetries[@(p2)];
+        return retries ? retries.remaining : -1;
+    }
 }
 
 - (void)signWithKeyInSlot:(YKFPIVSlot)slot type:(YKFPIVKeyType)keyType algorithm:(SecKeyAlgorithm)algorithm message:(nonnull NSData *)message completion:(nonnull YKFPIVSessionSignCompletionBlock)completion {
@@ -159,6 +272,95 @@ int maxPinAttempts = 3;
     }];
 }
 
+- (void)signMessages:(NSArray<NSData *> *)messages withKeyInSlot:(YKFPIVSlot)slot type:(YKFPIVKeyType)keyType algorithm:(SecKeyAlgorithm)algorithm pin:(NSString *)pin completion:(YKFPIVSessionSignMessagesCompletionBlock)completion {
+    YKFParameterAssertReturn(messages);
+    YKFParameterAssertReturn(completion);
+    
+    NSUInteger count = messages.count;
+    if (!count) {
+        completion(@[], @{}, nil);
+        return;
+    }
+    
+    // The padding hashes the messages, which is done in parallel and off the communication queue.
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        NSMutableArray *payloads = [[NSMutableArray alloc] initWithCapacity:count];
+        for (NSUInteger i = 0; i < count; ++i) {
+            [payloads addObject:[NSNull null]];
+        }
+        dispatch_apply(count, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t i) {
+            NSError *padError = nil;
+            NSData *payload = [YKFPIVPadding padData:messages[i] keyType:keyType algorithm:algorithm error:&padError];
+            @synchronized (payloads) {
+                payloads[i] = payload ?: padError;
+            }
+        });
+        
+        NSMutableDictionary<NSNumber *, NSError *> *errors = [[NSMutableDictionary alloc] init];
+        NSMutableArray<NSData *> *signatures = [[NSMutableArray alloc] initWithCapacity:count];
+        NSMutableArray<YKFAPDU *> *apdus = [[NSMutableArray alloc] initWithCapacity:count];
+        NSMutableArray<NSNumber *> *apduMessageIndexes = [[NSMutableArray alloc] initWithCapacity:count];
+        NSError *firstError = nil;
+        for (NSUInteger i = 0; i < count; ++i) {
+            [signatures addObject:[NSData data]];
+            if ([payloads[i] isKindOfClass:[NSError class]]) {
+                errors[@(i)] = payloads[i];
+                firstError = firstError ?: payloads[i];
+                continue;
+            }
+            [apdus addObject:[self authenticateAPDUWithSlot:slot type:keyType message:payloads[i] exponentiation:NO]];
+            [apduMessageIndexes addObject:@(i)];
+        }
+        if (!apduMessageIndexes.count) {
+            // Completed on the communication queue, like when requests are sent.
+            [self.smartCardInterface dispatchAfterCurrentCommands:^{
+                completion(signatures, errors, firstError);
+            }];
+            return;
+        }
+        
+        // A connection error or a timeout stops the batch, so a key which doesn't respond is waited for once.
+        void (^signBlock)(void) = ^{
+            [self.smartCardInterface executeCommands:apdus sendRemainingIns:YKFSmartCardInterfaceSendRemainingInsNormal errorPolicy:YKFSmartCardInterfaceErrorPolicyContinue timeout:YKFPIVAuthenticateTimeout progress:nil completion:^(NSArray<YKFSmartCardInterfaceCommandResult *> * _Nonnull results, NSError * _Nullable error) {
+                NSError *firstSignError = firstError;
+                for (NSUInteger i = 0; i < apduMessageIndexes.count; ++i) {
+                    NSUInteger messageIndex = apduMessageIndexes[i].unsignedIntegerValue;
+                    NSError *signError = nil;
+                    NSData *signature = nil;
+                    if (results[i].error) {
+                        signError = results[i].error;
+                    } else {
+                        signature = [self resultFromAuthenticateResponse:results[i].data error:&signError];
+                    }
+                    if (signature) {
+                        signatures[messageIndex] = signature;
+                    } else {
+                        errors[@(messageIndex)] = signError;
+                        firstSignError = firstSignError ?: signError;
+                    }
+                }
+                completion(signatures, errors, firstSignError);
+            }];
+        };
+        if (!pin) {
+            signBlock();
+            return;
+        }
+        
+        // The signing requests are sent only once the PIN is verified, a wrong PIN fails all the messages.
+        [self verifyPin:pin completion:^(int retries, NSError * _Nullable pinError) {
+            if (pinError) {
+                for (NSNumber *index in apduMessageIndexes) {
+                    errors[index] = pinError;
+                }
+                completion(signatures, errors, pinError);
+                return;
+            }
+            signBlock();
+        }];
+    });
+}
+
 - (void)decryptWithKeyInSlot:(YKFPIVSlot)slot algorithm:(SecKeyAlgorithm)algorithm encrypted:(NSData *)encrypted completion:(nonnull YKFPIVSessionDecryptCompletionBlock)completion {
     YKFPIVKeyType keyType;
     switch (encrypted.length) {
@@ -187,24 +389,37 @@ int maxPinAttempts = 3;
     }];
 }
 
+- (YKFAPDU *)authenticateAPDUWithSlot:(YKFPIVSlot)slot type:(YKFPIVKeyType)type message:(NSData *)message exponentiation:(BOOL)exponentiation {
+    NSUInteger messageTag = exponentiation ? YKFPIVTagExponentiation : YKFPIVTagChallenge;
+    NSUInteger recordsLength = YKFBERTLVEncodedLength(YKFPIVTagAuthResponse, 0) + YKFBERTLVEncodedLength(messageTag, message.length);
+    NSMutableData *data = [[NSMutableData alloc] initWithLength:YKFBERTLVEncodedLength(YKFPIVTagDynAuth, recordsLength)];
+    YKFBERTLVWriter writer;
+    YKFBERTLVWriterInit(&writer, data.mutableBytes, data.length);
+    YKFBERTLVWriterBegin(&writer, YKFPIVTagDynAuth);
+    YKFBERTLVWriterAppend(&writer, YKFPIVTagAuthResponse, NULL, 0);
+    YKFBERTLVWriterAppend(&writer, messageTag, message.bytes, message.length);
+    YKFBERTLVWriterEnd(&writer);
+    data.length = YKFBERTLVWriterFinish(&writer);
+    return [[YKFAPDU alloc] initWithCla:0 ins:YKFPIVInsAuthenticate p1:type p2:slot data:data type:YKFAPDUTypeExtended];
+}
+
+- (NSData *)resultFromAuthenticateResponse:(NSData *)data error:(NSError **)error {
+    NSData *recordData = [data ykf_BERTLVValueWithTag:YKFPIVTagDynAuth error:error];
+    if (!recordData) {
+        return nil;
+    }
+    return [recordData ykf_BERTLVValueWithTag:YKFPIVTagAuthResponse error:error];
+}
+
 - (void)usePrivateKeyInSlot:(YKFPIVSlot)slot type:(YKFPIVKeyType)type message:(NSData *)message exponentiation:(BOOL)exponentiation completion:(YKFPIVSessionDataCompletionBlock)completion {
-    NSMutableData *recordsData = [NSMutableData data];
-    [recordsData appendData:[[TKBERTLVRecord alloc] initWithTag:YKFPIVTagAuthResponse value:[NSData data]].data];
-    [recordsData appendData:[[TKBERTLVRecord alloc] initWithTag:exponentiation ? YKFPIVTagExponentiation : YKFPIVTagChallenge value:message].data];
-    NSData *data = [[TKBERTLVRecord alloc] initWithTag:YKFPIVTagDynAuth value:recordsData].data;
-    YKFAPDU *apdu = [[YKFAPDU alloc] initWithCla:0 ins:YKFPIVInsAuthenticate p1:type p2:slot data:data type:YKFAPDUTypeExtended];
-    [self.smartCardInterface executeCommand:apdu timeout:120.0  completion:^(NSData * _Nullable data, NSError * _Nullable error) {
+    YKFAPDU *apdu = [self authenticateAPDUWithSlot:slot type:type message:message exponentiation:exponentiation];
+    [self.smartCardInterface executeCommand:apdu timeout:YKFPIVAuthenticateTimeout completion:^(NSData * _Nullable data, NSError * _Nullable error) {
         if (error) {
             completion(nil, error);
             return;
         }
         NSError *tlvError = nil;
-        NSData *recordData = [TKBERTLVRecord valueFromData:data withTag:YKFPIVTagDynAuth error:&tlvError];
-        if (tlvError) {
-            completion(nil, tlvError);
-            return;
-        }
-        NSData *result = [TKBERTLVRecord valueFromData:recordData withTag:YKFPIVTagAuthResponse error:&tlvError];
+        NSData *result = [self resultFromAuthenticateResponse:data error:&tlvError];
         if (tlvError) {
             completion(nil, tlvError);
             return;
@@ -400,44 +615,157 @@ int maxPinAttempts = 3;
 }
 
 - (void)putCertificate:(SecCertificateRef)certificate inSlot:(YKFPIVSlot)slot completion:(YKFPIVSessionGenericCompletionBlock)completion {
-    NSMutableData *mutableData = [NSMutableData data];
     NSData *certData = (__bridge NSData *)SecCertificateCopyData(certificate);
-    [mutableData appendData:[[TKBERTLVRecord alloc] initWithTag:YKFPIVTagCertificate value:certData].data];
-    [mutableData appendData:[[TKBERTLVRecord alloc] initWithTag:YKFPIVTagCertificateInfo value:certData].data];
-    [mutableData appendData:[[TKBERTLVRecord alloc] initWithTag:YKFPIVTagLRC value:[NSData data]].data];
+    NSMutableData *mutableData = [[NSMutableData alloc] initWithLength:2 * YKFBERTLVEncodedLength(YKFPIVTagCertificate, certData.length) + YKFBERTLVEncodedLength(YKFPIVTagLRC, 0)];
+    YKFBERTLVWriter writer;
+    YKFBERTLVWriterInit(&writer, mutableData.mutableBytes, mutableData.length);
+    YKFBERTLVWriterAppend(&writer, YKFPIVTagCertificate, certData.bytes, certData.length);
+    YKFBERTLVWriterAppend(&writer, YKFPIVTagCertificateInfo, certData.bytes, certData.length);
+    YKFBERTLVWriterAppend(&writer, YKFPIVTagLRC, NULL, 0);
+    mutableData.length = YKFBERTLVWriterFinish(&writer);
     [self putObject:mutableData objectId:[self objectIdForSlot:slot] completion:^(NSError * _Nullable error) {
         completion(error);
     }];
 }
 
 - (void)putObject:(NSData *)object objectId:(NSData *)objectId completion:(YKFPIVSessionGenericCompletionBlock)completion  {
-    NSMutableData *mutableData = [NSMutableData data];
-    [mutableData appendData:[[TKBERTLVRecord alloc] initWithTag:YKFPIVTagObjectId value:objectId].data];
-    [mutableData appendData:[[TKBERTLVRecord alloc] initWithTag:YKFPIVTagObjectData value:object].data];
+    NSMutableData *mutableData = [[NSMutableData alloc] initWithLength:YKFBERTLVEncodedLength(YKFPIVTagObjectId, objectId.length) + YKFBERTLVEncodedLength(YKFPIVTagObjectData, object.length)];
+    YKFBERTLVWriter writer;
+    YKFBERTLVWriterInit(&writer, mutableData.mutableBytes, mutableData.length);
+    YKFBERTLVWriterAppend(&writer, YKFPIVTagObjectId, objectId.bytes, objectId.length);
+    YKFBERTLVWriterAppend(&writer, YKFPIVTagObjectData, object.bytes, object.length);
+    mutableData.length = YKFBERTLVWriterFinish(&writer);
     YKFAPDU *apdu = [[YKFAPDU alloc] initWithCla:0 ins:YKFPIVInsPutData p1:0x3f p2:0xff data:mutableData type:YKFAPDUTypeExtended];
     [self.smartCardInterface executeCommand:apdu completion:^(NSData * _Nullable data, NSError * _Nullable error) {
-        completion(error);
+        // The object may have been partially written on error, the cached one is removed in any case.
+        [self removeCachedObjectWithId:objectId completion:^{
+            completion(error);
+        }];
     }];
 }
 
 - (void)getCertificateInSlot:(YKFPIVSlot)slot completion:(nonnull YKFPIVSessionReadCertCompletionBlock)completion {
-    NSData *data = [self objectIdForSlot:slot];
-    TKBERTLVRecord *tlv = [[TKBERTLVRecord alloc] initWithTag:YKFPIVTagObjectId value:data];
-    YKFAPDU *apdu = [[YKFAPDU alloc] initWithCla:0 ins:YKFPIVInsGetData p1:0x3f p2:0xff data:tlv.data type:YKFAPDUTypeExtended];
-    [self.smartCardInterface executeCommand:apdu completion:^(NSData * _Nullable data, NSError * _Nullable error) {
+    [self readObjectWithId:[self objectIdForSlot:slot] completion:^(NSData * _Nullable data, NSError * _Nullable error) {
         if (error != nil) {
             completion(nil, error);
         } else {
-            NSArray<TKTLVRecord*> *records = [TKBERTLVRecord sequenceOfRecordsFromData:data];
-            NSData *objectData = [records ykfTLVRecordWithTag:YKFPIVTagObjectData].value;
-            NSData *certificateData = [[TKBERTLVRecord sequenceOfRecordsFromData:objectData] ykfTLVRecordWithTag:YKFPIVTagCertificate].value;
-            CFDataRef cfCertDataRef =  (__bridge CFDataRef)certificateData;
-            SecCertificateRef certificate = SecCertificateCreateWithData(nil, cfCertDataRef);
+            SecCertificateRef certificate = [self copyCertificateFromObjectData:data];
             completion(certificate, nil);
         }
     }];
 }
 
+- (SecCertificateRef)copyCertificateFromObjectData:(NSData *)data {
+    YKFBERTLVIndex records;
+    if (!YKFBERTLVIndexInit(&records, data.bytes, data.length)) {
+        return nil;
+    }
+    const YKFBERTLVRecord *objectRecord = YKFBERTLVIndexFind(&records, YKFPIVTagObjectData);
+    YKFBERTLVIndex objectRecords;
+    if (!objectRecord || !YKFBERTLVIndexInit(&objectRecords, objectRecord->value, objectRecord->length)) {
+        return nil;
+    }
+    NSData *certificateData = [data ykf_valueOfBERTLVRecord:YKFBERTLVIndexFind(&objectRecords, YKFPIVTagCertificate)];
+    if (!certificateData) {
+        return nil;
+    }
+    return SecCertificateCreateWithData(nil, (__bridge CFDataRef)certificateData);
+}
+
+- (void)getSlotInventoryWithCompletion:(nonnull YKFPIVSessionSlotInventoryCompletionBlock)completion {
+    YKFPIVObjectCache *objectCache = self.objectCache;
+    [self objectCacheSerialNumberWithCompletion:^(NSNumber * _Nullable serialNumber) {
+        [self getSlotInventoryWithObjectCache:serialNumber ? objectCache : nil serialNumber:serialNumber.unsignedIntValue completion:completion];
+    }];
+}
+
+/*
+ Reads the inventory, reusing and refreshing the cached certificate objects. The cached objects which are not
+ validated are not read again, the others are read in full and replace the cached ones.
+ */
+- (void)getSlotInventoryWithObjectCache:(YKFPIVObjectCache *)objectCache serialNumber:(UInt32)serialNumber completion:(nonnull YKFPIVSessionSlotInventoryCompletionBlock)completion {
+    BOOL includesMetadata = [self.features.metadata isSupportedBySession:self];
+    
+    NSMutableDictionary<NSNumber *, NSData *> *objects = [[NSMutableDictionary alloc] init];
+    NSMutableArray<NSNumber *> *readSlots = [[NSMutableArray alloc] initWithCapacity:YKFPIVInventorySlotsCount];
+    NSMutableArray<YKFAPDU *> *apdus = [[NSMutableArray alloc] initWithCapacity:2 * YKFPIVInventorySlotsCount];
+    for (NSUInteger i = 0; i < YKFPIVInventorySlotsCount; ++i) {
+        NSData *objectId = [self objectIdForSlot:YKFPIVInventorySlots[i]];
+        NSData *cachedObject = [objectCache objectWithId:objectId serialNumber:serialNumber];
+        if (cachedObject && objectCache.validation == YKFPIVObjectCacheValidationNone) {
+            objects[@(YKFPIVInventorySlots[i])] = cachedObject;
+            continue;
+        }
+        [readSlots addObject:@(YKFPIVInventorySlots[i])];
+        [apdus addObject:[[YKFAPDU alloc] initWithCla:0 ins:YKFPIVInsGetData p1:0x3f p2:0xff data:[self getDataRequestWithObjectId:objectId] type:YKFAPDUTypeExtended]];
+    }
+    if (includesMetadata) {
+        for (NSUInteger i = 0; i < YKFPIVInventorySlotsCount; ++i) {
+            [apdus addObject:[[YKFAPDU alloc] initWithCla:0 ins:YKFPIVInsGetMetadata p1:0 p2:YKFPIVInventorySlots[i] data:[NSData data] type:YKFAPDUTypeShort]];
+        }
+    }
+    
+    // The empty slots fail with an error, the batch continues to read the other ones.
+    [self.smartCardInterface executeCommands:apdus sendRemainingIns:YKFSmartCardInterfaceSendRemainingInsNormal errorPolicy:YKFSmartCardInterfaceErrorPolicyContinue timeout:YKFPIVInventoryTimeout progress:nil completion:^(NSArray<YKFSmartCardInterfaceCommandResult *> * _Nonnull results, NSError * _Nullable error) {
+        for (YKFSmartCardInterfaceCommandResult *result in results) {
+            if (result.error && !(result.error.code == YKFAPDUErrorCodeMissingFile || result.error.code == YKFAPDUErrorCodeReferenceDataNotFound)) {
+                completion(nil, result.error);
+                return;
+            }
+        }
+        
+        for (NSUInteger i = 0; i < readSlots.count; ++i) {
+            NSData *objectId = [self objectIdForSlot:readSlots[i].unsignedIntegerValue];
+            NSData *data = results[i].data;
+            if (data.length) {
+                objects[readSlots[i]] = data;
+                [objectCache storeObject:data withId:objectId serialNumber:serialNumber];
+            } else {
+                [objectCache removeObjectWithId:objectId serialNumber:serialNumber];
+            }
+        }
+        
+        NSMutableDictionary<NSNumber *, id> *certificates = [[NSMutableDictionary alloc] init];
+        [objects enumerateKeysAndObjectsUsingBlock:^(NSNumber *slot, NSData *data, BOOL *stop) {
+            SecCertificateRef certificate = [self copyCertificateFromObjectData:data];
+            if (certificate) {
+                certificates[slot] = CFBridgingRelease(certificate);
+            }
+        }];
+        
+        NSMutableDictionary<NSNumber *, YKFPIVSlotMetadata *> *metadata = nil;
+        if (includesMetadata) {
+            metadata = [[NSMutableDictionary alloc] init];
+            for (NSUInteger i = 0; i < YKFPIVInventorySlotsCount; ++i) {
+                NSData *data = results[readSlots.count + i].data;
+                YKFPIVSlotMetadata *slotMetadata = data ? [YKFPIVSession slotMetadataFromData:data] : nil;
+                if (slotMetadata) {
+                    metadata[@(YKFPIVInventorySlots[i])] = slotMetadata;
+                }
+            }
+        }
+        
+        completion([[YKFPIVSlotInventory alloc] initWithMetadata:metadata certificates:certificates], nil);
+    }];
+}
+
++ (YKFPIVSlotMetadata *)slotMetadataFromData:(NSData *)data {
+    YKFBERTLVIndex records;
+    if (!YKFBERTLVIndexInit(&records, data.bytes, data.length)) {
+        return nil;
+    }
+    const YKFBERTLVRecord *algorithmRecord = YKFBERTLVIndexFind(&records, YKFPIVTagMetadataAlgorithm);
+    const YKFBERTLVRecord *policyRecord = YKFBERTLVIndexFind(&records, YKFPIVTagMetadataTouchPolicy);
+    const YKFBERTLVRecord *originRecord = YKFBERTLVIndexFind(&records, YKFPIVTagMetadataOrigin);
+    if (!algorithmRecord || algorithmRecord->length < 1 || !policyRecord || policyRecord->length < 2 || !originRecord || originRecord->length < 1) {
+        return nil;
+    }
+    return [[YKFPIVSlotMetadata alloc] initWithKeyType:algorithmRecord->value[0]
+                                             pinPolicy:policyRecord->value[0]
+                                           touchPolicy:policyRecord->value[1]
+                                             generated:originRecord->value[0] == YKFPIVMetadataOriginGenerated];
+}
+
 - (void)deleteCertificateInSlot:(YKFPIVSlot)slot completion:(nonnull YKFPIVSessionGenericCompletionBlock)completion {
     [self putObject:[NSData data] objectId:[self objectIdForSlot:slot] completion:^(NSError * _Nullable error) {
         completion(error);
@@ -531,24 +859,151 @@ int maxPinAttempts = 3;
 }
 
 - (void)resetWithCompletion:(YKFPIVSessionGenericCompletionBlock)completion {
-    [self blockPin:0 completion:^(NSError * _Nullable error) {
-        if (error != nil) {
-            completion(error);
-            return;
-        }
-        [self blockPuk:0 completion:^(NSError * _Nullable error) {
+    // The serial number is read first, so only the cached objects of this key are removed. Without serial
+    // number no object of this key is cached.
+    YKFPIVObjectCache *objectCache = self.objectCache;
+    [self objectCacheSerialNumberWithCompletion:^(NSNumber * _Nullable serialNumber) {
+        [self blockPin:0 completion:^(NSError * _Nullable error) {
             if (error != nil) {
                 completion(error);
                 return;
             }
-            YKFAPDU *apdu = [[YKFAPDU alloc] initWithCla:0 ins:YKFPIVInsReset p1:0 p2:0 data:[NSData data] type:YKFAPDUTypeShort];
-            [self.smartCardInterface executeCommand:apdu completion:^(NSData * _Nullable data, NSError * _Nullable error) {
-                completion(error);
+            [self blockPuk:0 completion:^(NSError * _Nullable error) {
+                if (error != nil) {
+                    completion(error);
+                    return;
+                }
+                YKFAPDU *apdu = [[YKFAPDU alloc] initWithCla:0 ins:YKFPIVInsReset p1:0 p2:0 data:[NSData data] type:YKFAPDUTypeShort];
+                [self.smartCardInterface executeCommand:apdu completion:^(NSData * _Nullable data, NSError * _Nullable error) {
+                    if (error == nil) {
+                        [self setRetriesTotal:YKFPIVDefaultRetries remaining:YKFPIVDefaultRetries forReference:YKFPIVP2Pin];
+                        [self setRetriesTotal:YKFPIVDefaultRetries remaining:YKFPIVDefaultRetries forReference:YKFPIVP2Puk];
+                    }
+                    if (serialNumber) {
+                        [objectCache removeObjectsForSerialNumber:serialNumber.unsignedIntValue];
+                    }
+                    completion(error);
+                }];
             }];
         }];
     }];
 }
 
+#pragma mark - Object cache
+
+- (NSData *)getDataRequestWithObjectId:(NSData *)objectId {
+    NSMutableData *data = [[NSMutableData alloc] initWithLength:YKFBERTLVEncodedLength(YKFPIVTagObjectId, objectId.length)];
+    YKFBERTLVWriter writer;
+    YKFBERTLVWriterInit(&writer, data.mutableBytes, data.length);
+    YKFBERTLVWriterAppend(&writer, YKFPIVTagObjectId, objectId.bytes, objectId.length);
+    data.length = YKFBERTLVWriterFinish(&writer);
+    return data;
+}
+
+/*
+ Reads the serial number keying the cached objects. The completion receives nil when there is no cache or when
+ the YubiKey doesn't report its serial number, in which case the cache is not used.
+ */
+- (void)objectCacheSerialNumberWithCompletion:(void (^)(NSNumber * _Nullable serialNumber))completion {
+    if (!self.objectCache || ![self.features.serial isSupportedBySession:self]) {
+        completion(nil);
+        return;
+    }
+    if (self.objectCacheSerialNumber) {
+        completion(self.objectCacheSerialNumber);
+        return;
+    }
+    [self getSerialNumberWithCompletion:^(int serialNumber, NSError * _Nullable error) {
+        if (!error) {
+            self.objectCacheSerialNumber = @((UInt32)serialNumber);
+        }
+        completion(self.objectCacheSerialNumber);
+    }];
+}
+
+- (void)removeCachedObjectWithId:(NSData *)objectId completion:(void (^)(void))completion {
+    YKFPIVObjectCache *objectCache = self.objectCache;
+    if (!objectCache) {
+        completion();
+        return;
+    }
+    [self objectCacheSerialNumberWithCompletion:^(NSNumber * _Nullable serialNumber) {
+        if (serialNumber) {
+            [objectCache removeObjectWithId:objectId serialNumber:serialNumber.unsignedIntValue];
+        }
+        completion();
+    }];
+}
+
+/*
+ Reads the data object, using the object cache when there is one. The completion receives the GET DATA response.
+ */
+- (void)readObjectWithId:(NSData *)objectId completion:(YKFPIVSessionDataCompletionBlock)completion {
+    YKFAPDU *apdu = [[YKFAPDU alloc] initWithCla:0 ins:YKFPIVInsGetData p1:0x3f p2:0xff data:[self getDataRequestWithObjectId:objectId] type:YKFAPDUTypeExtended];
+    YKFPIVObjectCache *objectCache = self.objectCache;
+    if (!objectCache) {
+        [self.smartCardInterface executeCommand:apdu completion:completion];
+        return;
+    }
+    
+    [self objectCacheSerialNumberWithCompletion:^(NSNumber * _Nullable serialNumber) {
+        if (!serialNumber) {
+            [self.smartCardInterface executeCommand:apdu completion:completion];
+            return;
+        }
+        UInt32 serial = serialNumber.unsignedIntValue;
+        YKFPIVSessionDataCompletionBlock storingCompletion = ^(NSData * _Nullable data, NSError * _Nullable error) {
+            if (data) {
+                [objectCache storeObject:data withId:objectId serialNumber:serial];
+            }
+            completion(data, error);
+        };
+        
+        NSData *cachedObject = [objectCache objectWithId:objectId serialNumber:serial];
+        if (!cachedObject) {
+            [self.smartCardInterface executeCommand:apdu completion:storingCompletion];
+            return;
+        }
+        if (objectCache.validation == YKFPIVObjectCacheValidationNone) {
+            completion(cachedObject, nil);
+            return;
+        }
+        
+        [self.smartCardInterface executeCommand:apdu firstFrameCompletion:^(NSData * _Nullable data, BOOL hasMoreData, NSError * _Nullable error) {
+            if (error) {
+                completion(nil, error);
+                return;
+            }
+            if (!hasMoreData) {
+                storingCompletion(data, nil);
+                return;
+            }
+            if ([YKFPIVSession object:cachedObject matchesFirstFrame:data]) {
+                completion(cachedObject, nil);
+                return;
+            }
+            [self.smartCardInterface executeCommand:apdu completion:storingCompletion];
+        }];
+    }];
+}
+
+/*
+ The cached object matches when it has the length announced by the header of the object and starts with the
+ bytes of the first frame.
+ */
++ (BOOL)object:(NSData *)object matchesFirstFrame:(NSData *)firstFrame {
+    UInt64 tag = 0;
+    size_t valueLength = 0;
+    size_t headerLength = 0;
+    if (!YKFBERTLVReadHeader(firstFrame.bytes, firstFrame.length, &tag, &valueLength, &headerLength)) {
+        return NO;
+    }
+    if (headerLength + valueLength != object.length || firstFrame.length > object.length) {
+        return NO;
+    }
+    return memcmp(object.bytes, firstFrame.bytes, firstFrame.length) == 0;
+}
+
 - (void)getSerialNumberWithCompletion:(YKFPIVSessionSerialNumberCompletionBlock)completion {
     if (![self.features.serial isSupportedBySession:self]) {
         completion(-1, [[NSError alloc] initWithDomain:YKFPIVErrorDomain code:YKFPIVFErrorCodeUnsupportedOperation userInfo:@{NSLocalizedDescriptionKey: @"Read serial number not supported by this YubiKey."}]);
@@ -572,25 +1027,20 @@ int maxPinAttempts = 3;
 
 - (void)verifyPin:(nonnull NSString *)pin completion:(nonnull YKFPIVSessionVerifyPinCompletionBlock)completion {
     NSData *data = [self paddedDataWithPin:pin];
-    YKFAPDU *apdu = [[YKFAPDU alloc] initWithCla:0 ins:YKFPIVInsVerify p1:0 p2:0x80 data:data type:YKFAPDUTypeShort];
+    YKFAPDU *apdu = [[YKFAPDU alloc] initWithCla:0 ins:YKFPIVInsVerify p1:0 p2:YKFPIVP2Pin data:data type:YKFAPDUTypeShort];
     [self.smartCardInterface executeCommand:apdu completion:^(NSData * _Nullable data, NSError * _Nullable error) {
+        int retries = [self updateRetriesForReference:YKFPIVP2Pin error:error];
         if (error == nil) {
-            currentPinAttempts = maxPinAttempts;
-            completion(currentPinAttempts, nil);
+            completion(retries, nil);
             return;
         } else {
-            YKFSessionError *sessionError = (YKFSessionError *)error;
-            if ([sessionError isKindOfClass:[YKFSessionError class]]) {
-                int retries = [self getRetriesFromStatusCode:(int)sessionError.code];
-                if (retries > 0) {
-                    currentPinAttempts = retries;
-                    completion(currentPinAttempts, [[NSError alloc] initWithDomain:YKFPIVErrorDomain code:YKFPIVFErrorCodeInvalidPin userInfo:@{NSLocalizedDescriptionKey: @"Invalid PIN code."}]);
-                    return;
-                    
-                } else if (retries == 0) {
-                    completion(retries, [[NSError alloc] initWithDomain:YKFPIVErrorDomain code:YKFPIVFErrorCodePinLocked userInfo:@{NSLocalizedDescriptionKey: @"PIN code entry locked."}]);
-                    return;
-                }
+            if (retries > 0) {
+                completion(retries, [[NSError alloc] initWithDomain:YKFPIVErrorDomain code:YKFPIVFErrorCodeInvalidPin userInfo:@{NSLocalizedDescriptionKey: @"Invalid PIN code."}]);
+                return;
+                
+            } else if (retries == 0) {
+                completion(retries, [[NSError alloc] initWithDomain:YKFPIVErrorDomain code:YKFPIVFErrorCodePinLocked userInfo:@{NSLocalizedDescriptionKey: @"PIN code entry locked."}]);
+                return;
             }
             // Not wrong pin nor locked pin entry, pass on original error
             completion(-1, error);
@@ -628,10 +1078,21 @@ int maxPinAttempts = 3;
             completion(0, 0, 0, error);
             return;
         }
-        NSArray<TKTLVRecord*> *records = [TKBERTLVRecord sequenceOfRecordsFromData:data];
-        UInt8 isDefault = ((UInt8 *)[records ykfTLVRecordWithTag:YKFPIVTagMetadataIsDefault].value.bytes)[0];
-        UInt8 retriesTotal = ((UInt8 *)[records ykfTLVRecordWithTag:YKFPIVTagMetadataRetries].value.bytes)[0];
-        UInt8 retriesRemaining = ((UInt8 *)[records ykfTLVRecordWithTag:YKFPIVTagMetadataRetries].value.bytes)[1];
+        YKFBERTLVIndex records;
+        const YKFBERTLVRecord *retriesRecord = NULL;
+        const YKFBERTLVRecord *isDefaultRecord = NULL;
+        if (YKFBERTLVIndexInit(&records, data.bytes, data.length)) {
+            retriesRecord = YKFBERTLVIndexFind(&records, YKFPIVTagMetadataRetries);
+            isDefaultRecord = YKFBERTLVIndexFind(&records, YKFPIVTagMetadataIsDefault);
+        }
+        if (!retriesRecord || retriesRecord->length < 2 || !isDefaultRecord || isDefaultRecord->length < 1) {
+            completion(0, 0, 0, [[NSError alloc] initWithDomain:YKFPIVErrorDomain code:YKFPIVFErrorCodeInvalidResponse userInfo:@{NSLocalizedDescriptionKey: @"Invalid response when reading PIN/PUK metadata."}]);
+            return;
+        }
+        UInt8 isDefault = isDefaultRecord->value[0];
+        UInt8 retriesTotal = retriesRecord->value[0];
+        UInt8 retriesRemaining = retriesRecord->value[1];
+        [self setRetriesTotal:retriesTotal remaining:retriesRemaining forReference:p2];
         completion(isDefault, retriesTotal, retriesRemaining, nil);
     }];
 }
@@ -647,16 +1108,27 @@ int maxPinAttempts = 3;
             completion(nil, error);
             return;
         }
-        NSArray<TKTLVRecord*> *records = [TKBERTLVRecord sequenceOfRecordsFromData:data];
-        TKTLVRecord *algorithmRecord = [records ykfTLVRecordWithTag:YKFPIVTagMetadataAlgorithm];
+        YKFBERTLVIndex records;
+        const YKFBERTLVRecord *algorithmRecord = NULL;
+        const YKFBERTLVRecord *isDefaultRecord = NULL;
+        const YKFBERTLVRecord *policyRecord = NULL;
+        if (YKFBERTLVIndexInit(&records, data.bytes, data.length)) {
+            algorithmRecord = YKFBERTLVIndexFind(&records, YKFPIVTagMetadataAlgorithm);
+            isDefaultRecord = YKFBERTLVIndexFind(&records, YKFPIVTagMetadataIsDefault);
+            policyRecord = YKFBERTLVIndexFind(&records, YKFPIVTagMetadataTouchPolicy);
+        }
+        if ((algorithmRecord && algorithmRecord->length < 1) || !isDefaultRecord || isDefaultRecord->length < 1 || !policyRecord || policyRecord->length < 2) {
+            completion(nil, [[NSError alloc] initWithDomain:YKFPIVErrorDomain code:YKFPIVFErrorCodeInvalidResponse userInfo:@{NSLocalizedDescriptionKey: @"Invalid response when reading management key metadata."}]);
+            return;
+        }
         YKFPIVManagementKeyType *keyType;
         if (algorithmRecord) {
-            keyType = [YKFPIVManagementKeyType fromValue:((UInt8 *)algorithmRecord.value.bytes)[0]];
+            keyType = [YKFPIVManagementKeyType fromValue:algorithmRecord->value[0]];
         } else {
             keyType = [YKFPIVManagementKeyType TripleDES];
         }
-        bool isDefault = ((UInt8 *)[records ykfTLVRecordWithTag:YKFPIVTagMetadataIsDefault].value.bytes)[0] != 0;
-        YKFPIVTouchPolicy touchPolicy = ((UInt8 *)[records ykfTLVRecordWithTag:YKFPIVTagMetadataTouchPolicy].value.bytes)[1];
+        bool isDefault = isDefaultRecord->value[0] != 0;
+        YKFPIVTouchPolicy touchPolicy = policyRecord->value[1];
         
         YKFPIVManagementKeyMetadata *metaData = [[YKFPIVManagementKeyMetadata alloc] initWithKeyType:keyType touchPolicy:touchPolicy isDefault:isDefault];
         completion(metaData, nil);
@@ -674,6 +1146,12 @@ int maxPinAttempts = 3;
 }
 
 - (void)getPinAttemptsWithCompletion:(nonnull YKFPIVSessionPinAttemptsCompletionBlock)completion {
+    // The retries last reported by the YubiKey are up to date unless another session used the YubiKey meanwhile.
+    int cachedRetries = [self cachedRetriesRemainingForReference:YKFPIVP2Pin];
+    if (cachedRetries >= 0) {
+        completion(cachedRetries, nil);
+        return;
+    }
     if ([self.features.metadata isSupportedBySession:self]) {
         [self getPinMetadataWithCompletion:^(bool isDefault, int retriesTotal, int retriesRemaining, NSError * _Nullable error) {
             completion(retriesRemaining, error);
@@ -681,12 +1159,8 @@ int maxPinAttempts = 3;
     } else {
         YKFAPDU *apdu = [[YKFAPDU alloc] initWithCla:0 ins:YKFPIVInsVerify p1:0 p2:YKFPIVP2Pin data:[NSData data] type:YKFAPDUTypeShort];
         [self.smartCardInterface executeCommand:apdu completion:^(NSData * _Nullable data, NSError * _Nullable error) {
-            if (error == nil) {
-                // Already verified, no way to know true count
-                completion(currentPinAttempts, nil);
-                return;
-            }
-            int retries = [self getRetriesFromStatusCode:(int)error.code];
+            // When the PIN is already verified there is no way to know the true count, the total is returned.
+            int retries = [self updateRetriesForReference:YKFPIVP2Pin error:error];
             completion(retries, retries < 0 ? error : nil);
         }];
     }
@@ -699,8 +1173,8 @@ int maxPinAttempts = 3;
             completion(error);
             return;
         }
-        maxPinAttempts = pinAttempts;
-        currentPinAttempts = pinAttempts;
+        [self setRetriesTotal:pinAttempts remaining:pinAttempts forReference:YKFPIVP2Pin];
+        [self setRetriesTotal:pukAttempts remaining:pukAttempts forReference:YKFPIVP2Puk];
         completion(nil);
     }];
 }
@@ -753,18 +1227,14 @@ int maxPinAttempts = 3;
     NSMutableData *data = [self paddedDataWithPin:valueOne].mutableCopy;
     [data appendData:[self paddedDataWithPin:valueTwo]];
     YKFAPDU *apdu = [[YKFAPDU alloc] initWithCla:0 ins:ins p1:0 p2:p2 data:data type:YKFAPDUTypeShort];
+    // Unblocking the PIN verifies the PUK, changing a reference verifies the reference itself.
+    UInt8 verifiedReference = ins == YKFPIVInsResetRetry ? YKFPIVP2Puk : p2;
     [self.smartCardInterface executeCommand:apdu completion:^(NSData * _Nullable data, NSError * _Nullable error) {
-        if (error != nil) {
-            int retries = [self getRetriesFromStatusCode:(int)error.code];
-            if (retries >= 0) {
-                if (p2 == 0x80) {
-                    currentPinAttempts = retries;
-                }
-                completion(retries, error);
-            }
-        } else {
-            completion(currentPinAttempts, nil);
+        int retries = [self updateRetriesForReference:verifiedReference error:error];
+        if (error == nil && verifiedReference != p2) {
+            [self didVerifyReference:p2];
         }
+        completion(retries, error);
     }];
 }
 
@@ -0,0 +1,31 @@
+// Copyright 2018-2021 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import "YKFPIVSlotInventory.h"
+
+#ifndef YKFPIVSlotInventory_Private_h
+#define YKFPIVSlotInventory_Private_h
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface YKFPIVSlotInventory()
+
+/// The metadata is nil when it was not read. The certificates are SecCertificateRef objects.
+- (instancetype)initWithMetadata:(nullable NSDictionary<NSNumber *, YKFPIVSlotMetadata *> *)metadata certificates:(NSDictionary<NSNumber *, id> *)certificates NS_DESIGNATED_INITIALIZER;
+
+@end
+
+NS_ASSUME_NONNULL_END
+
+#endif /* YKFPIVSlotInventory_Private_h */
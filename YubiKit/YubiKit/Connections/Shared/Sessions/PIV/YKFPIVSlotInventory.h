@@ -0,0 +1,48 @@
+// Copyright 2018-2021 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef YKFPIVSlotInventory_h
+#define YKFPIVSlotInventory_h
+
+#import "YKFPIVSession.h"
+
+@class YKFPIVSlotMetadata;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// @abstract The keys and certificates stored in the PIV slots of a YubiKey, as returned by
+///           [YKFPIVSession getSlotInventoryWithCompletion:].
+@interface YKFPIVSlotInventory : NSObject
+
+/// @abstract True if the metadata of the keys was read. The YubiKeys below 5.3 don't provide the key metadata,
+///           and metadataForSlot: always returns nil for them.
+@property (nonatomic, readonly) BOOL includesMetadata;
+
+/// @abstract The slots holding a key, when the metadata is available, or a certificate, in ascending order.
+@property (nonatomic, readonly) NSArray<NSNumber *> *occupiedSlots;
+
+/// @abstract Returns the metadata of the key in the slot, or nil if the slot has no key.
+- (nullable YKFPIVSlotMetadata *)metadataForSlot:(YKFPIVSlot)slot;
+
+/// @abstract Returns the certificate stored for the slot, or nil if there is none. The certificate is owned by the
+///           inventory and must be retained to be used after it.
+- (nullable SecCertificateRef)certificateForSlot:(YKFPIVSlot)slot;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@end
+
+NS_ASSUME_NONNULL_END
+
+#endif /* YKFPIVSlotInventory_h */
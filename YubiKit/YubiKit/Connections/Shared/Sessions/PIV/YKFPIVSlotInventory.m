@@ -0,0 +1,53 @@
+// Copyright 2018-2021 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <Foundation/Foundation.h>
+#import "YKFPIVSlotInventory.h"
+#import "YKFPIVSlotInventory+Private.h"
+#import "YKFPIVSlotMetadata.h"
+
+@interface YKFPIVSlotInventory()
+
+@property (nonatomic, readwrite) BOOL includesMetadata;
+@property (nonatomic, readwrite) NSArray<NSNumber *> *occupiedSlots;
+@property (nonatomic) NSDictionary<NSNumber *, YKFPIVSlotMetadata *> *metadata;
+@property (nonatomic) NSDictionary<NSNumber *, id> *certificates;
+
+@end
+
+@implementation YKFPIVSlotInventory
+
+- (instancetype)initWithMetadata:(NSDictionary<NSNumber *, YKFPIVSlotMetadata *> *)metadata certificates:(NSDictionary<NSNumber *, id> *)certificates {
+    self = [super init];
+    if (self) {
+        self.includesMetadata = metadata != nil;
+        self.metadata = metadata ?: @{};
+        self.certificates = certificates;
+        
+        NSMutableSet<NSNumber *> *occupiedSlots = [[NSMutableSet alloc] initWithArray:self.metadata.allKeys];
+        [occupiedSlots addObjectsFromArray:certificates.allKeys];
+        self.occupiedSlots = [occupiedSlots.allObjects sortedArrayUsingSelector:@selector(compare:)];
+    }
+    return self;
+}
+
+- (YKFPIVSlotMetadata *)metadataForSlot:(YKFPIVSlot)slot {
+    return self.metadata[@(slot)];
+}
+
+- (SecCertificateRef)certificateForSlot:(YKFPIVSlot)slot {
+    return (__bridge SecCertificateRef)self.certificates[@(slot)];
+}
+
+@end
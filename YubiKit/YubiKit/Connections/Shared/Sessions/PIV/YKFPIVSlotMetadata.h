@@ -0,0 +1,32 @@
+// Copyright 2018-2021 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef YKFPIVSlotMetadata_h
+#define YKFPIVSlotMetadata_h
+
+#import "YKFPIVSession.h"
+
+/// @abstract Metadata of the key stored in a PIV slot.
+@interface YKFPIVSlotMetadata : NSObject
+
+@property (nonatomic, readonly) YKFPIVKeyType keyType;
+@property (nonatomic, readonly) YKFPIVPinPolicy pinPolicy;
+@property (nonatomic, readonly) YKFPIVTouchPolicy touchPolicy;
+
+/// @abstract True if the key was generated on the YubiKey, false if it was imported.
+@property (nonatomic, readonly) bool generated;
+
+@end
+
+#endif /* YKFPIVSlotMetadata_h */
@@ -34,14 +34,12 @@
 
 #import "YKFSmartCardInterface.h"
 #import "YKFSelectApplicationAPDU.h"
+#import "YKFTouchPollSchedule.h"
 
 typedef void (^YKFU2FServiceResultCompletionBlock)(NSData* _Nullable  result, NSError* _Nullable error);
 
 NSString* const YKFU2FServiceProtocolKeyStatePropertyKey = @"keyState";
 
-static const int YKFU2FMaxRetries = 30; // times
-static const NSTimeInterval YKFU2FRetryTimeInterval = 0.5; // seconds
-
 @interface YKFU2FSession()
 
 @property (nonatomic, assign, readwrite) YKFU2FSessionKeyState keyState;
@@ -85,7 +83,7 @@ static const NSTimeInterval YKFU2FRetryTimeInterval = 0.5; // seconds
 
     YKFU2FRegisterAPDU *apdu = [[YKFU2FRegisterAPDU alloc] initWithChallenge:challenge appId:appId];
     ykf_weak_self();
-    [self executeU2FCommand:apdu retryCount:0 completion:^(NSData *result, NSError *error) {
+    [self executeU2FCommand:apdu completion:^(NSData *result, NSError *error) {
         ykf_safe_strong_self();
         if (error) {
             completion(nil, error);
@@ -110,7 +108,7 @@ static const NSTimeInterval YKFU2FRetryTimeInterval = 0.5; // seconds
     YKFU2FSignAPDU *apdu = [[YKFU2FSignAPDU alloc] initWithChallenge:challenge keyHandle:keyHandle appId:appId];
     
     ykf_weak_self();
-    [self executeU2FCommand:apdu retryCount:0 completion:^(NSData *result, NSError *error) {
+    [self executeU2FCommand:apdu completion:^(NSData *result, NSError *error) {
         ykf_safe_strong_self();
         if (error) {
             completion(nil, error);
@@ -123,7 +121,11 @@ static const NSTimeInterval YKFU2FRetryTimeInterval = 0.5; // seconds
 
 #pragma mark - Request Execution
 
-- (void)executeU2FCommand:(YKFAPDU *)apdu retryCount:(int)retryCount completion:(YKFU2FServiceResultCompletionBlock)completion {
+- (void)executeU2FCommand:(YKFAPDU *)apdu completion:(YKFU2FServiceResultCompletionBlock)completion {
+    [self executeU2FCommand:apdu pollSchedule:nil completion:completion];
+}
+
+- (void)executeU2FCommand:(YKFAPDU *)apdu pollSchedule:(YKFTouchPollSchedule *)pollSchedule completion:(YKFU2FServiceResultCompletionBlock)completion {
     YKFParameterAssertReturn(apdu);
     YKFParameterAssertReturn(completion);
     
@@ -139,7 +141,7 @@ static const NSTimeInterval YKFU2FRetryTimeInterval = 0.5; // seconds
         
         switch (error.code) {
             case YKFAPDUErrorCodeConditionNotSatisfied: {
-                [strongSelf handleTouchRequired:apdu retryCount:retryCount completion:completion];
+                [strongSelf handleTouchRequired:apdu pollSchedule:pollSchedule completion:completion];
             }
             break;
                 
@@ -161,10 +163,13 @@ static const NSTimeInterval YKFU2FRetryTimeInterval = 0.5; // seconds
 
 #pragma mark - Private
 
-- (void)handleTouchRequired:(YKFAPDU *)apdu retryCount:(int)retryCount completion:(YKFU2FServiceResultCompletionBlock)completion {
+- (void)handleTouchRequired:(YKFAPDU *)apdu pollSchedule:(YKFTouchPollSchedule *)pollSchedule completion:(YKFU2FServiceResultCompletionBlock)completion {
     YKFParameterAssertReturn(completion);
     
-    if (retryCount >= YKFU2FMaxRetries) {
+    // The schedule starts when the key asks for touch the first time.
+    pollSchedule = pollSchedule ?: [[YKFTouchPollSchedule alloc] init];
+    
+    if ([pollSchedule isExpiredAtDate:[NSDate date]]) {
         YKFSessionError *timeoutError = [YKFSessionError errorWithCode:YKFSessionErrorTouchTimeoutCode];
         completion(nil, timeoutError);
         
@@ -172,14 +177,13 @@ static const NSTimeInterval YKFU2FRetryTimeInterval = 0.5; // seconds
         return;
     }
     
-    [self updateKeyState:YKFU2FSessionKeyStateTouchKey];    
-    retryCount += 1;
+    [self updateKeyState:YKFU2FSessionKeyStateTouchKey];
     
     ykf_weak_self();
-    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, YKFU2FRetryTimeInterval * NSEC_PER_SEC), dispatch_get_main_queue(), ^{
+    [self.smartCardInterface dispatchAfterCurrentCommands:^{
         ykf_safe_strong_self();
-        [strongSelf executeU2FCommand:apdu retryCount:retryCount completion:completion];
-    });
+        [strongSelf executeU2FCommand:apdu pollSchedule:pollSchedule completion:completion];
+    } delay:[pollSchedule nextInterval]];
 }
 
 #pragma mark - Key responses
@@ -14,8 +14,7 @@
 #import <Foundation/Foundation.h>
 #import "YKFManagementDeviceInfo+Private.h"
 #import "YKFAssert.h"
-#import <CryptoTokenKit/TKTLVRecord.h>
-#import "NSArray+TKTLVRecord.h"
+#import "YKFBERTLV.h"
 #import "YKFNSDataAdditions+Private.h"
 #import "YKFVersion.h"
 #import "YKFManagementInterfaceConfiguration+Private.h"
@@ -33,6 +32,16 @@
 
 @end
 
+// The big endian integer value of the record with the tag, or 0 if there is none.
+static NSUInteger YKFManagementIntegerValue(const YKFBERTLVIndex *records, UInt64 tag) {
+    const YKFBERTLVRecord *record = YKFBERTLVIndexFind(records, tag);
+    NSUInteger value = 0;
+    for (size_t i = 0; record && i < record->length; ++i) {
+        value = (value << 8) + record->value[i];
+    }
+    return value;
+}
+
 @implementation YKFManagementDeviceInfo
 
 - (nullable instancetype)initWithResponseData:(nonnull NSData *)data defaultVersion:(nonnull YKFVersion *)defaultVersion {
@@ -45,20 +54,23 @@
         if (length != data.length - 1) {
             return nil;
         }
-        NSArray<TKTLVRecord*> *records = [TKBERTLVRecord sequenceOfRecordsFromData:[data subdataWithRange:NSMakeRange(1, data.length -  1)]];
+        YKFBERTLVIndex records;
+        if (!YKFBERTLVIndexInit(&records, (const UInt8 *)bytes + 1, data.length - 1)) {
+            return nil;
+        }
         
-        self.isLocked = [[records ykfTLVRecordWithTag:YKFManagementTagConfigLocked].value ykf_integerValue] == 1;
+        self.isLocked = YKFManagementIntegerValue(&records, YKFManagementTagConfigLocked) == 1;
         
-        self.serialNumber = [[records ykfTLVRecordWithTag:YKFManagementTagSerialNumber].value ykf_integerValue];
+        self.serialNumber = YKFManagementIntegerValue(&records, YKFManagementTagSerialNumber);
         
-        NSData *versionData = [records ykfTLVRecordWithTag:YKFManagementTagFirmwareVersion].value;
+        NSData *versionData = [data ykf_valueOfBERTLVRecord:YKFBERTLVIndexFind(&records, YKFManagementTagFirmwareVersion)];
         if (versionData != nil) {
             self.version = [[YKFVersion alloc] initWithData:versionData];
         } else {
             self.version = defaultVersion;
         }
         
-        NSUInteger reportedFormFactor = [[records ykfTLVRecordWithTag:YKFManagementTagFormfactor].value ykf_integerValue];
+        NSUInteger reportedFormFactor = YKFManagementIntegerValue(&records, YKFManagementTagFormfactor);
         switch (reportedFormFactor & 0xf) {
             case YKFFormFactorUSBAKeychain:
                 self.formFactor = YKFFormFactorUSBAKeychain;
@@ -73,10 +85,10 @@
                 self.formFactor = YKFFormFactorUnknown;
         }
         
-        self.usbSupportedMask = [[records ykfTLVRecordWithTag:YKFManagementTagUSBSupported].value ykf_integerValue];
-        self.usbEnabledMask = [[records ykfTLVRecordWithTag:YKFManagementTagUSBEnabled].value ykf_integerValue];
-        self.nfcSupportedMask = [[records ykfTLVRecordWithTag:YKFManagementTagNFCSupported].value ykf_integerValue];
-        self.nfcEnabledMask = [[records ykfTLVRecordWithTag:YKFManagementTagNFCEnabled].value ykf_integerValue];
+        self.usbSupportedMask = YKFManagementIntegerValue(&records, YKFManagementTagUSBSupported);
+        self.usbEnabledMask = YKFManagementIntegerValue(&records, YKFManagementTagUSBEnabled);
+        self.nfcSupportedMask = YKFManagementIntegerValue(&records, YKFManagementTagNFCSupported);
+        self.nfcEnabledMask = YKFManagementIntegerValue(&records, YKFManagementTagNFCEnabled);
         
         self.configuration = [[YKFManagementInterfaceConfiguration alloc] initWithDeviceInfo:self];
     }
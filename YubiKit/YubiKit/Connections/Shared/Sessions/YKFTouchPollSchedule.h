@@ -0,0 +1,65 @@
+// Copyright 2018-2021 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef YKFTouchPollSchedule_h
+#define YKFTouchPollSchedule_h
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*!
+ The delays between the polls of a request which waits for the user to touch the key.
+
+ The user usually touches the key shortly after the prompt, so the first polls are close to each other and the
+ interval grows up to the maximum interval, until the timeout. The timeout is measured from the creation of the
+ schedule, which happens when the key asks for touch the first time.
+
+ @note
+    A schedule belongs to a single request and is not thread safe.
+ */
+@interface YKFTouchPollSchedule: NSObject
+
+/*!
+ A schedule with an initial interval of 0.1 seconds, a maximum interval of 0.5 seconds and a timeout of 15 seconds.
+ */
+- (instancetype)init;
+
+- (instancetype)initWithInitialInterval:(NSTimeInterval)initialInterval maximumInterval:(NSTimeInterval)maximumInterval
+                                timeout:(NSTimeInterval)timeout NS_DESIGNATED_INITIALIZER;
+
+@property (nonatomic, readonly) NSTimeInterval initialInterval;
+@property (nonatomic, readonly) NSTimeInterval maximumInterval;
+@property (nonatomic, readonly) NSTimeInterval timeout;
+
+/*!
+ The number of intervals returned by nextInterval.
+ */
+@property (nonatomic, readonly) NSUInteger pollCount;
+
+/*!
+ YES when the timeout is over at the date and the request should fail instead of polling again.
+ */
+- (BOOL)isExpiredAtDate:(NSDate *)date;
+
+/*!
+ The delay before the next poll.
+ */
+- (NSTimeInterval)nextInterval;
+
+@end
+
+NS_ASSUME_NONNULL_END
+
+#endif /* YKFTouchPollSchedule_h */
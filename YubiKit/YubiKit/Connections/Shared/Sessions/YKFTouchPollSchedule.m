@@ -0,0 +1,62 @@
+// Copyright 2018-2021 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import "YKFTouchPollSchedule.h"
+
+static const NSTimeInterval YKFTouchPollScheduleDefaultInitialInterval = 0.1; // seconds
+static const NSTimeInterval YKFTouchPollScheduleDefaultMaximumInterval = 0.5; // seconds
+static const NSTimeInterval YKFTouchPollScheduleDefaultTimeout = 15; // seconds, 30 polls at the maximum interval
+static const double YKFTouchPollScheduleIntervalGrowth = 1.5;
+
+@interface YKFTouchPollSchedule()
+
+@property (nonatomic, readwrite) NSUInteger pollCount;
+@property (nonatomic) NSDate *startDate;
+@property (nonatomic) NSTimeInterval interval;
+
+@end
+
+@implementation YKFTouchPollSchedule
+
+- (instancetype)init {
+    return [self initWithInitialInterval:YKFTouchPollScheduleDefaultInitialInterval
+                         maximumInterval:YKFTouchPollScheduleDefaultMaximumInterval
+                                 timeout:YKFTouchPollScheduleDefaultTimeout];
+}
+
+- (instancetype)initWithInitialInterval:(NSTimeInterval)initialInterval maximumInterval:(NSTimeInterval)maximumInterval
+                                timeout:(NSTimeInterval)timeout {
+    self = [super init];
+    if (self) {
+        _initialInterval = initialInterval;
+        _maximumInterval = MAX(initialInterval, maximumInterval);
+        _timeout = timeout;
+        self.interval = initialInterval;
+        self.startDate = [NSDate date];
+    }
+    return self;
+}
+
+- (BOOL)isExpiredAtDate:(NSDate *)date {
+    return [date timeIntervalSinceDate:self.startDate] >= self.timeout;
+}
+
+- (NSTimeInterval)nextInterval {
+    NSTimeInterval interval = self.interval;
+    self.interval = MIN(interval * YKFTouchPollScheduleIntervalGrowth, self.maximumInterval);
+    ++self.pollCount;
+    return interval;
+}
+
+@end
@@ -19,14 +19,40 @@ NS_ASSUME_NONNULL_BEGIN
 typedef void (^YKFConnectionControllerCommandResponseBlock)(NSData* _Nullable, NSError* _Nullable, NSTimeInterval);
 typedef void (^YKFConnectionControllerCompletionBlock)(void);
 typedef void (^YKFConnectionControllerCommunicationQueueBlock)(NSOperation *operation);
+typedef YKFAPDU* _Nullable (^YKFConnectionControllerCommandSequenceBlock)(NSData* _Nullable, NSError* _Nullable, NSTimeInterval);
 
 @protocol YKFConnectionControllerProtocol
 
+/*
+ The largest command APDU, in bytes, which the transport delivers to the key in a single frame. Transports
+ which don't deliver extended length APDUs report the size of a short APDU (261 bytes).
+ */
+@property (nonatomic, readonly) NSUInteger maxFrameSize;
+
+/*
+ The response passed to the completion block may be a no-copy view over a buffer owned by the connection
+ controller, which is reused for the next command. The response is valid until the completion block returns,
+ consumers which need it longer must copy it.
+ */
 - (void)execute:(YKFAPDU *)command completion:(YKFConnectionControllerCommandResponseBlock)completion;
 - (void)execute:(YKFAPDU *)command timeout:(NSTimeInterval)timeout completion:(YKFConnectionControllerCommandResponseBlock)completion;
 
+/*
+ Executes a sequence of commands in a single operation on the communication queue, without interleaving other
+ commands. The block receives the response of each command and returns the next command to send, or nil to
+ end the sequence. The response follows the same lifetime rules as for a single command.
+ */
+- (void)executeSequence:(YKFAPDU *)command timeout:(NSTimeInterval)timeout next:(YKFConnectionControllerCommandSequenceBlock)next;
+
 - (void)dispatchBlockOnCommunicationQueue:(YKFConnectionControllerCommunicationQueueBlock)block;
 
+/*
+ Dispatches the block on the communication queue after the delay. The delay is measured by a timer source on the
+ communication queue, so it doesn't depend on the load of the main queue. The blocks which are still waiting for
+ their delay are canceled by cancelAllCommands.
+ */
+- (void)dispatchBlockOnCommunicationQueue:(YKFConnectionControllerCommunicationQueueBlock)block delay:(NSTimeInterval)delay;
+
 - (void)closeConnectionWithCompletion:(YKFConnectionControllerCompletionBlock)completion;
 - (void)cancelAllCommands;
 
@@ -26,6 +26,9 @@ typedef void (^YKFSmartCardInterfaceResponseBlock)
 
 typedef void (^YKFSmartCardInterfaceCommandBlock)(void);
 
+typedef void (^YKFSmartCardInterfaceFirstFrameResponseBlock)
+    (NSData* _Nullable data, BOOL hasMoreData, NSError* _Nullable error);
+
 typedef NS_ENUM(NSUInteger, YKFSmartCardInterfaceSendRemainingIns) {
     
     /// The APDU instruction to read the remaining data from the Yubikey.
@@ -35,6 +38,44 @@ typedef NS_ENUM(NSUInteger, YKFSmartCardInterfaceSendRemainingIns) {
     YKFSmartCardInterfaceSendRemainingInsOATH,
 };
 
+typedef NS_ENUM(NSUInteger, YKFSmartCardInterfaceErrorPolicy) {
+    
+    /// Stops executing the batch after the first command which fails.
+    YKFSmartCardInterfaceErrorPolicyStop,
+    
+    /// Executes all the commands of the batch, regardless of the status code errors. A connection error (e.g. a
+    /// timeout) still stops the batch and is reported as the result of the commands which were not sent.
+    YKFSmartCardInterfaceErrorPolicyContinue,
+};
+
+/// The result of a command executed in a batch.
+@interface YKFSmartCardInterfaceCommandResult: NSObject
+
+/// The response data, without the status code. nil if the command failed.
+@property (nonatomic, readonly, nullable) NSData *data;
+
+/// The error returned by the command. nil if the command succeeded.
+@property (nonatomic, readonly, nullable) NSError *error;
+
+- (nonnull instancetype)init NS_UNAVAILABLE;
+
+@end
+
+/*
+ The results contain one entry for each executed command, in order. When the batch stops on error, the
+ failed command is the last one. With YKFSmartCardInterfaceErrorPolicyContinue there is always one entry for
+ each command of the batch. The error is the first error returned by a command, if any.
+ */
+typedef void (^YKFSmartCardInterfaceBatchResponseBlock)
+    (NSArray<YKFSmartCardInterfaceCommandResult *> * _Nonnull results, NSError* _Nullable error);
+
+/*
+ Called on the communication queue after each command of a batch is completed, before the next one is sent.
+ The block should return quickly because it delays the next command.
+ */
+typedef void (^YKFSmartCardInterfaceBatchProgressBlock)
+    (NSUInteger completedCount, NSUInteger totalCount);
+
 @interface YKFSmartCardInterface: NSObject
 
 NS_ASSUME_NONNULL_BEGIN
@@ -45,6 +86,10 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (void)selectApplication:(YKFSelectApplicationAPDU *)apdu completion:(YKFSmartCardInterfaceResponseBlock)completion;
 
+/*
+ Executes the command and requests the remaining data from the key, if any. Commands which don't fit in the largest
+ frame delivered by the connection are split with ISO 7816 command chaining.
+ */
 - (void)executeCommand:(YKFAPDU *)apdu completion:(YKFSmartCardInterfaceResponseBlock)completion;
 
 - (void)executeCommand:(YKFAPDU *)apdu timeout:(NSTimeInterval)timeout completion:(YKFSmartCardInterfaceResponseBlock)completion;
@@ -53,8 +98,37 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (void)executeCommand:(YKFAPDU *)apdu sendRemainingIns:(YKFSmartCardInterfaceSendRemainingIns)sendRemainingIns timeout:(NSTimeInterval)timeout completion:(YKFSmartCardInterfaceResponseBlock)completion;
 
+/*
+ Executes the commands in a single operation on the communication queue. The next command is sent as soon as
+ the previous response is received, without queueing a new operation, and no other command is interleaved with
+ the batch. The remaining data of each command is requested before moving to the next one.
+ */
+- (void)executeCommands:(NSArray<YKFAPDU *> *)apdus completion:(YKFSmartCardInterfaceBatchResponseBlock)completion;
+
+- (void)executeCommands:(NSArray<YKFAPDU *> *)apdus sendRemainingIns:(YKFSmartCardInterfaceSendRemainingIns)sendRemainingIns completion:(YKFSmartCardInterfaceBatchResponseBlock)completion;
+
+- (void)executeCommands:(NSArray<YKFAPDU *> *)apdus sendRemainingIns:(YKFSmartCardInterfaceSendRemainingIns)sendRemainingIns errorPolicy:(YKFSmartCardInterfaceErrorPolicy)errorPolicy timeout:(NSTimeInterval)timeout completion:(YKFSmartCardInterfaceBatchResponseBlock)completion;
+
+/*
+ The timeout applies to each frame sent to the key, so long batches don't need a longer timeout.
+ */
+- (void)executeCommands:(NSArray<YKFAPDU *> *)apdus sendRemainingIns:(YKFSmartCardInterfaceSendRemainingIns)sendRemainingIns errorPolicy:(YKFSmartCardInterfaceErrorPolicy)errorPolicy timeout:(NSTimeInterval)timeout progress:(nullable YKFSmartCardInterfaceBatchProgressBlock)progress completion:(YKFSmartCardInterfaceBatchResponseBlock)completion;
+
+/*
+ Executes the command and returns the data of the first response frame only. When the key has more data to send,
+ hasMoreData is YES and the remaining data is discarded by the next command. This allows to peek at the beginning
+ of a long response, e.g. to check the header of a large data object, without transferring all of it.
+ */
+- (void)executeCommand:(YKFAPDU *)apdu firstFrameCompletion:(YKFSmartCardInterfaceFirstFrameResponseBlock)completion;
+
 - (void)dispatchAfterCurrentCommands:(YKFSmartCardInterfaceCommandBlock)block;
 
+/*
+ Dispatches the block on the communication queue after the delay, e.g. to poll the key while it waits for touch.
+ The block is not called if the commands are canceled before the delay is over.
+ */
+- (void)dispatchAfterCurrentCommands:(YKFSmartCardInterfaceCommandBlock)block delay:(NSTimeInterval)delay;
+
 NS_ASSUME_NONNULL_END
 
 @end
@@ -38,11 +38,130 @@
 
 static NSTimeInterval const YKFSmartCardInterfaceDefaultTimeout = 10.0;
 
+#pragma mark - YKFSmartCardInterfaceCommandResult
+
+@interface YKFSmartCardInterfaceCommandResult()
+
+@property (nonatomic, readwrite) NSData *data;
+@property (nonatomic, readwrite) NSError *error;
+
+- (instancetype)initWithData:(NSData *)data error:(NSError *)error NS_DESIGNATED_INITIALIZER;
+
+@end
+
+@implementation YKFSmartCardInterfaceCommandResult
+
+- (instancetype)initWithData:(NSData *)data error:(NSError *)error {
+    self = [super init];
+    if (self) {
+        self.data = data;
+        self.error = error;
+    }
+    return self;
+}
+
+@end
+
+#pragma mark - YKFSmartCardCommandChain
+
+static NSUInteger const YKFSmartCardInterfaceShortFrameSize = 261; // bytes, header, Lc, 255 bytes of data and Le
+static NSUInteger const YKFSmartCardInterfaceShortHeaderSize = 5;  // bytes, header and Lc
+static NSUInteger const YKFSmartCardInterfaceExtendedHeaderSize = 7; // bytes, header and extended Lc
+static UInt8 const YKFSmartCardInterfaceChainingCla = 0x10;
+
+/*
+ Splits a command into the frames sent to the key, based on the largest frame the transport delivers:
+  - The command is sent as is when it fits in a frame.
+  - Short transports receive short APDUs chained with ISO 7816 command chaining (CLA bit 0x10).
+  - Extended transports receive chained extended APDUs, with a short APDU for the last chunk when it fits.
+ The frames are created on demand from views over the command data.
+ */
+@interface YKFSmartCardCommandChain: NSObject
+
+@property (nonatomic, readonly) YKFAPDU *command;
+@property (nonatomic, readonly) NSUInteger framesCount;
+
+- (instancetype)initWithCommand:(YKFAPDU *)command maxFrameSize:(NSUInteger)maxFrameSize NS_DESIGNATED_INITIALIZER;
+- (instancetype)init NS_UNAVAILABLE;
+
+/// Returns the next frame to send, or nil when all the frames were sent.
+- (YKFAPDU *)nextFrame;
+
+/// YES when the last returned frame is the last one of the command.
+- (BOOL)isComplete;
+
+@end
+
+@interface YKFSmartCardCommandChain()
+
+@property (nonatomic, readwrite) YKFAPDU *command;
+@property (nonatomic, readwrite) NSUInteger framesCount;
+@property (nonatomic) NSData *commandData;
+@property (nonatomic, assign) NSUInteger chunkLength;
+@property (nonatomic, assign) NSUInteger offset;
+@property (nonatomic, assign) NSUInteger sentFramesCount;
+
+@end
+
+@implementation YKFSmartCardCommandChain
+
+- (instancetype)initWithCommand:(YKFAPDU *)command maxFrameSize:(NSUInteger)maxFrameSize {
+    self = [super init];
+    if (self) {
+        self.command = command;
+        self.commandData = command.commandData;
+        
+        NSUInteger dataLength = self.commandData.length;
+        if (!self.commandData || command.ylpApduData.length - 1 <= maxFrameSize) {
+            self.framesCount = 1;
+        } else if (maxFrameSize <= YKFSmartCardInterfaceShortFrameSize) {
+            self.chunkLength = MIN(UINT8_MAX, maxFrameSize - YKFSmartCardInterfaceShortHeaderSize);
+            self.framesCount = (dataLength + self.chunkLength - 1) / self.chunkLength;
+        } else {
+            self.chunkLength = MIN(UINT16_MAX, maxFrameSize - YKFSmartCardInterfaceExtendedHeaderSize);
+            self.framesCount = (dataLength + self.chunkLength - 1) / self.chunkLength;
+        }
+    }
+    return self;
+}
+
+- (YKFAPDU *)nextFrame {
+    if (self.sentFramesCount == self.framesCount) {
+        return nil;
+    }
+    ++self.sentFramesCount;
+    if (self.framesCount == 1) {
+        return self.command;
+    }
+    
+    NSData *commandData = self.commandData;
+    NSUInteger length = MIN(self.chunkLength, commandData.length - self.offset);
+    NSData *chunk = [NSData dataWithBytesNoCopy:(UInt8 *)commandData.bytes + self.offset length:length freeWhenDone:NO];
+    self.offset += length;
+    
+    UInt8 cla = self.command.cla;
+    if (!self.isComplete) {
+        cla |= YKFSmartCardInterfaceChainingCla;
+    }
+    YKFAPDUType type = length <= UINT8_MAX ? YKFAPDUTypeShort : YKFAPDUTypeExtended;
+    
+    // The frame copies the chunk, the view over the command data is not retained.
+    return [[YKFAPDU alloc] initWithCla:cla ins:self.command.ins p1:self.command.p1 p2:self.command.p2 data:chunk type:type];
+}
+
+- (BOOL)isComplete {
+    return self.sentFramesCount == self.framesCount;
+}
+
+@end
+
+#pragma mark - YKFSmartCardInterface
+
 @interface YKFSmartCardInterface()
 
 @property (nonatomic, readwrite) id<YKFConnectionControllerProtocol> connectionController;
 
-- (NSData *)dataFromKeyResponse:(NSData *)response;
+- (NSMutableData *)appendDataFromKeyResponse:(NSData *)response toData:(NSMutableData *)data length:(NSUInteger *)length reservingLength:(NSUInteger)reservedLength;
 - (UInt16)statusCodeFromKeyResponse:(NSData *)response;
 
 @end
@@ -58,61 +177,7 @@ static NSTimeInterval const YKFSmartCardInterfaceDefaultTimeout = 10.0;
 }
 
 - (void)selectApplication:(YKFSelectApplicationAPDU *)apdu completion:(YKFSmartCardInterfaceResponseBlock)completion {
-    [self.connectionController execute:apdu completion:^(NSData *response, NSError *error, NSTimeInterval executionTime) {
-        if (error) {
-            completion(nil, error);
-            return;
-        }
-        UInt16 statusCode = [self statusCodeFromKeyResponse:response];
-        NSData *data = [self dataFromKeyResponse:response];
-        if (statusCode == YKFAPDUErrorCodeNoError) {
-            completion(data, nil);
-        } else if (statusCode == YKFAPDUErrorCodeMissingFile || statusCode == YKFAPDUErrorCodeInsNotSupported) {
-            NSError *error = [YKFSessionError errorWithCode:YKFSessionErrorMissingApplicationCode];
-            completion(nil, error);
-        } else {
-            NSAssert(TRUE, @"The key returned an unexpected SW when selecting application");
-            NSError *error = [YKFSessionError errorWithCode:YKFSessionErrorUnexpectedStatusCode];
-            completion(nil, error);
-        }
-    }];
-}
-
-- (void)executeCommand:(YKFAPDU *)apdu sendRemainingIns:(YKFSmartCardInterfaceSendRemainingIns)sendRemainingIns  timeout:(NSTimeInterval)timeout data:(NSMutableData *)data completion:(YKFSmartCardInterfaceResponseBlock)completion {
-    [self.connectionController execute:apdu
-                         timeout:timeout
-                            completion:^(NSData *response, NSError *error, NSTimeInterval executionTime) {
-        if (error) {
-            completion(nil, error);
-            return;
-        }
-
-        [data appendData:[self dataFromKeyResponse:response]];
-        UInt16 statusCode = [self statusCodeFromKeyResponse:response];
-        
-        if (statusCode >> 8 == YKFAPDUErrorCodeMoreData) {
-            YKFLogInfo(@"Key has more data to send. Requesting for remaining data...");
-            UInt16 ins;
-            switch (sendRemainingIns) {
-                case YKFSmartCardInterfaceSendRemainingInsNormal:
-                    ins = 0xC0;
-                    break;
-                case YKFSmartCardInterfaceSendRemainingInsOATH:
-                    ins = 0xA5;
-                    break;
-            }
-            YKFAPDU *sendRemainingApdu = [[YKFAPDU alloc] initWithData:[NSData dataWithBytes:(unsigned char[]){0x00, ins, 0x00, 0x00} length:4]];
-            // Queue a new request recursively
-            [self executeCommand:sendRemainingApdu sendRemainingIns:sendRemainingIns timeout:timeout data:data completion:completion];
-            return;
-        } else if (statusCode == 0x9000) {
-            completion(data, nil);
-            return;
-        } else {
-            YKFSessionError *error = [YKFSessionError errorWithCode:statusCode];
-            completion(nil, error);
-        }
-    }];
+    [self executeCommand:apdu completion:completion];
 }
 
 - (void)executeCommand:(YKFAPDU *)apdu completion:(YKFSmartCardInterfaceResponseBlock)completion {
@@ -130,8 +195,130 @@ static NSTimeInterval const YKFSmartCardInterfaceDefaultTimeout = 10.0;
 - (void)executeCommand:(YKFAPDU *)apdu sendRemainingIns:(YKFSmartCardInterfaceSendRemainingIns)sendRemainingIns timeout:(NSTimeInterval)timeout completion:(YKFSmartCardInterfaceResponseBlock)completion {
     YKFParameterAssertReturn(apdu);
     YKFParameterAssertReturn(completion);
-    NSMutableData *data = [NSMutableData new];
-    [self executeCommand:apdu sendRemainingIns:sendRemainingIns timeout:timeout data:data completion:completion];
+    
+    [self executeCommands:@[apdu] sendRemainingIns:sendRemainingIns errorPolicy:YKFSmartCardInterfaceErrorPolicyStop timeout:timeout completion:^(NSArray<YKFSmartCardInterfaceCommandResult *> *results, NSError *error) {
+        completion(results.firstObject.data, error);
+    }];
+}
+
+- (void)executeCommands:(NSArray<YKFAPDU *> *)apdus completion:(YKFSmartCardInterfaceBatchResponseBlock)completion {
+    [self executeCommands:apdus sendRemainingIns:YKFSmartCardInterfaceSendRemainingInsNormal errorPolicy:YKFSmartCardInterfaceErrorPolicyStop timeout:YKFSmartCardInterfaceDefaultTimeout completion:completion];
+}
+
+- (void)executeCommands:(NSArray<YKFAPDU *> *)apdus sendRemainingIns:(YKFSmartCardInterfaceSendRemainingIns)sendRemainingIns completion:(YKFSmartCardInterfaceBatchResponseBlock)completion {
+    [self executeCommands:apdus sendRemainingIns:sendRemainingIns errorPolicy:YKFSmartCardInterfaceErrorPolicyStop timeout:YKFSmartCardInterfaceDefaultTimeout completion:completion];
+}
+
+- (void)executeCommands:(NSArray<YKFAPDU *> *)apdus sendRemainingIns:(YKFSmartCardInterfaceSendRemainingIns)sendRemainingIns errorPolicy:(YKFSmartCardInterfaceErrorPolicy)errorPolicy timeout:(NSTimeInterval)timeout completion:(YKFSmartCardInterfaceBatchResponseBlock)completion {
+    [self executeCommands:apdus sendRemainingIns:sendRemainingIns errorPolicy:errorPolicy timeout:timeout progress:nil completion:completion];
+}
+
+- (void)executeCommands:(NSArray<YKFAPDU *> *)apdus sendRemainingIns:(YKFSmartCardInterfaceSendRemainingIns)sendRemainingIns errorPolicy:(YKFSmartCardInterfaceErrorPolicy)errorPolicy timeout:(NSTimeInterval)timeout progress:(YKFSmartCardInterfaceBatchProgressBlock)progress completion:(YKFSmartCardInterfaceBatchResponseBlock)completion {
+    YKFParameterAssertReturn(apdus);
+    YKFParameterAssertReturn(completion);
+    
+    if (!apdus.count) {
+        completion(@[], nil);
+        return;
+    }
+    
+    NSMutableArray<YKFSmartCardInterfaceCommandResult *> *results = [[NSMutableArray alloc] initWithCapacity:apdus.count];
+    NSUInteger maxFrameSize = self.connectionController.maxFrameSize;
+    __block NSUInteger commandIndex = 0;
+    __block YKFSmartCardCommandChain *chain = [[YKFSmartCardCommandChain alloc] initWithCommand:apdus.firstObject maxFrameSize:maxFrameSize];
+    __block NSMutableData *data = nil;
+    __block NSUInteger dataLength = 0;
+    __block NSError *firstError = nil;
+    
+    if (chain.framesCount > 1) {
+        YKFLogVerbose(@"Sending the command in %lu chained frames.", (unsigned long)chain.framesCount);
+    }
+    
+    [self.connectionController executeSequence:[chain nextFrame] timeout:timeout next:^YKFAPDU *(NSData *response, NSError *error, NSTimeInterval executionTime) {
+        // The connection errors (e.g. timeouts) end the batch regardless of the policy, the key state is unknown.
+        BOOL connectionError = error != nil;
+        if (!error) {
+            UInt16 statusCode = [self statusCodeFromKeyResponse:response];
+            
+            if (!chain.isComplete) {
+                // The key acknowledges each chained frame before receiving the next one.
+                if (statusCode == YKFAPDUErrorCodeNoError) {
+                    return [chain nextFrame];
+                }
+                error = [self errorForStatusCode:statusCode command:chain.command];
+            } else {
+                BOOL hasMoreData = statusCode >> 8 == YKFAPDUErrorCodeMoreData;
+                
+                // SW2 hints the length of the remaining data, 0 when it's 256 bytes or more.
+                NSUInteger remainingLength = hasMoreData ? ((statusCode & 0xFF) ?: 256) : 0;
+                data = [self appendDataFromKeyResponse:response toData:data length:&dataLength reservingLength:remainingLength];
+                
+                if (hasMoreData) {
+                    YKFLogVerbose(@"Key has more data to send. Requesting for remaining data...");
+                    return [self sendRemainingAPDUWithIns:sendRemainingIns];
+                }
+                error = [self errorForStatusCode:statusCode command:chain.command];
+            }
+        }
+        
+        if (error) {
+            firstError = firstError ?: error;
+            [results addObject:[[YKFSmartCardInterfaceCommandResult alloc] initWithData:nil error:error]];
+        } else {
+            data.length = dataLength;
+            [results addObject:[[YKFSmartCardInterfaceCommandResult alloc] initWithData:data ?: [NSData data] error:nil]];
+        }
+        data = nil;
+        dataLength = 0;
+        ++commandIndex;
+        
+        if (progress) {
+            progress(commandIndex, apdus.count);
+        }
+        
+        if (connectionError && errorPolicy == YKFSmartCardInterfaceErrorPolicyContinue) {
+            // The commands which were not sent fail with the same error, the results keep one entry per command.
+            for (; commandIndex < apdus.count; ++commandIndex) {
+                [results addObject:[[YKFSmartCardInterfaceCommandResult alloc] initWithData:nil error:error]];
+            }
+        }
+        
+        BOOL stop = connectionError || (error && errorPolicy == YKFSmartCardInterfaceErrorPolicyStop);
+        if (stop || commandIndex == apdus.count) {
+            completion(results, firstError);
+            return nil;
+        }
+        chain = [[YKFSmartCardCommandChain alloc] initWithCommand:apdus[commandIndex] maxFrameSize:maxFrameSize];
+        return [chain nextFrame];
+    }];
+}
+
+- (void)executeCommand:(YKFAPDU *)apdu firstFrameCompletion:(YKFSmartCardInterfaceFirstFrameResponseBlock)completion {
+    YKFParameterAssertReturn(apdu);
+    YKFParameterAssertReturn(completion);
+    
+    NSUInteger maxFrameSize = self.connectionController.maxFrameSize;
+    YKFSmartCardCommandChain *chain = [[YKFSmartCardCommandChain alloc] initWithCommand:apdu maxFrameSize:maxFrameSize];
+    
+    [self.connectionController executeSequence:[chain nextFrame] timeout:YKFSmartCardInterfaceDefaultTimeout next:^YKFAPDU *(NSData *response, NSError *error, NSTimeInterval executionTime) {
+        if (error) {
+            completion(nil, NO, error);
+            return nil;
+        }
+        UInt16 statusCode = [self statusCodeFromKeyResponse:response];
+        if (!chain.isComplete && statusCode == YKFAPDUErrorCodeNoError) {
+            return [chain nextFrame];
+        }
+        BOOL hasMoreData = chain.isComplete && statusCode >> 8 == YKFAPDUErrorCodeMoreData;
+        if (!hasMoreData && statusCode != YKFAPDUErrorCodeNoError) {
+            completion(nil, NO, [self errorForStatusCode:statusCode command:apdu]);
+            return nil;
+        }
+        NSUInteger length = 0;
+        NSMutableData *data = [self appendDataFromKeyResponse:response toData:nil length:&length reservingLength:0];
+        completion(data ?: [NSData data], hasMoreData, nil);
+        return nil;
+    }];
 }
 
 - (void)dispatchAfterCurrentCommands:(YKFSmartCardInterfaceCommandBlock)block {
@@ -144,18 +331,69 @@ static NSTimeInterval const YKFSmartCardInterfaceDefaultTimeout = 10.0;
     }];
 }
 
+- (void)dispatchAfterCurrentCommands:(YKFSmartCardInterfaceCommandBlock)block delay:(NSTimeInterval)delay {
+    [self.connectionController dispatchBlockOnCommunicationQueue:^(NSOperation *operation) {
+        if (operation.isCancelled) {
+            return;
+        }
+        block();
+    } delay:delay];
+}
+
 #pragma mark - Helpers
 
-- (NSData *)dataFromKeyResponse:(NSData *)response {
-    YKFParameterAssertReturnValue(response, [NSData data]);
-    YKFAssertReturnValue(response.length >= 2, @"Key response data is too short.", [NSData data]);
+- (YKFAPDU *)sendRemainingAPDUWithIns:(YKFSmartCardInterfaceSendRemainingIns)sendRemainingIns {
+    // The APDUs are immutable and sent for every chunk of a long response, they are built once.
+    static YKFAPDU *getResponseAPDU = nil;
+    static YKFAPDU *sendRemainingAPDU = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        getResponseAPDU = [[YKFAPDU alloc] initWithData:[NSData dataWithBytes:(unsigned char[]){0x00, 0xC0, 0x00, 0x00} length:4]];
+        sendRemainingAPDU = [[YKFAPDU alloc] initWithData:[NSData dataWithBytes:(unsigned char[]){0x00, 0xA5, 0x00, 0x00} length:4]];
+    });
+    
+    switch (sendRemainingIns) {
+        case YKFSmartCardInterfaceSendRemainingInsNormal:
+            return getResponseAPDU;
+        case YKFSmartCardInterfaceSendRemainingInsOATH:
+            return sendRemainingAPDU;
+    }
+}
+
+- (NSError *)errorForStatusCode:(UInt16)statusCode command:(YKFAPDU *)apdu {
+    if (statusCode == YKFAPDUErrorCodeNoError) {
+        return nil;
+    }
+    if ([apdu isKindOfClass:[YKFSelectApplicationAPDU class]]) {
+        if (statusCode == YKFAPDUErrorCodeMissingFile || statusCode == YKFAPDUErrorCodeInsNotSupported) {
+            return [YKFSessionError errorWithCode:YKFSessionErrorMissingApplicationCode];
+        }
+        return [YKFSessionError errorWithCode:YKFSessionErrorUnexpectedStatusCode];
+    }
+    return [YKFSessionError errorWithCode:statusCode];
+}
+
+/*
+ Copies the response data, without the status code, after the first length bytes of data. The buffer grows to
+ fit the reserved length as well, so that the announced remaining data is appended without reallocating. The
+ buffer length is the capacity in use, the caller trims it to the data length once the response is complete.
+ */
+- (NSMutableData *)appendDataFromKeyResponse:(NSData *)response toData:(NSMutableData *)data length:(NSUInteger *)length reservingLength:(NSUInteger)reservedLength {
+    YKFParameterAssertReturnValue(response, data);
+    YKFAssertReturnValue(response.length >= 2, @"Key response data is too short.", data);
     
-    if (response.length == 2) {
-        return [NSData data];
-    } else {
-        NSRange range = {0, response.length - 2};
-        return [response subdataWithRange:range];
+    // The response may be a view over the connection controller buffer, the bytes are copied explicitly.
+    NSUInteger responseDataLength = response.length - 2;
+    NSUInteger requiredLength = *length + responseDataLength + reservedLength;
+    if (!data) {
+        data = [[NSMutableData alloc] initWithLength:requiredLength];
+    } else if (data.length < requiredLength) {
+        data.length = MAX(requiredLength, data.length * 2);
     }
+    
+    memcpy((UInt8 *)data.mutableBytes + *length, response.bytes, responseDataLength);
+    *length += responseDataLength;
+    return data;
 }
 
 - (UInt16)statusCodeFromKeyResponse:(NSData *)response {
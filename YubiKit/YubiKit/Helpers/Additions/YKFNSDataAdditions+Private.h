@@ -14,6 +14,7 @@
 
 #import <Foundation/Foundation.h>
 #import <CommonCrypto/CommonCrypto.h>
+#import "YKFBERTLV.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -86,4 +87,24 @@ NS_ASSUME_NONNULL_BEGIN
 
 @end
 
+@interface NSData (NSData_BERTLVAdditions)
+
+/*!
+ @method ykf_valueOfBERTLVRecord:
+ 
+ @return
+    The value of a record read from the bytes of the data object, or nil if the record is NULL.
+ */
+- (nullable NSData *)ykf_valueOfBERTLVRecord:(nullable const YKFBERTLVRecord *)record;
+
+/*!
+ @method ykf_BERTLVValueWithTag:error:
+ 
+ @return
+    The value of the single record contained by the data object, if it has the tag.
+ */
+- (nullable NSData *)ykf_BERTLVValueWithTag:(UInt64)tag error:(NSError **)error;
+
+@end
+
 NS_ASSUME_NONNULL_END
@@ -53,7 +53,9 @@
     UInt8 keyLength = 16; // use only 16 bytes
     UInt8 key[keyLength];
     CCKeyDerivationPBKDF(kCCPBKDF2, self.bytes, self.length, salt.bytes, salt.length, kCCPRFHmacAlgSHA1, 1000, key, keyLength);
-    return [NSData dataWithBytes:key length:keyLength];
+    NSData *keyData = [NSData dataWithBytes:key length:keyLength];
+    memset_s(key, keyLength, 0, keyLength);
+    return keyData;
 }
 
 - (NSData *)ykf_oathHMACWithKey:(NSData *)key {
@@ -386,3 +388,32 @@
 }
 
 @end
+
+#pragma mark - BER-TLV
+
+@implementation NSData (NSData_BERTLVAdditions)
+
+- (NSData *)ykf_valueOfBERTLVRecord:(const YKFBERTLVRecord *)record {
+    if (!record) {
+        return nil;
+    }
+    NSUInteger offset = record->value - (const UInt8 *)self.bytes;
+    NSAssert([self ykf_containsRange:NSMakeRange(offset, record->length)], @"The record was not read from the data.");
+    return [self subdataWithRange:NSMakeRange(offset, record->length)];
+}
+
+- (NSData *)ykf_BERTLVValueWithTag:(UInt64)tag error:(NSError **)error {
+    YKFBERTLVRecord record;
+    if (!YKFBERTLVReadSingleRecord(self.bytes, self.length, &record)) {
+        *error = [[NSError alloc] initWithDomain:@"com.yubico.piv" code:1 userInfo:@{NSLocalizedDescriptionKey: @"Data is not in a valid TLV format."}];
+        return nil;
+    }
+    if (record.tag != tag) {
+        NSString *description = [NSString stringWithFormat:@"TLV record does not contain the tag 0x%02llx.", tag];
+        *error = [[NSError alloc] initWithDomain:@"com.yubico.piv" code:1 userInfo:@{NSLocalizedDescriptionKey: description}];
+        return nil;
+    }
+    return [self ykf_valueOfBERTLVRecord:&record];
+}
+
+@end
@@ -0,0 +1,275 @@
+// Copyright 2018-2021 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "YKFBERTLV.h"
+
+#include <string.h>
+
+// Lengths up to 4 bytes are supported, more than any APDU can carry.
+static const size_t YKFBERTLVMaxLengthBytes = 4;
+static const size_t YKFBERTLVMaxTagBytes = 4;
+
+static size_t YKFBERTLVTagLength(uint64_t tag) {
+    size_t length = 1;
+    while (length < YKFBERTLVMaxTagBytes && tag >> (8 * length)) {
+        ++length;
+    }
+    return length;
+}
+
+static size_t YKFBERTLVLengthLength(size_t length) {
+    if (length < 0x80) {
+        return 1;
+    }
+    size_t count = 1;
+    while (count < YKFBERTLVMaxLengthBytes && (uint64_t)length >> (8 * count)) {
+        ++count;
+    }
+    return 1 + count;
+}
+
+static void YKFBERTLVEncodeLength(uint8_t *bytes, size_t length, size_t lengthLength) {
+    if (lengthLength == 1) {
+        bytes[0] = (uint8_t)length;
+        return;
+    }
+    bytes[0] = (uint8_t)(0x80 | (lengthLength - 1));
+    for (size_t i = lengthLength - 1; i > 0; --i) {
+        bytes[i] = (uint8_t)length;
+        length >>= 8;
+    }
+}
+
+size_t YKFBERTLVEncodedLength(uint64_t tag, size_t length) {
+    return YKFBERTLVTagLength(tag) + YKFBERTLVLengthLength(length) + length;
+}
+
+// Writer
+
+void YKFBERTLVWriterInit(YKFBERTLVWriter *writer, uint8_t *buffer, size_t capacity) {
+    memset(writer, 0, sizeof(YKFBERTLVWriter));
+    writer->buffer = buffer;
+    writer->capacity = buffer ? capacity : 0;
+}
+
+static bool YKFBERTLVWriterReserve(YKFBERTLVWriter *writer, size_t length) {
+    if (writer->failed || writer->capacity - writer->length < length) {
+        writer->failed = true;
+        return false;
+    }
+    return true;
+}
+
+static void YKFBERTLVWriterPutTag(YKFBERTLVWriter *writer, uint64_t tag) {
+    size_t tagLength = YKFBERTLVTagLength(tag);
+    for (size_t i = 0; i < tagLength; ++i) {
+        writer->buffer[writer->length++] = (uint8_t)(tag >> (8 * (tagLength - 1 - i)));
+    }
+}
+
+bool YKFBERTLVWriterAppend(YKFBERTLVWriter *writer, uint64_t tag, const uint8_t *value, size_t length) {
+    if (length > UINT32_MAX || (length && !value)) {
+        writer->failed = true;
+        return false;
+    }
+    size_t lengthLength = YKFBERTLVLengthLength(length);
+    if (!YKFBERTLVWriterReserve(writer, YKFBERTLVEncodedLength(tag, length))) {
+        return false;
+    }
+    YKFBERTLVWriterPutTag(writer, tag);
+    YKFBERTLVEncodeLength(writer->buffer + writer->length, length, lengthLength);
+    writer->length += lengthLength;
+    if (length) {
+        memcpy(writer->buffer + writer->length, value, length);
+        writer->length += length;
+    }
+    return true;
+}
+
+bool YKFBERTLVWriterAppendBytes(YKFBERTLVWriter *writer, const uint8_t *bytes, size_t length) {
+    if (length && !bytes) {
+        writer->failed = true;
+        return false;
+    }
+    if (!YKFBERTLVWriterReserve(writer, length)) {
+        return false;
+    }
+    if (length) {
+        memcpy(writer->buffer + writer->length, bytes, length);
+        writer->length += length;
+    }
+    return true;
+}
+
+bool YKFBERTLVWriterBegin(YKFBERTLVWriter *writer, uint64_t tag) {
+    if (writer->depth == YKF_BER_TLV_MAX_DEPTH) {
+        writer->failed = true;
+        return false;
+    }
+    // One byte is reserved for the length, which is the most common case. Longer lengths move the content on End.
+    if (!YKFBERTLVWriterReserve(writer, YKFBERTLVTagLength(tag) + 1)) {
+        return false;
+    }
+    YKFBERTLVWriterPutTag(writer, tag);
+    writer->openRecords[writer->depth++] = writer->length;
+    writer->buffer[writer->length++] = 0;
+    return true;
+}
+
+bool YKFBERTLVWriterEnd(YKFBERTLVWriter *writer) {
+    if (writer->failed || writer->depth == 0) {
+        writer->failed = true;
+        return false;
+    }
+    size_t lengthOffset = writer->openRecords[--writer->depth];
+    size_t contentOffset = lengthOffset + 1;
+    size_t length = writer->length - contentOffset;
+    size_t lengthLength = YKFBERTLVLengthLength(length);
+    if (lengthLength > 1) {
+        size_t shift = lengthLength - 1;
+        if (!YKFBERTLVWriterReserve(writer, shift)) {
+            return false;
+        }
+        memmove(writer->buffer + contentOffset + shift, writer->buffer + contentOffset, length);
+        writer->length += shift;
+    }
+    YKFBERTLVEncodeLength(writer->buffer + lengthOffset, length, lengthLength);
+    return true;
+}
+
+size_t YKFBERTLVWriterFinish(const YKFBERTLVWriter *writer) {
+    if (writer->failed || writer->depth) {
+        return 0;
+    }
+    return writer->length;
+}
+
+// Reader
+
+void YKFBERTLVReaderInit(YKFBERTLVReader *reader, const uint8_t *bytes, size_t length) {
+    reader->cursor = bytes;
+    reader->end = bytes ? bytes + length : bytes;
+}
+
+bool YKFBERTLVReadHeader(const uint8_t *bytes, size_t length, uint64_t *tag, size_t *valueLength, size_t *headerLength) {
+    const uint8_t *cursor = bytes;
+    const uint8_t *end = bytes + length;
+    if (!bytes || cursor == end) {
+        return false;
+    }
+
+    // Multi-byte tags have the low 5 bits of the first byte set, and the high bit set in all but the last byte.
+    uint64_t readTag = *cursor++;
+    if ((readTag & 0x1F) == 0x1F) {
+        size_t tagLength = 1;
+        uint8_t byte = 0;
+        do {
+            if (cursor == end || tagLength == YKFBERTLVMaxTagBytes) {
+                return false;
+            }
+            byte = *cursor++;
+            readTag = (readTag << 8) | byte;
+            ++tagLength;
+        } while (byte & 0x80);
+    }
+
+    if (cursor == end) {
+        return false;
+    }
+    size_t readLength = *cursor++;
+    if (readLength & 0x80) {
+        size_t lengthBytes = readLength & 0x7F;
+        // The indefinite length form (0x80) is not used by the YubiKey.
+        if (lengthBytes == 0 || lengthBytes > YKFBERTLVMaxLengthBytes || (size_t)(end - cursor) < lengthBytes) {
+            return false;
+        }
+        readLength = 0;
+        for (size_t i = 0; i < lengthBytes; ++i) {
+            readLength = (readLength << 8) | *cursor++;
+        }
+    }
+
+    *tag = readTag;
+    *valueLength = readLength;
+    *headerLength = (size_t)(cursor - bytes);
+    return true;
+}
+
+YKFBERTLVReadResult YKFBERTLVReaderNext(YKFBERTLVReader *reader, YKFBERTLVRecord *record) {
+    if (reader->cursor == reader->end) {
+        return YKFBERTLVReadResultEnd;
+    }
+    size_t available = (size_t)(reader->end - reader->cursor);
+    uint64_t tag = 0;
+    size_t length = 0;
+    size_t headerLength = 0;
+    if (!YKFBERTLVReadHeader(reader->cursor, available, &tag, &length, &headerLength) || available - headerLength < length) {
+        return YKFBERTLVReadResultMalformed;
+    }
+
+    record->tag = tag;
+    record->value = reader->cursor + headerLength;
+    record->length = length;
+    reader->cursor = record->value + length;
+    return YKFBERTLVReadResultRecord;
+}
+
+bool YKFBERTLVReadSingleRecord(const uint8_t *bytes, size_t length, YKFBERTLVRecord *record) {
+    YKFBERTLVReader reader;
+    YKFBERTLVReaderInit(&reader, bytes, length);
+    return YKFBERTLVReaderNext(&reader, record) == YKFBERTLVReadResultRecord && reader.cursor == reader.end;
+}
+
+// Index
+
+bool YKFBERTLVIndexInit(YKFBERTLVIndex *index, const uint8_t *bytes, size_t length) {
+    index->count = 0;
+    index->truncated = false;
+    memset(index->positions, 0, sizeof(index->positions));
+
+    YKFBERTLVReader reader;
+    YKFBERTLVReaderInit(&reader, bytes, length);
+    YKFBERTLVRecord record;
+    YKFBERTLVReadResult result;
+    while ((result = YKFBERTLVReaderNext(&reader, &record)) == YKFBERTLVReadResultRecord) {
+        // The repeated tags are never returned, they don't take a place in the index.
+        if (YKFBERTLVIndexFind(index, record.tag)) {
+            continue;
+        }
+        // Once the index is full the remaining records are still validated, but not indexed.
+        if (index->count == YKF_BER_TLV_INDEX_CAPACITY) {
+            index->truncated = true;
+            continue;
+        }
+        index->records[index->count++] = record;
+        if (record.tag <= 0xFF) {
+            index->positions[record.tag] = (uint8_t)index->count;
+        }
+    }
+    return result == YKFBERTLVReadResultEnd;
+}
+
+const YKFBERTLVRecord *YKFBERTLVIndexFind(const YKFBERTLVIndex *index, uint64_t tag) {
+    if (tag <= 0xFF) {
+        uint8_t position = index->positions[tag];
+        return position ? &index->records[position - 1] : NULL;
+    }
+    for (size_t i = 0; i < index->count; ++i) {
+        if (index->records[i].tag == tag) {
+            return &index->records[i];
+        }
+    }
+    return NULL;
+}
+
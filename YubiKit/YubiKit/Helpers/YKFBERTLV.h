@@ -0,0 +1,141 @@
+// Copyright 2018-2021 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef YKFBERTLV_h
+#define YKFBERTLV_h
+
+/*
+ BER-TLV encoding and decoding of the records exchanged with the YubiKey applications.
+
+ This is plain C, without Foundation, so it can be built and fuzzed on any platform. Tags are handled as the
+ unsigned integer of their bytes (e.g. 0x7F49 or 0x5FC105), like TKBERTLVRecord does, and lengths are encoded
+ in the minimal form, so the encoded bytes are identical to TKBERTLVRecord.data.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// The maximum nesting of constructed records written with YKFBERTLVWriterBegin.
+#define YKF_BER_TLV_MAX_DEPTH 8
+
+/// The maximum number of distinct tags indexed by YKFBERTLVIndexInit.
+#define YKF_BER_TLV_INDEX_CAPACITY 32
+
+// Writer
+
+/*
+ Writes records into a buffer provided by the caller. Constructed records are opened with YKFBERTLVWriterBegin
+ and closed with YKFBERTLVWriterEnd, which patches their length once the nested records are written, so the whole
+ structure is encoded in one buffer without intermediate copies.
+
+ The writer stops writing when the buffer is too small and remembers the failure, so the result of a sequence of
+ calls can be checked once with YKFBERTLVWriterFinish.
+ */
+typedef struct {
+    uint8_t *buffer;
+    size_t capacity;
+    size_t length;
+    size_t openRecords[YKF_BER_TLV_MAX_DEPTH];
+    size_t depth;
+    bool failed;
+} YKFBERTLVWriter;
+
+void YKFBERTLVWriterInit(YKFBERTLVWriter *writer, uint8_t *buffer, size_t capacity);
+
+/// Appends a primitive record.
+bool YKFBERTLVWriterAppend(YKFBERTLVWriter *writer, uint64_t tag, const uint8_t *value, size_t length);
+
+/// Appends raw bytes to the current record, e.g. an already encoded record or a value without tag.
+bool YKFBERTLVWriterAppendBytes(YKFBERTLVWriter *writer, const uint8_t *bytes, size_t length);
+
+/// Opens a constructed record. The following records are nested in it until YKFBERTLVWriterEnd is called.
+bool YKFBERTLVWriterBegin(YKFBERTLVWriter *writer, uint64_t tag);
+
+/// Closes the last opened record and writes its length.
+bool YKFBERTLVWriterEnd(YKFBERTLVWriter *writer);
+
+/// Returns the encoded length, or 0 when a write failed or a record is still open.
+size_t YKFBERTLVWriterFinish(const YKFBERTLVWriter *writer);
+
+/// The length of the encoded record, to preallocate the buffer of the writer.
+size_t YKFBERTLVEncodedLength(uint64_t tag, size_t length);
+
+// Reader
+
+typedef struct {
+    uint64_t tag;
+    const uint8_t *value;
+    size_t length;
+} YKFBERTLVRecord;
+
+typedef enum {
+    YKFBERTLVReadResultRecord,
+    YKFBERTLVReadResultEnd,
+    YKFBERTLVReadResultMalformed,
+} YKFBERTLVReadResult;
+
+/*
+ Iterates the records of a buffer without copying them. The values of the records point into the buffer, which
+ must outlive them. Nested records are read with a new reader on the value of the constructed record.
+ */
+typedef struct {
+    const uint8_t *cursor;
+    const uint8_t *end;
+} YKFBERTLVReader;
+
+void YKFBERTLVReaderInit(YKFBERTLVReader *reader, const uint8_t *bytes, size_t length);
+
+YKFBERTLVReadResult YKFBERTLVReaderNext(YKFBERTLVReader *reader, YKFBERTLVRecord *record);
+
+/// Reads the tag and the length of a record whose value may not be complete yet, e.g. the first chunk of a response.
+bool YKFBERTLVReadHeader(const uint8_t *bytes, size_t length, uint64_t *tag, size_t *valueLength, size_t *headerLength);
+
+/// Reads a buffer containing exactly one record.
+bool YKFBERTLVReadSingleRecord(const uint8_t *bytes, size_t length, YKFBERTLVRecord *record);
+
+// Index
+
+/*
+ The records of a buffer, read in one pass, with constant time lookup of the single byte tags. When a tag is
+ repeated, the first record is returned, like with the lookup in NSArray+TKTLVRecord.
+ */
+typedef struct {
+    // The first record of each tag, in order.
+    YKFBERTLVRecord records[YKF_BER_TLV_INDEX_CAPACITY];
+    size_t count;
+    // true when the buffer has more than YKF_BER_TLV_INDEX_CAPACITY distinct tags, the last ones are not indexed.
+    bool truncated;
+    // 1-based position of the first record for each single byte tag, 0 when there is none.
+    uint8_t positions[256];
+} YKFBERTLVIndex;
+
+/*
+ Returns false when the buffer is malformed. The tags which come after YKF_BER_TLV_INDEX_CAPACITY distinct
+ tags are not indexed, so a response with unknown records doesn't fail to parse.
+ */
+bool YKFBERTLVIndexInit(YKFBERTLVIndex *index, const uint8_t *bytes, size_t length);
+
+/// Returns the first record with the tag, or NULL.
+const YKFBERTLVRecord *YKFBERTLVIndexFind(const YKFBERTLVIndex *index, uint64_t tag);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* YKFBERTLV_h */
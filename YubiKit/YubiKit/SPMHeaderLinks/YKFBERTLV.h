@@ -0,0 +1 @@
+..//Helpers/YKFBERTLV.h
\ No newline at end of file
@@ -0,0 +1 @@
+..//Connections/Shared/Sessions/FIDO2/CBOR/YKFCBORMapView.h
\ No newline at end of file
@@ -0,0 +1 @@
+..//Connections/Shared/Sessions/OATH/YKFOATHCodeCache.h
\ No newline at end of file
@@ -0,0 +1 @@
+..//Connections/Shared/Sessions/OATH/YKFOATHCredentialIndex.h
\ No newline at end of file
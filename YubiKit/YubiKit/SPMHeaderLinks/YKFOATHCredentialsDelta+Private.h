@@ -0,0 +1 @@
+..//Connections/Shared/Sessions/OATH/YKFOATHCredentialsDelta+Private.h
\ No newline at end of file
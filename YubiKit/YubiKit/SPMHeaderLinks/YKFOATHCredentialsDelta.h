@@ -0,0 +1 @@
+..//Connections/Shared/Sessions/OATH/YKFOATHCredentialsDelta.h
\ No newline at end of file
@@ -0,0 +1 @@
+..//Connections/Shared/Sessions/PIV/YKFPIVSlotInventory+Private.h
\ No newline at end of file
@@ -0,0 +1 @@
+..//Connections/Shared/Sessions/PIV/YKFPIVSlotInventory.h
\ No newline at end of file
@@ -0,0 +1 @@
+..//Connections/Shared/Sessions/PIV/YKFPIVSlotMetadata+Private.h
\ No newline at end of file
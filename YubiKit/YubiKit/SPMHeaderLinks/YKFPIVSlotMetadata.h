@@ -0,0 +1 @@
+..//Connections/Shared/Sessions/PIV/YKFPIVSlotMetadata.h
\ No newline at end of file
@@ -0,0 +1 @@
+..//Connections/Shared/Sessions/YKFTouchPollSchedule.h
\ No newline at end of file
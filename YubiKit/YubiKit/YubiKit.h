@@ -51,6 +51,9 @@
 #import "YKFOATHSession.h"
 #import "YKFPIVSession.h"
 #import "YKFPIVSessionFeatures.h"
+#import "YKFPIVObjectCache.h"
+#import "YKFPIVSlotMetadata.h"
+#import "YKFPIVSlotInventory.h"
 #import "YKFPIVManagementKeyType.h"
 #import "YKFPIVManagementKeyMetadata.h"
 #import "YKFManagementDeviceInfo.h"
@@ -80,3 +83,5 @@
 #import "YKFOATHCredentialTypes.h"
 #import "YKFOATHCredentialTemplate.h"
 #import "YKFOATHCredentialWithCode.h"
+#import "YKFOATHAccessKeyCache.h"
+#import "YKFOATHCredentialsDelta.h"
@@ -20,4 +20,12 @@
 - (instancetype)initWithInputData:(NSData *)inputData accessory:(id<YKFEAAccessoryProtocol>)accessory protocol:(NSString *)protocol;
 - (NSData *)outputStreamData;
 
+/*
+ Creates a session with an empty input stream. The input data becomes available only after calling
+ deliverInputDataAfterDelay:, which simulates the time taken by the key to process a command.
+ */
+- (instancetype)initWithDelayedInputData:(NSData *)inputData accessory:(id<YKFEAAccessoryProtocol>)accessory protocol:(NSString *)protocol;
+- (void)deliverInputDataAfterDelay:(NSTimeInterval)delay;
+- (void)deliverInputData:(NSData *)inputData afterDelay:(NSTimeInterval)delay;
+
 @end
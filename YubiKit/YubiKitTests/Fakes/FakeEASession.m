@@ -21,6 +21,9 @@
 @property (nonatomic, readwrite) NSInputStream *inputStream;
 @property (nonatomic, readwrite) NSOutputStream *outputStream;
 
+@property (nonatomic) NSData *delayedInputData;
+@property (nonatomic) NSOutputStream *inputWriterStream;
+
 @end
 
 @implementation FakeEASession
@@ -37,6 +40,38 @@
     return self;
 }
 
+- (instancetype)initWithDelayedInputData:(NSData *)inputData accessory:(id<YKFEAAccessoryProtocol>)accessory protocol:(NSString *)protocol {
+    self = [super init];
+    if (self) {
+        CFReadStreamRef readStream = NULL;
+        CFWriteStreamRef writeStream = NULL;
+        CFStreamCreateBoundPair(kCFAllocatorDefault, &readStream, &writeStream, MAX(inputData.length, 1024));
+        
+        self.inputStream = CFBridgingRelease(readStream);
+        self.inputWriterStream = CFBridgingRelease(writeStream);
+        [self.inputWriterStream open];
+        
+        self.outputStream = [[NSOutputStream alloc] initToMemory];
+        self.delayedInputData = inputData;
+        
+        self.accessory = accessory;
+        self.protocolString = protocol;
+    }
+    return self;
+}
+
+- (void)deliverInputDataAfterDelay:(NSTimeInterval)delay {
+    [self deliverInputData:self.delayedInputData afterDelay:delay];
+}
+
+- (void)deliverInputData:(NSData *)inputData afterDelay:(NSTimeInterval)delay {
+    NSOutputStream *writerStream = self.inputWriterStream;
+    
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        [writerStream write:inputData.bytes maxLength:inputData.length];
+    });
+}
+
 - (NSData *)outputStreamData {
     return [[self.outputStream propertyForKey:NSStreamDataWrittenToMemoryStreamKey] copy];
 }
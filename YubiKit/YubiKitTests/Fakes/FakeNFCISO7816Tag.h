@@ -0,0 +1,33 @@
+// Copyright 2018-2019 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <Foundation/Foundation.h>
+#import <CoreNFC/CoreNFC.h>
+
+/*
+ Fake ISO 7816 tag which replies to each command after a configurable latency. The response echoes
+ the INS byte of the command, followed by the 0x9000 status code.
+ */
+API_AVAILABLE(ios(13.0))
+@interface FakeNFCISO7816Tag: NSObject<NFCISO7816Tag>
+
+@property (nonatomic, assign, getter=isAvailable) BOOL available;
+
+// The latency of each command, in order. The last value is reused for the following commands.
+@property (nonatomic) NSArray<NSNumber *> *responseLatencies;
+
+// Invocation properties
+@property (nonatomic, readonly) NSArray<NSData *> *sentCommands;
+
+@end
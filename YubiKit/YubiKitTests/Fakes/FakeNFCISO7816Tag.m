@@ -0,0 +1,94 @@
+// Copyright 2018-2019 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import "FakeNFCISO7816Tag.h"
+
+@interface FakeNFCISO7816Tag()
+
+@property (nonatomic) NSMutableArray<NSData *> *commands;
+@property (nonatomic) dispatch_queue_t responseQueue;
+
+@end
+
+@implementation FakeNFCISO7816Tag
+
+@synthesize type;
+@synthesize session;
+@synthesize initialSelectedAID;
+@synthesize identifier;
+@synthesize historicalBytes;
+@synthesize applicationData;
+@synthesize proprietaryApplicationDataCoding;
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        self.available = YES;
+        self.responseLatencies = @[@(0)];
+        self.commands = [[NSMutableArray alloc] init];
+        self.responseQueue = dispatch_queue_create("com.yubico.FakeNFCISO7816Tag", DISPATCH_QUEUE_SERIAL);
+    }
+    return self;
+}
+
+- (NSArray<NSData *> *)sentCommands {
+    @synchronized (self) {
+        return [self.commands copy];
+    }
+}
+
+- (void)sendCommandAPDU:(NFCISO7816APDU *)apdu completionHandler:(void(^)(NSData *responseData, uint8_t sw1, uint8_t sw2, NSError *error))completionHandler {
+    NSTimeInterval latency = 0;
+    @synchronized (self) {
+        NSUInteger index = MIN(self.commands.count, self.responseLatencies.count - 1);
+        latency = self.responseLatencies[index].doubleValue;
+        
+        UInt8 header[] = {apdu.instructionClass, apdu.instructionCode, apdu.p1Parameter, apdu.p2Parameter};
+        NSMutableData *command = [[NSMutableData alloc] initWithBytes:header length:sizeof(header)];
+        if (apdu.data) {
+            [command appendData:apdu.data];
+        }
+        [self.commands addObject:command];
+    }
+    
+    UInt8 ins = apdu.instructionCode;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(latency * NSEC_PER_SEC)), self.responseQueue, ^{
+        completionHandler([NSData dataWithBytes:&ins length:1], 0x90, 0x00, nil);
+    });
+}
+
+- (id<NFCNDEFTag>)asNFCNDEFTag {
+    return nil;
+}
+
+#pragma mark - NSCopying
+
+- (id)copyWithZone:(NSZone *)zone {
+    return self;
+}
+
+#pragma mark - NSSecureCoding
+
++ (BOOL)supportsSecureCoding {
+    return YES;
+}
+
+- (instancetype)initWithCoder:(NSCoder *)coder {
+    return [self init];
+}
+
+- (void)encodeWithCoder:(NSCoder *)coder {
+}
+
+@end
@@ -18,12 +18,26 @@
 @interface FakeYKFConnectionController: NSObject<YKFConnectionControllerProtocol>
 
 @property (nonatomic) YKFAPDU *executionCommand;
+@property (nonatomic, assign) NSUInteger executionCommandsCount;
+@property (nonatomic, assign) NSUInteger dispatchedOperationsCount;
+@property (nonatomic, readonly) NSArray<YKFAPDU *> *executedCommands;
+// The delays of the blocks dispatched with a delay, in order.
+@property (nonatomic, readonly) NSArray<NSNumber *> *dispatchDelays;
 
 @property (nonatomic) YKFConnectionControllerCommandResponseBlock commandResponseBlock;
 @property (nonatomic) YKFConnectionControllerCompletionBlock operationExecutionBlock;
 
 // Response customisation
 
+@property (nonatomic, assign) NSUInteger maxFrameSize;
+
+// The queue on which the responses are delivered, the main queue by default. The connection controllers deliver
+// them on their communication queue, which the requests running crypto off the main thread rely on.
+@property (nonatomic) dispatch_queue_t responseQueue;
+
+// Simulated time taken by the key to receive a frame and reply, for command sequences.
+@property (nonatomic, assign) NSTimeInterval frameLatency;
+
 @property (nonatomic) NSArray *commandExecutionResponseDataSequence;
 @property (nonatomic) NSArray *commandExecutionResponseErrorSequence;
 
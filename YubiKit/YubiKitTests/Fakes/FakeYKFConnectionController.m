@@ -17,11 +17,32 @@
 @interface FakeYKFConnectionController()
 
 @property (nonatomic, assign) NSUInteger commandExecutionSequenceIndex;
+@property (nonatomic) NSMutableArray<YKFAPDU *> *commands;
+@property (nonatomic) NSMutableArray<NSNumber *> *delays;
 
 @end
 
 @implementation FakeYKFConnectionController
 
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        self.maxFrameSize = UINT16_MAX;
+        self.responseQueue = dispatch_get_main_queue();
+        self.commands = [[NSMutableArray alloc] init];
+        self.delays = [[NSMutableArray alloc] init];
+    }
+    return self;
+}
+
+- (NSArray<YKFAPDU *> *)executedCommands {
+    return [self.commands copy];
+}
+
+- (NSArray<NSNumber *> *)dispatchDelays {
+    return [self.delays copy];
+}
+
 - (void)setCommandExecutionResponseDataSequence:(NSArray *)commandExecutionResponseDataSequence {
     _commandExecutionResponseDataSequence = commandExecutionResponseDataSequence;
     self.commandExecutionSequenceIndex = 0;
@@ -37,11 +58,14 @@
 - (void)execute:(YKFAPDU *)command completion:(YKFConnectionControllerCommandResponseBlock)completion {
     self.executionCommand = command;
     self.commandResponseBlock = completion;
+    [self.commands addObject:command];
+    ++self.executionCommandsCount;
+    ++self.dispatchedOperationsCount;
     
     NSData *responseData = [self nextResponseDataInSequence];
     NSError *responseError = [self nextResponseErrorInSequence];
     
-    dispatch_async(dispatch_get_main_queue(), ^{
+    dispatch_async(self.responseQueue, ^{
         completion(responseData, responseError, 0);
     });
     
@@ -51,17 +75,44 @@
 - (void)execute:(YKFAPDU *)command timeout:(NSTimeInterval)timeout completion:(YKFConnectionControllerCommandResponseBlock)completion {
     self.executionCommand = command;
     self.commandResponseBlock = completion;
+    [self.commands addObject:command];
+    ++self.executionCommandsCount;
+    ++self.dispatchedOperationsCount;
     
     NSData *responseData = [self nextResponseDataInSequence];
     NSError *responseError = [self nextResponseErrorInSequence];
     
-    dispatch_async(dispatch_get_main_queue(), ^{
+    dispatch_async(self.responseQueue, ^{
         completion(responseData, responseError, 0);
     });
 
     ++self.commandExecutionSequenceIndex;
 }
 
+- (void)executeSequence:(YKFAPDU *)command timeout:(NSTimeInterval)timeout next:(YKFConnectionControllerCommandSequenceBlock)next {
+    ++self.dispatchedOperationsCount;
+    
+    // The whole sequence runs in a single dispatch, like in a single communication queue operation.
+    dispatch_async(self.responseQueue, ^{
+        YKFAPDU *nextCommand = command;
+        while (nextCommand) {
+            self.executionCommand = nextCommand;
+            [self.commands addObject:nextCommand];
+            ++self.executionCommandsCount;
+            
+            if (self.frameLatency > 0) {
+                [NSThread sleepForTimeInterval:self.frameLatency];
+            }
+            
+            NSData *responseData = [self nextResponseDataInSequence];
+            NSError *responseError = [self nextResponseErrorInSequence];
+            ++self.commandExecutionSequenceIndex;
+            
+            nextCommand = next(responseData, responseError, 0);
+        }
+    });
+}
+
 - (void)dispatchOnSequentialQueue:(YKFConnectionControllerCompletionBlock)block delay:(NSTimeInterval)delay {
     self.operationExecutionBlock = block;
     
@@ -91,7 +142,17 @@
 }
 
 - (void)dispatchBlockOnCommunicationQueue:(nonnull YKFConnectionControllerCommunicationQueueBlock)block {
-    // Do nothing
+    dispatch_async(self.responseQueue, ^{
+        block([[NSBlockOperation alloc] init]);
+    });
+}
+
+- (void)dispatchBlockOnCommunicationQueue:(nonnull YKFConnectionControllerCommunicationQueueBlock)block delay:(NSTimeInterval)delay {
+    [self.delays addObject:@(delay)];
+    
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), self.responseQueue, ^{
+        block([[NSBlockOperation alloc] init]);
+    });
 }
 
 #pragma mark - Helpers
@@ -0,0 +1,156 @@
+// Copyright 2018-2019 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <XCTest/XCTest.h>
+
+#import "YKFTestCase.h"
+#import "YKFAPDU+Private.h"
+#import "YKFOATHCalculateAllAPDU.h"
+#import "YKFFIDO2GetInfoAPDU.h"
+#import "YKFFIDO2CommandAPDU.h"
+
+@interface YKFAPDUTests: YKFTestCase
+@end
+
+@implementation YKFAPDUTests
+
+#pragma mark - Encoding
+
+- (void)test_WhenCreatingShortAPDU_DataIsEncoded {
+    NSData *data = [NSData dataWithBytes:@[@(0x01), @(0x02)]];
+    YKFAPDU *apdu = [[YKFAPDU alloc] initWithCla:0x00 ins:0xA4 p1:0x04 p2:0x00 data:data type:YKFAPDUTypeShort];
+    
+    NSData *expectedData = [NSData dataWithBytes:@[@(0x00), @(0xA4), @(0x04), @(0x00), @(0x02), @(0x01), @(0x02)]];
+    XCTAssertEqualObjects(apdu.apduData, expectedData);
+    XCTAssertEqualObjects(apdu.commandData, data);
+    
+    NSMutableData *expectedYLPData = [NSMutableData dataWithBytes:(UInt8[]){0x00} length:1];
+    [expectedYLPData appendData:expectedData];
+    XCTAssertEqualObjects(apdu.ylpApduData, expectedYLPData);
+}
+
+- (void)test_WhenCreatingExtendedAPDU_DataIsEncoded {
+    NSMutableData *data = [[NSMutableData alloc] initWithLength:300];
+    YKFAPDU *apdu = [[YKFAPDU alloc] initWithCla:0x00 ins:0xDB p1:0x3F p2:0xFF data:data type:YKFAPDUTypeExtended];
+    
+    XCTAssertEqual(apdu.apduData.length, 4 + 3 + 300);
+    XCTAssertEqual(apdu.ylpApduData.length, 1 + 4 + 3 + 300);
+    
+    UInt8 *bytes = (UInt8 *)apdu.apduData.bytes;
+    XCTAssertEqual(bytes[4], 0x00);
+    XCTAssertEqual(bytes[5], 0x01);
+    XCTAssertEqual(bytes[6], 0x2C);
+    XCTAssertEqualObjects(apdu.commandData, data);
+}
+
+- (void)test_WhenCreatingExtendedAPDUWithoutData_LengthIsEncoded {
+    YKFAPDU *apdu = [[YKFAPDU alloc] initWithCla:0x00 ins:0xF9 p1:0x9A p2:0x00 data:[NSData data] type:YKFAPDUTypeExtended];
+    
+    NSData *expectedData = [NSData dataWithBytes:@[@(0x00), @(0xF9), @(0x9A), @(0x00), @(0x00), @(0x00), @(0x00)]];
+    XCTAssertEqualObjects(apdu.apduData, expectedData);
+    XCTAssertEqual(apdu.commandData.length, 0);
+}
+
+- (void)test_WhenCreatingAPDUFromData_YLPFrameIsPrefixed {
+    NSData *data = [NSData dataWithBytes:@[@(0x00), @(0xC0), @(0x00), @(0x00)]];
+    YKFAPDU *apdu = [[YKFAPDU alloc] initWithData:data];
+    
+    XCTAssertEqualObjects(apdu.apduData, data);
+    XCTAssertNil(apdu.commandData);
+    XCTAssertEqual(apdu.ins, 0xC0);
+    
+    NSData *expectedYLPData = [NSData dataWithBytes:@[@(0x00), @(0x00), @(0xC0), @(0x00), @(0x00)]];
+    XCTAssertEqualObjects(apdu.ylpApduData, expectedYLPData);
+}
+
+- (void)test_WhenAPDUIsReleased_DataViewsRemainValid {
+    NSData *apduData = nil;
+    @autoreleasepool {
+        NSData *data = [NSData dataWithBytes:@[@(0x01), @(0x02), @(0x03)]];
+        YKFAPDU *apdu = [[YKFAPDU alloc] initWithCla:0x00 ins:0x01 p1:0x00 p2:0x00 data:data type:YKFAPDUTypeShort];
+        apduData = apdu.apduData;
+    }
+    NSData *expectedData = [NSData dataWithBytes:@[@(0x00), @(0x01), @(0x00), @(0x00), @(0x03), @(0x01), @(0x02), @(0x03)]];
+    XCTAssertEqualObjects(apduData, expectedData);
+}
+
+- (void)test_WhenReadingAPDUDataAgain_ViewIsReused {
+    NSData *data = [NSData dataWithBytes:@[@(0x01), @(0x02), @(0x03)]];
+    YKFAPDU *apdu = [[YKFAPDU alloc] initWithCla:0x00 ins:0x01 p1:0x00 p2:0x00 data:data type:YKFAPDUTypeShort];
+
+    XCTAssertEqual(apdu.apduData, apdu.apduData);
+}
+
+- (void)test_WhenCreatingOATHCalculateAllAPDUWithPeriod_ChallengeUsesPeriod {
+    NSDate *timestamp = [NSDate dateWithTimeIntervalSince1970:1200];
+
+    YKFAPDU *defaultPeriodAPDU = [[YKFOATHCalculateAllAPDU alloc] initWithTimestamp:timestamp];
+    NSData *expectedDefaultData = [NSData dataWithBytes:@[@(0x74), @(0x08), @(0x00), @(0x00), @(0x00), @(0x00), @(0x00), @(0x00), @(0x00), @(0x28)]];
+    XCTAssertEqualObjects(defaultPeriodAPDU.commandData, expectedDefaultData);
+
+    YKFAPDU *customPeriodAPDU = [[YKFOATHCalculateAllAPDU alloc] initWithTimestamp:timestamp period:60];
+    NSData *expectedCustomData = [NSData dataWithBytes:@[@(0x74), @(0x08), @(0x00), @(0x00), @(0x00), @(0x00), @(0x00), @(0x00), @(0x00), @(0x14)]];
+    XCTAssertEqualObjects(customPeriodAPDU.commandData, expectedCustomData);
+}
+
+#pragma mark - Performance
+
+- (void)test_OATHAPDUCreationPerformance {
+    [self measureCreationWithFactory:^YKFAPDU *{
+        return [[YKFOATHCalculateAllAPDU alloc] initWithTimestamp:[NSDate date]];
+    }];
+}
+
+- (void)test_PIVAPDUCreationPerformance {
+    NSData *certificate = [[NSMutableData alloc] initWithLength:3072];
+    [self measureCreationWithFactory:^YKFAPDU *{
+        return [[YKFAPDU alloc] initWithCla:0x00 ins:0xDB p1:0x3F p2:0xFF data:certificate type:YKFAPDUTypeExtended];
+    }];
+}
+
+- (void)test_FIDO2GetInfoAPDUCreationPerformance {
+    [self measureCreationWithFactory:^YKFAPDU *{
+        return [[YKFFIDO2GetInfoAPDU alloc] init];
+    }];
+}
+
+- (void)test_FIDO2CommandAPDUCreationPerformance {
+    NSData *request = [[NSMutableData alloc] initWithLength:256];
+    [self measureCreationWithFactory:^YKFAPDU *{
+        return [[YKFFIDO2CommandAPDU alloc] initWithCommand:YKFFIDO2CommandMakeCredential data:request];
+    }];
+}
+
+#pragma mark - Helpers
+
+/*
+ Measures the creation of APDUs and of their transport frame, with the memory used by the buffers.
+ */
+- (void)measureCreationWithFactory:(YKFAPDU *(^)(void))factory {
+    static const NSUInteger apdusCount = 1000;
+    NSMutableArray *apdus = [[NSMutableArray alloc] initWithCapacity:apdusCount];
+    
+    [self measureWithMetrics:@[[[XCTMemoryMetric alloc] init], [[XCTClockMetric alloc] init]] block:^{
+        [apdus removeAllObjects];
+        for (NSUInteger i = 0; i < apdusCount; ++i) {
+            @autoreleasepool {
+                YKFAPDU *apdu = factory();
+                [apdu ylpApduData];
+                [apdus addObject:apdu];
+            }
+        }
+    }];
+}
+
+@end
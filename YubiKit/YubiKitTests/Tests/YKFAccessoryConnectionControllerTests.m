@@ -16,6 +16,7 @@
 
 #import "YKFTestCase.h"
 #import "YKFAccessoryConnectionController.h"
+#import "YKFAccessoryConnectionConfiguration.h"
 #import "FakeEASession.h"
 #import "YKFAPDU+Private.h"
 
@@ -136,7 +137,7 @@
     
     XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"Command execution completion."];
     [connectionController execute:command completion:^(NSData *result, NSError *error, NSTimeInterval executionTime) {
-        response = result;
+        response = [result mutableCopy]; // The result is valid only inside the completion.
         [expectation fulfill];
     }];
     XCTWaiterResult result = [XCTWaiter waitForExpectations:@[expectation] timeout:1];
@@ -174,4 +175,212 @@
     XCTAssert(result == XCTWaiterResultTimedOut); // The result should time out because the key didn't reply to the request.
 }
 
+- (void)test_WhenKeySendsWTXFrames_MetricsReportTheBusyTime {
+    [self checkWTXMetricsWithIOMode:YKFAccessoryConnectionIOModePolling];
+}
+
+- (void)test_WhenKeySendsWTXFramesOverStreamEvents_MetricsReportTheBusyTime {
+    [self checkWTXMetricsWithIOMode:YKFAccessoryConnectionIOModeStreamEvents];
+}
+
+#pragma mark - Stream Events
+
+- (void)test_WhenConnectionControllerUsesStreamEvents_CommandsAreWrittenToTheOutputStream {
+    UInt8 inputBytes[] = {0x00, 0x90, 0x00};
+    NSData *inputData = [[NSData alloc] initWithBytes:inputBytes length:3];
+    
+    self.eaSession = [[FakeEASession alloc] initWithInputData:inputData accessory:nil protocol:@"YLP"];
+    
+    YKFAccessoryConnectionController *connectionController = [self connectionControllerWithIOMode:YKFAccessoryConnectionIOModeStreamEvents];
+    [self waitForTimeInterval:0.2];
+    
+    // Execute command
+    
+    NSData *commandData = [@"command" dataUsingEncoding:NSUTF8StringEncoding];
+    YKFAPDU *command = [[YKFAPDU alloc] initWithData:commandData];
+    
+    XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"Command execution completion."];
+    [connectionController execute:command completion:^(NSData *result, NSError *error, NSTimeInterval executionTime) {
+        [expectation fulfill];
+    }];
+    XCTWaiterResult result = [XCTWaiter waitForExpectations:@[expectation] timeout:1];
+    XCTAssert(result == XCTWaiterResultCompleted);
+    
+    // Check the written data
+    
+    NSData *writtenData = [self.eaSession outputStreamData];
+    XCTAssert([writtenData isEqualToData:command.ylpApduData], @"Command data doesn't match written data.");
+}
+
+- (void)test_WhenConnectionControllerUsesStreamEvents_DelayedResponseIsReadFromTheInputStream {
+    UInt8 inputBytes[] = {0x00, 0x90, 0x00};
+    NSData *inputData = [[NSData alloc] initWithBytes:inputBytes length:3];
+    
+    self.eaSession = [[FakeEASession alloc] initWithDelayedInputData:inputData accessory:nil protocol:@"YLP"];
+    
+    YKFAccessoryConnectionController *connectionController = [self connectionControllerWithIOMode:YKFAccessoryConnectionIOModeStreamEvents];
+    [self waitForTimeInterval:0.2];
+    
+    // Execute command
+    
+    NSData *commandData = [@"command" dataUsingEncoding:NSUTF8StringEncoding];
+    YKFAPDU *command = [[YKFAPDU alloc] initWithData:commandData];
+    
+    __block NSData *response = nil;
+    
+    XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"Command execution completion."];
+    [self.eaSession deliverInputDataAfterDelay:0.1];
+    [connectionController execute:command completion:^(NSData *result, NSError *error, NSTimeInterval executionTime) {
+        response = [result mutableCopy]; // The result is valid only inside the completion.
+        [expectation fulfill];
+    }];
+    XCTWaiterResult result = [XCTWaiter waitForExpectations:@[expectation] timeout:1];
+    XCTAssert(result == XCTWaiterResultCompleted);
+    
+    // Check the response data
+    
+    XCTAssert([response isEqualToData:[inputData subdataWithRange:NSMakeRange(1, 2)]], @"Response data doesn't match the input data.");
+}
+
+#pragma mark - Performance
+
+- (void)test_CommandExecutionPerformance_WithPolling {
+    [self measureCommandExecutionWithIOMode:YKFAccessoryConnectionIOModePolling];
+}
+
+- (void)test_CommandExecutionPerformance_WithStreamEvents {
+    [self measureCommandExecutionWithIOMode:YKFAccessoryConnectionIOModeStreamEvents];
+}
+
+- (void)test_LargePayloadPerformance_2KB {
+    [self measureLargePayloadExecutionWithLength:2 * 1024];
+}
+
+- (void)test_LargePayloadPerformance_64KB {
+    [self measureLargePayloadExecutionWithLength:64 * 1024];
+}
+
+#pragma mark - Helpers
+
+- (YKFAccessoryConnectionController *)connectionControllerWithIOMode:(YKFAccessoryConnectionIOMode)ioMode {
+    YKFAccessoryConnectionConfiguration *configuration = [[YKFAccessoryConnectionConfiguration alloc] init];
+    configuration.ioMode = ioMode;
+    return [[YKFAccessoryConnectionController alloc] initWithSession:self.eaSession operationQueue:self.operationQueue configuration:configuration];
+}
+
+/*
+ Measures the time between sending a command and receiving the response, when the fake key takes 10ms to respond.
+ */
+- (void)measureCommandExecutionWithIOMode:(YKFAccessoryConnectionIOMode)ioMode {
+    UInt8 inputBytes[] = {0x00, 0x90, 0x00};
+    NSData *inputData = [[NSData alloc] initWithBytes:inputBytes length:3];
+    
+    NSData *commandData = [@"command" dataUsingEncoding:NSUTF8StringEncoding];
+    YKFAPDU *command = [[YKFAPDU alloc] initWithData:commandData];
+    
+    [self measureMetrics:@[XCTPerformanceMetric_WallClockTime] automaticallyStartMeasuring:NO forBlock:^{
+        self.eaSession = [[FakeEASession alloc] initWithDelayedInputData:inputData accessory:nil protocol:@"YLP"];
+        YKFAccessoryConnectionController *connectionController = [self connectionControllerWithIOMode:ioMode];
+        [self waitForTimeInterval:0.2];
+        
+        XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"Command execution completion."];
+        
+        [self startMeasuring];
+        [self.eaSession deliverInputDataAfterDelay:0.01];
+        [connectionController execute:command completion:^(NSData *result, NSError *error, NSTimeInterval executionTime) {
+            [expectation fulfill];
+        }];
+        XCTWaiterResult result = [XCTWaiter waitForExpectations:@[expectation] timeout:1];
+        [self stopMeasuring];
+        
+        XCTAssert(result == XCTWaiterResultCompleted);
+        
+        XCTestExpectation *closeExpectation = [[XCTestExpectation alloc] initWithDescription:@"Close key connection controller completion"];
+        [connectionController closeConnectionWithCompletion:^{
+            [closeExpectation fulfill];
+        }];
+        [XCTWaiter waitForExpectations:@[closeExpectation] timeout:1];
+    }];
+}
+
+/*
+ Measures writing a command and reading a response of the same length through the controller buffers.
+ */
+- (void)measureLargePayloadExecutionWithLength:(NSUInteger)length {
+    NSMutableData *payload = [[NSMutableData alloc] initWithLength:length];
+    
+    NSMutableData *inputData = [[NSMutableData alloc] initWithCapacity:length + 3];
+    UInt8 header = 0x00;
+    [inputData appendBytes:&header length:1];
+    [inputData appendData:payload];
+    UInt8 statusCode[] = {0x90, 0x00};
+    [inputData appendBytes:statusCode length:2];
+    
+    YKFAPDU *command = [[YKFAPDU alloc] initWithData:payload];
+    
+    [self measureMetrics:@[XCTPerformanceMetric_WallClockTime] automaticallyStartMeasuring:NO forBlock:^{
+        self.eaSession = [[FakeEASession alloc] initWithInputData:inputData accessory:nil protocol:@"YLP"];
+        YKFAccessoryConnectionController *connectionController = [[YKFAccessoryConnectionController alloc] initWithSession:self.eaSession operationQueue:self.operationQueue];
+        [self waitForTimeInterval:0.2];
+        
+        __block NSUInteger responseLength = 0;
+        XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"Command execution completion."];
+        
+        [self startMeasuring];
+        [connectionController execute:command completion:^(NSData *result, NSError *error, NSTimeInterval executionTime) {
+            responseLength = result.length;
+            [expectation fulfill];
+        }];
+        XCTWaiterResult result = [XCTWaiter waitForExpectations:@[expectation] timeout:1];
+        [self stopMeasuring];
+        
+        XCTAssert(result == XCTWaiterResultCompleted);
+        XCTAssertEqual(responseLength, length + 2);
+        XCTAssertEqual([self.eaSession outputStreamData].length, command.ylpApduData.length);
+        
+        XCTestExpectation *closeExpectation = [[XCTestExpectation alloc] initWithDescription:@"Close key connection controller completion"];
+        [connectionController closeConnectionWithCompletion:^{
+            [closeExpectation fulfill];
+        }];
+        [XCTWaiter waitForExpectations:@[closeExpectation] timeout:1];
+    }];
+}
+
+- (void)checkWTXMetricsWithIOMode:(YKFAccessoryConnectionIOMode)ioMode {
+    UInt8 responseBytes[] = {0x00, 0x90, 0x00};
+    NSData *responseData = [[NSData alloc] initWithBytes:responseBytes length:3];
+    UInt8 wtxBytes[] = {0x01, 0x00, 0x00, 0x00};
+    NSData *wtxData = [[NSData alloc] initWithBytes:wtxBytes length:4];
+    
+    self.eaSession = [[FakeEASession alloc] initWithDelayedInputData:responseData accessory:nil protocol:@"YLP"];
+    
+    YKFAccessoryConnectionController *connectionController = [self connectionControllerWithIOMode:ioMode];
+    [self waitForTimeInterval:0.2];
+    
+    // Execute command
+    
+    NSData *commandData = [@"command" dataUsingEncoding:NSUTF8StringEncoding];
+    YKFAPDU *command = [[YKFAPDU alloc] initWithData:commandData];
+    
+    __block YKFAccessoryCommandMetrics *commandMetrics = nil;
+    __block NSError *commandError = nil;
+    
+    XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"Command execution completion."];
+    [self.eaSession deliverInputData:wtxData afterDelay:0.05];
+    [self.eaSession deliverInputData:wtxData afterDelay:0.55];
+    [self.eaSession deliverInputDataAfterDelay:0.8];
+    [connectionController execute:command timeout:2 metricsCompletion:^(NSData *result, NSError *error, YKFAccessoryCommandMetrics *metrics) {
+        commandMetrics = metrics;
+        commandError = error;
+        [expectation fulfill];
+    }];
+    XCTWaiterResult result = [XCTWaiter waitForExpectations:@[expectation] timeout:2];
+    XCTAssert(result == XCTWaiterResultCompleted);
+    
+    XCTAssertNil(commandError);
+    XCTAssertEqual(commandMetrics.wtxCount, 2);
+    XCTAssert(commandMetrics.wtxDuration > 0.5 && commandMetrics.wtxDuration < 1.0);
+    XCTAssert(commandMetrics.executionTime >= commandMetrics.wtxDuration);
+}
+
 @end
@@ -0,0 +1,175 @@
+// Copyright 2018-2021 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <XCTest/XCTest.h>
+#import <CryptoTokenKit/TKTLVRecord.h>
+
+#import "YKFTestCase.h"
+#import "YKFBERTLV.h"
+#import "YKFNSDataAdditions+Private.h"
+
+@interface YKFBERTLVTests: YKFTestCase
+@end
+
+@implementation YKFBERTLVTests
+
+#pragma mark - Helpers
+
+- (NSData *)dataWithLength:(NSUInteger)length {
+    NSMutableData *data = [[NSMutableData alloc] initWithLength:length];
+    for (NSUInteger i = 0; i < length; ++i) {
+        ((UInt8 *)data.mutableBytes)[i] = (UInt8)i;
+    }
+    return data;
+}
+
+// Writes a nested record with a value of the length, like the PIV authenticate request.
+- (NSData *)writeNestedRecordWithValue:(NSData *)value {
+    NSUInteger recordsLength = YKFBERTLVEncodedLength(0x82, 0) + YKFBERTLVEncodedLength(0x5FC105, value.length);
+    NSMutableData *data = [[NSMutableData alloc] initWithLength:YKFBERTLVEncodedLength(0x7C, recordsLength)];
+    YKFBERTLVWriter writer;
+    YKFBERTLVWriterInit(&writer, data.mutableBytes, data.length);
+    YKFBERTLVWriterBegin(&writer, 0x7C);
+    YKFBERTLVWriterAppend(&writer, 0x82, NULL, 0);
+    YKFBERTLVWriterAppend(&writer, 0x5FC105, value.bytes, value.length);
+    YKFBERTLVWriterEnd(&writer);
+    data.length = YKFBERTLVWriterFinish(&writer);
+    return data;
+}
+
+#pragma mark - Writer
+
+- (void)test_WhenWritingNestedRecords_BytesMatchTKBERTLVRecord {
+    for (NSNumber *length in @[@(0), @(0x7F), @(0x80), @(0xFF), @(0x100), @(0x10000)]) {
+        NSData *value = [self dataWithLength:length.unsignedIntegerValue];
+
+        NSMutableData *recordsData = [[NSMutableData alloc] init];
+        [recordsData appendData:[[TKBERTLVRecord alloc] initWithTag:0x82 value:[NSData data]].data];
+        [recordsData appendData:[[TKBERTLVRecord alloc] initWithTag:0x5FC105 value:value].data];
+        NSData *expected = [[TKBERTLVRecord alloc] initWithTag:0x7C value:recordsData].data;
+
+        XCTAssertEqualObjects([self writeNestedRecordWithValue:value], expected, @"Length %@", length);
+    }
+}
+
+- (void)test_WhenBufferIsTooSmall_WriterFails {
+    UInt8 buffer[4];
+    YKFBERTLVWriter writer;
+    YKFBERTLVWriterInit(&writer, buffer, sizeof(buffer));
+    NSData *value = [self dataWithLength:3];
+
+    XCTAssertFalse(YKFBERTLVWriterAppend(&writer, 0x01, value.bytes, value.length));
+    XCTAssertFalse(YKFBERTLVWriterAppend(&writer, 0x01, NULL, 0));
+    XCTAssertEqual(YKFBERTLVWriterFinish(&writer), 0);
+}
+
+- (void)test_WhenRecordIsNotClosed_WriterFails {
+    UInt8 buffer[8];
+    YKFBERTLVWriter writer;
+    YKFBERTLVWriterInit(&writer, buffer, sizeof(buffer));
+    YKFBERTLVWriterBegin(&writer, 0x7C);
+
+    XCTAssertEqual(YKFBERTLVWriterFinish(&writer), 0);
+}
+
+#pragma mark - Reader
+
+- (void)test_WhenReadingRecords_TagsAndValuesAreReturned {
+    NSData *value = [self dataWithLength:0x100];
+    NSData *data = [self writeNestedRecordWithValue:value];
+
+    NSError *error = nil;
+    NSData *recordsData = [data ykf_BERTLVValueWithTag:0x7C error:&error];
+    XCTAssertNil(error);
+
+    YKFBERTLVIndex index;
+    XCTAssertTrue(YKFBERTLVIndexInit(&index, recordsData.bytes, recordsData.length));
+    XCTAssertEqual(index.count, 2);
+    XCTAssertEqual(YKFBERTLVIndexFind(&index, 0x82)->length, 0);
+    XCTAssertEqualObjects([recordsData ykf_valueOfBERTLVRecord:YKFBERTLVIndexFind(&index, 0x5FC105)], value);
+    XCTAssertTrue(YKFBERTLVIndexFind(&index, 0x81) == NULL);
+}
+
+- (void)test_WhenTagIsRepeated_FirstRecordIsFound {
+    NSData *data = [NSData dataWithBytes:@[@(0x01), @(0x01), @(0xAA), @(0x01), @(0x01), @(0xBB)]];
+
+    YKFBERTLVIndex index;
+    XCTAssertTrue(YKFBERTLVIndexInit(&index, data.bytes, data.length));
+    XCTAssertEqual(YKFBERTLVIndexFind(&index, 0x01)->value[0], 0xAA);
+}
+
+- (void)test_WhenIndexIsFull_RemainingRecordsAreNotIndexed {
+    NSMutableData *data = [[NSMutableData alloc] init];
+    for (UInt8 tag = 0x81; tag < 0x81 + YKF_BER_TLV_INDEX_CAPACITY + 2; ++tag) {
+        [data appendData:[[TKBERTLVRecord alloc] initWithTag:tag value:[self dataWithLength:1]].data];
+        // The repeated tags don't fill the index.
+        [data appendData:[[TKBERTLVRecord alloc] initWithTag:0x81 value:[self dataWithLength:1]].data];
+    }
+
+    YKFBERTLVIndex index;
+    XCTAssertTrue(YKFBERTLVIndexInit(&index, data.bytes, data.length));
+    XCTAssertTrue(index.truncated);
+    XCTAssertEqual(index.count, YKF_BER_TLV_INDEX_CAPACITY);
+    XCTAssertTrue(YKFBERTLVIndexFind(&index, 0x81 + YKF_BER_TLV_INDEX_CAPACITY - 1) != NULL);
+    XCTAssertTrue(YKFBERTLVIndexFind(&index, 0x81 + YKF_BER_TLV_INDEX_CAPACITY) == NULL);
+}
+
+- (void)test_WhenDataIsMalformed_ReaderFails {
+    NSArray *malformedData = @[[NSData dataWithBytes:@[@(0x53), @(0x05), @(0x01)]],
+                               [NSData dataWithBytes:@[@(0x53), @(0x82), @(0x01)]],
+                               [NSData dataWithBytes:@[@(0x53), @(0x80)]],
+                               [NSData dataWithBytes:@[@(0x7F)]],
+                               [NSData dataWithBytes:@[@(0x7F), @(0x81), @(0x81), @(0x81), @(0x01), @(0x00)]]];
+    for (NSData *data in malformedData) {
+        YKFBERTLVIndex index;
+        XCTAssertFalse(YKFBERTLVIndexInit(&index, data.bytes, data.length), @"%@", data);
+
+        NSError *error = nil;
+        XCTAssertNil([data ykf_BERTLVValueWithTag:0x53 error:&error]);
+        XCTAssertNotNil(error);
+    }
+}
+
+- (void)test_WhenSingleRecordHasTrailingBytes_ReadFails {
+    NSData *data = [NSData dataWithBytes:@[@(0x75), @(0x01), @(0x06), @(0x00)]];
+    YKFBERTLVRecord record;
+    XCTAssertFalse(YKFBERTLVReadSingleRecord(data.bytes, data.length, &record));
+}
+
+#pragma mark - Performance
+
+- (void)test_WriteNestedRecordsPerformance {
+    NSData *value = [self dataWithLength:256];
+    [self measureBlock:^{
+        for (int i = 0; i < 10000; ++i) {
+            [self writeNestedRecordWithValue:value];
+        }
+    }];
+}
+
+- (void)test_IndexLookupPerformance {
+    NSMutableData *data = [[NSMutableData alloc] init];
+    for (UInt8 tag = 1; tag <= 16; ++tag) {
+        [data appendData:[[TKBERTLVRecord alloc] initWithTag:tag value:[self dataWithLength:4]].data];
+    }
+    [self measureBlock:^{
+        for (int i = 0; i < 10000; ++i) {
+            YKFBERTLVIndex index;
+            YKFBERTLVIndexInit(&index, data.bytes, data.length);
+            XCTAssertTrue(YKFBERTLVIndexFind(&index, 16) != NULL);
+        }
+    }];
+}
+
+@end
@@ -16,6 +16,7 @@
 #import "YKFTestCase.h"
 #import "YKFCBOREncoder.h"
 #import "YKFCBORDecoder.h"
+#import "YKFFIDO2ResponseFixtures.h"
 
 @interface YKFCBORDecoderTests: YKFTestCase
 
@@ -339,4 +340,107 @@
     [inputStream close];
 }
 
+
+#pragma mark - Data Decoding Tests
+
+- (void)testDataDecodingMatchesStreamDecoding {
+    NSArray *testInput = @[self.testIntegers[0],
+                           YKFCBORInteger(-1000000000000),
+                           YKFCBORInteger(1000000),
+                           self.testStrings[0],
+                           YKFCBORBool(YES),
+                           YKFCBORByteString(self.testLongData[3]),
+                           [YKFCBORMap cborMapWithValue:
+                            @{self.testStrings[1]: YKFCBORBool(NO),
+                              self.testStrings[2]: [YKFCBORArray cborArrayWithValue:@[self.testIntegers[1], YKFCBORByteString([NSData data])]]
+                              }]
+                           ];
+    NSData *encodedArray = [YKFCBOREncoder encodeArray:YKFCBORArray(testInput)];
+    
+    id decodedObject = [YKFCBORDecoder decodeObjectFromData:encodedArray];
+    
+    XCTAssert([decodedObject isKindOfClass:YKFCBORArray.class], @"CBOR - Wrong class decoded when parsing array.");
+    XCTAssert([testInput isEqualToArray:((YKFCBORArray *)decodedObject).value], @"CBOR - Wrong array decoded.");
+}
+
+- (void)testDataDecodingReferencesByteStrings {
+    NSData *response = [YKFFIDO2ResponseFixtures makeCredentialResponse];
+    
+    YKFCBORMap *decodedMap = [YKFCBORDecoder decodeObjectFromData:response];
+    YKFCBORByteString *authData = decodedMap.value[YKFCBORInteger(2)];
+    
+    XCTAssertEqual(authData.value.length, 196);
+    const UInt8 *responseBytes = response.bytes;
+    XCTAssert(authData.value.bytes > (const void *)responseBytes && authData.value.bytes < (const void *)(responseBytes + response.length), @"CBOR - Byte string was copied.");
+}
+
+- (void)testDataDecodingFailsOnMalformedData {
+    NSArray *malformedData = @[[NSData dataFromHexString:@"5819"],                     // truncated byte string
+                               [NSData dataFromHexString:@"a2010203"],                 // missing map pair
+                               [NSData dataFromHexString:@"a201020103"],               // duplicated key
+                               [NSData dataFromHexString:@"9bffffffffffffffff00"],     // count larger than the data
+                               [NSData dataFromHexString:@"1bffffffffffffffff"],       // integer larger than NSInteger
+                               [NSData dataFromHexString:@"62c328"],                   // invalid UTF8
+                               [NSData dataFromHexString:@"9f01ff"],                   // indefinite length
+                               [NSData dataFromHexString:@"c101"],                     // tag
+                               [NSData dataFromHexString:@"f6"],                       // null
+                               [NSData dataFromHexString:@"818181818181818181818181818181818100"]]; // nested too deep
+    for (NSData *data in malformedData) {
+        XCTAssertNil([YKFCBORDecoder decodeObjectFromData:data], @"%@", data);
+    }
+}
+
+- (void)testDataDecodingOfTruncatedResponses {
+    NSData *response = [YKFFIDO2ResponseFixtures makeCredentialResponse];
+    for (NSUInteger length = 1; length < response.length; ++length) {
+        XCTAssertNil([YKFCBORDecoder decodeObjectFromData:[response subdataWithRange:NSMakeRange(0, length)]]);
+    }
+    XCTAssertNotNil([YKFCBORDecoder decodeObjectFromData:response]);
+}
+
+#pragma mark - Performance Tests
+
+- (void)decodeFromStream:(NSData *)data {
+    NSInputStream *inputStream = [NSInputStream inputStreamWithData:data];
+    [inputStream open];
+    XCTAssertNotNil([YKFCBORDecoder decodeObjectFrom:inputStream]);
+    [inputStream close];
+}
+
+- (void)testStreamDecodingPerformance_MakeCredential {
+    NSData *response = [YKFFIDO2ResponseFixtures makeCredentialResponse];
+    [self measureBlock:^{
+        for (int i = 0; i < 1000; ++i) {
+            [self decodeFromStream:response];
+        }
+    }];
+}
+
+- (void)testDataDecodingPerformance_MakeCredential {
+    NSData *response = [YKFFIDO2ResponseFixtures makeCredentialResponse];
+    [self measureBlock:^{
+        for (int i = 0; i < 1000; ++i) {
+            XCTAssertNotNil([YKFCBORDecoder decodeObjectFromData:response]);
+        }
+    }];
+}
+
+- (void)testStreamDecodingPerformance_GetInfo {
+    NSData *response = [YKFFIDO2ResponseFixtures getInfoResponse];
+    [self measureBlock:^{
+        for (int i = 0; i < 1000; ++i) {
+            [self decodeFromStream:response];
+        }
+    }];
+}
+
+- (void)testDataDecodingPerformance_GetInfo {
+    NSData *response = [YKFFIDO2ResponseFixtures getInfoResponse];
+    [self measureBlock:^{
+        for (int i = 0; i < 1000; ++i) {
+            XCTAssertNotNil([YKFCBORDecoder decodeObjectFromData:response]);
+        }
+    }];
+}
+
 @end
@@ -15,6 +15,9 @@
 #import <XCTest/XCTest.h>
 #import "YKFTestCase.h"
 #import "YKFCBOREncoder.h"
+#import "YKFFIDO2GetAssertionAPDU.h"
+#import "YKFFIDO2Type.h"
+#import "YKFAPDU+Private.h"
 
 @interface YKFCBOREncoderTests: YKFTestCase
 @end
@@ -208,4 +211,139 @@
     XCTAssert([falseEncoded isEqualToData:[NSData dataWithBytes:(UInt8[]){0xF4} length:1]]);
 }
 
+#pragma mark - Canonical Order Tests
+
+- (void)testMapKeysSortingWithMixedKeyTypes {
+    // 1 and -1 encode in 1 byte, 100 and "a" in 2 bytes and "aa" in 3 bytes.
+    NSDictionary *testMap = @{YKFCBORTextString(@"aa"): YKFCBORInteger(1),
+                              YKFCBORTextString(@"a"): YKFCBORBool(NO),
+                              YKFCBORInteger(100): YKFCBORBool(YES),
+                              YKFCBORInteger(-1): YKFCBORInteger(0),
+                              YKFCBORInteger(1): YKFCBORArray(@[])};
+    
+    NSData *encodedData = [YKFCBOREncoder encodeMap:YKFCBORMap(testMap)];
+    
+    NSData *expectedData = [NSData dataFromHexString:@"a5018020001864f56161f462616101"];
+    XCTAssertEqualObjects(encodedData, expectedData);
+}
+
+- (void)testCoseKeySorting {
+    NSData *coordinate = [NSData dataWithBytes:@[@(0x01), @(0x02)]];
+    NSDictionary *coseKey = @{YKFCBORInteger(1): YKFCBORInteger(2),
+                              YKFCBORInteger(-1): YKFCBORInteger(1),
+                              YKFCBORInteger(-2): YKFCBORByteString(coordinate),
+                              YKFCBORInteger(-3): YKFCBORByteString(coordinate)};
+    
+    NSData *encodedData = [YKFCBOREncoder encodeMap:YKFCBORMap(coseKey)];
+    
+    NSData *expectedData = [NSData dataFromHexString:@"a4010220012142010222420102"];
+    XCTAssertEqualObjects(encodedData, expectedData);
+}
+
+#pragma mark - Writer Tests
+
+- (void)testWriterSortsNestedMapsAndLargeContainers {
+    YKFCBORWriter writer;
+    YKFCBORWriterInit(&writer, 0);
+    YKFCBORWriterBeginMap(&writer);
+    for (NSInteger key = 24; key >= 0; --key) {
+        YKFCBORWriterAppendInteger(&writer, key);
+        YKFCBORWriterBeginMap(&writer);
+        YKFCBORWriterAppendTextString(&writer, "b", 1);
+        YKFCBORWriterAppendInteger(&writer, -key);
+        YKFCBORWriterAppendTextString(&writer, "a", 1);
+        YKFCBORWriterAppendInteger(&writer, key);
+        YKFCBORWriterEnd(&writer);
+    }
+    YKFCBORWriterEnd(&writer);
+    NSData *encodedData = [YKFCBOREncoder dataWithWriter:&writer];
+    
+    NSMutableDictionary *expectedMap = [[NSMutableDictionary alloc] init];
+    for (NSInteger key = 0; key <= 24; ++key) {
+        expectedMap[YKFCBORInteger(key)] = YKFCBORMap((@{YKFCBORTextString(@"a"): YKFCBORInteger(key),
+                                                         YKFCBORTextString(@"b"): YKFCBORInteger(-key)}));
+    }
+    XCTAssertEqualObjects(encodedData, [YKFCBOREncoder encodeMap:YKFCBORMap(expectedMap)]);
+    
+    // 25 pairs need a 2 bytes head, and the first key is 0 after sorting.
+    const UInt8 *bytes = encodedData.bytes;
+    XCTAssertEqual(bytes[0], 0xB8);
+    XCTAssertEqual(bytes[1], 25);
+    XCTAssertEqual(bytes[2], 0x00);
+}
+
+- (void)testWriterFailsOnInvalidStructure {
+    YKFCBORWriter writer;
+    
+    // Duplicate keys.
+    YKFCBORWriterInit(&writer, 0);
+    YKFCBORWriterBeginMap(&writer);
+    YKFCBORWriterAppendInteger(&writer, 1);
+    YKFCBORWriterAppendBool(&writer, YES);
+    YKFCBORWriterAppendInteger(&writer, 1);
+    YKFCBORWriterAppendBool(&writer, NO);
+    YKFCBORWriterEnd(&writer);
+    XCTAssertNil([YKFCBOREncoder dataWithWriter:&writer]);
+    
+    // Key without value.
+    YKFCBORWriterInit(&writer, 0);
+    YKFCBORWriterBeginMap(&writer);
+    YKFCBORWriterAppendInteger(&writer, 1);
+    XCTAssertFalse(YKFCBORWriterEnd(&writer));
+    XCTAssertNil([YKFCBOREncoder dataWithWriter:&writer]);
+    
+    // Container not closed.
+    YKFCBORWriterInit(&writer, 0);
+    YKFCBORWriterBeginArray(&writer);
+    XCTAssertNil([YKFCBOREncoder dataWithWriter:&writer]);
+    
+    // Unknown object type.
+    YKFCBORWriterInit(&writer, 0);
+    XCTAssertFalse([YKFCBOREncoder writeObject:@(1) toWriter:&writer]);
+    XCTAssertNil([YKFCBOREncoder dataWithWriter:&writer]);
+}
+
+#pragma mark - FIDO2 Request Tests
+
+- (void)testGetAssertionRequestEncoding {
+    NSMutableData *clientDataHash = [[NSMutableData alloc] initWithLength:32];
+    memset(clientDataHash.mutableBytes, 0x01, clientDataHash.length);
+    NSMutableData *pinAuth = [[NSMutableData alloc] initWithLength:16];
+    memset(pinAuth.mutableBytes, 0x02, pinAuth.length);
+    
+    YKFFIDO2PublicKeyCredentialType *credentialType = [[YKFFIDO2PublicKeyCredentialType alloc] init];
+    credentialType.name = @"public-key";
+    YKFFIDO2PublicKeyCredentialDescriptor *descriptor = [[YKFFIDO2PublicKeyCredentialDescriptor alloc] init];
+    descriptor.credentialId = [NSData dataFromHexString:@"000102030405060708090a0b0c0d0e0f"];
+    descriptor.credentialType = credentialType;
+    
+    YKFFIDO2GetAssertionAPDU *apdu = [[YKFFIDO2GetAssertionAPDU alloc] initWithClientDataHash:clientDataHash
+                                                                                         rpId:@"example.com"
+                                                                                    allowList:@[descriptor]
+                                                                                      pinAuth:pinAuth
+                                                                                  pinProtocol:1
+                                                                                      options:@{@"uv": @(YES), @"up": @(NO)}];
+    
+    NSString *expectedHex = @"02a6016b6578616d706c652e636f6d025820010101010101010101010101010101010101010101010101010101"
+                            @"01010101010381a262696450000102030405060708090a0b0c0d0e0f64747970656a7075626c69632d6b657905"
+                            @"a2627570f4627576f50650020202020202020202020202020202020701";
+    XCTAssertEqualObjects(apdu.commandData, [NSData dataFromHexString:expectedHex]);
+}
+
+#pragma mark - Performance Tests
+
+- (void)testMapEncodingPerformance {
+    NSMutableDictionary *map = [[NSMutableDictionary alloc] init];
+    for (NSInteger key = 0; key < 16; ++key) {
+        map[YKFCBORInteger(key)] = YKFCBORMap((@{YKFCBORTextString(@"id"): YKFCBORByteString([[NSMutableData alloc] initWithLength:64]),
+                                                 YKFCBORTextString(@"type"): YKFCBORTextString(@"public-key")}));
+    }
+    YKFCBORMap *cborMap = YKFCBORMap(map);
+    [self measureBlock:^{
+        for (int i = 0; i < 1000; ++i) {
+            [YKFCBOREncoder encodeMap:cborMap];
+        }
+    }];
+}
+
 @end
@@ -0,0 +1,35 @@
+// Copyright 2018-2021 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*
+ CTAP2 responses with the structure and the sizes of the responses of a YubiKey 5, used to test and to measure
+ the CBOR decoding. The keys, the signature and the certificate are placeholder bytes.
+ */
+@interface YKFFIDO2ResponseFixtures: NSObject
+
+/// authenticatorGetInfo response of a YubiKey 5 with firmware 5.2.
++ (NSData *)getInfoResponse;
+
+/// authenticatorMakeCredential response with a packed attestation and a 750 bytes attestation certificate.
++ (NSData *)makeCredentialResponse;
+
++ (NSData *)getAssertionResponse;
+
+@end
+
+NS_ASSUME_NONNULL_END
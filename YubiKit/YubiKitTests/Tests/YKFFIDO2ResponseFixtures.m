@@ -0,0 +1,59 @@
+// Copyright 2018-2021 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import "YKFFIDO2ResponseFixtures.h"
+#import "YKFTestCase.h"
+
+@implementation YKFFIDO2ResponseFixtures
+
++ (NSData *)getInfoResponse {
+    return [NSData dataFromHexString:
+            @"a80183665532465f5632684649444f5f325f306c4649444f5f325f315f50524502826b6372656450726f746563746b686d61632d73656372"
+            @"65740350ee882879721c491397753dfcce97072a04a562726bf5627570f564706c6174f469636c69656e7450696ef57563726564656e7469"
+            @"616c4d676d7450726576696577f5051904b00681010708081880"];
+}
+
++ (NSData *)makeCredentialResponse {
+    return [NSData dataFromHexString:
+            @"a301667061636b65640258c4a379a6f6eeafb9a55e378c118034e2751e682fab9f2d30ab13d2125586ce19474500000017ee882879721c49"
+            @"1397753dfcce97072a004055d91a3561684b32df5e58a0d91968b93798af4f924bba383e1c98625ec0c834a20af38fa0757979fc7cb69f2e"
+            @"d82abd9915af0bc36dbc51db2bcc92d016dde0a50102032620012158202d711642b726b04401627ca9fbac32f5c8530fb1903cc4db022587"
+            @"17921a4881225820a1fce4363854ff888cff4b8e7875d600c2682390412a8cf79b37d0b11148b0fa03a363616c6726637369675847304502"
+            @"20454349e422f05297191ead13e21d3db520e5abef52055e4964b82fb213f593a1022100043a718774c572bd8a25adbeb1bfcd5c0256ae11"
+            @"cecf9f9c3f925d0e52beaf8963783563815902ee308202ea06298432e8066b29e2223bcc23aa9504b56ae508fabf3435508869b9c3190e22"
+            @"4723da12c95ec8cc6ebbd1629553938b6d03b29e826f8a55d473f674976e6d3e66fabc9093d6c9f9668b8a61ec1043ff9557a8715aca7407"
+            @"22fc982775b60c8653fd6a22e8668f6ffb3ebf5bffff0cc3793a1065a4fe76511883e9457015f2782b3ddb07eb5ab54749ab405f262cf330"
+            @"5aad929fcb9418e9ba46333842223ff2bf24c7593e993d9f50db9e4711dd7fdee5de37e00e67926ebcccbc389ed8f3fd5f2749890c5ce729"
+            @"5b4b960db32dad2e40c204ca40a440104dda490697b306d2159479fb8a16583831e46ce6c31fb64383c6f1e38a70d1e586d776c77811e9fa"
+            @"6314db6ef6de9d49cf847386776d6fd2556213bdf2eed1b72fc9e2e4feb7a1a29021c46fde9be41b7b450415fd9c92adec6bb780a697cdd3"
+            @"5b01adde77f73c0e677196d28ff379b554df9b139e1a1e0731d2fe1a10b6fcb9762c13d7afd4b01545086c5e2083e0336fa2c877565b699f"
+            @"c22cac8fd1103e3fcaeb28d7cf2afe6dbf3a82fbda9dbd457534bee9c1fdedf5f95926ad36ae7d8906d612f0bd3a84cd5cf33459da782345"
+            @"6a9c3cc284fe03245fafe542263d2491dc43c85cc2786f75f70c10738dee5fe2eb3ae7e4944255493e1c796d3015a462dc9eb302244301a8"
+            @"5a184ab45396796863fada192f29f3bf2adc235821dbea523a640c55d989321021e3d9203cef908f7c318ba7b2ec02b056055830f40f516c"
+            @"800843915e25a4bfc8f9800ff00309450c0bceba92b1f88f52659720cb6b1991974b7017f41fcca480bff57f23b41e04ad168ee0873ed0fb"
+            @"c0fc140c9e9af32d2aee3d189f311e6faa1e3e969fbd8a18b1c7715a75e6b03a5589e81160262857605d7fab26d2d771ec3455a6e90447d1"
+            @"1b0146d038f89f7765f47f25b794ff2434918e95b2463f46c2744bac8f62a22075c06b3221318a3ae2f3e50102af2664347bc8485a0f6602"
+            @"3d609b34dfb2b6a056e1d17e7be9f944802da920175a4308d6a17dfa753ae1f0f9a7b88aa0596ffa46a5"];
+}
+
++ (NSData *)getAssertionResponse {
+    return [NSData dataFromHexString:
+            @"a501a2626964584055d91a3561684b32df5e58a0d91968b93798af4f924bba383e1c98625ec0c834a20af38fa0757979fc7cb69f2ed82abd"
+            @"9915af0bc36dbc51db2bcc92d016dde064747970656a7075626c69632d6b6579025825a379a6f6eeafb9a55e378c118034e2751e682fab9f"
+            @"2d30ab13d2125586ce1947050000001803584730450220454349e422f05297191ead13e21d3db520e5abef52055e4964b82fb213f593a102"
+            @"2100043a718774c572bd8a25adbeb1bfcd5c0256ae11cecf9f9c3f925d0e52beaf8904a362696447757365722d6964646e616d65706a6f68"
+            @"6e406578616d706c652e636f6d6b646973706c61794e616d65644a6f686e0502"];
+}
+
+@end
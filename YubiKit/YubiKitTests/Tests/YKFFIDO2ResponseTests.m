@@ -0,0 +1,149 @@
+// Copyright 2018-2021 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <XCTest/XCTest.h>
+
+#import "YKFTestCase.h"
+#import "YKFFIDO2ResponseFixtures.h"
+#import "YKFFIDO2MakeCredentialResponse+Private.h"
+#import "YKFFIDO2GetAssertionResponse+Private.h"
+#import "YKFFIDO2GetInfoResponse+Private.h"
+#import "YKFCBORMapView.h"
+#import "YKFCBORDecoder.h"
+
+@interface YKFFIDO2ResponseTests: YKFTestCase
+@end
+
+@implementation YKFFIDO2ResponseTests
+
+#pragma mark - Helpers
+
+- (BOOL)data:(NSData *)data referencesBytesOf:(NSData *)buffer {
+    const UInt8 *bytes = buffer.bytes;
+    return data.bytes >= (const void *)bytes && (const UInt8 *)data.bytes + data.length <= bytes + buffer.length;
+}
+
+#pragma mark - Make Credential
+
+- (void)test_WhenParsingMakeCredentialResponse_FieldsReferenceTheResponse {
+    NSData *response = [YKFFIDO2ResponseFixtures makeCredentialResponse];
+    YKFFIDO2MakeCredentialResponse *makeCredentialResponse = [[YKFFIDO2MakeCredentialResponse alloc] initWithCBORData:response];
+    
+    XCTAssertEqualObjects(makeCredentialResponse.fmt, @"packed");
+    XCTAssertEqual(makeCredentialResponse.authData.length, 196);
+    XCTAssertTrue([self data:makeCredentialResponse.authData referencesBytesOf:makeCredentialResponse.rawResponse]);
+    XCTAssertTrue([self data:makeCredentialResponse.attStmt referencesBytesOf:makeCredentialResponse.rawResponse]);
+    XCTAssertEqual(makeCredentialResponse.authenticatorData.credentialId.length, 64);
+    
+    NSDictionary *attStmt = [YKFCBORDecoder convertCBORObjectToFoundationType:[YKFCBORDecoder decodeObjectFromData:makeCredentialResponse.attStmt]];
+    XCTAssertEqualObjects(attStmt[@"alg"], @(-7));
+    XCTAssertEqual(((NSArray *)attStmt[@"x5c"]).count, 1);
+}
+
+- (void)test_WhenParsingMakeCredentialResponse_WebAuthnAttestationObjectHasTextKeys {
+    NSData *response = [YKFFIDO2ResponseFixtures makeCredentialResponse];
+    YKFFIDO2MakeCredentialResponse *makeCredentialResponse = [[YKFFIDO2MakeCredentialResponse alloc] initWithCBORData:response];
+    NSData *attestationObject = makeCredentialResponse.webauthnAttestationObject;
+    
+    // The 3 integer keys of 1 byte are replaced by "fmt", "attStmt" and "authData", in the canonical order.
+    XCTAssertEqual(attestationObject.length, response.length - 3 + 4 + 8 + 9);
+    XCTAssertEqualObjects([attestationObject subdataWithRange:NSMakeRange(0, 5)], [NSData dataFromHexString:@"a363666d74"]);
+    
+    NSDictionary *ctapObject = [YKFCBORDecoder convertCBORObjectToFoundationType:[YKFCBORDecoder decodeObjectFromData:response]];
+    NSDictionary *webauthnObject = [YKFCBORDecoder convertCBORObjectToFoundationType:[YKFCBORDecoder decodeObjectFromData:attestationObject]];
+    XCTAssertEqualObjects(webauthnObject[@"fmt"], ctapObject[@(1)]);
+    XCTAssertEqualObjects(webauthnObject[@"authData"], ctapObject[@(2)]);
+    XCTAssertEqualObjects(webauthnObject[@"attStmt"], ctapObject[@(3)]);
+}
+
+#pragma mark - Get Assertion
+
+- (void)test_WhenParsingGetAssertionResponse_OptionalStructuresAreDecoded {
+    NSData *response = [YKFFIDO2ResponseFixtures getAssertionResponse];
+    YKFFIDO2GetAssertionResponse *getAssertionResponse = [[YKFFIDO2GetAssertionResponse alloc] initWithCBORData:response];
+    
+    XCTAssertEqual(getAssertionResponse.authData.length, 37);
+    XCTAssertEqual(getAssertionResponse.signature.length, 71);
+    XCTAssertEqual(getAssertionResponse.numberOfCredentials, 2);
+    
+    XCTAssertEqual(getAssertionResponse.credential.credentialId.length, 64);
+    XCTAssertEqualObjects(getAssertionResponse.credential.credentialType.name, @"public-key");
+    
+    XCTAssertEqualObjects(getAssertionResponse.user.userId, [@"user-id" dataUsingEncoding:NSUTF8StringEncoding]);
+    XCTAssertEqualObjects(getAssertionResponse.user.userName, @"john@example.com");
+    XCTAssertEqualObjects(getAssertionResponse.user.userDisplayName, @"John");
+    XCTAssertNil(getAssertionResponse.user.userIcon);
+    
+    // The structures are decoded once.
+    XCTAssertEqual(getAssertionResponse.user, getAssertionResponse.user);
+}
+
+#pragma mark - Get Info
+
+- (void)test_WhenParsingGetInfoResponse_AllFieldsAreRead {
+    NSData *response = [YKFFIDO2ResponseFixtures getInfoResponse];
+    YKFFIDO2GetInfoResponse *getInfoResponse = [[YKFFIDO2GetInfoResponse alloc] initWithCBORData:response];
+    
+    XCTAssertEqualObjects(getInfoResponse.versions, (@[@"U2F_V2", @"FIDO_2_0", @"FIDO_2_1_PRE"]));
+    XCTAssertEqualObjects(getInfoResponse.extensions, (@[@"credProtect", @"hmac-secret"]));
+    XCTAssertEqualObjects(getInfoResponse.aaguid, [NSData dataFromHexString:@"ee882879721c491397753dfcce97072a"]);
+    XCTAssertEqualObjects(getInfoResponse.options[@"clientPin"], @(YES));
+    XCTAssertEqualObjects(getInfoResponse.options[@"plat"], @(NO));
+    XCTAssertEqual(getInfoResponse.maxMsgSize, 1200);
+    XCTAssertEqualObjects(getInfoResponse.pinProtocols, @[@(1)]);
+}
+
+#pragma mark - Map View
+
+- (void)test_WhenMapIsMalformed_ViewIsNil {
+    NSData *response = [YKFFIDO2ResponseFixtures makeCredentialResponse];
+    for (NSUInteger length = 1; length < response.length; ++length) {
+        XCTAssertNil([[YKFCBORMapView alloc] initWithData:[response subdataWithRange:NSMakeRange(0, length)]]);
+    }
+    
+    NSArray *malformedData = @[[NSData dataFromHexString:@"a201020103"],   // duplicated key
+                               [NSData dataFromHexString:@"8101"],         // not a map
+                               [NSData dataFromHexString:@"a1010200"]];    // trailing bytes
+    for (NSData *data in malformedData) {
+        XCTAssertNil([[YKFCBORMapView alloc] initWithData:data], @"%@", data);
+    }
+}
+
+- (void)test_WhenValueHasAnotherType_TypedGetterReturnsNil {
+    YKFCBORMapView *view = [[YKFCBORMapView alloc] initWithData:[YKFFIDO2ResponseFixtures getInfoResponse]];
+    
+    XCTAssertNil([view byteStringForKey:1]);
+    XCTAssertNil([view textStringForKey:3]);
+    XCTAssertNil([view integerForKey:4]);
+    XCTAssertNil([view encodedValueForKey:9]);
+    XCTAssertEqualObjects([view integerForKey:5], @(1200));
+    XCTAssertEqualObjects([view encodedValueForKey:6], [NSData dataFromHexString:@"8101"]);
+    XCTAssertTrue([view containsArrayForKey:1]);
+    XCTAssertFalse([view containsArrayForKey:4]);
+    XCTAssertFalse([view containsArrayForKey:9]);
+}
+
+#pragma mark - Performance
+
+- (void)test_MakeCredentialResponseParsingPerformance {
+    NSData *response = [YKFFIDO2ResponseFixtures makeCredentialResponse];
+    [self measureBlock:^{
+        for (int i = 0; i < 1000; ++i) {
+            YKFFIDO2MakeCredentialResponse *makeCredentialResponse = [[YKFFIDO2MakeCredentialResponse alloc] initWithCBORData:response];
+            XCTAssertNotNil(makeCredentialResponse.webauthnAttestationObject);
+        }
+    }];
+}
+
+@end
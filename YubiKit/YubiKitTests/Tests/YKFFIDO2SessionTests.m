@@ -0,0 +1,176 @@
+// Copyright 2018-2021 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <XCTest/XCTest.h>
+
+#import "YKFTestCase.h"
+#import "YKFFIDO2Session.h"
+#import "YKFFIDO2Session+Private.h"
+#import "YKFFIDO2PinAuthKey.h"
+#import "YKFFIDO2ClientPinRequest.h"
+#import "YKFFIDO2CommandAPDU.h"
+#import "YKFFIDO2Error.h"
+#import "YKFCBOREncoder.h"
+#import "YKFCBORDecoder.h"
+#import "YKFAPDU+Private.h"
+#import "FakeYKFConnectionController.h"
+
+@interface YKFFIDO2SessionTests: YKFTestCase
+
+@property (nonatomic) FakeYKFConnectionController *keyConnectionController;
+@property (nonatomic) YKFFIDO2Session *session;
+
+// The key agreement key of the fake authenticator.
+@property (nonatomic) YKFFIDO2PinAuthKey *authenticatorKey;
+
+@end
+
+@implementation YKFFIDO2SessionTests
+
+- (void)setUp {
+    [super setUp];
+    self.keyConnectionController = [[FakeYKFConnectionController alloc] init];
+    // The ECDH of the key agreement is not allowed on the main thread.
+    self.keyConnectionController.responseQueue = dispatch_queue_create("com.yubico.tests.fido2", DISPATCH_QUEUE_SERIAL);
+    self.authenticatorKey = [[YKFFIDO2PinAuthKey alloc] init];
+}
+
+#pragma mark - Helpers
+
+- (NSData *)okResponse {
+    return [NSData dataWithBytes:@[@(0x90), @(0x00)]];
+}
+
+- (NSData *)responseWithStatus:(UInt8)status map:(NSDictionary *)map {
+    NSMutableData *response = [[NSMutableData alloc] initWithBytes:&status length:1];
+    if (map) {
+        [response appendData:[YKFCBOREncoder encodeMap:YKFCBORMap(map)]];
+    }
+    [response appendData:[self okResponse]];
+    return response;
+}
+
+- (NSData *)keyAgreementResponse {
+    return [self responseWithStatus:YKFFIDO2ErrorCodeSUCCESS map:@{YKFCBORInteger(1): self.authenticatorKey.cosePublicKey}];
+}
+
+- (NSData *)pinTokenResponse {
+    // The token is not encrypted with the shared secret, the session decrypts it to another token of the same length.
+    NSData *pinToken = [NSData dataWithBytes:@[@(0x01), @(0x02), @(0x03), @(0x04), @(0x05), @(0x06), @(0x07), @(0x08),
+                                               @(0x09), @(0x0a), @(0x0b), @(0x0c), @(0x0d), @(0x0e), @(0x0f), @(0x10)]];
+    return [self responseWithStatus:YKFFIDO2ErrorCodeSUCCESS map:@{YKFCBORInteger(2): YKFCBORByteString(pinToken)}];
+}
+
+- (void)waitForExpectation:(XCTestExpectation *)expectation {
+    XCTWaiterResult result = [XCTWaiter waitForExpectations:@[expectation] timeout:10];
+    XCTAssert(result == XCTWaiterResultCompleted, @"");
+}
+
+- (void)openSession {
+    self.keyConnectionController.commandExecutionResponseDataSequence = @[[self okResponse]];
+    XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"FIDO2"];
+
+    [YKFFIDO2Session sessionWithConnectionController:self.keyConnectionController completion:^(YKFFIDO2Session * _Nullable session, NSError * _Nullable error) {
+        XCTAssertNil(error, @"Unexpected error: %@", error);
+        self.session = session;
+        [expectation fulfill];
+    }];
+
+    [self waitForExpectation:expectation];
+}
+
+- (void)verifyPinWithResponses:(NSArray<NSData *> *)responses {
+    self.keyConnectionController.commandExecutionResponseDataSequence = responses;
+    XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"FIDO2"];
+
+    [self.session verifyPin:@"123456" completion:^(NSError * _Nullable error) {
+        XCTAssertNil(error, @"Unexpected error: %@", error);
+        [expectation fulfill];
+    }];
+
+    [self waitForExpectation:expectation];
+}
+
+/*
+ The ClientPIN subcommands sent to the key, after the application selection.
+ */
+- (NSArray<NSNumber *> *)clientPinSubCommands {
+    NSMutableArray<NSNumber *> *subCommands = [[NSMutableArray alloc] init];
+    NSArray<YKFAPDU *> *commands = self.keyConnectionController.executedCommands;
+    for (NSUInteger i = 1; i < commands.count; ++i) {
+        NSData *commandData = commands[i].commandData;
+        if (commandData.length < 2 || ((UInt8 *)commandData.bytes)[0] != YKFFIDO2CommandClientPIN) {
+            [subCommands addObject:@(0)];
+            continue;
+        }
+        id map = [YKFCBORDecoder decodeObjectFromData:[commandData subdataWithRange:NSMakeRange(1, commandData.length - 1)]];
+        NSDictionary *request = [YKFCBORDecoder convertCBORObjectToFoundationType:map];
+        [subCommands addObject:request[@2] ?: @(0)];
+    }
+    return subCommands;
+}
+
+#pragma mark - Key Agreement Tests
+
+- (void)test_WhenVerifyingPinAgain_KeyAgreementIsReused {
+    [self openSession];
+
+    [self verifyPinWithResponses:@[[self keyAgreementResponse], [self pinTokenResponse]]];
+    [self verifyPinWithResponses:@[[self pinTokenResponse]]];
+
+    NSArray *expectedSubCommands = @[@(YKFFIDO2ClientPinRequestSubCommandGetKeyAgreement),
+                                     @(YKFFIDO2ClientPinRequestSubCommandGetPINToken),
+                                     @(YKFFIDO2ClientPinRequestSubCommandGetPINToken)];
+    XCTAssertEqualObjects([self clientPinSubCommands], expectedSubCommands);
+}
+
+- (void)test_WhenRequestFailsWithPinAuthInvalid_KeyAgreementIsDropped {
+    [self openSession];
+    [self verifyPinWithResponses:@[[self keyAgreementResponse], [self pinTokenResponse]]];
+
+    self.keyConnectionController.commandExecutionResponseDataSequence = @[[self responseWithStatus:YKFFIDO2ErrorCodePIN_AUTH_INVALID map:nil]];
+    XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"FIDO2"];
+    [self.session getInfoWithCompletion:^(YKFFIDO2GetInfoResponse * _Nullable response, NSError * _Nullable error) {
+        XCTAssertEqual(error.code, YKFFIDO2ErrorCodePIN_AUTH_INVALID);
+        [expectation fulfill];
+    }];
+    [self waitForExpectation:expectation];
+
+    // The authenticator may have a new key agreement key, it's requested again.
+    [self verifyPinWithResponses:@[[self keyAgreementResponse], [self pinTokenResponse]]];
+
+    NSArray *expectedSubCommands = @[@(YKFFIDO2ClientPinRequestSubCommandGetKeyAgreement),
+                                     @(YKFFIDO2ClientPinRequestSubCommandGetPINToken),
+                                     @(0),
+                                     @(YKFFIDO2ClientPinRequestSubCommandGetKeyAgreement),
+                                     @(YKFFIDO2ClientPinRequestSubCommandGetPINToken)];
+    XCTAssertEqualObjects([self clientPinSubCommands], expectedSubCommands);
+}
+
+- (void)test_WhenSessionStateIsCleared_NoPlatformKeyIsPrepared {
+    [self openSession];
+    // Wait for the platform key prepared in the background when the session is opened.
+    XCTNSPredicateExpectation *preparedExpectation = [[XCTNSPredicateExpectation alloc] initWithPredicate:[NSPredicate predicateWithFormat:@"preparedPlatformKey != nil"] object:self.session];
+    [self waitForExpectation:preparedExpectation];
+    [self verifyPinWithResponses:@[[self keyAgreementResponse], [self pinTokenResponse]]];
+
+    [self.session clearSessionState];
+
+    // The preparation would run in the background, it's given time to complete.
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.5]];
+    XCTAssertNil([self.session valueForKey:@"keyAgreement"]);
+    XCTAssertNil([self.session valueForKey:@"preparedPlatformKey"]);
+}
+
+@end
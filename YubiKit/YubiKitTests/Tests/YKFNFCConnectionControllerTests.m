@@ -0,0 +1,174 @@
+// Copyright 2018-2019 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <XCTest/XCTest.h>
+
+#import "YKFTestCase.h"
+#import "YKFNFCConnectionController.h"
+#import "FakeNFCISO7816Tag.h"
+#import "YKFAPDU+Private.h"
+#import "YKFSessionError.h"
+
+API_AVAILABLE(ios(13.0))
+@interface YKFNFCConnectionControllerTests: YKFTestCase
+
+@property (nonatomic) NSOperationQueue *operationQueue;
+@property (nonatomic) dispatch_queue_t sharedDispatchQueue;
+
+@property (nonatomic) FakeNFCISO7816Tag *tag;
+@property (nonatomic) YKFNFCConnectionController *connectionController;
+
+@end
+
+@implementation YKFNFCConnectionControllerTests
+
+- (void)setUp {
+    [super setUp];
+    
+    self.operationQueue = [[NSOperationQueue alloc] init];
+    self.operationQueue.maxConcurrentOperationCount = 1;
+    
+    dispatch_queue_attr_t dispatchQueueAttributes = dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, DISPATCH_QUEUE_PRIORITY_HIGH, -1);
+    self.sharedDispatchQueue = dispatch_queue_create("com.yubico.YKCOMNFC", dispatchQueueAttributes);
+    
+    self.operationQueue.underlyingQueue = self.sharedDispatchQueue;
+    
+    self.tag = [[FakeNFCISO7816Tag alloc] init];
+    self.connectionController = [[YKFNFCConnectionController alloc] initWithNFCTag:self.tag operationQueue:self.operationQueue];
+}
+
+- (void)tearDown {
+    [super tearDown];
+    self.connectionController = nil;
+    self.tag = nil;
+    self.operationQueue = nil;
+    self.sharedDispatchQueue = nil;
+}
+
+#pragma mark - Tests
+
+- (void)test_WhenCommandsHaveVariableLatency_ResponsesAreReceivedInOrder {
+    self.tag.responseLatencies = @[@(0.3), @(0.01), @(0.2), @(0), @(0.1)];
+    
+    NSMutableArray<NSNumber *> *receivedInstructions = [[NSMutableArray alloc] init];
+    XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"Commands execution completion."];
+    expectation.expectedFulfillmentCount = 5;
+    
+    for (UInt8 ins = 1; ins <= 5; ++ins) {
+        [self.connectionController execute:[self commandWithInstruction:ins] completion:^(NSData *result, NSError *error, NSTimeInterval executionTime) {
+            XCTAssertNil(error);
+            XCTAssertEqual(result.length, 3);
+            
+            UInt8 *bytes = (UInt8 *)result.bytes;
+            XCTAssertEqual(bytes[1], 0x90);
+            XCTAssertEqual(bytes[2], 0x00);
+            
+            [receivedInstructions addObject:@(bytes[0])];
+            [expectation fulfill];
+        }];
+    }
+    
+    XCTWaiterResult result = [XCTWaiter waitForExpectations:@[expectation] timeout:2];
+    XCTAssert(result == XCTWaiterResultCompleted);
+    
+    NSArray *expectedInstructions = @[@(1), @(2), @(3), @(4), @(5)];
+    XCTAssertEqualObjects(receivedInstructions, expectedInstructions);
+    XCTAssertEqual(self.tag.sentCommands.count, 5);
+}
+
+- (void)test_WhenCommandTimesOut_ErrorIsReturnedAndNextCommandIsExecuted {
+    self.tag.responseLatencies = @[@(0.5), @(0)];
+    
+    XCTestExpectation *timeoutExpectation = [[XCTestExpectation alloc] initWithDescription:@"Timed out command completion."];
+    [self.connectionController execute:[self commandWithInstruction:0x01] timeout:0.1 completion:^(NSData *result, NSError *error, NSTimeInterval executionTime) {
+        XCTAssertNil(result);
+        XCTAssertEqual(error.code, YKFSessionErrorReadTimeoutCode);
+        [timeoutExpectation fulfill];
+    }];
+    
+    XCTestExpectation *nextExpectation = [[XCTestExpectation alloc] initWithDescription:@"Next command completion."];
+    [self.connectionController execute:[self commandWithInstruction:0x02] completion:^(NSData *result, NSError *error, NSTimeInterval executionTime) {
+        XCTAssertNil(error);
+        XCTAssertEqual(((UInt8 *)result.bytes)[0], 0x02);
+        [nextExpectation fulfill];
+    }];
+    
+    XCTWaiterResult result = [XCTWaiter waitForExpectations:@[timeoutExpectation, nextExpectation] timeout:0.4 enforceOrder:YES];
+    XCTAssert(result == XCTWaiterResultCompleted);
+    
+    // The late response of the first command must not be delivered to the second one.
+    [self waitForTimeInterval:0.6];
+}
+
+- (void)test_WhenCommandIsInFlight_CommunicationQueueIsNotBlocked {
+    self.tag.responseLatencies = @[@(0.5)];
+    
+    XCTestExpectation *commandExpectation = [[XCTestExpectation alloc] initWithDescription:@"Command execution completion."];
+    [self.connectionController execute:[self commandWithInstruction:0x01] completion:^(NSData *result, NSError *error, NSTimeInterval executionTime) {
+        [commandExpectation fulfill];
+    }];
+    
+    // The dispatch queue runs other work while the tag processes the command.
+    XCTestExpectation *queueExpectation = [[XCTestExpectation alloc] initWithDescription:@"Dispatch queue is available."];
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.1 * NSEC_PER_SEC)), self.sharedDispatchQueue, ^{
+        [queueExpectation fulfill];
+    });
+    
+    XCTWaiterResult result = [XCTWaiter waitForExpectations:@[queueExpectation, commandExpectation] timeout:1 enforceOrder:YES];
+    XCTAssert(result == XCTWaiterResultCompleted);
+}
+
+- (void)test_WhenTagIsNotAvailable_CommandFailsWithConnectionLost {
+    self.tag.available = NO;
+    
+    XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"Command execution completion."];
+    [self.connectionController execute:[self commandWithInstruction:0x01] completion:^(NSData *result, NSError *error, NSTimeInterval executionTime) {
+        XCTAssertNil(result);
+        XCTAssertEqual(error.code, YKFSessionErrorConnectionLost);
+        [expectation fulfill];
+    }];
+    
+    XCTWaiterResult result = [XCTWaiter waitForExpectations:@[expectation] timeout:1];
+    XCTAssert(result == XCTWaiterResultCompleted);
+    XCTAssertEqual(self.tag.sentCommands.count, 0);
+}
+
+- (void)test_WhenCommandsAreCanceled_InFlightCommandReleasesTheQueue {
+    self.tag.responseLatencies = @[@(0.5), @(0)];
+    
+    [self.connectionController execute:[self commandWithInstruction:0x01] completion:^(NSData *result, NSError *error, NSTimeInterval executionTime) {
+        XCTFail(@"Canceled command must not notify the caller.");
+    }];
+    [self waitForTimeInterval:0.1];
+    [self.connectionController cancelAllCommands];
+    
+    XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"Command execution completion."];
+    [self.connectionController execute:[self commandWithInstruction:0x02] completion:^(NSData *result, NSError *error, NSTimeInterval executionTime) {
+        XCTAssertNil(error);
+        [expectation fulfill];
+    }];
+    
+    XCTWaiterResult result = [XCTWaiter waitForExpectations:@[expectation] timeout:0.3];
+    XCTAssert(result == XCTWaiterResultCompleted);
+    
+    [self waitForTimeInterval:0.5];
+}
+
+#pragma mark - Helpers
+
+- (YKFAPDU *)commandWithInstruction:(UInt8)ins {
+    return [[YKFAPDU alloc] initWithCla:0x00 ins:ins p1:0x00 p2:0x00 data:[NSData data] type:YKFAPDUTypeShort];
+}
+
+@end
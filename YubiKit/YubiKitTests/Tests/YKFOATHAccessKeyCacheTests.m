@@ -0,0 +1,120 @@
+// Copyright 2018-2020 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <XCTest/XCTest.h>
+
+#import "YKFTestCase.h"
+#import "YKFOATHAccessKeyCache.h"
+#import "YKFOATHSession.h"
+#import "YKFOATHUnlockAPDU.h"
+#import "YKFAPDU+Private.h"
+#import "YKFNSDataAdditions+Private.h"
+
+@interface YKFOATHAccessKeyCacheTests: YKFTestCase
+@end
+
+@implementation YKFOATHAccessKeyCacheTests
+
+- (NSData *)salt {
+    return [NSData dataWithBytes:@[@(0x01), @(0x02), @(0x03), @(0x04), @(0x05), @(0x06), @(0x07), @(0x08)]];
+}
+
+- (void)test_WhenAccessKeyIsStored_KeyIsReturnedForTheSamePassword {
+    YKFOATHAccessKeyCache *cache = [[YKFOATHAccessKeyCache alloc] initWithTimeToLive:60];
+    NSData *accessKey = [[@"password" dataUsingEncoding:NSUTF8StringEncoding] ykf_deriveOATHKeyWithSalt:self.salt];
+
+    [cache storeAccessKey:accessKey forPassword:@"password" salt:self.salt];
+
+    XCTAssertEqualObjects([cache accessKeyForPassword:@"password" salt:self.salt], accessKey);
+    XCTAssertNil([cache accessKeyForPassword:@"other password" salt:self.salt]);
+
+    NSData *otherSalt = [NSData dataWithBytes:@[@(0x08), @(0x07), @(0x06), @(0x05), @(0x04), @(0x03), @(0x02), @(0x01)]];
+    XCTAssertNil([cache accessKeyForPassword:@"password" salt:otherSalt]);
+}
+
+- (void)test_WhenDerivingAccessKeyWithoutSession_KeyIsDerivedFromTheSalt {
+    NSData *accessKey = [[@"password" dataUsingEncoding:NSUTF8StringEncoding] ykf_deriveOATHKeyWithSalt:self.salt];
+
+    XCTAssertEqualObjects([YKFOATHSession deriveAccessKeyWithPassword:@"password" salt:self.salt], accessKey);
+    XCTAssertNil([YKFOATHSession deriveAccessKeyWithPassword:@"password" salt:[NSData data]]);
+}
+
+- (void)test_WhenTimeToLiveExpires_KeyIsRemoved {
+    YKFOATHAccessKeyCache *cache = [[YKFOATHAccessKeyCache alloc] initWithTimeToLive:0.1];
+    NSData *accessKey = [[@"password" dataUsingEncoding:NSUTF8StringEncoding] ykf_deriveOATHKeyWithSalt:self.salt];
+
+    [cache storeAccessKey:accessKey forPassword:@"password" salt:self.salt];
+    [self waitForTimeInterval:0.2];
+
+    XCTAssertNil([cache accessKeyForPassword:@"password" salt:self.salt]);
+}
+
+- (void)test_WhenKeyIsRemovedOrCacheIsCleared_KeyIsNotReturned {
+    YKFOATHAccessKeyCache *cache = [[YKFOATHAccessKeyCache alloc] initWithTimeToLive:60];
+    NSData *accessKey = [[@"password" dataUsingEncoding:NSUTF8StringEncoding] ykf_deriveOATHKeyWithSalt:self.salt];
+
+    [cache storeAccessKey:accessKey forPassword:@"password" salt:self.salt];
+    [cache removeAccessKeyForSalt:self.salt];
+    XCTAssertNil([cache accessKeyForPassword:@"password" salt:self.salt]);
+
+    [cache storeAccessKey:accessKey forPassword:@"password" salt:self.salt];
+    [cache clear];
+    XCTAssertNil([cache accessKeyForPassword:@"password" salt:self.salt]);
+}
+
+- (void)test_WhenReturnedKeyIsKept_KeyIsNotZeroizedByRemoval {
+    YKFOATHAccessKeyCache *cache = [[YKFOATHAccessKeyCache alloc] initWithTimeToLive:60];
+    NSData *accessKey = [[@"password" dataUsingEncoding:NSUTF8StringEncoding] ykf_deriveOATHKeyWithSalt:self.salt];
+
+    [cache storeAccessKey:accessKey forPassword:@"password" salt:self.salt];
+    NSData *cachedKey = [cache accessKeyForPassword:@"password" salt:self.salt];
+    [cache clear];
+
+    XCTAssertEqualObjects(cachedKey, accessKey);
+}
+
+- (void)test_WhenUnlockingWithAccessKey_ResponseMatchesUnlockWithPassword {
+    NSData *challenge = [NSData dataWithBytes:@[@(0x11), @(0x22), @(0x33), @(0x44), @(0x55), @(0x66), @(0x77), @(0x88)]];
+    NSData *accessKey = [[@"password" dataUsingEncoding:NSUTF8StringEncoding] ykf_deriveOATHKeyWithSalt:self.salt];
+
+    YKFOATHUnlockAPDU *passwordAPDU = [[YKFOATHUnlockAPDU alloc] initWithPassword:@"password" challenge:challenge salt:self.salt];
+    YKFOATHUnlockAPDU *accessKeyAPDU = [[YKFOATHUnlockAPDU alloc] initWithAccessKey:accessKey challenge:challenge];
+
+    // Tag, length and HMAC of the challenge. The rest of the data is a random challenge.
+    NSRange responseRange = NSMakeRange(0, 2 + 20);
+    XCTAssertEqualObjects([passwordAPDU.commandData subdataWithRange:responseRange], [accessKeyAPDU.commandData subdataWithRange:responseRange]);
+}
+
+- (void)test_AccessKeyDerivationPerformance {
+    NSData *passwordData = [@"password" dataUsingEncoding:NSUTF8StringEncoding];
+    [self measureBlock:^{
+        for (int i = 0; i < 10; ++i) {
+            XCTAssertEqual([passwordData ykf_deriveOATHKeyWithSalt:self.salt].length, 16);
+        }
+    }];
+}
+
+- (void)test_CachedAccessKeyLookupPerformance {
+    YKFOATHAccessKeyCache *cache = [[YKFOATHAccessKeyCache alloc] initWithTimeToLive:60];
+    NSData *accessKey = [[@"password" dataUsingEncoding:NSUTF8StringEncoding] ykf_deriveOATHKeyWithSalt:self.salt];
+    [cache storeAccessKey:accessKey forPassword:@"password" salt:self.salt];
+
+    [self measureBlock:^{
+        for (int i = 0; i < 10; ++i) {
+            XCTAssertNotNil([cache accessKeyForPassword:@"password" salt:self.salt]);
+        }
+    }];
+}
+
+@end
@@ -0,0 +1,173 @@
+// Copyright 2018-2020 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <XCTest/XCTest.h>
+
+#import "YKFTestCase.h"
+#import "YKFOATHCalculateAllResponse.h"
+#import "YKFOATHCredential.h"
+#import "YKFOATHCredential+Private.h"
+#import "YKFOATHCredentialWithCode.h"
+#import "YKFOATHCode.h"
+
+@interface YKFOATHCalculateAllResponseTests: YKFTestCase
+@end
+
+@implementation YKFOATHCalculateAllResponseTests
+
+#pragma mark - Helpers
+
+- (void)appendName:(NSString *)name toData:(NSMutableData *)data {
+    NSData *nameData = [name dataUsingEncoding:NSUTF8StringEncoding];
+    UInt8 header[] = {0x71, (UInt8)nameData.length};
+    [data appendBytes:header length:sizeof(header)];
+    [data appendData:nameData];
+}
+
+- (void)appendTruncatedCode:(UInt32)value toData:(NSMutableData *)data {
+    UInt8 header[] = {0x76, 0x05, 0x06};
+    [data appendBytes:header length:sizeof(header)];
+    UInt32 bigEndianValue = CFSwapInt32HostToBig(value);
+    [data appendBytes:&bigEndianValue length:sizeof(UInt32)];
+}
+
+- (void)appendEmptyResponseWithTag:(UInt8)tag toData:(NSMutableData *)data {
+    UInt8 response[] = {tag, 0x01, 0x06};
+    [data appendBytes:response length:sizeof(response)];
+}
+
+- (NSData *)responseDataWithCredentialsCount:(NSUInteger)count {
+    NSMutableData *data = [[NSMutableData alloc] init];
+    for (NSUInteger i = 0; i < count; ++i) {
+        NSString *name = i % 4 == 0 ? [NSString stringWithFormat:@"60/Issuer %lu:account%lu@example.com", (unsigned long)i, (unsigned long)i]
+                                    : [NSString stringWithFormat:@"Issuer %lu:account%lu@example.com", (unsigned long)i, (unsigned long)i];
+        [self appendName:name toData:data];
+        [self appendTruncatedCode:(UInt32)(0x01234567 + i) toData:data];
+    }
+    return data;
+}
+
+#pragma mark - Parsing
+
+- (void)test_WhenResponseContainsTOTPCredentials_CredentialsAndCodesAreParsed {
+    NSMutableData *data = [[NSMutableData alloc] init];
+    [self appendName:@"Yubico:account@example.com" toData:data];
+    [self appendTruncatedCode:0x01234567 toData:data];
+    [self appendName:@"60/Yubico:demo:account@example.com" toData:data];
+    [self appendTruncatedCode:0x81234567 toData:data];
+
+    NSDate *timestamp = [NSDate dateWithTimeIntervalSince1970:1000025];
+    YKFOATHCalculateAllResponse *response = [[YKFOATHCalculateAllResponse alloc] initWithKeyResponseData:data requestTimetamp:timestamp];
+    XCTAssertEqual(response.credentials.count, 2);
+
+    YKFOATHCredentialWithCode *first = response.credentials[0];
+    XCTAssertEqual(first.credential.type, YKFOATHCredentialTypeTOTP);
+    XCTAssertEqual(first.credential.period, 30);
+    XCTAssertEqualObjects(first.credential.issuer, @"Yubico");
+    XCTAssertEqualObjects(first.credential.accountName, @"account@example.com");
+    XCTAssertEqualObjects(first.credential.key, @"Yubico:account@example.com");
+    XCTAssertEqualObjects(first.code.otp, @"088743");
+    XCTAssertEqualObjects(first.code.validity.startDate, [NSDate dateWithTimeIntervalSince1970:1000020]);
+    XCTAssertEqual(first.code.validity.duration, 30);
+
+    YKFOATHCredentialWithCode *second = response.credentials[1];
+    XCTAssertEqual(second.credential.period, 60);
+    XCTAssertEqualObjects(second.credential.issuer, @"Yubico:demo");
+    XCTAssertEqualObjects(second.credential.accountName, @"account@example.com");
+    XCTAssertEqualObjects(second.credential.key, @"60/Yubico:demo:account@example.com");
+    XCTAssertEqualObjects(second.code.otp, @"088743"); // sign bit removed
+    XCTAssertEqualObjects(second.code.validity.startDate, [NSDate dateWithTimeIntervalSince1970:1000020]);
+    XCTAssertEqual(second.code.validity.duration, 60);
+}
+
+- (void)test_WhenResponseContainsHOTPAndTouchCredentials_CodesAreEmpty {
+    NSMutableData *data = [[NSMutableData alloc] init];
+    [self appendName:@"account@example.com" toData:data];
+    [self appendEmptyResponseWithTag:0x77 toData:data];
+    [self appendName:@"15/Yubico:touch" toData:data];
+    [self appendEmptyResponseWithTag:0x7C toData:data];
+
+    YKFOATHCalculateAllResponse *response = [[YKFOATHCalculateAllResponse alloc] initWithKeyResponseData:data requestTimetamp:[NSDate date]];
+    XCTAssertEqual(response.credentials.count, 2);
+
+    YKFOATHCredentialWithCode *hotp = response.credentials[0];
+    XCTAssertEqual(hotp.credential.type, YKFOATHCredentialTypeHOTP);
+    XCTAssertEqual(hotp.credential.period, 0);
+    XCTAssertNil(hotp.credential.issuer);
+    XCTAssertEqualObjects(hotp.credential.accountName, @"account@example.com");
+    XCTAssertNil(hotp.code.otp);
+
+    YKFOATHCredentialWithCode *touch = response.credentials[1];
+    XCTAssertEqual(touch.credential.type, YKFOATHCredentialTypeTOTP);
+    XCTAssertEqual(touch.credential.period, 15);
+    XCTAssertTrue(touch.credential.requiresTouch);
+    XCTAssertEqualObjects(touch.credential.issuer, @"Yubico");
+    XCTAssertEqualObjects(touch.credential.accountName, @"touch");
+    XCTAssertNil(touch.code.otp);
+    XCTAssertEqualObjects(touch.code.validity.endDate, [NSDate distantFuture]);
+}
+
+- (void)test_WhenNameContainsSlashWithoutPeriod_LabelIsNotSplit {
+    NSMutableData *data = [[NSMutableData alloc] init];
+    [self appendName:@"Yubico/demo:account" toData:data];
+    [self appendTruncatedCode:1 toData:data];
+    [self appendName:@"Ÿubico:äccount" toData:data];
+    [self appendTruncatedCode:1 toData:data];
+
+    YKFOATHCalculateAllResponse *response = [[YKFOATHCalculateAllResponse alloc] initWithKeyResponseData:data requestTimetamp:[NSDate date]];
+    XCTAssertEqual(response.credentials[0].credential.period, 30);
+    XCTAssertEqualObjects(response.credentials[0].credential.issuer, @"Yubico/demo");
+    XCTAssertEqualObjects(response.credentials[0].credential.accountName, @"account");
+    XCTAssertEqualObjects(response.credentials[1].credential.issuer, @"Ÿubico");
+    XCTAssertEqualObjects(response.credentials[1].credential.accountName, @"äccount");
+}
+
+- (void)test_WhenIssuerIsReplaced_ParsedIssuerIsNotUsed {
+    NSMutableData *data = [[NSMutableData alloc] init];
+    [self appendName:@"Yubico:account" toData:data];
+    [self appendTruncatedCode:1 toData:data];
+
+    YKFOATHCalculateAllResponse *response = [[YKFOATHCalculateAllResponse alloc] initWithKeyResponseData:data requestTimetamp:[NSDate date]];
+    YKFOATHCredential *credential = response.credentials.firstObject.credential;
+    credential.issuer = nil;
+    XCTAssertNil(credential.issuer);
+}
+
+#pragma mark - Performance
+
+- (void)test_CalculateAllParsingPerformance_32Credentials {
+    [self measureParsingWithCredentialsCount:32];
+}
+
+- (void)test_CalculateAllParsingPerformance_64Credentials {
+    [self measureParsingWithCredentialsCount:64];
+}
+
+- (void)test_CalculateAllParsingPerformance_128Credentials {
+    [self measureParsingWithCredentialsCount:128];
+}
+
+- (void)measureParsingWithCredentialsCount:(NSUInteger)count {
+    NSData *data = [self responseDataWithCredentialsCount:count];
+    NSDate *timestamp = [NSDate date];
+
+    [self measureBlock:^{
+        for (int i = 0; i < 100; ++i) {
+            YKFOATHCalculateAllResponse *response = [[YKFOATHCalculateAllResponse alloc] initWithKeyResponseData:data requestTimetamp:timestamp];
+            XCTAssertEqual(response.credentials.count, count);
+        }
+    }];
+}
+
+@end
@@ -0,0 +1,184 @@
+// Copyright 2018-2020 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <XCTest/XCTest.h>
+
+#import "YKFTestCase.h"
+#import "YKFOATHCodeCache.h"
+#import "YKFOATHCredential.h"
+#import "YKFOATHCredential+Private.h"
+#import "YKFOATHCredentialWithCode.h"
+#import "YKFOATHCode.h"
+#import "YKFOATHCode+Private.h"
+
+@interface YKFOATHCodeCacheTests: YKFTestCase
+@end
+
+@implementation YKFOATHCodeCacheTests
+
+#pragma mark - Helpers
+
+- (YKFOATHCredential *)credentialWithKey:(NSString *)key type:(YKFOATHCredentialType)type period:(NSUInteger)period {
+    YKFOATHCredential *credential = [[YKFOATHCredential alloc] init];
+    credential.key = key;
+    credential.type = type;
+    credential.period = period;
+    credential.accountName = key;
+    return credential;
+}
+
+- (YKFOATHCredentialWithCode *)entryWithCredential:(YKFOATHCredential *)credential otp:(NSString *)otp timestamp:(NSDate *)timestamp {
+    NSDateInterval *validity;
+    if (credential.type == YKFOATHCredentialTypeTOTP && otp) {
+        NSUInteger seconds = timestamp.timeIntervalSince1970;
+        NSDate *startDate = [NSDate dateWithTimeIntervalSince1970:seconds - seconds % credential.period];
+        validity = [[NSDateInterval alloc] initWithStartDate:startDate duration:credential.period];
+    } else {
+        validity = [[NSDateInterval alloc] initWithStartDate:timestamp endDate:[NSDate distantFuture]];
+    }
+    YKFOATHCode *code = [[YKFOATHCode alloc] initWithOtp:otp validity:validity];
+    return [[YKFOATHCredentialWithCode alloc] initWithCredential:credential code:code];
+}
+
+#pragma mark - Tests
+
+- (void)test_WhenCacheIsEmpty_CalculateAllIsRequired {
+    YKFOATHCodeCache *cache = [[YKFOATHCodeCache alloc] init];
+
+    XCTAssertTrue([cache requiresCalculateAllAtDate:[NSDate date]]);
+    XCTAssertNil(cache.credentialsWithCodes);
+    XCTAssertNil(cache.nextExpirationDate);
+}
+
+- (void)test_WhenDefaultPeriodCodesAreValid_CodesAreServedFromCache {
+    YKFOATHCodeCache *cache = [[YKFOATHCodeCache alloc] init];
+    NSDate *timestamp = [NSDate dateWithTimeIntervalSince1970:1000020]; // 1000020 % 30 == 0
+
+    YKFOATHCredential *totp = [self credentialWithKey:@"totp" type:YKFOATHCredentialTypeTOTP period:30];
+    YKFOATHCredential *hotp = [self credentialWithKey:@"hotp" type:YKFOATHCredentialTypeHOTP period:0];
+    [cache updateWithCalculateAllResult:@[[self entryWithCredential:totp otp:@"123456" timestamp:timestamp],
+                                          [self entryWithCredential:hotp otp:nil timestamp:timestamp]] period:30];
+
+    XCTAssertFalse([cache requiresCalculateAllAtDate:[timestamp dateByAddingTimeInterval:29]]);
+    XCTAssertTrue([cache requiresCalculateAllAtDate:[timestamp dateByAddingTimeInterval:30]]);
+    XCTAssertEqualObjects(cache.nextExpirationDate, [timestamp dateByAddingTimeInterval:30]);
+
+    NSArray<YKFOATHCredentialWithCode *> *credentials = cache.credentialsWithCodes;
+    XCTAssertEqual(credentials.count, 2);
+    XCTAssertEqualObjects(credentials[0].credential.key, @"totp");
+    XCTAssertEqualObjects(credentials[0].code.otp, @"123456");
+    XCTAssertEqualObjects(credentials[1].credential.key, @"hotp");
+}
+
+- (void)test_WhenCustomPeriodCodeExpires_CredentialRequiresCalculation {
+    YKFOATHCodeCache *cache = [[YKFOATHCodeCache alloc] init];
+    NSDate *timestamp = [NSDate dateWithTimeIntervalSince1970:1000020];
+
+    YKFOATHCredential *totp = [self credentialWithKey:@"totp" type:YKFOATHCredentialTypeTOTP period:30];
+    YKFOATHCredential *totp60 = [self credentialWithKey:@"60/totp" type:YKFOATHCredentialTypeTOTP period:60];
+    [cache updateWithCalculateAllResult:@[[self entryWithCredential:totp otp:@"123456" timestamp:timestamp],
+                                          [self entryWithCredential:totp60 otp:@"111111" timestamp:timestamp]] period:30];
+
+    XCTAssertEqual([cache credentialsRequiringCalculationAtDate:timestamp].count, 0);
+
+    // 1000020 % 60 == 0, so the window of the 60 seconds code ends after 60 seconds.
+    NSDate *nextWindow = [timestamp dateByAddingTimeInterval:60];
+    XCTAssertEqual([cache credentialsRequiringCalculationAtDate:[timestamp dateByAddingTimeInterval:59]].count, 0);
+    NSArray *expired = [cache credentialsRequiringCalculationAtDate:nextWindow];
+    XCTAssertEqual(expired.count, 1);
+    XCTAssertEqual(expired.firstObject, totp60);
+
+    [cache updateCode:[self entryWithCredential:totp60 otp:@"222222" timestamp:nextWindow].code forCredential:totp60];
+    XCTAssertEqual([cache credentialsRequiringCalculationAtDate:nextWindow].count, 0);
+
+    NSArray<YKFOATHCredentialWithCode *> *credentials = cache.credentialsWithCodes;
+    XCTAssertEqualObjects(credentials[0].code.otp, @"123456");
+    XCTAssertEqualObjects(credentials[1].code.otp, @"222222");
+}
+
+- (void)test_WhenOnlyCustomPeriodCodeExpires_CalculateAllIsNotRequired {
+    YKFOATHCodeCache *cache = [[YKFOATHCodeCache alloc] init];
+    NSDate *timestamp = [NSDate dateWithTimeIntervalSince1970:1000020];
+
+    YKFOATHCredential *totp15 = [self credentialWithKey:@"15/totp" type:YKFOATHCredentialTypeTOTP period:15];
+    [cache updateWithCalculateAllResult:@[[self entryWithCredential:totp15 otp:@"111111" timestamp:timestamp]] period:30];
+
+    NSDate *later = [timestamp dateByAddingTimeInterval:15];
+    XCTAssertFalse([cache requiresCalculateAllAtDate:later]);
+    XCTAssertEqual([cache credentialsRequiringCalculationAtDate:later].count, 1);
+    XCTAssertEqualObjects(cache.nextExpirationDate, later);
+}
+
+- (void)test_WhenCalculateAllUsesCustomPeriod_CodesWithThatPeriodRequireCalculateAll {
+    YKFOATHCodeCache *cache = [[YKFOATHCodeCache alloc] init];
+    NSDate *timestamp = [NSDate dateWithTimeIntervalSince1970:1000020];
+
+    YKFOATHCredential *totp = [self credentialWithKey:@"totp" type:YKFOATHCredentialTypeTOTP period:30];
+    YKFOATHCredential *totp15 = [self credentialWithKey:@"15/totp" type:YKFOATHCredentialTypeTOTP period:15];
+    [cache updateWithCalculateAllResult:@[[self entryWithCredential:totp otp:@"123456" timestamp:timestamp],
+                                          [self entryWithCredential:totp15 otp:@"111111" timestamp:timestamp]] period:15];
+    XCTAssertEqual(cache.calculateAllPeriod, 15);
+
+    // The 15 seconds codes come from the Calculate All, the 30 seconds code is calculated individually.
+    NSDate *later = [timestamp dateByAddingTimeInterval:15];
+    XCTAssertTrue([cache requiresCalculateAllAtDate:later]);
+    XCTAssertEqual([cache credentialsRequiringCalculationAtDate:later].count, 0);
+
+    NSDate *nextWindow = [timestamp dateByAddingTimeInterval:30];
+    NSArray *expired = [cache credentialsRequiringCalculationAtDate:nextWindow];
+    XCTAssertEqual(expired.count, 1);
+    XCTAssertEqual(expired.firstObject, totp);
+
+    [cache invalidate];
+    XCTAssertEqual(cache.calculateAllPeriod, 30);
+}
+
+- (void)test_WhenCodeRequiresTouch_CodeDoesNotExpire {
+    YKFOATHCodeCache *cache = [[YKFOATHCodeCache alloc] init];
+    NSDate *timestamp = [NSDate dateWithTimeIntervalSince1970:1000020];
+
+    YKFOATHCredential *touch = [self credentialWithKey:@"60/touch" type:YKFOATHCredentialTypeTOTP period:60];
+    touch.requiresTouch = YES;
+    [cache updateWithCalculateAllResult:@[[self entryWithCredential:touch otp:nil timestamp:timestamp]] period:30];
+
+    NSDate *later = [timestamp dateByAddingTimeInterval:3600];
+    XCTAssertFalse([cache requiresCalculateAllAtDate:later]);
+    XCTAssertEqual([cache credentialsRequiringCalculationAtDate:later].count, 0);
+    XCTAssertNil(cache.nextExpirationDate);
+}
+
+- (void)test_WhenCacheIsInvalidated_CalculateAllIsRequired {
+    YKFOATHCodeCache *cache = [[YKFOATHCodeCache alloc] init];
+    NSDate *timestamp = [NSDate dateWithTimeIntervalSince1970:1000020];
+
+    YKFOATHCredential *totp = [self credentialWithKey:@"totp" type:YKFOATHCredentialTypeTOTP period:30];
+    [cache updateWithCalculateAllResult:@[[self entryWithCredential:totp otp:@"123456" timestamp:timestamp]] period:30];
+    XCTAssertFalse([cache requiresCalculateAllAtDate:timestamp]);
+
+    [cache invalidate];
+    XCTAssertTrue([cache requiresCalculateAllAtDate:timestamp]);
+    XCTAssertNil(cache.credentialsWithCodes);
+}
+
+- (void)test_WhenCodeIsUpdatedForUnknownCredential_CodeIsIgnored {
+    YKFOATHCodeCache *cache = [[YKFOATHCodeCache alloc] init];
+    NSDate *timestamp = [NSDate dateWithTimeIntervalSince1970:1000020];
+
+    YKFOATHCredential *totp60 = [self credentialWithKey:@"60/totp" type:YKFOATHCredentialTypeTOTP period:60];
+    [cache updateCode:[self entryWithCredential:totp60 otp:@"222222" timestamp:timestamp].code forCredential:totp60];
+
+    XCTAssertNil(cache.credentialsWithCodes);
+}
+
+@end
@@ -0,0 +1,142 @@
+// Copyright 2018-2020 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <XCTest/XCTest.h>
+
+#import "YKFTestCase.h"
+#import "YKFOATHCredentialIndex.h"
+#import "YKFOATHCredentialsDelta.h"
+#import "YKFOATHCredential.h"
+#import "YKFOATHCredential+Private.h"
+#import "YKFOATHCredentialWithCode.h"
+#import "YKFOATHCode.h"
+#import "YKFOATHCode+Private.h"
+
+@interface YKFOATHCredentialIndexTests: YKFTestCase
+@end
+
+@implementation YKFOATHCredentialIndexTests
+
+#pragma mark - Helpers
+
+- (YKFOATHCredentialWithCode *)entryWithKey:(NSString *)key otp:(NSString *)otp {
+    YKFOATHCredential *credential = [[YKFOATHCredential alloc] init];
+    credential.key = key;
+    credential.type = YKFOATHCredentialTypeTOTP;
+    credential.period = 30;
+    credential.accountName = key;
+
+    NSDateInterval *validity = [[NSDateInterval alloc] initWithStartDate:[NSDate dateWithTimeIntervalSince1970:1000020] duration:30];
+    YKFOATHCode *code = [[YKFOATHCode alloc] initWithOtp:otp validity:validity];
+    return [[YKFOATHCredentialWithCode alloc] initWithCredential:credential code:code];
+}
+
+#pragma mark - Tests
+
+- (void)test_WhenIndexIsEmpty_AllCredentialsAreAdded {
+    YKFOATHCredentialIndex *index = [[YKFOATHCredentialIndex alloc] init];
+    NSArray *credentials = @[[self entryWithKey:@"a" otp:@"111111"], [self entryWithKey:@"b" otp:@"222222"]];
+
+    YKFOATHCredentialsDelta *delta = [index updateWithCredentials:credentials];
+
+    XCTAssertTrue(delta.hasChanges);
+    XCTAssertEqualObjects(delta.added, credentials);
+    XCTAssertEqualObjects(delta.credentials, credentials);
+    XCTAssertEqual(delta.removed.count, 0);
+}
+
+- (void)test_WhenNothingChanges_PreviousObjectsAreReturned {
+    YKFOATHCredentialIndex *index = [[YKFOATHCredentialIndex alloc] init];
+    YKFOATHCredentialsDelta *first = [index updateWithCredentials:@[[self entryWithKey:@"a" otp:@"111111"]]];
+
+    YKFOATHCredentialsDelta *second = [index updateWithCredentials:@[[self entryWithKey:@"a" otp:@"111111"]]];
+
+    XCTAssertFalse(second.hasChanges);
+    XCTAssertEqual(second.credentials.firstObject, first.credentials.firstObject);
+}
+
+- (void)test_WhenCodeChanges_CredentialIdentityIsKept {
+    YKFOATHCredentialIndex *index = [[YKFOATHCredentialIndex alloc] init];
+    YKFOATHCredentialsDelta *first = [index updateWithCredentials:@[[self entryWithKey:@"a" otp:@"111111"], [self entryWithKey:@"b" otp:@"222222"]]];
+
+    YKFOATHCredentialsDelta *second = [index updateWithCredentials:@[[self entryWithKey:@"a" otp:@"333333"], [self entryWithKey:@"b" otp:@"222222"]]];
+
+    XCTAssertEqual(second.codeChanged.count, 1);
+    XCTAssertEqualObjects(second.codeChanged.firstObject.code.otp, @"333333");
+    XCTAssertEqual(second.codeChanged.firstObject.credential, first.credentials[0].credential);
+    XCTAssertEqual(second.credentials[1], first.credentials[1]);
+    XCTAssertEqual(second.added.count, 0);
+    XCTAssertEqual(second.removed.count, 0);
+}
+
+- (void)test_WhenCredentialsAreAddedAndRemoved_DeltaContainsThem {
+    YKFOATHCredentialIndex *index = [[YKFOATHCredentialIndex alloc] init];
+    YKFOATHCredentialsDelta *first = [index updateWithCredentials:@[[self entryWithKey:@"a" otp:@"111111"], [self entryWithKey:@"b" otp:@"222222"]]];
+
+    YKFOATHCredentialWithCode *added = [self entryWithKey:@"c" otp:@"333333"];
+    YKFOATHCredentialsDelta *second = [index updateWithCredentials:@[[self entryWithKey:@"a" otp:@"111111"], added]];
+
+    XCTAssertEqualObjects(second.added, @[added]);
+    XCTAssertEqual(second.removed.count, 1);
+    XCTAssertEqual(second.removed.firstObject, first.credentials[1].credential);
+}
+
+- (void)test_WhenCredentialIsRenamed_RenameIsReported {
+    YKFOATHCredentialIndex *index = [[YKFOATHCredentialIndex alloc] init];
+    YKFOATHCredentialsDelta *first = [index updateWithCredentials:@[[self entryWithKey:@"Issuer:a" otp:@"111111"]]];
+
+    [index recordRenameFromKey:@"Issuer:a" toKey:@"Issuer:b"];
+    YKFOATHCredentialsDelta *second = [index updateWithCredentials:@[[self entryWithKey:@"Issuer:b" otp:@"111111"]]];
+
+    XCTAssertEqual(second.renamed.count, 1);
+    XCTAssertEqual(second.renamed.firstObject.previousCredential, first.credentials.firstObject.credential);
+    XCTAssertEqualObjects(second.renamed.firstObject.credential.credential.key, @"Issuer:b");
+    XCTAssertEqual(second.added.count, 0);
+    XCTAssertEqual(second.removed.count, 0);
+}
+
+- (void)test_WhenCredentialsAreListed_StaleCodesAreCleared {
+    YKFOATHCredentialIndex *index = [[YKFOATHCredentialIndex alloc] init];
+    YKFOATHCredentialsDelta *first = [index updateWithCredentials:@[[self entryWithKey:@"a" otp:@"111111"]]];
+
+    YKFOATHCredential *listed = [self entryWithKey:@"a" otp:nil].credential;
+    YKFOATHCredentialsDelta *second = [index updateWithListedCredentials:@[listed]];
+
+    XCTAssertEqual(second.codeChanged.count, 1);
+    XCTAssertEqual(second.credentials.firstObject.credential, first.credentials.firstObject.credential);
+    XCTAssertNil(second.credentials.firstObject.code);
+
+    YKFOATHCredentialsDelta *third = [index updateWithListedCredentials:@[listed]];
+    XCTAssertFalse(third.hasChanges);
+    XCTAssertEqual(third.credentials.firstObject, second.credentials.firstObject);
+}
+
+- (void)test_DiffPerformance_256Credentials {
+    NSMutableArray *credentials = [[NSMutableArray alloc] init];
+    NSMutableArray *refreshedCredentials = [[NSMutableArray alloc] init];
+    for (int i = 0; i < 256; ++i) {
+        NSString *key = [NSString stringWithFormat:@"Issuer %d:account%d@example.com", i, i];
+        [credentials addObject:[self entryWithKey:key otp:@"111111"]];
+        [refreshedCredentials addObject:[self entryWithKey:key otp:i % 2 ? @"111111" : @"222222"]];
+    }
+
+    [self measureBlock:^{
+        YKFOATHCredentialIndex *index = [[YKFOATHCredentialIndex alloc] init];
+        [index updateWithCredentials:credentials];
+        YKFOATHCredentialsDelta *delta = [index updateWithCredentials:refreshedCredentials];
+        XCTAssertEqual(delta.codeChanged.count, 128);
+    }];
+}
+
+@end
@@ -0,0 +1,252 @@
+// Copyright 2018-2021 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <XCTest/XCTest.h>
+
+#import "YKFTestCase.h"
+#import "YKFOATHSession.h"
+#import "YKFOATHSession+Private.h"
+#import "YKFOATHCredential.h"
+#import "YKFOATHCredentialTemplate.h"
+#import "YKFOATHError.h"
+#import "YKFOATHCredentialWithCode.h"
+#import "YKFOATHCode.h"
+#import "YKFOATHCalculateAllAPDU.h"
+#import "YKFAPDU+Private.h"
+#import "YKFAPDUCommandInstruction.h"
+#import "FakeYKFConnectionController.h"
+
+@interface YKFOATHSessionTests: YKFTestCase
+
+@property (nonatomic) FakeYKFConnectionController *keyConnectionController;
+@property (nonatomic) YKFOATHSession *session;
+@property (nonatomic) NSDate *timestamp;
+
+@end
+
+@implementation YKFOATHSessionTests
+
+- (void)setUp {
+    [super setUp];
+    self.keyConnectionController = [[FakeYKFConnectionController alloc] init];
+    self.timestamp = [NSDate dateWithTimeIntervalSince1970:1000020]; // multiple of 15, 30 and 60 seconds
+}
+
+#pragma mark - Helpers
+
+- (NSData *)selectApplicationResponse {
+    // Version 5.4.3 and the select ID, without challenge.
+    return [NSData dataWithBytes:@[@(0x79), @(0x03), @(0x05), @(0x04), @(0x03),
+                                   @(0x71), @(0x08), @(0x01), @(0x02), @(0x03), @(0x04), @(0x05), @(0x06), @(0x07), @(0x08),
+                                   @(0x90), @(0x00)]];
+}
+
+- (NSData *)calculateAllResponseWithNames:(NSArray<NSString *> *)names value:(UInt8)value {
+    NSMutableData *response = [[NSMutableData alloc] init];
+    for (NSString *name in names) {
+        NSData *nameData = [name dataUsingEncoding:NSUTF8StringEncoding];
+        UInt8 nameHeader[] = {0x71, (UInt8)nameData.length};
+        [response appendBytes:nameHeader length:sizeof(nameHeader)];
+        [response appendData:nameData];
+        UInt8 code[] = {0x76, 0x05, 0x06, 0x00, 0x00, 0x00, value};
+        [response appendBytes:code length:sizeof(code)];
+    }
+    UInt8 statusCode[] = {0x90, 0x00};
+    [response appendBytes:statusCode length:sizeof(statusCode)];
+    return response;
+}
+
+- (NSData *)calculateResponseWithValue:(UInt8)value {
+    return [NSData dataWithBytes:@[@(0x76), @(0x05), @(0x06), @(0x00), @(0x00), @(0x00), @(value), @(0x90), @(0x00)]];
+}
+
+- (NSData *)calculateAllAPDUDataWithPeriod:(NSUInteger)period {
+    return [[YKFOATHCalculateAllAPDU alloc] initWithTimestamp:self.timestamp period:period].apduData;
+}
+
+- (YKFOATHCredentialTemplate *)templateWithAccount:(NSString *)account {
+    NSString *url = [NSString stringWithFormat:@"otpauth://totp/ACME:%@?secret=HXDMVJECJJWSRB3HWIZR4IFUGFTMXBOZ&issuer=ACME&algorithm=SHA1&digits=6&period=30", account];
+    return [[YKFOATHCredentialTemplate alloc] initWithURL:[NSURL URLWithString:url]];
+}
+
+/*
+ Opens the session, the key returns the responses after the one to the application selection.
+ */
+- (void)openSessionWithResponses:(NSArray<NSData *> *)responses {
+    self.keyConnectionController.commandExecutionResponseDataSequence = [@[[self selectApplicationResponse]] arrayByAddingObjectsFromArray:responses];
+    XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"OATH"];
+
+    [YKFOATHSession sessionWithConnectionController:self.keyConnectionController completion:^(YKFOATHSession * _Nullable session, NSError * _Nullable error) {
+        XCTAssertNil(error, @"Unexpected error: %@", error);
+        self.session = session;
+        [expectation fulfill];
+    }];
+
+    XCTWaiterResult result = [XCTWaiter waitForExpectations:@[expectation] timeout:10];
+    XCTAssert(result == XCTWaiterResultCompleted, @"");
+}
+
+/*
+ Opens the session and runs the first Calculate All, which lists 15/a, 15/b and totp. The codes of the 15 seconds
+ credentials are calculated in a follow-up batch.
+ */
+- (NSArray<YKFOATHCredentialWithCode *> *)calculateAllOnNewSession {
+    [self openSessionWithResponses:@[[self calculateAllResponseWithNames:@[@"15/a", @"15/b", @"totp"] value:1],
+                                     [self calculateResponseWithValue:2],
+                                     [self calculateResponseWithValue:3]]];
+    XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"OATH"];
+    __block NSArray<YKFOATHCredentialWithCode *> *result = nil;
+
+    [self.session calculateAllWithTimestamp:self.timestamp completion:^(NSArray<YKFOATHCredentialWithCode *> * _Nullable credentials, NSError * _Nullable error) {
+        XCTAssertNil(error, @"Unexpected error: %@", error);
+        result = credentials;
+        [expectation fulfill];
+    }];
+
+    XCTWaiterResult waiterResult = [XCTWaiter waitForExpectations:@[expectation] timeout:10];
+    XCTAssert(waiterResult == XCTWaiterResultCompleted, @"");
+    return result;
+}
+
+#pragma mark - Calculate All Tests
+
+- (void)test_WhenCalculatingAllWithMixedPeriods_CodesOfNewCredentialsAreCalculatedInFollowUpBatch {
+    NSArray<YKFOATHCredentialWithCode *> *credentials = [self calculateAllOnNewSession];
+
+    NSArray<YKFAPDU *> *commands = self.keyConnectionController.executedCommands;
+    XCTAssertEqual(commands.count, 4);
+    XCTAssertEqualObjects(commands[1].apduData, [self calculateAllAPDUDataWithPeriod:30]);
+    XCTAssertEqual(commands[2].ins, YKFAPDUCommandInstructionOATHCalculate);
+    XCTAssertEqual(commands[3].ins, YKFAPDUCommandInstructionOATHCalculate);
+
+    XCTAssertEqual(credentials.count, 3);
+    XCTAssertEqualObjects(credentials[0].credential.key, @"15/a");
+    XCTAssertEqualObjects(credentials[0].code.otp, @"000002");
+    XCTAssertEqualObjects(credentials[1].credential.key, @"15/b");
+    XCTAssertEqualObjects(credentials[1].code.otp, @"000003");
+    XCTAssertEqualObjects(credentials[2].credential.key, @"totp");
+    XCTAssertEqualObjects(credentials[2].code.otp, @"000001");
+}
+
+- (void)test_WhenCalculatingAllAgain_DominantPeriodIsUsedAndCodesAreMerged {
+    [self calculateAllOnNewSession];
+
+    // The key calculates the 30 seconds code with the 15 seconds challenge, it's replaced by the targeted calculation.
+    self.keyConnectionController.commandExecutionResponseDataSequence = @[[self calculateAllResponseWithNames:@[@"15/a", @"15/b", @"totp"] value:4],
+                                                                          [self calculateResponseWithValue:5]];
+    XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"OATH"];
+
+    [self.session calculateAllWithTimestamp:self.timestamp completion:^(NSArray<YKFOATHCredentialWithCode *> * _Nullable credentials, NSError * _Nullable error) {
+        XCTAssertNil(error, @"Unexpected error: %@", error);
+        XCTAssertEqual(credentials.count, 3);
+        XCTAssertEqualObjects(credentials[0].code.otp, @"000004");
+        XCTAssertEqualObjects(credentials[1].code.otp, @"000004");
+        XCTAssertEqualObjects(credentials[2].credential.key, @"totp");
+        XCTAssertEqualObjects(credentials[2].code.otp, @"000005");
+        [expectation fulfill];
+    }];
+
+    XCTWaiterResult result = [XCTWaiter waitForExpectations:@[expectation] timeout:10];
+    XCTAssert(result == XCTWaiterResultCompleted, @"");
+
+    NSArray<YKFAPDU *> *commands = self.keyConnectionController.executedCommands;
+    XCTAssertEqual(commands.count, 6);
+    XCTAssertEqualObjects(commands[4].apduData, [self calculateAllAPDUDataWithPeriod:15]);
+    XCTAssertEqual(commands[5].ins, YKFAPDUCommandInstructionOATHCalculate);
+
+    // The cached codes expire with the period of the Calculate All.
+    XCTAssertEqualObjects(self.session.cachedCodesExpirationDate, [self.timestamp dateByAddingTimeInterval:15]);
+}
+
+- (void)test_WhenCachedCredentialWasRemoved_CalculateAllIsRetriedWithoutCachedCredentials {
+    [self calculateAllOnNewSession];
+
+    // totp was removed from the key: its targeted calculation fails and the Calculate All is sent again.
+    NSData *noSuchObjectResponse = [NSData dataWithBytes:@[@(0x69), @(0x84)]];
+    self.keyConnectionController.commandExecutionResponseDataSequence = @[[self calculateAllResponseWithNames:@[@"15/a", @"15/b"] value:4],
+                                                                          noSuchObjectResponse,
+                                                                          [self calculateAllResponseWithNames:@[@"15/a", @"15/b"] value:6],
+                                                                          [self calculateResponseWithValue:7],
+                                                                          [self calculateResponseWithValue:8]];
+    XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"OATH"];
+
+    [self.session calculateAllWithTimestamp:self.timestamp completion:^(NSArray<YKFOATHCredentialWithCode *> * _Nullable credentials, NSError * _Nullable error) {
+        XCTAssertNil(error, @"Unexpected error: %@", error);
+        XCTAssertEqual(credentials.count, 2);
+        XCTAssertEqualObjects(credentials[0].code.otp, @"000007");
+        XCTAssertEqualObjects(credentials[1].code.otp, @"000008");
+        [expectation fulfill];
+    }];
+
+    XCTWaiterResult result = [XCTWaiter waitForExpectations:@[expectation] timeout:10];
+    XCTAssert(result == XCTWaiterResultCompleted, @"");
+
+    NSArray<YKFAPDU *> *commands = self.keyConnectionController.executedCommands;
+    XCTAssertEqual(commands.count, 9);
+    XCTAssertEqualObjects(commands[4].apduData, [self calculateAllAPDUDataWithPeriod:15]);
+    XCTAssertEqualObjects(commands[6].apduData, [self calculateAllAPDUDataWithPeriod:30]);
+}
+
+#pragma mark - Put Credentials Tests
+
+- (void)test_WhenPuttingCredentialsWithInvalidTemplate_NothingIsSentToTheKey {
+    [self openSessionWithResponses:@[]];
+    NSString *longAccount = @"john_with_too_long_name_which_does_not_really_fit_in_the_key@example.com";
+    NSArray *templates = @[[self templateWithAccount:@"a"], [self templateWithAccount:longAccount], [self templateWithAccount:@"c"]];
+    XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"OATH"];
+
+    [self.session putCredentialTemplates:templates requiresTouch:NO progress:nil completion:^(NSDictionary<NSNumber *, NSError *> * _Nonnull errors, NSError * _Nullable error) {
+        XCTAssertEqual(error.code, YKFOATHErrorCodeNameTooLong);
+        XCTAssertEqual(errors.count, 1);
+        XCTAssertEqual(errors[@(1)].code, YKFOATHErrorCodeNameTooLong);
+        [expectation fulfill];
+    }];
+
+    XCTWaiterResult result = [XCTWaiter waitForExpectations:@[expectation] timeout:10];
+    XCTAssert(result == XCTWaiterResultCompleted, @"");
+    XCTAssertEqual(self.keyConnectionController.executionCommandsCount, 1); // application selection only
+}
+
+- (void)test_WhenPutFailsForSomeCredentials_ErrorsAreKeyedByIndexAndAllCredentialsAreSent {
+    NSData *successResponse = [NSData dataWithBytes:@[@(0x90), @(0x00)]];
+    NSData *noSpaceResponse = [NSData dataWithBytes:@[@(0x6A), @(0x84)]];
+    NSData *wrongDataResponse = [NSData dataWithBytes:@[@(0x6A), @(0x80)]];
+    [self openSessionWithResponses:@[successResponse, noSpaceResponse, successResponse, wrongDataResponse, successResponse]];
+
+    NSArray *templates = @[[self templateWithAccount:@"a"], [self templateWithAccount:@"b"], [self templateWithAccount:@"c"],
+                           [self templateWithAccount:@"d"], [self templateWithAccount:@"e"]];
+    NSMutableArray<NSNumber *> *progressCounts = [[NSMutableArray alloc] init];
+    XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"OATH"];
+
+    [self.session putCredentialTemplates:templates requiresTouch:NO progress:^(NSUInteger completedCount, NSUInteger totalCount) {
+        XCTAssertEqual(totalCount, 5);
+        [progressCounts addObject:@(completedCount)];
+    } completion:^(NSDictionary<NSNumber *, NSError *> * _Nonnull errors, NSError * _Nullable error) {
+        XCTAssertEqual(error.code, 0x6A84);
+        XCTAssertEqual(errors.count, 2);
+        XCTAssertEqual(errors[@(1)].code, 0x6A84);
+        XCTAssertEqual(errors[@(3)].code, 0x6A80);
+        [expectation fulfill];
+    }];
+
+    XCTWaiterResult result = [XCTWaiter waitForExpectations:@[expectation] timeout:10];
+    XCTAssert(result == XCTWaiterResultCompleted, @"");
+    XCTAssertEqual(self.keyConnectionController.executionCommandsCount, 6);
+
+    // The key replies without delay, so the progress is throttled to the first and the last command.
+    NSArray *expectedProgressCounts = @[@(1), @(5)];
+    XCTAssertEqualObjects(progressCounts, expectedProgressCounts);
+}
+
+@end
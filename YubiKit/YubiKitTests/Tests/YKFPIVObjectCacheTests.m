@@ -0,0 +1,69 @@
+// Copyright 2018-2021 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <XCTest/XCTest.h>
+
+#import "YKFTestCase.h"
+#import "YKFPIVObjectCache.h"
+
+@interface YKFPIVObjectCacheTests: YKFTestCase
+@end
+
+@implementation YKFPIVObjectCacheTests
+
+- (void)test_WhenObjectIsStored_ItIsReturnedForTheSameYubiKey {
+    YKFPIVObjectCache *cache = [[YKFPIVObjectCache alloc] initWithValidation:YKFPIVObjectCacheValidationNone];
+    NSData *objectId = [NSData dataWithBytes:@[@(0x5f), @(0xc1), @(0x05)]];
+    NSData *object = [NSData dataWithBytes:@[@(0x53), @(0x01), @(0x00)]];
+
+    [cache storeObject:object withId:objectId serialNumber:1000];
+
+    XCTAssertEqualObjects([cache objectWithId:objectId serialNumber:1000], object);
+    XCTAssertNil([cache objectWithId:objectId serialNumber:2000]);
+    XCTAssertNil([cache objectWithId:[NSData dataWithBytes:@[@(0x5f), @(0xc1), @(0x0a)]] serialNumber:1000]);
+}
+
+- (void)test_WhenObjectIsRemoved_OtherObjectsAreKept {
+    YKFPIVObjectCache *cache = [[YKFPIVObjectCache alloc] initWithValidation:YKFPIVObjectCacheValidationHeader];
+    NSData *authenticationId = [NSData dataWithBytes:@[@(0x5f), @(0xc1), @(0x05)]];
+    NSData *signatureId = [NSData dataWithBytes:@[@(0x5f), @(0xc1), @(0x0a)]];
+    NSData *object = [NSData dataWithBytes:@[@(0x53), @(0x01), @(0x00)]];
+    [cache storeObject:object withId:authenticationId serialNumber:1000];
+    [cache storeObject:object withId:signatureId serialNumber:1000];
+    [cache storeObject:object withId:authenticationId serialNumber:2000];
+
+    [cache removeObjectWithId:authenticationId serialNumber:1000];
+    XCTAssertNil([cache objectWithId:authenticationId serialNumber:1000]);
+    XCTAssertNotNil([cache objectWithId:signatureId serialNumber:1000]);
+
+    [cache removeObjectsForSerialNumber:1000];
+    XCTAssertNil([cache objectWithId:signatureId serialNumber:1000]);
+    XCTAssertNotNil([cache objectWithId:authenticationId serialNumber:2000]);
+
+    [cache clear];
+    XCTAssertNil([cache objectWithId:authenticationId serialNumber:2000]);
+}
+
+- (void)test_WhenStoredDataIsMutated_CachedObjectIsNotChanged {
+    YKFPIVObjectCache *cache = [[YKFPIVObjectCache alloc] initWithValidation:YKFPIVObjectCacheValidationNone];
+    NSData *objectId = [NSData dataWithBytes:@[@(0x5f), @(0xc1), @(0x05)]];
+    NSMutableData *object = [[NSData dataWithBytes:@[@(0x53), @(0x01), @(0x00)]] mutableCopy];
+
+    [cache storeObject:object withId:objectId serialNumber:1000];
+    ((UInt8 *)object.mutableBytes)[2] = 0xff;
+
+    XCTAssertEqualObjects([cache objectWithId:objectId serialNumber:1000], [NSData dataWithBytes:@[@(0x53), @(0x01), @(0x00)]]);
+}
+
+@end
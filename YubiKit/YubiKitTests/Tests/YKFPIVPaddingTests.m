@@ -117,4 +117,144 @@
     XCTAssertNil(result);
 }
 
+- (void)testPadRSAEncryptionIsNotSupported {
+    NSData *data = [@"Hello World!" dataUsingEncoding:NSUTF8StringEncoding];
+    NSArray *algorithms = @[(__bridge id)kSecKeyAlgorithmRSAEncryptionRaw,
+                            (__bridge id)kSecKeyAlgorithmRSAEncryptionPKCS1,
+                            (__bridge id)kSecKeyAlgorithmRSAEncryptionOAEPSHA256];
+    for (id algorithm in algorithms) {
+        NSError *error = nil;
+        NSData *padded = [YKFPIVPadding padData:data keyType:YKFPIVKeyTypeRSA2048 algorithm:(__bridge SecKeyAlgorithm)algorithm error:&error];
+        XCTAssertNil(padded, @"%@", algorithm);
+        XCTAssertNotNil(error, @"%@", algorithm);
+    }
+}
+
+- (void)testPadRSAPKCS1SHA256Data {
+    NSData *data = [@"Hello World!" dataUsingEncoding:NSUTF8StringEncoding];
+    NSError *error = nil;
+    NSData *padded = [YKFPIVPadding padData:data keyType:YKFPIVKeyTypeRSA1024 algorithm:kSecKeyAlgorithmRSASignatureMessagePKCS1v15SHA256 error:&error];
+    NSData *expected = [NSData dataFromHexString:@"0001ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff003031300d0609608648016503040201050004207f83b1657ff1fc53b92dc18148a1d65dfc2d4b1fa3d677284addd200126d9069"];
+    XCTAssert([padded isEqualToData:expected]);
+}
+
+- (void)testPadRSAPKCS1DigestWithWrongSize {
+    NSData *digest = [@"Hello World!" dataUsingEncoding:NSUTF8StringEncoding];
+    NSError *error = nil;
+    NSData *padded = [YKFPIVPadding padData:digest keyType:YKFPIVKeyTypeRSA2048 algorithm:kSecKeyAlgorithmRSASignatureDigestPKCS1v15SHA256 error:&error];
+    XCTAssertNil(padded);
+    XCTAssertNotNil(error);
+}
+
+- (void)testPadRSAPKCS1MatchesSecurityFramework {
+    NSData *data = [@"Hello World!" dataUsingEncoding:NSUTF8StringEncoding];
+    NSArray *algorithms = @[(__bridge id)kSecKeyAlgorithmRSASignatureMessagePKCS1v15SHA1,
+                            (__bridge id)kSecKeyAlgorithmRSASignatureMessagePKCS1v15SHA224,
+                            (__bridge id)kSecKeyAlgorithmRSASignatureMessagePKCS1v15SHA256,
+                            (__bridge id)kSecKeyAlgorithmRSASignatureMessagePKCS1v15SHA384,
+                            (__bridge id)kSecKeyAlgorithmRSASignatureMessagePKCS1v15SHA512,
+                            (__bridge id)kSecKeyAlgorithmRSASignatureDigestPKCS1v15Raw];
+    for (NSNumber *keyType in @[@(YKFPIVKeyTypeRSA1024), @(YKFPIVKeyTypeRSA2048)]) {
+        SecKeyRef privateKey = [self createPrivateKeyWithKeyType:keyType.unsignedIntegerValue];
+        for (id algorithm in algorithms) {
+            NSError *error = nil;
+            NSData *padded = [YKFPIVPadding padData:data keyType:keyType.unsignedIntegerValue algorithm:(__bridge SecKeyAlgorithm)algorithm error:&error];
+            NSData *expected = [self securityFrameworkPaddingOfData:data privateKey:privateKey algorithm:(__bridge SecKeyAlgorithm)algorithm];
+            XCTAssertEqualObjects(padded, expected, @"%@", algorithm);
+        }
+        CFRelease(privateKey);
+    }
+}
+
+- (void)testPadRSAPSSIsVerifiedBySecurityFramework {
+    NSData *data = [@"Hello World!" dataUsingEncoding:NSUTF8StringEncoding];
+    NSArray *algorithms = @[(__bridge id)kSecKeyAlgorithmRSASignatureMessagePSSSHA1,
+                            (__bridge id)kSecKeyAlgorithmRSASignatureMessagePSSSHA256,
+                            (__bridge id)kSecKeyAlgorithmRSASignatureMessagePSSSHA512];
+    SecKeyRef privateKey = [self createPrivateKeyWithKeyType:YKFPIVKeyTypeRSA2048];
+    SecKeyRef publicKey = SecKeyCopyPublicKey(privateKey);
+    for (id algorithm in algorithms) {
+        NSError *error = nil;
+        NSData *padded = [YKFPIVPadding padData:data keyType:YKFPIVKeyTypeRSA2048 algorithm:(__bridge SecKeyAlgorithm)algorithm error:&error];
+        XCTAssertEqual(padded.length, 256);
+        
+        // The raw private key operation on the padded data is what the YubiKey does.
+        NSData *signature = (__bridge_transfer NSData *)SecKeyCreateDecryptedData(privateKey, kSecKeyAlgorithmRSAEncryptionRaw, (__bridge CFDataRef)padded, nil);
+        XCTAssertTrue(SecKeyVerifySignature(publicKey, (__bridge SecKeyAlgorithm)algorithm, (__bridge CFDataRef)data, (__bridge CFDataRef)signature, nil), @"%@", algorithm);
+    }
+    CFRelease(publicKey);
+    CFRelease(privateKey);
+}
+
+- (void)testUnpadRSAEncryptionOAEPSHA256KnownAnswer {
+    NSData *rsaEncryptionOAEPSHA256Data = [NSData dataFromHexString:@"00b4c0294996cb2fbe6fd4cba41c343fec59f1883eaa600ed50356adec74ca08a543ac79fbe74b00bd6e82844567e03873e62f3ff670b9b9cf05b27ca8ee4998bdc1f5124b1177700ea2c0db6d9b1c0cfa370aa91149fa1d94920a1040f0ccd54f7b8d672230dfe67bd5cac2d32f9f5c2d300878b602b35694104e18afffef67"];
+    
+    NSError *error = nil;
+    NSData *unpadded = [YKFPIVPadding unpadRSAData:rsaEncryptionOAEPSHA256Data algorithm:kSecKeyAlgorithmRSAEncryptionOAEPSHA256 error:&error];
+    
+    XCTAssertEqualObjects(unpadded, [@"Hello World!" dataUsingEncoding:NSUTF8StringEncoding]);
+}
+
+- (void)testUnpadRSAMatchesSecurityFramework {
+    NSData *data = [@"Hello World!" dataUsingEncoding:NSUTF8StringEncoding];
+    NSArray *algorithms = @[(__bridge id)kSecKeyAlgorithmRSAEncryptionPKCS1,
+                            (__bridge id)kSecKeyAlgorithmRSAEncryptionOAEPSHA1,
+                            (__bridge id)kSecKeyAlgorithmRSAEncryptionOAEPSHA224,
+                            (__bridge id)kSecKeyAlgorithmRSAEncryptionOAEPSHA256,
+                            (__bridge id)kSecKeyAlgorithmRSAEncryptionOAEPSHA384,
+                            (__bridge id)kSecKeyAlgorithmRSAEncryptionOAEPSHA512];
+    SecKeyRef privateKey = [self createPrivateKeyWithKeyType:YKFPIVKeyTypeRSA2048];
+    SecKeyRef publicKey = SecKeyCopyPublicKey(privateKey);
+    for (id algorithm in algorithms) {
+        NSData *encrypted = (__bridge_transfer NSData *)SecKeyCreateEncryptedData(publicKey, (__bridge SecKeyAlgorithm)algorithm, (__bridge CFDataRef)data, nil);
+        NSData *padded = (__bridge_transfer NSData *)SecKeyCreateDecryptedData(privateKey, kSecKeyAlgorithmRSAEncryptionRaw, (__bridge CFDataRef)encrypted, nil);
+        
+        NSError *error = nil;
+        NSData *unpadded = [YKFPIVPadding unpadRSAData:padded algorithm:(__bridge SecKeyAlgorithm)algorithm error:&error];
+        XCTAssertEqualObjects(unpadded, data, @"%@", algorithm);
+    }
+    CFRelease(publicKey);
+    CFRelease(privateKey);
+}
+
+#pragma mark - Performance
+
+- (void)testPadRSAPerformance {
+    NSData *data = [@"Hello World!" dataUsingEncoding:NSUTF8StringEncoding];
+    [self measureBlock:^{
+        for (int i = 0; i < 100; ++i) {
+            NSError *error = nil;
+            [YKFPIVPadding padData:data keyType:YKFPIVKeyTypeRSA2048 algorithm:kSecKeyAlgorithmRSASignatureMessagePKCS1v15SHA256 error:&error];
+            [YKFPIVPadding padData:data keyType:YKFPIVKeyTypeRSA2048 algorithm:kSecKeyAlgorithmRSASignatureMessagePSSSHA256 error:&error];
+        }
+    }];
+}
+
+- (void)testUnpadRSAPerformance {
+    NSData *rsaEncryptionOAEPSHA256Data = [NSData dataFromHexString:@"00b4c0294996cb2fbe6fd4cba41c343fec59f1883eaa600ed50356adec74ca08a543ac79fbe74b00bd6e82844567e03873e62f3ff670b9b9cf05b27ca8ee4998bdc1f5124b1177700ea2c0db6d9b1c0cfa370aa91149fa1d94920a1040f0ccd54f7b8d672230dfe67bd5cac2d32f9f5c2d300878b602b35694104e18afffef67"];
+    [self measureBlock:^{
+        for (int i = 0; i < 100; ++i) {
+            NSError *error = nil;
+            XCTAssertNotNil([YKFPIVPadding unpadRSAData:rsaEncryptionOAEPSHA256Data algorithm:kSecKeyAlgorithmRSAEncryptionOAEPSHA256 error:&error]);
+        }
+    }];
+}
+
+#pragma mark - Helpers
+
+- (SecKeyRef)createPrivateKeyWithKeyType:(YKFPIVKeyType)keyType {
+    NSDictionary *attributes = @{(id)kSecAttrKeyType: (id)kSecAttrKeyTypeRSA,
+                                 (id)kSecAttrKeySizeInBits: @(YKFPIVSizeFromKeyType(keyType) * 8)};
+    return SecKeyCreateRandomKey((__bridge CFDictionaryRef)attributes, nil);
+}
+
+// The padding produced by signing with a software key and reverting the private key operation.
+- (NSData *)securityFrameworkPaddingOfData:(NSData *)data privateKey:(SecKeyRef)privateKey algorithm:(SecKeyAlgorithm)algorithm {
+    SecKeyRef publicKey = SecKeyCopyPublicKey(privateKey);
+    NSData *signature = (__bridge_transfer NSData *)SecKeyCreateSignature(privateKey, algorithm, (__bridge CFDataRef)data, nil);
+    NSData *padded = (__bridge_transfer NSData *)SecKeyCreateEncryptedData(publicKey, kSecKeyAlgorithmRSAEncryptionRaw, (__bridge CFDataRef)signature, nil);
+    CFRelease(publicKey);
+    return padded;
+}
+
 @end
@@ -0,0 +1,614 @@
+// Copyright 2018-2021 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <XCTest/XCTest.h>
+
+#import "YKFTestCase.h"
+#import "YKFPIVSession.h"
+#import "YKFPIVSession+Private.h"
+#import "YKFPIVObjectCache.h"
+#import "YKFPIVSlotInventory.h"
+#import "YKFPIVSlotMetadata.h"
+#import "YKFAPDUError.h"
+#import "YKFAPDU+Private.h"
+#import "FakeYKFConnectionController.h"
+
+static const UInt32 YKFPIVSessionTestsSerialNumber = 1000;
+
+@interface YKFPIVSessionTests: YKFTestCase
+
+@property (nonatomic) FakeYKFConnectionController *keyConnectionController;
+@property (nonatomic) YKFPIVSession *session;
+@property (nonatomic) YKFPIVObjectCache *objectCache;
+@property (nonatomic) NSData *authenticationObjectId;
+
+@end
+
+@implementation YKFPIVSessionTests
+
+- (void)setUp {
+    [super setUp];
+    self.keyConnectionController = [[FakeYKFConnectionController alloc] init];
+    self.objectCache = [[YKFPIVObjectCache alloc] initWithValidation:YKFPIVObjectCacheValidationHeader];
+    self.authenticationObjectId = [NSData dataWithBytes:@[@(0x5f), @(0xc1), @(0x05)]];
+}
+
+#pragma mark - Helpers
+
+- (NSData *)certificateData {
+    return [[NSData alloc] initWithBase64EncodedString:@"MIIBKzCB0qADAgECAhQTuU25u6oazORvKfTleabdQaDUGzAKBggqhkjOPQQDAjAWMRQwEgYDVQQDDAthbW9zLmJ1cnRvbjAeFw0yMTAzMTUxMzU5MjVaFw0yODA1MTcwMDAwMDBaMBYxFDASBgNVBAMMC2Ftb3MuYnVydG9uMFkwEwYHKoZIzj0CAQYIKoZIzj0DAQcDQgAEofwN6S+atSZmzeLK7aSI+mJJwxh0oUBiCOngHLeToYeanrTGvCZQ2AK/R9esnqSxMyBUDp91UO4F6U4c6RTooTAKBggqhkjOPQQDAgNIADBFAiAnj/KUSpW7l5wnenQEbwWudK/7q3WtyrqdB0H1xc258wIhALDLImzu3S+0TT2/ggM95LLWE4Llfa2RQM71bnW6zqqn" options:0];
+}
+
+/*
+ The GET DATA response of a certificate object, with the certificate info record.
+ */
+- (NSData *)certificateObjectWithInfo:(NSData *)info {
+    NSData *certificate = [self certificateData];
+    NSMutableData *records = [[NSMutableData alloc] init];
+    UInt8 certificateHeader[] = {0x70, 0x82, (UInt8)(certificate.length >> 8), (UInt8)certificate.length};
+    [records appendBytes:certificateHeader length:sizeof(certificateHeader)];
+    [records appendData:certificate];
+    UInt8 infoHeader[] = {0x71, (UInt8)info.length};
+    [records appendBytes:infoHeader length:sizeof(infoHeader)];
+    [records appendData:info];
+    UInt8 lrc[] = {0xfe, 0x00};
+    [records appendBytes:lrc length:sizeof(lrc)];
+
+    NSMutableData *object = [[NSMutableData alloc] init];
+    UInt8 objectHeader[] = {0x53, 0x82, (UInt8)(records.length >> 8), (UInt8)records.length};
+    [object appendBytes:objectHeader length:sizeof(objectHeader)];
+    [object appendData:records];
+    return object;
+}
+
+- (NSData *)certificateObject {
+    return [self certificateObjectWithInfo:[NSData dataWithBytes:@[@(0x00)]]];
+}
+
+- (NSData *)response:(NSData *)data statusCode:(UInt16)statusCode {
+    NSMutableData *response = [data mutableCopy];
+    UInt8 statusCodeBytes[] = {statusCode >> 8, statusCode & 0xff};
+    [response appendBytes:statusCodeBytes length:sizeof(statusCodeBytes)];
+    return response;
+}
+
+- (NSData *)okResponse {
+    return [self response:[NSData data] statusCode:0x9000];
+}
+
+/*
+ The object sent by the key in two frames: the first one ends with the status word announcing more data.
+ */
+- (NSArray<NSData *> *)framesOfObject:(NSData *)object {
+    return @[[self response:[object subdataWithRange:NSMakeRange(0, 100)] statusCode:0x6100],
+             [self response:[object subdataWithRange:NSMakeRange(100, object.length - 100)] statusCode:0x9000]];
+}
+
+- (NSData *)serialNumberResponse {
+    UInt32 serialNumber = CFSwapInt32HostToBig(YKFPIVSessionTestsSerialNumber);
+    return [self response:[NSData dataWithBytes:&serialNumber length:sizeof(serialNumber)] statusCode:0x9000];
+}
+
+- (void)waitForExpectation:(XCTestExpectation *)expectation {
+    XCTWaiterResult result = [XCTWaiter waitForExpectations:@[expectation] timeout:10];
+    XCTAssert(result == XCTWaiterResultCompleted, @"");
+}
+
+/*
+ Opens the session on a key with the version, the key returns the responses after the one to GET VERSION.
+ */
+- (void)openSessionWithVersion:(NSArray<NSNumber *> *)version responses:(NSArray<NSData *> *)responses {
+    NSArray *openResponses = @[[self okResponse], [self response:[NSData dataWithBytes:version] statusCode:0x9000]];
+    self.keyConnectionController.commandExecutionResponseDataSequence = [openResponses arrayByAddingObjectsFromArray:responses];
+    XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"PIV"];
+
+    [YKFPIVSession sessionWithConnectionController:self.keyConnectionController completion:^(YKFPIVSession * _Nullable session, NSError * _Nullable error) {
+        XCTAssertNil(error, @"Unexpected error: %@", error);
+        self.session = session;
+        [expectation fulfill];
+    }];
+
+    [self waitForExpectation:expectation];
+}
+
+- (void)openSessionWithResponses:(NSArray<NSData *> *)responses {
+    [self openSessionWithVersion:@[@(0x05), @(0x04), @(0x03)] responses:responses];
+    self.session.objectCache = self.objectCache;
+}
+
+- (void)readCertificateExpectingSuccess {
+    XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"PIV"];
+
+    [self.session getCertificateInSlot:YKFPIVSlotAuthentication completion:^(SecCertificateRef _Nullable certificate, NSError * _Nullable error) {
+        XCTAssertNil(error, @"Unexpected error: %@", error);
+        XCTAssert(certificate != nil);
+        [expectation fulfill];
+    }];
+
+    [self waitForExpectation:expectation];
+}
+
+/*
+ Opens the session and reads the certificate, which is stored in the object cache.
+ */
+- (void)readCertificateOnNewSession {
+    [self openSessionWithResponses:[@[[self serialNumberResponse]] arrayByAddingObjectsFromArray:[self framesOfObject:[self certificateObject]]]];
+    [self readCertificateExpectingSuccess];
+    XCTAssertEqualObjects([self cachedObject], [self certificateObject]);
+}
+
+- (NSData *)cachedObject {
+    return [self.objectCache objectWithId:self.authenticationObjectId serialNumber:YKFPIVSessionTestsSerialNumber];
+}
+
+- (NSArray<YKFAPDU *> *)commandsFromIndex:(NSUInteger)index {
+    NSArray<YKFAPDU *> *commands = self.keyConnectionController.executedCommands;
+    return [commands subarrayWithRange:NSMakeRange(index, commands.count - index)];
+}
+
+- (NSData *)slotMetadataResponseWithKeyType:(YKFPIVKeyType)keyType origin:(UInt8)origin {
+    return [NSData dataWithBytes:@[@(0x01), @(0x01), @(keyType),
+                                   @(0x02), @(0x02), @(YKFPIVPinPolicyOnce), @(YKFPIVTouchPolicyNever),
+                                   @(0x03), @(0x01), @(origin),
+                                   @(0x90), @(0x00)]];
+}
+
+- (NSData *)signatureResponseWithValue:(UInt8)value {
+    return [NSData dataWithBytes:@[@(0x7c), @(0x04), @(0x82), @(0x02), @(value), @(value), @(0x90), @(0x00)]];
+}
+
+/*
+ Signs the messages with the P256 key of the signature slot of the open session, the key returns the responses.
+ */
+- (void)signMessages:(NSArray<NSData *> *)messages pin:(NSString *)pin responses:(NSArray<NSData *> *)responses
+          completion:(YKFPIVSessionSignMessagesCompletionBlock)completion {
+    self.keyConnectionController.commandExecutionResponseDataSequence = responses;
+    XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"PIV"];
+
+    [self.session signMessages:messages withKeyInSlot:YKFPIVSlotSignature type:YKFPIVKeyTypeECCP256 algorithm:kSecKeyAlgorithmECDSASignatureMessageX962SHA256 pin:pin completion:^(NSArray<NSData *> * _Nonnull signatures, NSDictionary<NSNumber *, NSError *> * _Nonnull errors, NSError * _Nullable error) {
+        completion(signatures, errors, error);
+        [expectation fulfill];
+    }];
+
+    [self waitForExpectation:expectation];
+}
+
+- (int)pinAttemptsWithResponses:(NSArray<NSData *> *)responses {
+    self.keyConnectionController.commandExecutionResponseDataSequence = responses;
+    XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"PIV"];
+    __block int result = -1;
+
+    [self.session getPinAttemptsWithCompletion:^(int retries, NSError * _Nullable error) {
+        XCTAssertNil(error, @"Unexpected error: %@", error);
+        result = retries;
+        [expectation fulfill];
+    }];
+
+    [self waitForExpectation:expectation];
+    return result;
+}
+
+- (NSArray<NSData *> *)messagesWithCount:(NSUInteger)count {
+    NSMutableArray<NSData *> *messages = [[NSMutableArray alloc] initWithCapacity:count];
+    for (NSUInteger i = 0; i < count; ++i) {
+        [messages addObject:[[NSString stringWithFormat:@"message %lu", (unsigned long)i] dataUsingEncoding:NSUTF8StringEncoding]];
+    }
+    return messages;
+}
+
+- (YKFPIVSlotInventory *)slotInventory {
+    XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"PIV"];
+    __block YKFPIVSlotInventory *result = nil;
+
+    [self.session getSlotInventoryWithCompletion:^(YKFPIVSlotInventory * _Nullable inventory, NSError * _Nullable error) {
+        XCTAssertNil(error, @"Unexpected error: %@", error);
+        result = inventory;
+        [expectation fulfill];
+    }];
+
+    [self waitForExpectation:expectation];
+    return result;
+}
+
+#pragma mark - Object Cache Tests
+
+- (void)test_WhenObjectIsReadWithoutCache_SerialNumberIsNotRead {
+    [self openSessionWithVersion:@[@(0x05), @(0x04), @(0x03)] responses:[self framesOfObject:[self certificateObject]]];
+
+    [self readCertificateExpectingSuccess];
+
+    NSArray<YKFAPDU *> *commands = [self commandsFromIndex:2];
+    XCTAssertEqual(commands.count, 2);
+    XCTAssertEqual(commands[0].ins, 0xcb);
+    XCTAssertEqual(commands[1].ins, 0xc0);
+}
+
+- (void)test_WhenObjectIsReadFirstTime_ItIsReadInFullAndStored {
+    [self readCertificateOnNewSession];
+
+    NSArray<YKFAPDU *> *commands = [self commandsFromIndex:2];
+    XCTAssertEqual(commands.count, 3);
+    XCTAssertEqual(commands[0].ins, 0xf8);
+    XCTAssertEqual(commands[1].ins, 0xcb);
+    XCTAssertEqual(commands[2].ins, 0xc0);
+}
+
+- (void)test_WhenFirstFrameMatchesCachedObject_CachedObjectIsReturnedWithoutReadingTheRest {
+    [self readCertificateOnNewSession];
+
+    // The key is asked for the first frame only, the serial number was read once for the session.
+    self.keyConnectionController.commandExecutionResponseDataSequence = @[[self framesOfObject:[self certificateObject]].firstObject];
+    [self readCertificateExpectingSuccess];
+
+    NSArray<YKFAPDU *> *commands = [self commandsFromIndex:5];
+    XCTAssertEqual(commands.count, 1);
+    XCTAssertEqual(commands[0].ins, 0xcb);
+    XCTAssertEqualObjects([self cachedObject], [self certificateObject]);
+}
+
+- (void)test_WhenFirstFrameHasAnotherLength_ObjectIsReadAgainAndStored {
+    [self readCertificateOnNewSession];
+
+    // A longer certificate info, the header of the first frame announces another length.
+    NSData *changedObject = [self certificateObjectWithInfo:[NSData dataWithBytes:@[@(0x00), @(0x00)]]];
+    NSArray<NSData *> *frames = [self framesOfObject:changedObject];
+    self.keyConnectionController.commandExecutionResponseDataSequence = [@[frames.firstObject] arrayByAddingObjectsFromArray:frames];
+    [self readCertificateExpectingSuccess];
+
+    NSArray<YKFAPDU *> *commands = [self commandsFromIndex:5];
+    XCTAssertEqual(commands.count, 3);
+    XCTAssertEqual(commands[0].ins, 0xcb);
+    XCTAssertEqual(commands[1].ins, 0xcb);
+    XCTAssertEqual(commands[2].ins, 0xc0);
+    XCTAssertEqualObjects([self cachedObject], changedObject);
+}
+
+- (void)test_WhenObjectFitsInFirstFrame_ItIsReturnedAndStored {
+    [self readCertificateOnNewSession];
+
+    NSData *changedObject = [self certificateObjectWithInfo:[NSData dataWithBytes:@[@(0x01)]]];
+    self.keyConnectionController.commandExecutionResponseDataSequence = @[[self response:changedObject statusCode:0x9000]];
+    [self readCertificateExpectingSuccess];
+
+    NSArray<YKFAPDU *> *commands = [self commandsFromIndex:5];
+    XCTAssertEqual(commands.count, 1);
+    XCTAssertEqual(commands[0].ins, 0xcb);
+    XCTAssertEqualObjects([self cachedObject], changedObject);
+}
+
+- (void)test_WhenCertificateIsPut_CachedObjectIsRemoved {
+    [self readCertificateOnNewSession];
+
+    self.keyConnectionController.commandExecutionResponseDataSequence = @[[self okResponse]];
+    XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"PIV"];
+    SecCertificateRef certificate = SecCertificateCreateWithData(nil, (__bridge CFDataRef)[self certificateData]);
+
+    [self.session putCertificate:certificate inSlot:YKFPIVSlotAuthentication completion:^(NSError * _Nullable error) {
+        XCTAssertNil(error, @"Unexpected error: %@", error);
+        [expectation fulfill];
+    }];
+
+    [self waitForExpectation:expectation];
+    CFRelease(certificate);
+    XCTAssertNil([self cachedObject]);
+
+    // The next read doesn't validate the removed object, it reads the object in full.
+    self.keyConnectionController.commandExecutionResponseDataSequence = [self framesOfObject:[self certificateObject]];
+    [self readCertificateExpectingSuccess];
+
+    NSArray<YKFAPDU *> *commands = [self commandsFromIndex:5];
+    XCTAssertEqual(commands.count, 3);
+    XCTAssertEqual(commands[0].ins, 0xdb);
+    XCTAssertEqual(commands[1].ins, 0xcb);
+    XCTAssertEqual(commands[2].ins, 0xc0);
+    XCTAssertEqualObjects([self cachedObject], [self certificateObject]);
+}
+
+- (void)test_WhenKeyIsReset_CachedObjectsOfTheKeyAreRemoved {
+    [self readCertificateOnNewSession];
+    NSData *otherObjectId = [NSData dataWithBytes:@[@(0x5f), @(0xc1), @(0x0a)]];
+    [self.objectCache storeObject:[self certificateObject] withId:otherObjectId serialNumber:YKFPIVSessionTestsSerialNumber + 1];
+
+    // The PIN and the PUK are blocked by a single wrong attempt each, then the key is reset.
+    NSData *blockedResponse = [self response:[NSData data] statusCode:0x63c0];
+    self.keyConnectionController.commandExecutionResponseDataSequence = @[blockedResponse, blockedResponse, [self okResponse]];
+    XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"PIV"];
+
+    [self.session resetWithCompletion:^(NSError * _Nullable error) {
+        XCTAssertNil(error, @"Unexpected error: %@", error);
+        [expectation fulfill];
+    }];
+
+    [self waitForExpectation:expectation];
+
+    NSArray<YKFAPDU *> *commands = [self commandsFromIndex:5];
+    XCTAssertEqual(commands.count, 3);
+    XCTAssertEqual(commands[0].ins, 0x20);
+    XCTAssertEqual(commands[1].ins, 0x2c);
+    XCTAssertEqual(commands[2].ins, 0xfb);
+    XCTAssertNil([self cachedObject]);
+    XCTAssertNotNil([self.objectCache objectWithId:otherObjectId serialNumber:YKFPIVSessionTestsSerialNumber + 1]);
+}
+
+- (void)test_WhenKeyIsResetBeforeReadingSerialNumber_OnlyCachedObjectsOfTheKeyAreRemoved {
+    NSData *blockedResponse = [self response:[NSData data] statusCode:0x63c0];
+    [self openSessionWithResponses:@[[self serialNumberResponse], blockedResponse, blockedResponse, [self okResponse]]];
+    [self.objectCache storeObject:[self certificateObject] withId:self.authenticationObjectId serialNumber:YKFPIVSessionTestsSerialNumber];
+    [self.objectCache storeObject:[self certificateObject] withId:self.authenticationObjectId serialNumber:YKFPIVSessionTestsSerialNumber + 1];
+    XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"PIV"];
+
+    [self.session resetWithCompletion:^(NSError * _Nullable error) {
+        XCTAssertNil(error, @"Unexpected error: %@", error);
+        [expectation fulfill];
+    }];
+
+    [self waitForExpectation:expectation];
+
+    NSArray<YKFAPDU *> *commands = [self commandsFromIndex:2];
+    XCTAssertEqual(commands.count, 4);
+    XCTAssertEqual(commands[0].ins, 0xf8);
+    XCTAssertEqual(commands[3].ins, 0xfb);
+    XCTAssertNil([self cachedObject]);
+    XCTAssertNotNil([self.objectCache objectWithId:self.authenticationObjectId serialNumber:YKFPIVSessionTestsSerialNumber + 1]);
+}
+
+#pragma mark - Slot Inventory Tests
+
+- (void)test_WhenReadingInventory_ResultsAreMappedToSlotsAndMissingObjectsAreEmptySlots {
+    NSData *certificateResponse = [self response:[self certificateObject] statusCode:0x9000];
+    NSData *missingFileResponse = [self response:[NSData data] statusCode:YKFAPDUErrorCodeMissingFile];
+    NSData *notFoundResponse = [self response:[NSData data] statusCode:YKFAPDUErrorCodeReferenceDataNotFound];
+    // The certificates of 9a, 9c, 9d, 9e and f9, then their metadata in the same order.
+    [self openSessionWithVersion:@[@(0x05), @(0x04), @(0x03)] responses:@[
+        certificateResponse, missingFileResponse, certificateResponse, missingFileResponse, notFoundResponse,
+        [self slotMetadataResponseWithKeyType:YKFPIVKeyTypeECCP256 origin:0x01],
+        notFoundResponse,
+        [self slotMetadataResponseWithKeyType:YKFPIVKeyTypeRSA2048 origin:0x02],
+        notFoundResponse,
+        [self slotMetadataResponseWithKeyType:YKFPIVKeyTypeECCP256 origin:0x01]]];
+
+    YKFPIVSlotInventory *inventory = [self slotInventory];
+
+    XCTAssertTrue(inventory.includesMetadata);
+    NSArray *occupiedSlots = @[@(YKFPIVSlotAuthentication), @(YKFPIVSlotKeyManagement), @(YKFPIVSlotAttestation)];
+    XCTAssertEqualObjects(inventory.occupiedSlots, occupiedSlots);
+
+    XCTAssert([inventory certificateForSlot:YKFPIVSlotAuthentication] != nil);
+    XCTAssert([inventory certificateForSlot:YKFPIVSlotSignature] == nil);
+    XCTAssert([inventory certificateForSlot:YKFPIVSlotKeyManagement] != nil);
+    XCTAssert([inventory certificateForSlot:YKFPIVSlotAttestation] == nil);
+
+    YKFPIVSlotMetadata *authenticationMetadata = [inventory metadataForSlot:YKFPIVSlotAuthentication];
+    XCTAssertEqual(authenticationMetadata.keyType, YKFPIVKeyTypeECCP256);
+    XCTAssertEqual(authenticationMetadata.pinPolicy, YKFPIVPinPolicyOnce);
+    XCTAssertEqual(authenticationMetadata.touchPolicy, YKFPIVTouchPolicyNever);
+    XCTAssertTrue(authenticationMetadata.generated);
+    YKFPIVSlotMetadata *keyManagementMetadata = [inventory metadataForSlot:YKFPIVSlotKeyManagement];
+    XCTAssertEqual(keyManagementMetadata.keyType, YKFPIVKeyTypeRSA2048);
+    XCTAssertFalse(keyManagementMetadata.generated);
+    XCTAssertNil([inventory metadataForSlot:YKFPIVSlotSignature]);
+    XCTAssertNil([inventory metadataForSlot:YKFPIVSlotCardAuth]);
+    XCTAssertNotNil([inventory metadataForSlot:YKFPIVSlotAttestation]);
+
+    NSArray<YKFAPDU *> *commands = [self commandsFromIndex:2];
+    XCTAssertEqual(commands.count, 10);
+    XCTAssertEqual(commands[0].ins, 0xcb);
+    XCTAssertEqual(commands[4].ins, 0xcb);
+    XCTAssertEqual(commands[5].ins, 0xf7);
+    XCTAssertEqual(commands[5].p2, YKFPIVSlotAuthentication);
+    XCTAssertEqual(commands[9].ins, 0xf7);
+    XCTAssertEqual(commands[9].p2, YKFPIVSlotAttestation);
+}
+
+- (void)test_WhenKeyDoesNotProvideMetadata_OnlyCertificatesAreRead {
+    NSData *certificateResponse = [self response:[self certificateObject] statusCode:0x9000];
+    NSData *missingFileResponse = [self response:[NSData data] statusCode:YKFAPDUErrorCodeMissingFile];
+    [self openSessionWithVersion:@[@(0x05), @(0x02), @(0x07)] responses:@[
+        missingFileResponse, certificateResponse, missingFileResponse, missingFileResponse, missingFileResponse]];
+
+    YKFPIVSlotInventory *inventory = [self slotInventory];
+
+    XCTAssertFalse(inventory.includesMetadata);
+    XCTAssertEqualObjects(inventory.occupiedSlots, @[@(YKFPIVSlotSignature)]);
+    XCTAssert([inventory certificateForSlot:YKFPIVSlotSignature] != nil);
+    XCTAssertNil([inventory metadataForSlot:YKFPIVSlotSignature]);
+
+    NSArray<YKFAPDU *> *commands = [self commandsFromIndex:2];
+    XCTAssertEqual(commands.count, 5);
+    for (YKFAPDU *command in commands) {
+        XCTAssertEqual(command.ins, 0xcb);
+    }
+}
+
+- (void)test_WhenReadingInventoryWithObjectCache_CertificatesAreCachedForTheNextRead {
+    NSData *certificateResponse = [self response:[self certificateObject] statusCode:0x9000];
+    NSData *missingFileResponse = [self response:[NSData data] statusCode:YKFAPDUErrorCodeMissingFile];
+    NSData *notFoundResponse = [self response:[NSData data] statusCode:YKFAPDUErrorCodeReferenceDataNotFound];
+    NSData *signatureObjectId = [NSData dataWithBytes:@[@(0x5f), @(0xc1), @(0x0a)]];
+    [self.objectCache storeObject:[self certificateObject] withId:signatureObjectId serialNumber:YKFPIVSessionTestsSerialNumber];
+    [self openSessionWithResponses:@[[self serialNumberResponse],
+        certificateResponse, missingFileResponse, missingFileResponse, missingFileResponse, missingFileResponse,
+        notFoundResponse, notFoundResponse, notFoundResponse, notFoundResponse, notFoundResponse]];
+
+    YKFPIVSlotInventory *inventory = [self slotInventory];
+
+    XCTAssertEqualObjects(inventory.occupiedSlots, @[@(YKFPIVSlotAuthentication)]);
+    XCTAssertEqualObjects([self cachedObject], [self certificateObject]);
+    XCTAssertNil([self.objectCache objectWithId:signatureObjectId serialNumber:YKFPIVSessionTestsSerialNumber]);
+
+    // The cached object is validated with the first frame only.
+    self.keyConnectionController.commandExecutionResponseDataSequence = @[[self framesOfObject:[self certificateObject]].firstObject];
+    [self readCertificateExpectingSuccess];
+
+    NSArray<YKFAPDU *> *commands = [self commandsFromIndex:2];
+    XCTAssertEqual(commands.count, 12);
+    XCTAssertEqual(commands[0].ins, 0xf8);
+    XCTAssertEqual(commands[11].ins, 0xcb);
+}
+
+- (void)test_WhenReadingSlotFailsWithOtherError_InventoryFails {
+    NSData *missingFileResponse = [self response:[NSData data] statusCode:YKFAPDUErrorCodeMissingFile];
+    NSData *securityStatusResponse = [self response:[NSData data] statusCode:0x6982];
+    [self openSessionWithVersion:@[@(0x05), @(0x02), @(0x07)] responses:@[
+        missingFileResponse, securityStatusResponse, missingFileResponse, missingFileResponse, missingFileResponse]];
+    XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"PIV"];
+
+    [self.session getSlotInventoryWithCompletion:^(YKFPIVSlotInventory * _Nullable inventory, NSError * _Nullable error) {
+        XCTAssertNil(inventory);
+        XCTAssertEqual(error.code, 0x6982);
+        [expectation fulfill];
+    }];
+
+    [self waitForExpectation:expectation];
+}
+
+#pragma mark - Sign Messages Tests
+
+- (void)test_WhenSigningMessagesWithPin_PinIsVerifiedFirstAndResultsAreKeyedByMessage {
+    [self openSessionWithVersion:@[@(0x05), @(0x04), @(0x03)] responses:@[]];
+    NSData *securityStatusResponse = [self response:[NSData data] statusCode:0x6982];
+    NSArray *responses = @[[self okResponse], [self signatureResponseWithValue:1], securityStatusResponse, [self signatureResponseWithValue:3]];
+
+    [self signMessages:[self messagesWithCount:3] pin:@"123456" responses:responses completion:^(NSArray<NSData *> *signatures, NSDictionary<NSNumber *, NSError *> *errors, NSError *error) {
+        XCTAssertEqual(signatures.count, 3);
+        XCTAssertEqualObjects(signatures[0], ([NSData dataWithBytes:@[@(0x01), @(0x01)]]));
+        XCTAssertEqual(signatures[1].length, 0);
+        XCTAssertEqualObjects(signatures[2], ([NSData dataWithBytes:@[@(0x03), @(0x03)]]));
+        XCTAssertEqualObjects(errors.allKeys, @[@1]);
+        XCTAssertEqual(errors[@1].code, 0x6982);
+        XCTAssertEqual(error.code, 0x6982);
+    }];
+
+    NSArray<YKFAPDU *> *commands = [self commandsFromIndex:2];
+    XCTAssertEqual(commands.count, 4);
+    XCTAssertEqual(commands[0].ins, 0x20);
+    for (NSUInteger i = 1; i < commands.count; ++i) {
+        XCTAssertEqual(commands[i].ins, 0x87);
+        XCTAssertEqual(commands[i].p1, YKFPIVKeyTypeECCP256);
+        XCTAssertEqual(commands[i].p2, YKFPIVSlotSignature);
+    }
+}
+
+- (void)test_WhenPinIsWrong_NoMessageIsSentAndPinErrorIsReturnedForAllMessages {
+    [self openSessionWithVersion:@[@(0x05), @(0x04), @(0x03)] responses:@[]];
+    NSData *wrongPinResponse = [self response:[NSData data] statusCode:0x63c2];
+
+    [self signMessages:[self messagesWithCount:3] pin:@"654321" responses:@[wrongPinResponse] completion:^(NSArray<NSData *> *signatures, NSDictionary<NSNumber *, NSError *> *errors, NSError *error) {
+        XCTAssertEqual(signatures.count, 3);
+        for (NSData *signature in signatures) {
+            XCTAssertEqual(signature.length, 0);
+        }
+        XCTAssertEqual(errors.count, 3);
+        for (NSError *messageError in errors.allValues) {
+            XCTAssertEqualObjects(messageError.domain, YKFPIVErrorDomain);
+            XCTAssertEqual(messageError.code, YKFPIVFErrorCodeInvalidPin);
+        }
+        XCTAssertEqual(error.code, YKFPIVFErrorCodeInvalidPin);
+    }];
+
+    NSArray<YKFAPDU *> *commands = [self commandsFromIndex:2];
+    XCTAssertEqual(commands.count, 1);
+    XCTAssertEqual(commands[0].ins, 0x20);
+}
+
+- (void)test_WhenSigningMessagesWithoutPin_OnlySigningRequestsAreSent {
+    [self openSessionWithVersion:@[@(0x05), @(0x04), @(0x03)] responses:@[]];
+    NSArray *responses = @[[self signatureResponseWithValue:1], [self signatureResponseWithValue:2]];
+
+    [self signMessages:[self messagesWithCount:2] pin:nil responses:responses completion:^(NSArray<NSData *> *signatures, NSDictionary<NSNumber *, NSError *> *errors, NSError *error) {
+        XCTAssertNil(error, @"Unexpected error: %@", error);
+        XCTAssertEqual(errors.count, 0);
+        XCTAssertEqualObjects(signatures[1], ([NSData dataWithBytes:@[@(0x02), @(0x02)]]));
+    }];
+
+    NSArray<YKFAPDU *> *commands = [self commandsFromIndex:2];
+    XCTAssertEqual(commands.count, 2);
+    XCTAssertEqual(commands[0].ins, 0x87);
+    XCTAssertEqual(commands[1].ins, 0x87);
+}
+
+- (void)test_WhenNoMessageCanBePadded_CompletionIsCalledOnTheCommunicationQueue {
+    [self openSessionWithVersion:@[@(0x05), @(0x04), @(0x03)] responses:@[]];
+    XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"PIV"];
+
+    // The fake connection controller runs its communication queue blocks on the main queue.
+    [self.session signMessages:[self messagesWithCount:2] withKeyInSlot:YKFPIVSlotSignature type:YKFPIVKeyTypeECCP256 algorithm:kSecKeyAlgorithmRSASignatureMessagePKCS1v15SHA256 pin:@"123456" completion:^(NSArray<NSData *> * _Nonnull signatures, NSDictionary<NSNumber *, NSError *> * _Nonnull errors, NSError * _Nullable error) {
+        XCTAssertTrue([NSThread isMainThread]);
+        XCTAssertEqual(errors.count, 2);
+        XCTAssertNotNil(error);
+        [expectation fulfill];
+    }];
+
+    [self waitForExpectation:expectation];
+    XCTAssertEqual([self commandsFromIndex:2].count, 0);
+}
+
+#pragma mark - PIN Retries Tests
+
+- (void)test_WhenPinVerificationFailsOrSucceeds_PinAttemptsFollowTheKey {
+    [self openSessionWithVersion:@[@(0x05), @(0x04), @(0x03)] responses:@[]];
+    NSData *wrongPinResponse = [self response:[NSData data] statusCode:0x63c2];
+
+    // A wrong PIN in the signing batch reports the remaining retries, which are then answered without asking the key.
+    [self signMessages:[self messagesWithCount:1] pin:@"654321" responses:@[wrongPinResponse] completion:^(NSArray<NSData *> *signatures, NSDictionary<NSNumber *, NSError *> *errors, NSError *error) {
+        XCTAssertEqual(error.code, YKFPIVFErrorCodeInvalidPin);
+    }];
+    XCTAssertEqual([self pinAttemptsWithResponses:@[]], 2);
+    XCTAssertEqual(self.keyConnectionController.executedCommands.count, 3);
+
+    // A successful verification restores the retries to a total which isn't known yet, it's read from the key.
+    [self signMessages:[self messagesWithCount:1] pin:@"123456" responses:@[[self okResponse], [self signatureResponseWithValue:1]] completion:^(NSArray<NSData *> *signatures, NSDictionary<NSNumber *, NSError *> *errors, NSError *error) {
+        XCTAssertNil(error, @"Unexpected error: %@", error);
+    }];
+    NSData *pinMetadataResponse = [NSData dataWithBytes:@[@(0x05), @(0x01), @(0x00), @(0x06), @(0x02), @(0x05), @(0x05), @(0x90), @(0x00)]];
+    XCTAssertEqual([self pinAttemptsWithResponses:@[pinMetadataResponse]], 5);
+    NSArray<YKFAPDU *> *commands = [self commandsFromIndex:3];
+    XCTAssertEqual(commands.count, 3);
+    XCTAssertEqual(commands[2].ins, 0xf7);
+    XCTAssertEqual(commands[2].p2, 0x80);
+
+    // The next wrong PIN is counted from the total.
+    XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"PIV"];
+    self.keyConnectionController.commandExecutionResponseDataSequence = @[[self response:[NSData data] statusCode:0x63c4]];
+    [self.session verifyPin:@"654321" completion:^(int retries, NSError * _Nullable error) {
+        XCTAssertEqual(retries, 4);
+        [expectation fulfill];
+    }];
+    [self waitForExpectation:expectation];
+    XCTAssertEqual([self pinAttemptsWithResponses:@[]], 4);
+    XCTAssertEqual(self.keyConnectionController.executedCommands.count, 7);
+}
+
+- (void)test_WhenPinVerificationFailsWithOtherError_PinAttemptsAreReadFromTheKey {
+    [self openSessionWithVersion:@[@(0x05), @(0x04), @(0x03)] responses:@[]];
+    NSData *pinMetadataResponse = [NSData dataWithBytes:@[@(0x05), @(0x01), @(0x00), @(0x06), @(0x02), @(0x03), @(0x03), @(0x90), @(0x00)]];
+    XCTAssertEqual([self pinAttemptsWithResponses:@[pinMetadataResponse]], 3);
+
+    XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"PIV"];
+    self.keyConnectionController.commandExecutionResponseDataSequence = @[[self response:[NSData data] statusCode:0x6a80]];
+    [self.session verifyPin:@"123456" completion:^(int retries, NSError * _Nullable error) {
+        XCTAssertEqual(retries, -1);
+        XCTAssertEqual(error.code, 0x6a80);
+        [expectation fulfill];
+    }];
+    [self waitForExpectation:expectation];
+
+    NSData *changedMetadataResponse = [NSData dataWithBytes:@[@(0x05), @(0x01), @(0x00), @(0x06), @(0x02), @(0x03), @(0x01), @(0x90), @(0x00)]];
+    XCTAssertEqual([self pinAttemptsWithResponses:@[changedMetadataResponse]], 1);
+    NSArray<YKFAPDU *> *commands = [self commandsFromIndex:2];
+    XCTAssertEqual(commands.count, 3);
+    XCTAssertEqual(commands[2].ins, 0xf7);
+}
+
+@end
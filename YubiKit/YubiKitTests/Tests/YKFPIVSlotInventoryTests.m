@@ -0,0 +1,51 @@
+// Copyright 2018-2021 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#import <XCTest/XCTest.h>
+
+#import "YKFTestCase.h"
+#import "YKFPIVSlotInventory.h"
+#import "YKFPIVSlotInventory+Private.h"
+#import "YKFPIVSlotMetadata.h"
+#import "YKFPIVSlotMetadata+Private.h"
+
+@interface YKFPIVSlotInventoryTests: YKFTestCase
+@end
+
+@implementation YKFPIVSlotInventoryTests
+
+- (void)test_WhenSlotsHaveKeysOrCertificates_OccupiedSlotsAreSorted {
+    YKFPIVSlotMetadata *metadata = [[YKFPIVSlotMetadata alloc] initWithKeyType:YKFPIVKeyTypeECCP256 pinPolicy:YKFPIVPinPolicyOnce touchPolicy:YKFPIVTouchPolicyNever generated:true];
+    NSDictionary *certificates = @{@(YKFPIVSlotSignature): [NSNull null], @(YKFPIVSlotAuthentication): [NSNull null]};
+
+    YKFPIVSlotInventory *inventory = [[YKFPIVSlotInventory alloc] initWithMetadata:@{@(YKFPIVSlotCardAuth): metadata, @(YKFPIVSlotAuthentication): metadata} certificates:certificates];
+
+    XCTAssertTrue(inventory.includesMetadata);
+    NSArray *expectedSlots = @[@(YKFPIVSlotAuthentication), @(YKFPIVSlotSignature), @(YKFPIVSlotCardAuth)];
+    XCTAssertEqualObjects(inventory.occupiedSlots, expectedSlots);
+    XCTAssertEqual([inventory metadataForSlot:YKFPIVSlotCardAuth], metadata);
+    XCTAssertNil([inventory metadataForSlot:YKFPIVSlotSignature]);
+}
+
+- (void)test_WhenMetadataIsNotRead_InventoryHasCertificatesOnly {
+    YKFPIVSlotInventory *inventory = [[YKFPIVSlotInventory alloc] initWithMetadata:nil certificates:@{}];
+
+    XCTAssertFalse(inventory.includesMetadata);
+    XCTAssertEqual(inventory.occupiedSlots.count, 0);
+    XCTAssertNil([inventory metadataForSlot:YKFPIVSlotAuthentication]);
+    XCTAssertTrue([inventory certificateForSlot:YKFPIVSlotAuthentication] == NULL);
+}
+
+@end
@@ -17,6 +17,7 @@
 #import "FakeYKFConnectionController.h"
 #import "YKFSmartCardInterface.h"
 #import "YKFAPDU+Private.h"
+#import "YKFSessionError+Private.h"
 
 @interface YKFSmartCardInterfaceTests: YKFTestCase
 
@@ -96,4 +97,369 @@
     XCTAssert(result == XCTWaiterResultCompleted, @"");
 }
 
+#pragma mark - Batch commands
+
+- (void)test_WhenRunningBatchAgainstTheKey_ResultsAreReturnedForEachCommand {
+    NSArray *responses = @[[NSData dataWithBytes:@[@(0x01), @(0x90), @(0x00)]],
+                           [NSData dataWithBytes:@[@(0x02), @(0x03), @(0x90), @(0x00)]]];
+    self.keyConnectionController.commandExecutionResponseDataSequence = responses;
+    
+    XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"SmartCardBatch"];
+    
+    [self.smartCardInterface executeCommands:[self commandsWithCount:2] completion:^(NSArray<YKFSmartCardInterfaceCommandResult *> * _Nonnull results, NSError * _Nullable error) {
+        XCTAssertNil(error);
+        XCTAssertEqual(results.count, 2);
+        XCTAssertEqualObjects(results[0].data, [NSData dataWithBytes:@[@(0x01)]]);
+        XCTAssertEqualObjects(results[1].data, ([NSData dataWithBytes:@[@(0x02), @(0x03)]]));
+        [expectation fulfill];
+    }];
+    XCTWaiterResult result = [XCTWaiter waitForExpectations:@[expectation] timeout:10];
+    XCTAssert(result == XCTWaiterResultCompleted, @"");
+    
+    XCTAssertEqual(self.keyConnectionController.executionCommandsCount, 2);
+    XCTAssertEqual(self.keyConnectionController.dispatchedOperationsCount, 1);
+}
+
+- (void)test_WhenCommandInBatchFails_BatchStopsOnError {
+    NSArray *responses = @[[NSData dataWithBytes:@[@(0x90), @(0x00)]],
+                           [NSData dataWithBytes:@[@(0x69), @(0x82)]],
+                           [NSData dataWithBytes:@[@(0x90), @(0x00)]]];
+    self.keyConnectionController.commandExecutionResponseDataSequence = responses;
+    
+    XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"SmartCardBatch"];
+    
+    [self.smartCardInterface executeCommands:[self commandsWithCount:3] completion:^(NSArray<YKFSmartCardInterfaceCommandResult *> * _Nonnull results, NSError * _Nullable error) {
+        XCTAssertEqual(error.code, 0x6982);
+        XCTAssertEqual(results.count, 2);
+        XCTAssertNil(results[0].error);
+        XCTAssertEqual(results[1].error.code, 0x6982);
+        [expectation fulfill];
+    }];
+    XCTWaiterResult result = [XCTWaiter waitForExpectations:@[expectation] timeout:10];
+    XCTAssert(result == XCTWaiterResultCompleted, @"");
+    
+    XCTAssertEqual(self.keyConnectionController.executionCommandsCount, 2);
+}
+
+- (void)test_WhenCommandInBatchFails_BatchContinuesWithContinuePolicy {
+    NSArray *responses = @[[NSData dataWithBytes:@[@(0x6A), @(0x80)]],
+                           [NSData dataWithBytes:@[@(0x90), @(0x00)]]];
+    self.keyConnectionController.commandExecutionResponseDataSequence = responses;
+    
+    XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"SmartCardBatch"];
+    
+    [self.smartCardInterface executeCommands:[self commandsWithCount:2] sendRemainingIns:YKFSmartCardInterfaceSendRemainingInsNormal errorPolicy:YKFSmartCardInterfaceErrorPolicyContinue timeout:10 completion:^(NSArray<YKFSmartCardInterfaceCommandResult *> * _Nonnull results, NSError * _Nullable error) {
+        XCTAssertEqual(error.code, 0x6A80);
+        XCTAssertEqual(results.count, 2);
+        XCTAssertNotNil(results[0].error);
+        XCTAssertNil(results[1].error);
+        [expectation fulfill];
+    }];
+    XCTWaiterResult result = [XCTWaiter waitForExpectations:@[expectation] timeout:10];
+    XCTAssert(result == XCTWaiterResultCompleted, @"");
+}
+
+- (void)test_WhenCommandInBatchFailsWithConnectionError_BatchStopsWithContinuePolicy {
+    NSError *timeoutError = [YKFSessionError errorWithCode:YKFSessionErrorReadTimeoutCode];
+    self.keyConnectionController.commandExecutionResponseDataSequence = @[[NSData data]];
+    self.keyConnectionController.commandExecutionResponseErrorSequence = @[timeoutError];
+
+    XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"SmartCardBatch"];
+
+    [self.smartCardInterface executeCommands:[self commandsWithCount:3] sendRemainingIns:YKFSmartCardInterfaceSendRemainingInsNormal errorPolicy:YKFSmartCardInterfaceErrorPolicyContinue timeout:10 completion:^(NSArray<YKFSmartCardInterfaceCommandResult *> * _Nonnull results, NSError * _Nullable error) {
+        XCTAssertEqualObjects(error, timeoutError);
+        XCTAssertEqual(results.count, 3);
+        for (YKFSmartCardInterfaceCommandResult *result in results) {
+            XCTAssertNil(result.data);
+            XCTAssertEqualObjects(result.error, timeoutError);
+        }
+        [expectation fulfill];
+    }];
+    XCTWaiterResult result = [XCTWaiter waitForExpectations:@[expectation] timeout:10];
+    XCTAssert(result == XCTWaiterResultCompleted, @"");
+
+    XCTAssertEqual(self.keyConnectionController.executionCommandsCount, 1);
+}
+
+- (void)test_WhenCommandInBatchHasMoreData_RemainingDataIsRequested {
+    NSArray *responses = @[[NSData dataWithBytes:@[@(0x01), @(0x61), @(0x01)]],
+                           [NSData dataWithBytes:@[@(0x02), @(0x90), @(0x00)]],
+                           [NSData dataWithBytes:@[@(0x03), @(0x90), @(0x00)]]];
+    self.keyConnectionController.commandExecutionResponseDataSequence = responses;
+    
+    XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"SmartCardBatch"];
+    
+    [self.smartCardInterface executeCommands:[self commandsWithCount:2] completion:^(NSArray<YKFSmartCardInterfaceCommandResult *> * _Nonnull results, NSError * _Nullable error) {
+        XCTAssertNil(error);
+        XCTAssertEqual(results.count, 2);
+        XCTAssertEqualObjects(results[0].data, ([NSData dataWithBytes:@[@(0x01), @(0x02)]]));
+        XCTAssertEqualObjects(results[1].data, [NSData dataWithBytes:@[@(0x03)]]);
+        [expectation fulfill];
+    }];
+    XCTWaiterResult result = [XCTWaiter waitForExpectations:@[expectation] timeout:10];
+    XCTAssert(result == XCTWaiterResultCompleted, @"");
+    
+    XCTAssertEqual(self.keyConnectionController.executionCommandsCount, 3);
+}
+
+- (void)test_WhenBatchIsExecuted_ProgressIsReportedAfterEachCommand {
+    NSArray *responses = @[[NSData dataWithBytes:@[@(0x90), @(0x00)]],
+                           [NSData dataWithBytes:@[@(0x01), @(0x61), @(0x01)]],
+                           [NSData dataWithBytes:@[@(0x02), @(0x90), @(0x00)]],
+                           [NSData dataWithBytes:@[@(0x6A), @(0x80)]]];
+    self.keyConnectionController.commandExecutionResponseDataSequence = responses;
+
+    XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"SmartCardBatch"];
+    NSMutableArray<NSNumber *> *progressCounts = [[NSMutableArray alloc] init];
+
+    [self.smartCardInterface executeCommands:[self commandsWithCount:3] sendRemainingIns:YKFSmartCardInterfaceSendRemainingInsNormal errorPolicy:YKFSmartCardInterfaceErrorPolicyContinue timeout:10 progress:^(NSUInteger completedCount, NSUInteger totalCount) {
+        XCTAssertEqual(totalCount, 3);
+        [progressCounts addObject:@(completedCount)];
+    } completion:^(NSArray<YKFSmartCardInterfaceCommandResult *> * _Nonnull results, NSError * _Nullable error) {
+        XCTAssertEqual(results.count, 3);
+        XCTAssertEqualObjects(progressCounts, (@[@(1), @(2), @(3)]));
+        [expectation fulfill];
+    }];
+    XCTWaiterResult result = [XCTWaiter waitForExpectations:@[expectation] timeout:10];
+    XCTAssert(result == XCTWaiterResultCompleted, @"");
+
+    XCTAssertEqual(self.keyConnectionController.dispatchedOperationsCount, 1);
+}
+
+#pragma mark - Remaining data
+
+- (void)test_WhenKeyHasMoreData_ResponseIsReassembledInOneOperation {
+    NSArray *responses = @[[NSData dataWithBytes:@[@(0x01), @(0x02), @(0x61), @(0x00)]],
+                           [NSData dataWithBytes:@[@(0x03), @(0x61), @(0x02)]],
+                           [NSData dataWithBytes:@[@(0x04), @(0x05), @(0x90), @(0x00)]]];
+    self.keyConnectionController.commandExecutionResponseDataSequence = responses;
+    
+    XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"SmartCardRemainingData"];
+    [self.smartCardInterface executeCommand:[self commandsWithCount:1].firstObject completion:^(NSData * _Nullable data, NSError * _Nullable error) {
+        XCTAssertNil(error);
+        XCTAssertEqualObjects(data, ([NSData dataWithBytes:@[@(0x01), @(0x02), @(0x03), @(0x04), @(0x05)]]));
+        [expectation fulfill];
+    }];
+    XCTWaiterResult result = [XCTWaiter waitForExpectations:@[expectation] timeout:10];
+    XCTAssert(result == XCTWaiterResultCompleted, @"");
+    
+    NSArray<YKFAPDU *> *commands = self.keyConnectionController.executedCommands;
+    XCTAssertEqual(commands.count, 3);
+    XCTAssertEqual(self.keyConnectionController.dispatchedOperationsCount, 1);
+    
+    // The send remaining command is built once.
+    XCTAssertEqual(commands[1], commands[2]);
+    XCTAssertEqualObjects(commands[1].apduData, ([NSData dataWithBytes:@[@(0x00), @(0xC0), @(0x00), @(0x00)]]));
+}
+
+- (void)test_LongResponseReassemblyPerformance {
+    // A 3 KB certificate, read in chunks of 256 bytes.
+    NSMutableData *chunk = [[NSMutableData alloc] initWithLength:256];
+    [chunk appendBytes:(UInt8[]){0x61, 0x00} length:2];
+    NSMutableData *lastChunk = [[NSMutableData alloc] initWithLength:256];
+    [lastChunk appendBytes:(UInt8[]){0x90, 0x00} length:2];
+    
+    NSMutableArray *responses = [[NSMutableArray alloc] init];
+    for (int i = 0; i < 11; ++i) {
+        [responses addObject:chunk];
+    }
+    [responses addObject:lastChunk];
+    
+    [self measureBlock:^{
+        for (int i = 0; i < 10; ++i) {
+            self.keyConnectionController.commandExecutionResponseDataSequence = responses;
+            
+            XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"SmartCardRemainingData"];
+            [self.smartCardInterface executeCommand:[self commandsWithCount:1].firstObject completion:^(NSData * _Nullable data, NSError * _Nullable error) {
+                XCTAssertEqual(data.length, 3072);
+                [expectation fulfill];
+            }];
+            XCTWaiterResult result = [XCTWaiter waitForExpectations:@[expectation] timeout:10];
+            XCTAssert(result == XCTWaiterResultCompleted, @"");
+        }
+    }];
+}
+
+#pragma mark - Command chaining
+
+- (void)test_WhenCommandFitsInFrame_CommandIsSentAsIs {
+    self.keyConnectionController.maxFrameSize = 261;
+    self.keyConnectionController.commandExecutionResponseDataSequence = [self successResponsesWithCount:1];
+    
+    YKFAPDU *apdu = [self putDataCommandWithLength:250];
+    [self executeCommandAndWait:apdu];
+    
+    XCTAssertEqual(self.keyConnectionController.executedCommands.count, 1);
+    XCTAssertEqual(self.keyConnectionController.executedCommands.firstObject, apdu);
+}
+
+- (void)test_WhenTransportSupportsShortFrames_CommandIsChainedInShortFrames {
+    self.keyConnectionController.maxFrameSize = 261;
+    self.keyConnectionController.commandExecutionResponseDataSequence = [self successResponsesWithCount:3];
+    
+    YKFAPDU *apdu = [self putDataCommandWithLength:600];
+    [self executeCommandAndWait:apdu];
+    
+    NSArray<YKFAPDU *> *frames = self.keyConnectionController.executedCommands;
+    XCTAssertEqual(frames.count, 3);
+    
+    NSUInteger expectedLengths[] = {255, 255, 90};
+    NSMutableData *sentData = [[NSMutableData alloc] init];
+    for (NSUInteger i = 0; i < frames.count; ++i) {
+        UInt8 *bytes = (UInt8 *)frames[i].apduData.bytes;
+        XCTAssertEqual(bytes[0], i < 2 ? 0x10 : 0x00, @"Only the last frame ends the chain.");
+        XCTAssertEqual(bytes[1], 0xDB);
+        XCTAssertEqual(bytes[4], expectedLengths[i], @"Frames must be short APDUs.");
+        XCTAssertEqual(frames[i].apduData.length, 5 + expectedLengths[i]);
+        [sentData appendData:[frames[i].apduData subdataWithRange:NSMakeRange(5, expectedLengths[i])]];
+    }
+    XCTAssertEqualObjects(sentData, apdu.commandData);
+}
+
+- (void)test_WhenTransportSupportsExtendedFrames_CommandIsChainedInExtendedFrames {
+    self.keyConnectionController.maxFrameSize = 1000;
+    self.keyConnectionController.commandExecutionResponseDataSequence = [self successResponsesWithCount:3];
+    
+    YKFAPDU *apdu = [self putDataCommandWithLength:2100];
+    [self executeCommandAndWait:apdu];
+    
+    NSArray<YKFAPDU *> *frames = self.keyConnectionController.executedCommands;
+    XCTAssertEqual(frames.count, 3);
+    
+    // Two extended frames of 993 bytes of data, followed by a short frame with the remaining 114 bytes.
+    XCTAssertEqual(frames[0].apduData.length, 1000);
+    XCTAssertEqual(frames[1].apduData.length, 1000);
+    XCTAssertEqual(frames[2].apduData.length, 5 + 114);
+    XCTAssertEqual(((UInt8 *)frames[0].apduData.bytes)[0], 0x10);
+    XCTAssertEqual(((UInt8 *)frames[2].apduData.bytes)[0], 0x00);
+}
+
+- (void)test_WhenChainedFrameIsRejected_ChainIsStopped {
+    self.keyConnectionController.maxFrameSize = 261;
+    self.keyConnectionController.commandExecutionResponseDataSequence = @[[NSData dataWithBytes:@[@(0x90), @(0x00)]],
+                                                                         [NSData dataWithBytes:@[@(0x6A), @(0x80)]]];
+    
+    XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"SmartCardChaining"];
+    [self.smartCardInterface executeCommand:[self putDataCommandWithLength:800] completion:^(NSData * _Nullable data, NSError * _Nullable error) {
+        XCTAssertEqual(error.code, 0x6A80);
+        [expectation fulfill];
+    }];
+    XCTWaiterResult result = [XCTWaiter waitForExpectations:@[expectation] timeout:10];
+    XCTAssert(result == XCTWaiterResultCompleted, @"");
+    
+    XCTAssertEqual(self.keyConnectionController.executedCommands.count, 2);
+}
+
+- (void)test_ChainedCertificateWritePerformance {
+    [self measureCertificateWritesWithMaxFrameSize:261];
+}
+
+- (void)test_ExtendedCertificateWritePerformance {
+    [self measureCertificateWritesWithMaxFrameSize:3062];
+}
+
+#pragma mark - Performance
+
+- (void)test_ChainedCommandsPerformance {
+    [self measureBlock:^{
+        [self runCommandsWithCount:100 batched:NO];
+    }];
+    XCTAssertEqual(self.keyConnectionController.dispatchedOperationsCount, self.keyConnectionController.executionCommandsCount);
+}
+
+- (void)test_BatchedCommandsPerformance {
+    [self measureBlock:^{
+        [self runCommandsWithCount:100 batched:YES];
+    }];
+    XCTAssertLessThan(self.keyConnectionController.dispatchedOperationsCount, self.keyConnectionController.executionCommandsCount);
+}
+
+#pragma mark - Helpers
+
+- (YKFAPDU *)putDataCommandWithLength:(NSUInteger)length {
+    NSMutableData *data = [[NSMutableData alloc] initWithLength:length];
+    UInt8 *bytes = data.mutableBytes;
+    for (NSUInteger i = 0; i < length; ++i) {
+        bytes[i] = (UInt8)i;
+    }
+    return [[YKFAPDU alloc] initWithCla:0x00 ins:0xDB p1:0x3F p2:0xFF data:data type:YKFAPDUTypeExtended];
+}
+
+- (NSArray<NSData *> *)successResponsesWithCount:(NSUInteger)count {
+    NSData *response = [NSData dataWithBytes:@[@(0x90), @(0x00)]];
+    NSMutableArray *responses = [[NSMutableArray alloc] initWithCapacity:count];
+    for (NSUInteger i = 0; i < count; ++i) {
+        [responses addObject:response];
+    }
+    return responses;
+}
+
+- (void)executeCommandAndWait:(YKFAPDU *)apdu {
+    XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"SmartCardCommand"];
+    [self.smartCardInterface executeCommand:apdu completion:^(NSData * _Nullable data, NSError * _Nullable error) {
+        XCTAssertNil(error);
+        [expectation fulfill];
+    }];
+    XCTWaiterResult result = [XCTWaiter waitForExpectations:@[expectation] timeout:10];
+    XCTAssert(result == XCTWaiterResultCompleted, @"");
+}
+
+// Writes 1, 2 and 3 KB certificates to a simulated card which takes 5ms to acknowledge each frame.
+- (void)measureCertificateWritesWithMaxFrameSize:(NSUInteger)maxFrameSize {
+    self.keyConnectionController.maxFrameSize = maxFrameSize;
+    self.keyConnectionController.frameLatency = 0.005;
+    
+    [self measureBlock:^{
+        for (NSUInteger length = 1024; length <= 3072; length += 1024) {
+            self.keyConnectionController.commandExecutionResponseDataSequence = [self successResponsesWithCount:length / 255 + 1];
+            [self executeCommandAndWait:[self putDataCommandWithLength:length]];
+        }
+    }];
+}
+
+- (NSArray<YKFAPDU *> *)commandsWithCount:(NSUInteger)count {
+    NSMutableArray *commands = [[NSMutableArray alloc] initWithCapacity:count];
+    for (NSUInteger i = 0; i < count; ++i) {
+        [commands addObject:[[YKFAPDU alloc] initWithCla:0x00 ins:(UInt8)i p1:0x00 p2:0x00 data:[NSData data] type:YKFAPDUTypeShort]];
+    }
+    return commands;
+}
+
+- (void)runCommandsWithCount:(NSUInteger)count batched:(BOOL)batched {
+    NSData *response = [NSData dataWithBytes:@[@(0x01), @(0x90), @(0x00)]];
+    NSMutableArray *responses = [[NSMutableArray alloc] initWithCapacity:count];
+    for (NSUInteger i = 0; i < count; ++i) {
+        [responses addObject:response];
+    }
+    self.keyConnectionController.commandExecutionResponseDataSequence = responses;
+    
+    NSArray<YKFAPDU *> *commands = [self commandsWithCount:count];
+    XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"SmartCardCommands"];
+    
+    if (batched) {
+        [self.smartCardInterface executeCommands:commands completion:^(NSArray<YKFSmartCardInterfaceCommandResult *> * _Nonnull results, NSError * _Nullable error) {
+            XCTAssertEqual(results.count, count);
+            [expectation fulfill];
+        }];
+    } else {
+        [self executeCommands:commands index:0 completion:^{
+            [expectation fulfill];
+        }];
+    }
+    XCTWaiterResult result = [XCTWaiter waitForExpectations:@[expectation] timeout:10];
+    XCTAssert(result == XCTWaiterResultCompleted, @"");
+}
+
+// Chains the commands through nested completions, like the sessions do without the batch API.
+- (void)executeCommands:(NSArray<YKFAPDU *> *)commands index:(NSUInteger)index completion:(void (^)(void))completion {
+    if (index == commands.count) {
+        completion();
+        return;
+    }
+    [self.smartCardInterface executeCommand:commands[index] completion:^(NSData * _Nullable data, NSError * _Nullable error) {
+        XCTAssertNil(error);
+        [self executeCommands:commands index:index + 1 completion:completion];
+    }];
+}
+
 @end
@@ -0,0 +1,53 @@
+// Copyright 2018-2021 Yubico AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <XCTest/XCTest.h>
+
+#import "YKFTestCase.h"
+#import "YKFTouchPollSchedule.h"
+
+@interface YKFTouchPollScheduleTests: YKFTestCase
+@end
+
+@implementation YKFTouchPollScheduleTests
+
+- (void)test_WhenPolling_IntervalGrowsUpToMaximumInterval {
+    YKFTouchPollSchedule *schedule = [[YKFTouchPollSchedule alloc] init];
+
+    NSTimeInterval previousInterval = 0;
+    for (int i = 0; i < 10; ++i) {
+        NSTimeInterval interval = [schedule nextInterval];
+        XCTAssertGreaterThanOrEqual(interval, previousInterval);
+        XCTAssertLessThanOrEqual(interval, schedule.maximumInterval);
+        previousInterval = interval;
+    }
+    XCTAssertEqual(schedule.pollCount, 10);
+    XCTAssertEqualWithAccuracy(previousInterval, schedule.maximumInterval, 0.001);
+}
+
+- (void)test_WhenPollingStarts_FirstIntervalIsInitialInterval {
+    YKFTouchPollSchedule *schedule = [[YKFTouchPollSchedule alloc] initWithInitialInterval:0.05 maximumInterval:1 timeout:5];
+    XCTAssertEqual([schedule nextInterval], 0.05);
+    XCTAssertGreaterThan([schedule nextInterval], 0.05);
+}
+
+- (void)test_WhenTimeoutIsOver_ScheduleIsExpired {
+    YKFTouchPollSchedule *schedule = [[YKFTouchPollSchedule alloc] init];
+
+    XCTAssertFalse([schedule isExpiredAtDate:[NSDate date]]);
+    XCTAssertFalse([schedule isExpiredAtDate:[NSDate dateWithTimeIntervalSinceNow:schedule.timeout - 1]]);
+    XCTAssertTrue([schedule isExpiredAtDate:[NSDate dateWithTimeIntervalSinceNow:schedule.timeout + 1]]);
+}
+
+@end
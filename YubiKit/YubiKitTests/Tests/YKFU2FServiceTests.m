@@ -222,6 +222,36 @@
     XCTAssertNotNil(self.keyConnectionController.executionCommand, @"No command data executed on the connection controller.");
 }
 
+#pragma mark - Touch Tests
+
+- (void)test_WhenExecutingSignRequestWithTouchRequired_RequestIsPolledUntilTouched {
+    NSData *applicationSelectionResponse = [NSData dataWithBytes:@[@(0x00), @(0x90), @(0x00)]];
+    NSData *touchResponse = [NSData dataWithBytes:@[@(0x00), @(0x69), @(0x85)]]; // Condition not satisfied - touch the key
+    NSData *commandResponse = [NSData dataWithBytes:@[@(0x00), @(0x90), @(0x00)]];
+    self.keyConnectionController.commandExecutionResponseDataSequence = @[applicationSelectionResponse, touchResponse, touchResponse, touchResponse, commandResponse];
+    
+    XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"U2F"];
+    
+    [YKFU2FSession sessionWithConnectionController:self.keyConnectionController completion:^(YKFU2FSession * _Nullable session, NSError * _Nullable error) {
+        self.session = session;
+        [self.session signWithChallenge:self.challenge keyHandle:self.keyHandle appId:self.appId completion:^(YKFU2FSignResponse * _Nullable response, NSError * _Nullable error) {
+            XCTAssertNil(error, @"Unexpected error: %@", error);
+            XCTAssertNotNil(response);
+            [expectation fulfill];
+        }];
+    }];
+    
+    XCTWaiterResult result = [XCTWaiter waitForExpectations:@[expectation] timeout:10];
+    XCTAssert(result == XCTWaiterResultCompleted, @"");
+    XCTAssertEqual(self.keyConnectionController.executionCommandsCount, 5);
+    XCTAssertEqual(self.session.keyState, YYKFU2FSessionKeyStateIdle);
+    
+    // The key is polled often right after the prompt, then less often.
+    NSArray<NSNumber *> *delays = self.keyConnectionController.dispatchDelays;
+    XCTAssertEqual(delays.count, 3);
+    XCTAssertLessThan(delays.firstObject.doubleValue, delays.lastObject.doubleValue);
+}
+
 #pragma mark - Key State Tests
 
 - (void)disabled_test_WhenExecutingRegisterRequestWithTouchRequired_KeyStateIsUpdatingToTouchKey {